@@ -8,6 +8,7 @@
 #include "opencv2/img_hash/average_hash.hpp"
 #include "opencv2/img_hash/block_mean_hash.hpp"
 #include "opencv2/img_hash/color_moment_hash.hpp"
+#include "opencv2/img_hash/img_hash_index.hpp"
 #include "opencv2/img_hash/marr_hildreth_hash.hpp"
 #include "opencv2/img_hash/phash.hpp"
 #include "opencv2/img_hash/radial_variance_hash.hpp"
@@ -34,6 +35,11 @@ You can study more about image hashing from following paper and websites:
 - "Implementation and benchmarking of perceptual image hash functions" @cite zauner2010implementation
 - "Looks Like It" @cite lookslikeit
 
+### Searching large sets of hashes
+
+cv::img_hash::ImgHashIndex finds the hashes within a Hamming distance or the nearest hashes of a query
+without comparing it against every hash of the set.
+
 ### Code Example
 
 @include samples/hash_samples.cpp
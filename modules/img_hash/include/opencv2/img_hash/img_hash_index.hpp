@@ -0,0 +1,82 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef OPENCV_IMG_HASH_INDEX_HPP
+#define OPENCV_IMG_HASH_INDEX_HPP
+
+#include "img_hash_base.hpp"
+
+namespace cv {
+namespace img_hash {
+
+//! @addtogroup img_hash
+//! @{
+
+/** @brief Index of binary image hashes answering Hamming distance queries in sub-linear time
+
+The index is meant for the hashes compared by Hamming distance: AverageHash, PHash, BlockMeanHash
+and MarrHildrethHash. It implements multi-index hashing @cite norouzi2012fast : every hash is split
+into substrings and each substring is indexed in its own table. A hash within distance r from the
+query has at least one substring within distance r / m from the corresponding query substring, m
+being the number of substrings, so only the table entries close to the query substrings are
+verified. The search falls back to the linear scan when probing the tables would be more expensive.
+
+Hashes get consecutive indices in the order they are added, the matches store them in
+DMatch::trainIdx and the query indices in DMatch::queryIdx. The queries of a batch are processed
+in parallel. Search methods may be called concurrently with each other, but not with add(), addImages(),
+build(), clear() or read(). If the tables are outdated after add(), the first search builds them and the
+concurrent searches wait for it.
+
+Only the hashes are serialized by write(), read() builds the tables again.
+*/
+class CV_EXPORTS_W ImgHashIndex : public Algorithm
+{
+public:
+    /** @brief Creates an empty index
+        @param substrings number of substrings each hash is split into, 0 chooses it from
+        the number of hashes when the index is built
+    */
+    CV_WRAP static Ptr<ImgHashIndex> create(int substrings = 0);
+
+    /** @brief Adds hashes to the index, the tables are rebuilt by the next search or build()
+        @param hashes CV_8UC1 matrix with a hash per row, all the hashes should have the same length
+    */
+    CV_WRAP virtual void add(InputArray hashes) = 0;
+
+    /** @brief Computes the hashes of the images and adds them to the index
+        @param algorithm hash algorithm producing CV_8U hashes
+        @param images images to compute the hashes of
+    */
+    CV_WRAP virtual void addImages(const Ptr<ImgHashBase>& algorithm, InputArrayOfArrays images) = 0;
+
+    /** @brief Builds the tables of the added hashes, it is done once after a series of add() calls
+    */
+    CV_WRAP virtual void build() = 0;
+
+    /** @brief Finds the k nearest hashes for every query
+        @param queries CV_8UC1 matrix with a query hash per row
+        @param matches the nearest hashes sorted by distance, a vector per query
+        @param k number of the nearest hashes to find
+    */
+    CV_WRAP virtual void knnSearch(InputArray queries, CV_OUT std::vector<std::vector<DMatch> >& matches, int k) = 0;
+
+    /** @brief Finds all the hashes not further than maxDistance for every query
+        @param queries CV_8UC1 matrix with a query hash per row
+        @param matches the hashes found sorted by distance, a vector per query
+        @param maxDistance search radius
+    */
+    CV_WRAP virtual void radiusSearch(InputArray queries, CV_OUT std::vector<std::vector<DMatch> >& matches, int maxDistance) = 0;
+
+    /** @brief Returns the number of hashes in the index */
+    CV_WRAP virtual int size() const = 0;
+
+    /** @brief Returns the hashes of the index, a hash per row */
+    CV_WRAP virtual Mat getHashes() const = 0;
+};
+
+//! @}
+
+} } // cv::img_hash::
+
+#endif // OPENCV_IMG_HASH_INDEX_HPP
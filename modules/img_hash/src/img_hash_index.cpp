@@ -0,0 +1,448 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+
+#include "opencv2/core/hal/hal.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace cv;
+using namespace cv::img_hash;
+using namespace std;
+
+namespace {
+
+//! the bits [start, start + len) of the code, len <= 64
+inline uint64 getBits(const uchar* code, int start, int len)
+{
+    uint64 value = 0;
+    for(int i = 0; i < len;)
+    {
+        int const bit = start + i;
+        int const offset = bit & 7;
+        int const n = std::min(8 - offset, len - i);
+        value |= (uint64)((code[bit >> 3] >> offset) & ((1 << n) - 1)) << i;
+        i += n;
+    }
+    return value;
+}
+
+//! number of the b-bit keys at distance s
+inline double binomial(int b, int s)
+{
+    double res = 1;
+    for(int i = 0; i < s; ++i)
+    {
+        res = res * (b - i) / (i + 1);
+    }
+    return res;
+}
+
+//! calls f for every b-bit key at distance s from the key
+template<typename Func>
+void forEachAtDistance(uint64 key, int b, int s, std::vector<int>& pos, Func f)
+{
+    if(s == 0)
+    {
+        f(key);
+        return;
+    }
+    if(s > b)
+        return;
+
+    // pos holds the flipped bits in increasing order
+    pos.resize(s);
+    for(int i = 0; i < s; ++i)
+    {
+        pos[i] = i;
+        key ^= (uint64)1 << i;
+    }
+    for(;;)
+    {
+        f(key);
+
+        // move the highest bit which can be moved and put the following ones right after it
+        int i = s - 1;
+        while(i >= 0 && pos[i] == b - s + i)
+            --i;
+        if(i < 0)
+            break;
+
+        for(int j = i; j < s; ++j)
+            key ^= (uint64)1 << pos[j];
+        ++pos[i];
+        for(int j = i + 1; j < s; ++j)
+            pos[j] = pos[j - 1] + 1;
+        for(int j = i; j < s; ++j)
+            key ^= (uint64)1 << pos[j];
+    }
+}
+
+//! table of a substring: hash indices grouped by the value of the substring
+struct SubstringTable
+{
+    int start;
+    int bits;
+    std::vector<uint64> keys;   //!< sorted distinct values of the substring
+    std::vector<int> offsets;   //!< indices of keys[i] are ids[offsets[i]] ... ids[offsets[i + 1] - 1]
+    std::vector<int> ids;
+};
+
+//! state of a single query, reused between the queries
+struct SearchContext
+{
+    explicit SearchContext(int n) : visited(n, 0), stamp(0) {}
+
+    std::vector<unsigned> visited; //!< equals to stamp if the hash is checked by the current query
+    unsigned stamp;
+    std::vector<uint64> substrings;
+    std::vector<int> pos;
+    std::vector<std::pair<int, int> > found; //!< (distance, index)
+};
+
+class ImgHashIndexImpl CV_FINAL : public ImgHashIndex
+{
+public:
+    explicit ImgHashIndexImpl(int _substrings) :
+        substrings(_substrings), built(false)
+    {
+        CV_Assert(substrings >= 0);
+    }
+
+    virtual void add(InputArray _hashes) CV_OVERRIDE
+    {
+        Mat newHashes = _hashes.getMat();
+        if(newHashes.empty())
+            return;
+
+        CV_Assert(newHashes.type() == CV_8UC1);
+        CV_Assert(hashes.empty() || newHashes.cols == hashes.cols);
+
+        hashes.push_back(newHashes);
+        built.store(false);
+    }
+
+    virtual void addImages(const Ptr<ImgHashBase>& algorithm, InputArrayOfArrays images) CV_OVERRIDE
+    {
+        CV_Assert(algorithm);
+
+        std::vector<Mat> imgs;
+        images.getMatVector(imgs);
+
+        // the algorithms keep intermediate buffers, so the hashes are computed one by one
+        Mat newHashes, hash;
+        for(size_t i = 0; i != imgs.size(); ++i)
+        {
+            algorithm->compute(imgs[i], hash);
+            // only the hashes compared by Hamming distance can be indexed
+            CV_Assert(hash.type() == CV_8UC1);
+            newHashes.push_back(hash.reshape(1, 1));
+        }
+        add(newHashes);
+    }
+
+    virtual void build() CV_OVERRIDE
+    {
+        AutoLock lock(buildMutex);
+        buildTables();
+    }
+
+    virtual void knnSearch(InputArray queries, std::vector<std::vector<DMatch> >& matches, int k) CV_OVERRIDE
+    {
+        CV_Assert(k > 0);
+        search(queries, matches, k, -1);
+    }
+
+    virtual void radiusSearch(InputArray queries, std::vector<std::vector<DMatch> >& matches, int maxDistance) CV_OVERRIDE
+    {
+        search(queries, matches, 0, maxDistance);
+    }
+
+    virtual int size() const CV_OVERRIDE
+    {
+        return hashes.rows;
+    }
+
+    virtual Mat getHashes() const CV_OVERRIDE
+    {
+        return hashes;
+    }
+
+    virtual void clear() CV_OVERRIDE
+    {
+        hashes.release();
+        tables.clear();
+        {
+            AutoLock lock(contextMutex);
+            contexts.clear();
+        }
+        built.store(false);
+    }
+
+    virtual bool empty() const CV_OVERRIDE
+    {
+        return hashes.empty();
+    }
+
+    virtual String getDefaultName() const CV_OVERRIDE
+    {
+        return "img_hash.ImgHashIndex";
+    }
+
+    virtual void write(FileStorage& fs) const CV_OVERRIDE
+    {
+        writeFormat(fs);
+        fs << "substrings" << substrings;
+        fs << "hashes" << hashes;
+    }
+
+    virtual void read(const FileNode& fn) CV_OVERRIDE
+    {
+        clear();
+        substrings = (int)fn["substrings"];
+        fn["hashes"] >> hashes;
+        CV_Assert(hashes.empty() || hashes.type() == CV_8UC1);
+        build();
+    }
+
+private:
+    //! builds the tables, called under buildMutex
+    void buildTables()
+    {
+        CV_TRACE_FUNCTION();
+
+        tables.clear();
+        {
+            AutoLock lock(contextMutex);
+            contexts.clear();
+        }
+
+        int const n = hashes.rows;
+        if(n > 0)
+            fillTables(n);
+        built.store(true, std::memory_order_release);
+    }
+
+    //! splits the hashes into the substrings and indexes every substring in its table
+    void fillTables(int n)
+    {
+        int const codeBits = hashes.cols * 8;
+        int m = substrings;
+        if(m == 0)
+        {
+            // the substring length close to log2(n) makes the tables neither too sparse nor too crowded
+            int const b = std::max(8, std::min(32, cvCeil(std::log((double)n) / std::log(2.0))));
+            m = std::max(1, cvRound((double)codeBits / b));
+        }
+        m = std::max(m, (codeBits + 63) / 64);
+        m = std::min(m, codeBits);
+
+        tables.resize(m);
+        for(int i = 0, start = 0; i < m; ++i)
+        {
+            tables[i].start = start;
+            tables[i].bits = codeBits / m + (i < codeBits % m ? 1 : 0);
+            start += tables[i].bits;
+        }
+
+        parallel_for_(Range(0, m), [&](const Range& range)
+        {
+            std::vector<std::pair<uint64, int> > entries(n);
+            for(int t = range.start; t < range.end; ++t)
+            {
+                SubstringTable& table = tables[t];
+                for(int i = 0; i < n; ++i)
+                    entries[i] = std::make_pair(getBits(hashes.ptr(i), table.start, table.bits), i);
+                std::sort(entries.begin(), entries.end());
+
+                table.ids.resize(n);
+                table.keys.clear();
+                table.offsets.clear();
+                for(int i = 0; i < n; ++i)
+                {
+                    if(i == 0 || entries[i].first != entries[i - 1].first)
+                    {
+                        table.keys.push_back(entries[i].first);
+                        table.offsets.push_back(i);
+                    }
+                    table.ids[i] = entries[i].second;
+                }
+                table.offsets.push_back(n);
+            }
+        });
+    }
+
+    void search(InputArray _queries, std::vector<std::vector<DMatch> >& matches, int k, int maxDistance)
+    {
+        CV_TRACE_FUNCTION();
+
+        Mat queries = _queries.getMat();
+        matches.clear();
+        if(queries.empty())
+            return;
+
+        CV_Assert(queries.type() == CV_8UC1);
+        CV_Assert(hashes.empty() || queries.cols == hashes.cols);
+
+        matches.resize(queries.rows);
+        if(hashes.empty() || (k <= 0 && maxDistance < 0))
+            return;
+
+        // the first search after add() builds the tables, concurrent searches wait for it
+        if(!built.load(std::memory_order_acquire))
+        {
+            AutoLock lock(buildMutex);
+            if(!built.load(std::memory_order_relaxed))
+                buildTables();
+        }
+
+        parallel_for_(Range(0, queries.rows), [&](const Range& range)
+        {
+            std::unique_ptr<SearchContext> ctx = acquireContext();
+            for(int i = range.start; i < range.end; ++i)
+            {
+                searchOne(queries.ptr(i), k, maxDistance, *ctx);
+
+                std::vector<DMatch>& res = matches[i];
+                res.resize(ctx->found.size());
+                for(size_t j = 0; j < ctx->found.size(); ++j)
+                    res[j] = DMatch(i, ctx->found[j].second, (float)ctx->found[j].first);
+            }
+            releaseContext(std::move(ctx));
+        });
+    }
+
+    //! finds the hashes within maxDistance if k <= 0, otherwise the k nearest hashes
+    void searchOne(const uchar* query, int k, int maxDistance, SearchContext& ctx) const
+    {
+        int const n = hashes.rows;
+        int const len = hashes.cols;
+        int const m = (int)tables.size();
+        bool const knn = k > 0;
+
+        std::vector<std::pair<int, int> >& found = ctx.found;
+        found.clear();
+
+        if(++ctx.stamp == 0)
+        {
+            std::fill(ctx.visited.begin(), ctx.visited.end(), 0u);
+            ctx.stamp = 1;
+        }
+        unsigned const stamp = ctx.stamp;
+
+        // found is a max-heap of the k nearest hashes in the kNN mode
+        auto check = [&](int idx)
+        {
+            if(ctx.visited[idx] == stamp)
+                return;
+            ctx.visited[idx] = stamp;
+
+            int const dist = hal::normHamming(query, hashes.ptr(idx), len);
+            if(!knn)
+            {
+                if(dist <= maxDistance)
+                    found.push_back(std::make_pair(dist, idx));
+            }
+            else if((int)found.size() < k)
+            {
+                found.push_back(std::make_pair(dist, idx));
+                std::push_heap(found.begin(), found.end());
+            }
+            else if(std::make_pair(dist, idx) < found.front())
+            {
+                std::pop_heap(found.begin(), found.end());
+                found.back() = std::make_pair(dist, idx);
+                std::push_heap(found.begin(), found.end());
+            }
+        };
+
+        ctx.substrings.resize(m);
+        for(int t = 0; t < m; ++t)
+            ctx.substrings[t] = getBits(query, tables[t].start, tables[t].bits);
+
+        // a hash with all the substrings further than s is further than m * (s + 1) - 1
+        int const maxBits = tables[0].bits;
+        int const maxLevel = knn ? maxBits : std::min(maxBits, maxDistance / m);
+        for(int s = 0; s <= maxLevel; ++s)
+        {
+            // enumerating the keys is more expensive than checking everything
+            double probes = 0;
+            for(int t = 0; t < m; ++t)
+                probes += binomial(tables[t].bits, s);
+            if(probes > n)
+            {
+                for(int idx = 0; idx < n; ++idx)
+                    check(idx);
+                break;
+            }
+
+            for(int t = 0; t < m; ++t)
+            {
+                const SubstringTable& table = tables[t];
+                forEachAtDistance(ctx.substrings[t], table.bits, s, ctx.pos, [&](uint64 key)
+                {
+                    std::vector<uint64>::const_iterator it = std::lower_bound(table.keys.begin(), table.keys.end(), key);
+                    if(it == table.keys.end() || *it != key)
+                        return;
+                    size_t const j = it - table.keys.begin();
+                    for(int p = table.offsets[j]; p < table.offsets[j + 1]; ++p)
+                        check(table.ids[p]);
+                });
+            }
+
+            if(knn && (int)found.size() == k && found.front().first <= m * (s + 1) - 1)
+                break;
+        }
+
+        std::sort(found.begin(), found.end());
+    }
+
+    std::unique_ptr<SearchContext> acquireContext()
+    {
+        {
+            AutoLock lock(contextMutex);
+            if(!contexts.empty())
+            {
+                std::unique_ptr<SearchContext> ctx = std::move(contexts.back());
+                contexts.pop_back();
+                return ctx;
+            }
+        }
+        return std::unique_ptr<SearchContext>(new SearchContext(hashes.rows));
+    }
+
+    void releaseContext(std::unique_ptr<SearchContext> ctx)
+    {
+        AutoLock lock(contextMutex);
+        contexts.push_back(std::move(ctx));
+    }
+
+    int substrings;
+    Mat hashes;
+    std::vector<SubstringTable> tables;
+    //! the tables match the hashes, set with buildMutex held
+    std::atomic<bool> built;
+    Mutex buildMutex;
+
+    //! the query buffers are as large as the index, so they are kept between the searches
+    Mutex contextMutex;
+    std::vector<std::unique_ptr<SearchContext> > contexts;
+};
+
+} // namespace::
+
+//==================================================================================================
+
+namespace cv { namespace img_hash {
+
+Ptr<ImgHashIndex> ImgHashIndex::create(int substrings)
+{
+    return makePtr<ImgHashIndexImpl>(substrings);
+}
+
+} } // cv::img_hash::
@@ -0,0 +1,187 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::img_hash;
+
+// random hashes with groups of near duplicates
+static void generateHashes(Mat& hashes, Mat& queries, int len)
+{
+    RNG& rng = theRNG();
+    hashes.create(2000, len, CV_8U);
+    rng.fill(hashes, RNG::UNIFORM, 0, 256);
+    for(int i = 100; i < hashes.rows; i += 3)
+    {
+        hashes.row(i - 100).copyTo(hashes.row(i));
+        for(int j = 0; j < i % 7; j++)
+            hashes.at<uchar>(i, rng.uniform(0, len)) ^= (uchar)(1 << rng.uniform(0, 8));
+    }
+
+    queries.create(50, len, CV_8U);
+    for(int i = 0; i < queries.rows; i++)
+    {
+        hashes.row(rng.uniform(0, hashes.rows)).copyTo(queries.row(i));
+        for(int j = 0; j < i % 5; j++)
+            queries.at<uchar>(i, rng.uniform(0, len)) ^= (uchar)(1 << rng.uniform(0, 8));
+    }
+}
+
+static std::vector<std::pair<int, int> > bruteForce(const Mat& hashes, const Mat& query)
+{
+    std::vector<std::pair<int, int> > res;
+    for(int i = 0; i < hashes.rows; i++)
+        res.push_back(std::make_pair((int)cvtest::norm(hashes.row(i), query, NORM_HAMMING), i));
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+static void checkMatches(const std::vector<DMatch>& matches, const std::vector<std::pair<int, int> >& expected, int queryIdx)
+{
+    ASSERT_EQ(expected.size(), matches.size()) << "query " << queryIdx;
+    for(size_t j = 0; j < matches.size(); j++)
+    {
+        EXPECT_EQ(queryIdx, matches[j].queryIdx);
+        EXPECT_EQ(expected[j].second, matches[j].trainIdx) << "query " << queryIdx << ", match " << j;
+        EXPECT_EQ((float)expected[j].first, matches[j].distance) << "query " << queryIdx << ", match " << j;
+    }
+}
+
+typedef testing::TestWithParam<tuple<int, int> > ImgHashIndex_Search;
+
+TEST_P(ImgHashIndex_Search, accuracy)
+{
+    int const len = get<0>(GetParam());
+    int const substrings = get<1>(GetParam());
+
+    Mat hashes, queries;
+    generateHashes(hashes, queries, len);
+
+    Ptr<ImgHashIndex> index = ImgHashIndex::create(substrings);
+    index->add(hashes.rowRange(0, 1000));
+    index->add(hashes.rowRange(1000, hashes.rows));
+    ASSERT_EQ(hashes.rows, index->size());
+
+    const int k = 5;
+    std::vector<std::vector<DMatch> > knnMatches;
+    index->knnSearch(queries, knnMatches, k);
+    ASSERT_EQ((size_t)queries.rows, knnMatches.size());
+
+    const int radius = 6;
+    std::vector<std::vector<DMatch> > radiusMatches;
+    index->radiusSearch(queries, radiusMatches, radius);
+    ASSERT_EQ((size_t)queries.rows, radiusMatches.size());
+
+    for(int i = 0; i < queries.rows; i++)
+    {
+        std::vector<std::pair<int, int> > expected = bruteForce(hashes, queries.row(i));
+
+        checkMatches(knnMatches[i], std::vector<std::pair<int, int> >(expected.begin(), expected.begin() + k), i);
+
+        size_t inRadius = 0;
+        while(inRadius < expected.size() && expected[inRadius].first <= radius)
+            inRadius++;
+        checkMatches(radiusMatches[i], std::vector<std::pair<int, int> >(expected.begin(), expected.begin() + inRadius), i);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, ImgHashIndex_Search, testing::Combine(
+    testing::Values(8, 32), // PHash, BlockMeanHash
+    testing::Values(0, 1, 4)
+));
+
+TEST(ImgHashIndex, serialization)
+{
+    Mat hashes, queries;
+    generateHashes(hashes, queries, 8);
+
+    Ptr<ImgHashIndex> index = ImgHashIndex::create();
+    index->add(hashes);
+
+    FileStorage fs("index.yml", FileStorage::WRITE | FileStorage::MEMORY);
+    index->write(fs);
+    std::string data = fs.releaseAndGetString();
+
+    Ptr<ImgHashIndex> loaded = ImgHashIndex::create();
+    FileStorage fs2(data, FileStorage::READ | FileStorage::MEMORY);
+    loaded->read(fs2.root());
+    ASSERT_EQ(index->size(), loaded->size());
+    EXPECT_EQ(0, cvtest::norm(index->getHashes(), loaded->getHashes(), NORM_INF));
+
+    std::vector<std::vector<DMatch> > matches, loadedMatches;
+    index->knnSearch(queries, matches, 3);
+    loaded->knnSearch(queries, loadedMatches, 3);
+    ASSERT_EQ(matches.size(), loadedMatches.size());
+    for(size_t i = 0; i < matches.size(); i++)
+    {
+        ASSERT_EQ(matches[i].size(), loadedMatches[i].size());
+        for(size_t j = 0; j < matches[i].size(); j++)
+        {
+            EXPECT_EQ(matches[i][j].trainIdx, loadedMatches[i][j].trainIdx);
+            EXPECT_EQ(matches[i][j].distance, loadedMatches[i][j].distance);
+        }
+    }
+}
+
+TEST(ImgHashIndex, concurrent_first_search)
+{
+    Mat hashes, queries;
+    generateHashes(hashes, queries, 8);
+
+    Ptr<ImgHashIndex> index = ImgHashIndex::create();
+    index->add(hashes.rowRange(0, hashes.rows / 2));
+    index->build();
+    // the tables are outdated, the first of the concurrent searches builds them
+    index->add(hashes.rowRange(hashes.rows / 2, hashes.rows));
+
+    const int nSearches = 8;
+    std::vector<std::vector<std::vector<DMatch> > > matches(nSearches);
+    parallel_for_(Range(0, nSearches), [&](const Range& range)
+    {
+        for(int t = range.start; t < range.end; t++)
+            index->radiusSearch(queries, matches[t], 4);
+    });
+
+    for(int t = 0; t < nSearches; t++)
+    {
+        ASSERT_EQ((size_t)queries.rows, matches[t].size());
+        for(int i = 0; i < queries.rows; i++)
+        {
+            std::vector<std::pair<int, int> > expected = bruteForce(hashes, queries.row(i));
+            size_t cnt = 0;
+            while(cnt < expected.size() && expected[cnt].first <= 4)
+                cnt++;
+            expected.resize(cnt);
+            checkMatches(matches[t][i], expected, i);
+        }
+    }
+}
+
+TEST(ImgHashIndex, add_images)
+{
+    Mat img(64, 64, CV_8UC3);
+    theRNG().fill(img, RNG::UNIFORM, 0, 256);
+    std::vector<Mat> images;
+    images.push_back(img);
+    images.push_back(255 - img);
+
+    Ptr<ImgHashBase> hasher = PHash::create();
+    Ptr<ImgHashIndex> index = ImgHashIndex::create();
+    index->addImages(hasher, images);
+    ASSERT_EQ(2, index->size());
+
+    Mat query;
+    hasher->compute(images[1], query);
+    std::vector<std::vector<DMatch> > matches;
+    index->radiusSearch(query, matches, 0);
+    ASSERT_EQ(1u, matches.size());
+    ASSERT_FALSE(matches[0].empty());
+    EXPECT_EQ(1, matches[0][0].trainIdx);
+
+    EXPECT_ANY_THROW(index->addImages(ColorMomentHash::create(), images));
+}
+
+}} // namespace
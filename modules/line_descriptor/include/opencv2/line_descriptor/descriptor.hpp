@@ -1094,6 +1094,36 @@ void radiusMatch( const Mat& queryDescriptors, std::vector<std::vector<DMatch> >
 std::vector<Mat>(),
 bool compactResult = false );
 
+/** @brief For every input query descriptor, retrieve the best *k* matching ones from the dataset internal
+to class. The queries are processed in parallel and the results are stored in matrices, which avoids
+creating a DMatch object for every match when the number of queries is large
+
+@param queryDescriptors query descriptors
+@param trainIdx output CV_32SC1 matrix with a row for every query and *k* columns, storing the indices of
+the matched descriptors in dataset sorted by distance; -1 where less than *k* descriptors were found
+@param distance output CV_32SC1 matrix of the same size, storing the Hamming distances of the matches
+(-1 where no descriptor was found)
+@param k number of the closest descriptors to be returned for every input query
+
+@note The image that a matched descriptor comes from can be retrieved from its index in dataset, the
+indices are assigned in the order the descriptors were added.
+ */
+CV_WRAP void knnMatchBatch( const Mat& queryDescriptors, CV_OUT Mat& trainIdx, CV_OUT Mat& distance, int k );
+
+/** @brief For every input query descriptor, retrieve from the dataset internal to class up to *maxMatches*
+closest descriptors that are not further than *maxDistance* from input query. The queries are processed
+in parallel and the search of every query stops at the given radius
+
+@param queryDescriptors query descriptors
+@param trainIdx output CV_32SC1 matrix with a row for every query and *maxMatches* columns, storing the
+indices of the matched descriptors in dataset sorted by distance; -1 where no more descriptors were found
+@param distance output CV_32SC1 matrix of the same size, storing the Hamming distances of the matches
+(-1 where no descriptor was found)
+@param maxDistance search radius
+@param maxMatches maximum number of the matches returned for every input query
+ */
+CV_WRAP void radiusMatchBatch( const Mat& queryDescriptors, CV_OUT Mat& trainIdx, CV_OUT Mat& distance, float maxDistance, int maxMatches );
+
 /** @brief Store locally new descriptors to be inserted in dataset, without updating dataset.
 
 @param descriptors matrices containing descriptors to be inserted into dataset
@@ -1290,18 +1320,12 @@ UINT64 N;
 /** Table of original full-length codes */
 cv::Mat codes;
 
-/** Counter for eliminating duplicate results (it is not thread safe) */
-Ptr<bitarray> counter;
-
 /** Array of m hashtables */
 std::vector<SparseHashtable> H;
 
 /** Volume of a b-bit Hamming ball with radius s (for s = 0 to d) */
 std::vector<UINT32> xornum;
 
-/** Used within generation of binary codes at a certain Hamming distance */
-int power[100];
-
 /** constructor */
 Mihasher();
 
@@ -1317,18 +1341,40 @@ void setK( int K );
 /** populate tables */
 void populate( cv::Mat & codes, UINT32 N, int dim1codes );
 
-/** execute a batch query */
-void batchquery( UINT32 * results, UINT32 *numres/*, qstat *stats*/, const cv::Mat & q, UINT32 numq, int dim1queries );
+/** execute a batch query, queries are processed in parallel;
+only the codes not further than radius are searched for, unless radius is negative */
+void batchquery( UINT32 * results, UINT32 *numres/*, qstat *stats*/, const cv::Mat & q, UINT32 numq, int dim1queries, int radius = -1 );
 
 private:
 
+/** Buffers of a single query, every thread has its own */
+struct QueryBuffers
+{
+  QueryBuffers( UINT64 N, int m, int B, int d );
+
+  /** Counter for eliminating duplicate results */
+  bitarray counter;
+
+  /** Substrings of the query */
+  std::vector<UINT64> chunks;
+
+  /** Results found so far, for every Hamming distance */
+  std::vector<std::vector<UINT32> > res;
+
+  /** Used within generation of binary codes at a certain Hamming distance */
+  std::vector<int> power;
+};
+
 /** execute a single query */
-void query( UINT32 * results, UINT32* numres/*, qstat *stats*/, UINT8 *q, UINT64 * chunks, UINT32 * res );
+void query( UINT32 * results, UINT32* numres/*, qstat *stats*/, const UINT8 *q, QueryBuffers& buffers, int radius );
 };
 
 /** retrieve Hamming distances */
 void checkKDistances( UINT32 * numres, int k, std::vector<int>& k_distances, int row, int string_length ) const;
 
+/** query dataset and store the results in matrices */
+void batchMatch( const Mat& queryDescriptors, Mat& trainIdx, Mat& distance, int k, int radius );
+
 /** matrix to store new descriptors */
 Mat descriptorsMat;
 
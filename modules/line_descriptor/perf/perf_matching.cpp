@@ -180,5 +180,34 @@ PERF_TEST(radius_match, radius_match_distances_test)
 
 }
 
+PERF_TEST(knn_matching, knn_match_batch)
+{
+  Mat query, train, trainIdx, distance;
+  Ptr<BinaryDescriptorMatcher> bd = BinaryDescriptorMatcher::createBinaryDescriptorMatcher();
+
+  generateData( query, train );
+  bd->add( std::vector<Mat>( 1, train ) );
+  bd->train();
+
+  TEST_CYCLE()
+    bd->knnMatchBatch( query, trainIdx, distance, COUNT_FACTOR );
+
+  SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST(radius_match, radius_match_batch)
+{
+  Mat query, train, trainIdx, distance;
+  Ptr<BinaryDescriptorMatcher> bd = BinaryDescriptorMatcher::createBinaryDescriptorMatcher();
+
+  generateData( query, train );
+  bd->add( std::vector<Mat>( 1, train ) );
+  bd->train();
+
+  TEST_CYCLE()
+    bd->radiusMatchBatch( query, trainIdx, distance, RADIUS, COUNT_FACTOR );
+
+  SANITY_CHECK_NOTHING();
+}
 
 }} // namespace
@@ -85,10 +85,13 @@ void BinaryDescriptorMatcher::train()
   if( !dataset )
     dataset = Ptr<Mihasher>(new Mihasher( 256, 32 ));
 
+  /* the dataset is kept when there is nothing new to insert */
   if( descriptorsMat.rows > 0 )
+  {
     dataset->populate( descriptorsMat, descriptorsMat.rows, descriptorsMat.cols );
+    descrInDS = descriptorsMat.rows;
+  }
 
-  descrInDS = descriptorsMat.rows;
   descriptorsMat.release();
 }
 
@@ -541,12 +544,12 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, std::vec
   int index = 0;
   for ( int counter = 0; counter < queryDescriptors.rows; counter++ )
   {
+    std::vector<int> k_distances;
+    checkKDistances( numres, descrInDS, k_distances, counter, 256 );
+
     std::vector < DMatch > tempVector;
     for ( int j = index; j < index + descrInDS; j++ )
     {
-      std::vector<int> k_distances;
-      checkKDistances( numres, descrInDS, k_distances, counter, 256 );
-
       if( k_distances[j - index] <= maxDistance )
       {
         int currentIndex = results[j] - 1;
@@ -592,50 +595,121 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, std::vec
 
 }
 
-/* execute a batch query */
-void BinaryDescriptorMatcher::Mihasher::batchquery( UINT32 * results, UINT32 *numres, const cv::Mat & queries, UINT32 numq, int dim1queries )
+/* for every input descriptor, find the best k matching ones
+ (from one image to a set), results are stored in matrices */
+void BinaryDescriptorMatcher::knnMatchBatch( const Mat& queryDescriptors, Mat& trainIdx, Mat& distance, int k )
+{
+  CV_Assert( k > 0 );
+  batchMatch( queryDescriptors, trainIdx, distance, k, -1 );
+}
+
+/* for every input descriptor, find up to maxMatches closest ones falling in a
+ certain matching radius (from one image to a set), results are stored in matrices */
+void BinaryDescriptorMatcher::radiusMatchBatch( const Mat& queryDescriptors, Mat& trainIdx, Mat& distance, float maxDistance, int maxMatches )
+{
+  CV_Assert( maxMatches > 0 );
+
+  /* distances are integers */
+  int radius = cvFloor( maxDistance );
+  if( radius < 0 )
+  {
+    trainIdx.create( queryDescriptors.rows, maxMatches, CV_32SC1 );
+    trainIdx.setTo( -1 );
+    trainIdx.copyTo( distance );
+    return;
+  }
+
+  batchMatch( queryDescriptors, trainIdx, distance, maxMatches, radius );
+}
+
+/* query dataset and store the results in matrices */
+void BinaryDescriptorMatcher::batchMatch( const Mat& queryDescriptors, Mat& trainIdx, Mat& distance, int k, int radius )
 {
-  /* create and initialize a bitarray */
-  counter = makePtr<bitarray>();
-  counter->init( N );
+  CV_Assert( queryDescriptors.type() == CV_8UC1 && queryDescriptors.cols == 32 );
+
+  /* add new descriptors to dataset, if needed */
+  train();
+
+  trainIdx.create( queryDescriptors.rows, k, CV_32SC1 );
+  distance.create( queryDescriptors.rows, k, CV_32SC1 );
+  trainIdx.setTo( -1 );
+  distance.setTo( -1 );
+
+  if( queryDescriptors.rows == 0 || descrInDS == 0 )
+    return;
 
-  UINT32 *res = new UINT32[K * ( D + 1 )];
-  UINT64 *chunks = new UINT64[m];
-  UINT32 * presults = results;
-  UINT32 *pnumres = numres;
+  /* set number of requested matches to return for each query */
+  dataset->setK( k );
 
-  /* make a copy of input queries */
-  cv::Mat queries_clone = queries.clone();
+  /* prepare structures for query */
+  std::vector<UINT32> results( (size_t) k * queryDescriptors.rows );
+  std::vector<UINT32> numres( (size_t) ( 256 + 1 ) * queryDescriptors.rows );
 
-  /* set a pointer to first query (row) */
-  UINT8 *pq = queries_clone.ptr();
+  /* execute query */
+  dataset->batchquery( results.data(), numres.data(), queryDescriptors, queryDescriptors.rows, queryDescriptors.cols, radius );
 
-  /* loop over number of descriptors */
-  for ( size_t i = 0; i < numq; i++ )
+  /* fill the output rows, distances follow from the numbers of codes found at every distance */
+  parallel_for_( Range( 0, queryDescriptors.rows ), [&]( const Range& range )
   {
-    /* for every descriptor, query database */
-    query( presults, pnumres, pq, chunks, res );
+    for ( int row = range.start; row < range.end; row++ )
+    {
+      const UINT32* presults = &results[(size_t) row * k];
+      const UINT32* pnumres = &numres[(size_t) row * ( 256 + 1 )];
+      int* pidx = trainIdx.ptr<int>( row );
+      int* pdist = distance.ptr<int>( row );
+      int maxd = radius >= 0 ? std::min( radius, 256 ) : 256;
+
+      int n = 0;
+      for ( int dist = 0; dist <= maxd && n < k; dist++ )
+      {
+        for ( UINT32 c = 0; c < pnumres[dist] && n < k; c++, n++ )
+        {
+          pidx[n] = (int) presults[n] - 1;
+          pdist[n] = dist;
+        }
+      }
+    }
+  } );
+}
 
-    /* move pointer to write next K indeces */
-    presults += K;
-    pnumres += B + 1;
+/* search buffers */
+BinaryDescriptorMatcher::Mihasher::QueryBuffers::QueryBuffers( UINT64 N_val, int m_val, int B_val, int d_val ) :
+    counter( N_val ), chunks( m_val ), res( B_val + 1 ), power( d_val + 2 )
+{
+}
 
-    /* move forward pointer to current row in descriptors matrix */
-    pq += dim1queries;
+/* execute a batch query */
+void BinaryDescriptorMatcher::Mihasher::batchquery( UINT32 * results, UINT32 *numres, const cv::Mat & queries, UINT32 numq, int dim1queries, int radius )
+{
+  CV_Assert( queries.rows >= (int) numq && queries.cols == dim1queries && queries.cols >= B_over_8 );
 
-  }
+  /* queries are independent, the index is only read */
+  parallel_for_( Range( 0, (int) numq ), [&]( const Range& range )
+  {
+    QueryBuffers buffers( N, m, B, d );
 
-  delete[] res;
-  delete[] chunks;
+    for ( int i = range.start; i < range.end; i++ )
+    {
+      /* for every descriptor, query database: K indices and B + 1 counters per query */
+      query( results + (size_t) i * K, numres + (size_t) i * ( B + 1 ), queries.ptr( i ), buffers, radius );
+    }
+  } );
 }
 
 /* execute a single query */
-void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres, UINT8 * Query, UINT64 *chunks, UINT32 *res )
+void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres, const UINT8 * Query, QueryBuffers& buffers, int radius )
 {
   /* if K == 0 that means we want everything to be processed.
    So maxres = N in that case. Otherwise K limits the results processed */
   UINT32 maxres = K ? K : (UINT32) N;
 
+  /* the codes further than maxd are not returned */
+  int maxd = radius >= 0 ? std::min( radius, D ) : D;
+
+  /* a code not further than maxd has at least one substring not further
+   than maxd / m from the query one, so the search can stop there */
+  int maxs = std::min( d, maxd / m );
+
   /* number of results so far obtained (up to a distance of s per chunk) */
   UINT32 n = 0;
 
@@ -644,8 +718,15 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
   UINT32 index;
   int hammd;
 
-  counter->erase();
+  bitarray& counter = buffers.counter;
+  UINT64* chunks = buffers.chunks.data();
+  std::vector<std::vector<UINT32> >& res = buffers.res;
+  int* power = buffers.power.data();
+
+  counter.erase();
   memset( numres, 0, ( B + 1 ) * sizeof ( *numres ) );
+  for ( size_t i = 0; i < res.size(); i++ )
+    res[i].clear();
 
   split( chunks, Query, m, mplus, b );
 
@@ -655,7 +736,7 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
   /* current b: for the first mplus substrings it is b, for the rest it is (b-1) */
   int curb = b;
 
-  for ( s = 0; s <= d && n < maxres; s++ )
+  for ( s = 0; s <= maxs && n < maxres; s++ )
   {
     for ( int k = 0; k < m; k++ )
     {
@@ -699,13 +780,16 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
             for ( int c = 0; c < size; c++ )
             {
               index = arr[c];
-              if( !counter->get( index ) )
+              if( !counter.get( index ) )
               { /* if it is not a duplicate */
-                counter->set( index );
+                counter.set( index );
                 hammd = cv::line_descriptor::match( codes.ptr() + (UINT64) index * ( B_over_8 ), Query, B_over_8 );
 
-                if( hammd <= D && numres[hammd] < maxres )
-                  res[hammd * K + numres[hammd]] = index + 1;
+                if( hammd > maxd )
+                  continue;
+
+                if( numres[hammd] < maxres )
+                  res[hammd].push_back( index + 1 );
 
                 numres[hammd]++;
               }
@@ -723,17 +807,20 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
         }
       }
 
-      n = n + numres[s * m + k];
+      /* all the codes not further than s * m + k are found at this point
+       (there are no codes further than B) */
+      if( s * m + k <= B )
+        n = n + numres[s * m + k];
       if( n >= maxres )
         break;
     }
   }
 
   n = 0;
-  for ( s = 0; s <= D && (int) n < K; s++ )
+  for ( s = 0; s <= maxd && (int) n < K; s++ )
   {
-    for ( int c = 0; c < (int) numres[s] && (int) n < K; c++ )
-      results[n++] = res[s * K + c];
+    for ( int c = 0; c < (int) res[s].size() && (int) n < K; c++ )
+      results[n++] = res[s][c];
   }
 
 }
@@ -743,6 +830,8 @@ BinaryDescriptorMatcher::Mihasher::Mihasher( int B_val, int _m )
 {
   B = B_val;
   B_over_8 = B / 8;
+  K = 0;
+  N = 0;
   m = _m;
   b = (int) ceil( (double) B / m );
 
@@ -44,6 +44,7 @@
 #define __OPENCV_BITOPTS_HPP
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #ifdef _MSC_VER
 #if defined(_M_ARM) || defined(_M_ARM64)
@@ -88,15 +89,21 @@ namespace cv
 namespace line_descriptor
 {
 /*matching function */
-inline int match( UINT8*P, UINT8*Q, int codelb )
+inline int match( const UINT8*P, const UINT8*Q, int codelb )
 {
-    int i, output = 0;
-    for( i = 0; i <= codelb - 16; i += 16 )
+    int i = 0, output = 0;
+#if CV_SIMD
+    v_uint64 t = vx_setzero_u64();
+    for( ; i <= codelb - v_uint8::nlanes; i += v_uint8::nlanes )
+        t += v_popcount( v_reinterpret_as_u64( vx_load( P + i ) ^ vx_load( Q + i ) ) );
+    output = (int) v_reduce_sum( t );
+#endif
+    for( ; i <= codelb - 16; i += 16 )
     {
-        output += popcnt( *(UINT32*) (P+i) ^ *(UINT32*) (Q+i) ) +
-                  popcnt( *(UINT32*) (P+i+4) ^ *(UINT32*) (Q+i+4) ) +
-                  popcnt( *(UINT32*) (P+i+8) ^ *(UINT32*) (Q+i+8) ) +
-                  popcnt( *(UINT32*) (P+i+12) ^ *(UINT32*) (Q+i+12) );
+        output += popcnt( *(const UINT32*) (P+i) ^ *(const UINT32*) (Q+i) ) +
+                  popcnt( *(const UINT32*) (P+i+4) ^ *(const UINT32*) (Q+i+4) ) +
+                  popcnt( *(const UINT32*) (P+i+8) ^ *(const UINT32*) (Q+i+8) ) +
+                  popcnt( *(const UINT32*) (P+i+12) ^ *(const UINT32*) (Q+i+12) );
     }
     for( ; i < codelb; i++ )
         output += lookup[P[i] ^ Q[i]];
@@ -104,7 +111,7 @@ inline int match( UINT8*P, UINT8*Q, int codelb )
 }
 
 /* splitting function (b <= 64) */
-inline void split( UINT64 *chunks, UINT8 *code, int m, int mplus, int b )
+inline void split( UINT64 *chunks, const UINT8 *code, int m, int mplus, int b )
 {
   UINT64 temp = 0x0;
   int nbits = 0;
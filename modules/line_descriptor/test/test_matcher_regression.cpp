@@ -65,6 +65,7 @@ class CV_BinaryDescriptorMatcherTest : public cvtest::BaseTest
   void matchTest( const Mat& query, const Mat& train );
   void knnMatchTest( const Mat& query, const Mat& train );
   void radiusMatchTest( const Mat& query, const Mat& train );
+  void batchMatchTest( const Mat& query, const Mat& train );
 
   std::string name;
   Ptr<BinaryDescriptorMatcher> dmatcher;
@@ -557,6 +558,83 @@ void CV_BinaryDescriptorMatcherTest::radiusMatchTest( const Mat& query, const Ma
   }
 }
 
+void CV_BinaryDescriptorMatcherTest::batchMatchTest( const Mat& query, const Mat& train )
+{
+  dmatcher->clear();
+  dmatcher->add( std::vector<Mat>( 1, train.rowRange( 0, train.rows / 2 ) ) );
+  dmatcher->add( std::vector<Mat>( 1, train.rowRange( train.rows / 2, train.rows ) ) );
+
+  // test knnMatchBatch()
+  {
+    const int knn = 3;
+    Mat trainIdx, distance;
+    dmatcher->knnMatchBatch( query, trainIdx, distance, knn );
+
+    if( trainIdx.rows != queryDescCount || trainIdx.cols != knn || trainIdx.type() != CV_32SC1 || distance.size() != trainIdx.size()
+        || distance.type() != CV_32SC1 )
+    {
+      ts->printf( cvtest::TS::LOG, "Incorrect output size while test knnMatchBatch() function.\n" );
+      ts->set_failed_test_info( cvtest::TS::FAIL_INVALID_OUTPUT );
+      return;
+    }
+
+    int badCount = 0;
+    for ( int i = 0; i < queryDescCount; i++ )
+    {
+      int localBadCount = 0;
+      for ( int k = 0; k < knn; k++ )
+      {
+        // k-th closest descriptor has k+1 bits inverted
+        if( trainIdx.at<int>( i, k ) != i * countFactor + k || distance.at<int>( i, k ) != k + 1 )
+          localBadCount++;
+      }
+      badCount += localBadCount > 0 ? 1 : 0;
+    }
+
+    if( (float) badCount > (float) queryDescCount * badPart )
+    {
+      ts->printf( cvtest::TS::LOG, "%f - too large bad matches part while test knnMatchBatch() function.\n",
+                  (float) badCount / (float) queryDescCount );
+      ts->set_failed_test_info( cvtest::TS::FAIL_BAD_ACCURACY );
+    }
+  }
+
+  // test radiusMatchBatch()
+  {
+    const int radius = 2;
+    const int maxMatches = countFactor;
+    Mat trainIdx, distance;
+    dmatcher->radiusMatchBatch( query, trainIdx, distance, (float) radius, maxMatches );
+
+    if( trainIdx.rows != queryDescCount || trainIdx.cols != maxMatches || distance.size() != trainIdx.size() )
+    {
+      ts->printf( cvtest::TS::LOG, "Incorrect output size while test radiusMatchBatch() function.\n" );
+      ts->set_failed_test_info( cvtest::TS::FAIL_INVALID_OUTPUT );
+      return;
+    }
+
+    int badCount = 0;
+    for ( int i = 0; i < queryDescCount; i++ )
+    {
+      int localBadCount = 0;
+      for ( int k = 0; k < maxMatches; k++ )
+      {
+        bool inRadius = k < radius;
+        if( trainIdx.at<int>( i, k ) != ( inRadius ? i * countFactor + k : -1 ) || distance.at<int>( i, k ) != ( inRadius ? k + 1 : -1 ) )
+          localBadCount++;
+      }
+      badCount += localBadCount > 0 ? 1 : 0;
+    }
+
+    if( (float) badCount > (float) queryDescCount * badPart )
+    {
+      ts->printf( cvtest::TS::LOG, "%f - too large bad matches part while test radiusMatchBatch() function.\n",
+                  (float) badCount / (float) queryDescCount );
+      ts->set_failed_test_info( cvtest::TS::FAIL_BAD_ACCURACY );
+    }
+  }
+}
+
 void CV_BinaryDescriptorMatcherTest::run( int )
 {
   Mat query, train;
@@ -565,6 +643,7 @@ void CV_BinaryDescriptorMatcherTest::run( int )
   matchTest( query, train );
   knnMatchTest( query, train );
   radiusMatchTest( query, train );
+  batchMatchTest( query, train );
 }
 
 /****************************************************************************************\
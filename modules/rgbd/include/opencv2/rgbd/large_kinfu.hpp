@@ -85,6 +85,19 @@ struct CV_EXPORTS_W Params
     /** @brief Volume parameters
     */
     kinfu::VolumeParams volumeParams;
+
+    /** @brief Memory budget for the volumes of the submaps in megabytes
+        Volumes of inactive submaps are written to the disk and released,
+        starting from the least recently used ones, when the resident volumes exceed the budget.
+        They are read back when the submaps are revisited.
+        0 keeps all the submaps in memory.
+    */
+    CV_PROP_RW int submapMemoryBudget;
+
+    /** @brief Directory for the volumes of evicted submaps
+        Temporary files are used when empty.
+    */
+    CV_PROP_RW String submapStorageDir;
 };
 
 /** @brief Large Scale Dense Depth Fusion implementation
@@ -5,6 +5,7 @@
 #include "hash_tsdf.hpp"
 
 #include <atomic>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <limits>
@@ -63,20 +64,29 @@ HashTSDFVolume::HashTSDFVolume(float _voxelSize, cv::Matx44f _pose, float _rayca
     volStrides = Vec4i(xdim, ydim, zdim);
 }
 
-//! Spatial hashing
-struct tsdf_hash
+static const char volumeUnitsMagic[8] = "CVHTSDF";
+static const int volumeUnitsVersion = 1;
+
+void HashTSDFVolume::writeVolumeUnitsHeader(std::ostream& out, int nUnits) const
 {
-    size_t operator()(const Vec3i& x) const noexcept
-    {
-        size_t seed = 0;
-        constexpr uint32_t GOLDEN_RATIO = 0x9e3779b9;
-        for (uint16_t i = 0; i < 3; i++)
-        {
-            seed ^= std::hash<int>()(x[i]) + GOLDEN_RATIO + (seed << 6) + (seed >> 2);
-        }
-        return seed;
-    }
-};
+    const int fields[4] = { volumeUnitsVersion, volumeUnitResolution, int(zFirstMemOrder), nUnits };
+    out.write(volumeUnitsMagic, sizeof(volumeUnitsMagic));
+    out.write((const char*)fields, sizeof(fields));
+}
+
+int HashTSDFVolume::readVolumeUnitsHeader(std::istream& in) const
+{
+    char magic[sizeof(volumeUnitsMagic)];
+    int fields[4];
+    in.read(magic, sizeof(magic));
+    in.read((char*)fields, sizeof(fields));
+    if (!in || memcmp(magic, volumeUnitsMagic, sizeof(magic)) != 0 || fields[0] != volumeUnitsVersion)
+        CV_Error(Error::StsParseError, "Unknown volume units format");
+    if (fields[1] != volumeUnitResolution || fields[2] != int(zFirstMemOrder))
+        CV_Error(Error::StsBadArg, "Volume units were written by a volume with different memory layout");
+    CV_Assert(fields[3] >= 0);
+    return fields[3];
+}
 
 struct VolumeUnit
 {
@@ -87,9 +97,6 @@ struct VolumeUnit
     bool isActive;
 };
 
-typedef std::unordered_set<cv::Vec3i, tsdf_hash> VolumeUnitIndexSet;
-typedef std::unordered_map<cv::Vec3i, VolumeUnit, tsdf_hash> VolumeUnitIndexes;
-
 class HashTSDFVolumeCPU : public HashTSDFVolume
 {
 public:
@@ -114,6 +121,9 @@ public:
     size_t getTotalVolumeUnits() const override { return volumeUnits.size(); }
     int getVisibleBlocks(int currFrameId, int frameThreshold) const override;
 
+    void writeVolumeUnits(std::ostream& out) const override;
+    void readVolumeUnits(std::istream& in) override;
+
     //! Return the voxel given the voxel index in the universal volume (1 unit = 1 voxel_length)
     TsdfVoxel at(const Vec3i& volumeIdx) const;
 
@@ -122,7 +132,7 @@ public:
     virtual TsdfVoxel at(const cv::Point3f& point) const;
     virtual TsdfVoxel _at(const cv::Vec3i& volumeIdx, int indx) const;
 
-    TsdfVoxel atVolumeUnit(const Vec3i& point, const Vec3i& volumeUnitIdx, VolumeUnitIndexes::const_iterator it) const;
+    TsdfVoxel atVolumeUnit(const Vec3i& point, const Vec3i& volumeUnitIdx, int indx) const;
 
 
     float interpolateVoxelPoint(const Point3f& point) const;
@@ -139,9 +149,11 @@ public:
 public:
     Vec6f frameParams;
     Mat pixNorms;
-    VolumeUnitIndexes volumeUnits;
+    //! maps the coordinates of the allocated volume units to their indices
+    VolumeUnitHashTable volumeUnitsTable;
+    //! volume units and the rows of their voxels in volUnitsData, by index
+    std::vector<VolumeUnit> volumeUnits;
     cv::Mat volUnitsData;
-    int lastVolIndex;
 };
 
 
@@ -163,11 +175,11 @@ HashTSDFVolumeCPU::HashTSDFVolumeCPU(const VolumeParams& _params, bool _zFirstMe
 void HashTSDFVolumeCPU::reset()
 {
     CV_TRACE_FUNCTION();
-    lastVolIndex = 0;
     volUnitsData = cv::Mat(VOLUMES_SIZE, volumeUnitResolution * volumeUnitResolution * volumeUnitResolution, rawType<TsdfVoxel>());
     frameParams = Vec6f();
     pixNorms = Mat();
-    volumeUnits = VolumeUnitIndexes();
+    volumeUnitsTable.reset();
+    volumeUnits.clear();
 }
 
 void HashTSDFVolumeCPU::integrate(InputArray _depth, float depthFactor, const Matx44f& cameraPose, const Intr& intrinsics, const int frameId)
@@ -183,12 +195,13 @@ void HashTSDFVolumeCPU::integrate(InputArray _depth, float depthFactor, const Ma
     const Intr::Reprojector reproj(intrinsics.makeReprojector());
     const Affine3f cam2vol(pose.inv() * Affine3f(cameraPose));
     const Point3f truncPt(truncDist, truncDist, truncDist);
-    VolumeUnitIndexSet newIndices;
-    Mutex mutex;
     Range allocateRange(0, depth.rows);
+    const int oldVolumeUnits = volumeUnitsTable.size();
+    std::atomic<bool> needReallocation(false);
 
+    //! Volume units touched by the frame are inserted right away without locking,
+    //! the new ones get consecutive indices after the existing ones
     auto AllocateVolumeUnitsInvoker = [&](const Range& range) {
-        VolumeUnitIndexSet localAccessVolUnits;
         for (int y = range.start; y < range.end; y += depthStride)
         {
             const depthType* depthRow = depth[y];
@@ -207,86 +220,90 @@ void HashTSDFVolumeCPU::integrate(InputArray _depth, float depthFactor, const Ma
                     for (int j = lower_bound[1]; j <= upper_bound[1]; j++)
                         for (int k = lower_bound[2]; k <= upper_bound[2]; k++)
                         {
-                            const Vec3i tsdf_idx = Vec3i(i, j, k);
-                            if (localAccessVolUnits.count(tsdf_idx) <= 0 && this->volumeUnits.count(tsdf_idx) <= 0)
+                            int index;
+                            if (!volumeUnitsTable.insert(Vec3i(i, j, k), index))
                             {
-                                //! This volume unit will definitely be required for current integration
-                                localAccessVolUnits.emplace(tsdf_idx);
+                                needReallocation = true;
+                                return;
                             }
                         }
             }
         }
+    };
 
-        mutex.lock();
-        for (const auto& tsdf_idx : localAccessVolUnits)
+    //! Units inserted before the table got full stay in it, the pass is simply repeated
+    do
+    {
+        if (needReallocation)
         {
-            //! If the insert into the global set passes
-            if (!newIndices.count(tsdf_idx))
-            {
-                // Volume allocation can be performed outside of the lock
-                newIndices.emplace(tsdf_idx);
-            }
+            volumeUnitsTable.rehash(volumeUnitsTable.capacity() * 2);
+            needReallocation = false;
         }
-        mutex.unlock();
-    };
-    parallel_for_(allocateRange, AllocateVolumeUnitsInvoker);
+
+        parallel_for_(allocateRange, AllocateVolumeUnitsInvoker);
+    } while (needReallocation);
 
     //! Perform the allocation
-    for (auto idx : newIndices)
+    const int totalVolumeUnits = volumeUnitsTable.size();
+    if (totalVolumeUnits > oldVolumeUnits)
     {
-        VolumeUnit& vu = this->volumeUnits.emplace(idx, VolumeUnit()).first->second;
-
-        Matx44f subvolumePose = pose.translate(volumeUnitIdxToVolume(idx)).matrix;
-
-        vu.pose = subvolumePose;
-        vu.index = lastVolIndex; lastVolIndex++;
-        if (lastVolIndex > int(volUnitsData.size().height))
+        volumeUnits.resize(totalVolumeUnits);
+        if (totalVolumeUnits > volUnitsData.rows)
         {
-            volUnitsData.resize((lastVolIndex - 1) * 2);
+            int rows = volUnitsData.rows;
+            while (rows < totalVolumeUnits)
+                rows *= 2;
+            volUnitsData.resize(rows);
         }
-        volUnitsData.row(vu.index).forEach<VecTsdfVoxel>([](VecTsdfVoxel& vv, const int* /* position */)
+
+        volumeUnitsTable.forEach([&](const Vec3i& idx, int index)
+        {
+            if (index >= oldVolumeUnits)
+                volumeUnits[index].coord = idx;
+        });
+
+        parallel_for_(Range(oldVolumeUnits, totalVolumeUnits), [&](const Range& range) {
+            for (int i = range.start; i < range.end; i++)
             {
-                TsdfVoxel& v = reinterpret_cast<TsdfVoxel&>(vv);
-                v.tsdf = floatToTsdf(0.0f); v.weight = 0;
-            });
-        //! This volume unit will definitely be required for current integration
-        vu.lastVisibleIndex = frameId;
-        vu.isActive = true;
-    }
+                VolumeUnit& vu = volumeUnits[i];
+                vu.pose = pose.translate(volumeUnitIdxToVolume(vu.coord)).matrix;
+                vu.index = i;
 
-    //! Get keys for all the allocated volume Units
-    std::vector<Vec3i> totalVolUnits;
-    for (const auto& keyvalue : volumeUnits)
-    {
-        totalVolUnits.push_back(keyvalue.first);
+                TsdfVoxel* voxels = volUnitsData.ptr<TsdfVoxel>(i);
+                for (int v = 0; v < volUnitsData.cols; v++)
+                {
+                    voxels[v].tsdf = floatToTsdf(0.0f);
+                    voxels[v].weight = 0;
+                }
+                //! This volume unit will definitely be required for current integration
+                vu.lastVisibleIndex = frameId;
+                vu.isActive = true;
+            }
+        });
     }
 
     //! Mark volumes in the camera frustum as active
-    Range inFrustumRange(0, (int)volumeUnits.size());
+    Range inFrustumRange(0, totalVolumeUnits);
     parallel_for_(inFrustumRange, [&](const Range& range) {
         const Affine3f vol2cam(Affine3f(cameraPose.inv()) * pose);
         const Intr::Projector proj(intrinsics.makeProjector());
 
         for (int i = range.start; i < range.end; ++i)
         {
-            Vec3i tsdf_idx = totalVolUnits[i];
-            VolumeUnitIndexes::iterator it = volumeUnits.find(tsdf_idx);
-            if (it == volumeUnits.end())
-                continue;
+            VolumeUnit& volumeUnit = volumeUnits[i];
 
-            Point3f volumeUnitPos = volumeUnitIdxToVolume(it->first);
+            Point3f volumeUnitPos = volumeUnitIdxToVolume(volumeUnit.coord);
             Point3f volUnitInCamSpace = vol2cam * volumeUnitPos;
             if (volUnitInCamSpace.z < 0 || volUnitInCamSpace.z > truncateThreshold)
             {
-                it->second.isActive = false;
+                volumeUnit.isActive = false;
                 continue;
             }
             Point2f cameraPoint = proj(volUnitInCamSpace);
             if (cameraPoint.x >= 0 && cameraPoint.y >= 0 && cameraPoint.x < depth.cols && cameraPoint.y < depth.rows)
             {
-                assert(it != volumeUnits.end());
-                it->second.lastVisibleIndex = frameId;
-                it->second.isActive         = true;
+                volumeUnit.lastVisibleIndex = frameId;
+                volumeUnit.isActive         = true;
             }
         }
         });
@@ -301,15 +318,10 @@ void HashTSDFVolumeCPU::integrate(InputArray _depth, float depthFactor, const Ma
     }
 
     //! Integrate the correct volumeUnits
-    parallel_for_(Range(0, (int)totalVolUnits.size()), [&](const Range& range) {
+    parallel_for_(Range(0, totalVolumeUnits), [&](const Range& range) {
         for (int i = range.start; i < range.end; i++)
         {
-            Vec3i tsdf_idx = totalVolUnits[i];
-            VolumeUnitIndexes::iterator it = volumeUnits.find(tsdf_idx);
-            if (it == volumeUnits.end())
-                return;
-
-            VolumeUnit& volumeUnit = it->second;
+            VolumeUnit& volumeUnit = volumeUnits[i];
             if (volumeUnit.isActive)
             {
                 //! The volume unit should already be added into the Volume from the allocator
@@ -369,9 +381,9 @@ inline TsdfVoxel HashTSDFVolumeCPU::at(const cv::Vec3i& volumeIdx) const
                                 volumeIdx[1] >> volumeUnitDegree,
                                 volumeIdx[2] >> volumeUnitDegree);
 
-    VolumeUnitIndexes::const_iterator it = volumeUnits.find(volumeUnitIdx);
+    int indx = volumeUnitsTable.find(volumeUnitIdx);
 
-    if (it == volumeUnits.end())
+    if (indx < 0)
     {
         return TsdfVoxel(floatToTsdf(1.f), 0);
     }
@@ -382,16 +394,16 @@ inline TsdfVoxel HashTSDFVolumeCPU::at(const cv::Vec3i& volumeIdx) const
 
     volUnitLocalIdx =
         cv::Vec3i(abs(volUnitLocalIdx[0]), abs(volUnitLocalIdx[1]), abs(volUnitLocalIdx[2]));
-    return _at(volUnitLocalIdx, it->second.index);
+    return _at(volUnitLocalIdx, indx);
 
 }
 
 TsdfVoxel HashTSDFVolumeCPU::at(const Point3f& point) const
 {
     cv::Vec3i volumeUnitIdx = volumeToVolumeUnitIdx(point);
-    VolumeUnitIndexes::const_iterator it = volumeUnits.find(volumeUnitIdx);
+    int indx = volumeUnitsTable.find(volumeUnitIdx);
 
-    if (it == volumeUnits.end())
+    if (indx < 0)
     {
         return TsdfVoxel(floatToTsdf(1.f), 0);
     }
@@ -400,12 +412,12 @@ TsdfVoxel HashTSDFVolumeCPU::at(const Point3f& point) const
     cv::Vec3i volUnitLocalIdx = volumeToVoxelCoord(point - volumeUnitPos);
     volUnitLocalIdx =
         cv::Vec3i(abs(volUnitLocalIdx[0]), abs(volUnitLocalIdx[1]), abs(volUnitLocalIdx[2]));
-    return _at(volUnitLocalIdx, it->second.index);
+    return _at(volUnitLocalIdx, indx);
 }
 
-TsdfVoxel HashTSDFVolumeCPU::atVolumeUnit(const Vec3i& point, const Vec3i& volumeUnitIdx, VolumeUnitIndexes::const_iterator it) const
+TsdfVoxel HashTSDFVolumeCPU::atVolumeUnit(const Vec3i& point, const Vec3i& volumeUnitIdx, int indx) const
 {
-    if (it == volumeUnits.end())
+    if (indx < 0)
     {
         return TsdfVoxel(floatToTsdf(1.f), 0);
     }
@@ -414,7 +426,7 @@ TsdfVoxel HashTSDFVolumeCPU::atVolumeUnit(const Vec3i& point, const Vec3i& volum
                                           volumeUnitIdx[2] << volumeUnitDegree);
 
     // expanding at(), removing bounds check
-    const TsdfVoxel* volData = volUnitsData.ptr<TsdfVoxel>(it->second.index);
+    const TsdfVoxel* volData = volUnitsData.ptr<TsdfVoxel>(indx);
     int coordBase = volUnitLocalIdx[0] * volStrides[0] + volUnitLocalIdx[1] * volStrides[1] + volUnitLocalIdx[2] * volStrides[2];
     return volData[coordBase];
 }
@@ -460,10 +472,10 @@ float HashTSDFVolumeCPU::interpolateVoxelPoint(const Point3f& point) const
 
     // A small hash table to reduce a number of find() calls
     bool queried[8];
-    VolumeUnitIndexes::const_iterator iterMap[8];
+    int iterMap[8];
     for (int i = 0; i < 8; i++)
     {
-        iterMap[i] = volumeUnits.end();
+        iterMap[i] = -1;
         queried[i] = false;
     }
 
@@ -483,10 +495,10 @@ float HashTSDFVolumeCPU::interpolateVoxelPoint(const Point3f& point) const
 
         Vec3i volumeUnitIdx = Vec3i(pt[0] >> volumeUnitDegree, pt[1] >> volumeUnitDegree, pt[2] >> volumeUnitDegree);
         int dictIdx = (volumeUnitIdx[0] & 1) + (volumeUnitIdx[1] & 1) * 2 + (volumeUnitIdx[2] & 1) * 4;
-        auto it = iterMap[dictIdx];
+        int it = iterMap[dictIdx];
         if (!queried[dictIdx])
         {
-            it = volumeUnits.find(volumeUnitIdx);
+            it = volumeUnitsTable.find(volumeUnitIdx);
             iterMap[dictIdx] = it;
             queried[dictIdx] = true;
         }
@@ -512,10 +524,10 @@ Point3f HashTSDFVolumeCPU::getNormalVoxel(const Point3f &point) const
 
     // A small hash table to reduce a number of find() calls
     bool queried[8];
-    VolumeUnitIndexes::const_iterator iterMap[8];
+    int iterMap[8];
     for (int i = 0; i < 8; i++)
     {
-        iterMap[i] = volumeUnits.end();
+        iterMap[i] = -1;
         queried[i] = false;
     }
 
@@ -546,10 +558,10 @@ Point3f HashTSDFVolumeCPU::getNormalVoxel(const Point3f &point) const
         Vec3i volumeUnitIdx = Vec3i(pt[0] >> volumeUnitDegree, pt[1] >> volumeUnitDegree, pt[2] >> volumeUnitDegree);
 
         int dictIdx = (volumeUnitIdx[0] & 1) + (volumeUnitIdx[1] & 1) * 2 + (volumeUnitIdx[2] & 1) * 4;
-        auto it = iterMap[dictIdx];
+        int it = iterMap[dictIdx];
         if (!queried[dictIdx])
         {
-            it = volumeUnits.find(volumeUnitIdx);
+            it = volumeUnitsTable.find(volumeUnitIdx);
             iterMap[dictIdx] = it;
             queried[dictIdx] = true;
         }
@@ -695,13 +707,15 @@ void HashTSDFVolumeCPU::raycast(const Matx44f& cameraPose, const kinfu::Intr& in
 
                 float tprev = tcurr;
                 float prevTsdf = volume.truncDist;
-                Ptr<TSDFVolumeCPU> currVolumeUnit;
+                //! consecutive samples mostly fall into the same volume unit, so the last lookup is reused
+                int prevVolumeUnitIndex = -1;
                 while (tcurr < tmax)
                 {
                     Point3f currRayPos = orig + tcurr * rayDirV;
                     cv::Vec3i currVolumeUnitIdx = volume.volumeToVolumeUnitIdx(currRayPos);
 
-                    VolumeUnitIndexes::const_iterator it = volume.volumeUnits.find(currVolumeUnitIdx);
+                    int currVolumeUnitIndex = (currVolumeUnitIdx == prevVolumeUnitIdx) ? prevVolumeUnitIndex :
+                                              volume.volumeUnitsTable.find(currVolumeUnitIdx);
 
                     float currTsdf = prevTsdf;
                     int currWeight = 0;
@@ -710,14 +724,14 @@ void HashTSDFVolumeCPU::raycast(const Matx44f& cameraPose, const kinfu::Intr& in
 
 
                     //! The subvolume exists in hashtable
-                    if (it != volume.volumeUnits.end())
+                    if (currVolumeUnitIndex >= 0)
                     {
                         cv::Point3f currVolUnitPos =
                             volume.volumeUnitIdxToVolume(currVolumeUnitIdx);
                         volUnitLocalIdx = volume.volumeToVoxelCoord(currRayPos - currVolUnitPos);
 
                         //! TODO: Figure out voxel interpolation
-                        TsdfVoxel currVoxel = _at(volUnitLocalIdx, it->second.index);
+                        TsdfVoxel currVoxel = _at(volUnitLocalIdx, currVolumeUnitIndex);
                         currTsdf = tsdfToFloat(currVoxel.tsdf);
                         currWeight = currVoxel.weight;
                         stepSize = tstep;
@@ -740,6 +754,7 @@ void HashTSDFVolumeCPU::raycast(const Matx44f& cameraPose, const kinfu::Intr& in
                         break;
                     }
                     prevVolumeUnitIdx = currVolumeUnitIdx;
+                    prevVolumeUnitIndex = currVolumeUnitIndex;
                     prevTsdf = currTsdf;
                     tprev = tcurr;
                     tcurr += stepSize;
@@ -761,12 +776,7 @@ void HashTSDFVolumeCPU::fetchPointsNormals(OutputArray _points, OutputArray _nor
     {
         std::vector<std::vector<ptype>> pVecs, nVecs;
 
-        std::vector<Vec3i> totalVolUnits;
-        for (const auto& keyvalue : volumeUnits)
-        {
-            totalVolUnits.push_back(keyvalue.first);
-        }
-        Range fetchRange(0, (int)totalVolUnits.size());
+        Range fetchRange(0, (int)volumeUnits.size());
         const int nstripes = -1;
 
         const HashTSDFVolumeCPU& volume(*this);
@@ -778,11 +788,8 @@ void HashTSDFVolumeCPU::fetchPointsNormals(OutputArray _points, OutputArray _nor
             std::vector<ptype> points, normals;
             for (int i = range.start; i < range.end; i++)
             {
-                cv::Vec3i tsdf_idx = totalVolUnits[i];
-
-                VolumeUnitIndexes::const_iterator it = volume.volumeUnits.find(tsdf_idx);
-                Point3f base_point = volume.volumeUnitIdxToVolume(tsdf_idx);
-                if (it != volume.volumeUnits.end())
+                const VolumeUnit& volumeUnit = volume.volumeUnits[i];
+                Point3f base_point = volume.volumeUnitIdxToVolume(volumeUnit.coord);
                 {
                     std::vector<ptype> localPoints;
                     std::vector<ptype> localNormals;
@@ -791,7 +798,7 @@ void HashTSDFVolumeCPU::fetchPointsNormals(OutputArray _points, OutputArray _nor
                             for (int z = 0; z < volume.volumeUnitResolution; z++)
                             {
                                 cv::Vec3i voxelIdx(x, y, z);
-                                TsdfVoxel voxel = _at(voxelIdx, it->second.index);
+                                TsdfVoxel voxel = _at(voxelIdx, volumeUnit.index);
 
                                 if (voxel.tsdf != -128 && voxel.weight != 0)
                                 {
@@ -867,15 +874,68 @@ int HashTSDFVolumeCPU::getVisibleBlocks(int currFrameId, int frameThreshold) con
 {
     int numVisibleBlocks = 0;
     //! TODO: Iterate over map parallely?
-    for (const auto& keyvalue : volumeUnits)
+    for (const VolumeUnit& volumeUnit : volumeUnits)
     {
-        const VolumeUnit& volumeUnit = keyvalue.second;
         if (volumeUnit.lastVisibleIndex > (currFrameId - frameThreshold))
             numVisibleBlocks++;
     }
     return numVisibleBlocks;
 }
 
+void HashTSDFVolumeCPU::writeVolumeUnits(std::ostream& out) const
+{
+    CV_TRACE_FUNCTION();
+
+    //! Unobserved units are written too: raycast steps differently through
+    //! allocated and missing units, so dropping them would change the result
+    writeVolumeUnitsHeader(out, (int)volumeUnits.size());
+    const size_t rowSize = volUnitsData.cols * sizeof(TsdfVoxel);
+    for (const VolumeUnit& volumeUnit : volumeUnits)
+    {
+        const int indx = volumeUnit.index;
+        out.write((const char*)volumeUnit.coord.val, sizeof(volumeUnit.coord.val));
+        out.write((const char*)&volumeUnit.lastVisibleIndex, sizeof(volumeUnit.lastVisibleIndex));
+        out.write(volUnitsData.ptr<char>(indx), rowSize);
+    }
+
+    if (!out)
+        CV_Error(Error::StsError, "Failed to write volume units");
+}
+
+void HashTSDFVolumeCPU::readVolumeUnits(std::istream& in)
+{
+    CV_TRACE_FUNCTION();
+
+    const int nUnits = readVolumeUnitsHeader(in);
+    reset();
+
+    int capacity = VolumeUnitHashTable::startCapacity;
+    while (nUnits >= capacity - capacity / 4)
+        capacity *= 2;
+    volumeUnitsTable.reset(capacity);
+
+    volumeUnits.resize(nUnits);
+    if (nUnits > volUnitsData.rows)
+        volUnitsData.create(nUnits, volUnitsData.cols, volUnitsData.type());
+
+    const size_t rowSize = volUnitsData.cols * sizeof(TsdfVoxel);
+    for (int i = 0; i < nUnits; i++)
+    {
+        VolumeUnit& volumeUnit = volumeUnits[i];
+        in.read((char*)volumeUnit.coord.val, sizeof(volumeUnit.coord.val));
+        in.read((char*)&volumeUnit.lastVisibleIndex, sizeof(volumeUnit.lastVisibleIndex));
+        in.read(volUnitsData.ptr<char>(i), rowSize);
+        if (!in)
+            CV_Error(Error::StsParseError, "Unexpected end of volume units data");
+
+        //! Units are inserted one by one, so they keep the order they were written in
+        if (volumeUnitsTable.insert(volumeUnit.coord, volumeUnit.index) != 1)
+            CV_Error(Error::StsParseError, "Duplicate volume unit");
+        volumeUnit.pose = pose.translate(volumeUnitIdxToVolume(volumeUnit.coord)).matrix;
+        volumeUnit.isActive = false;
+    }
+}
+
 
 ///////// GPU implementation /////////
 
@@ -912,6 +972,9 @@ public:
     size_t getTotalVolumeUnits() const override { return size_t(hashTable.last); }
     int getVisibleBlocks(int currFrameId, int frameThreshold) const override;
 
+    void writeVolumeUnits(std::ostream& out) const override;
+    void readVolumeUnits(std::istream& in) override;
+
 
 
     //! Return the voxel given the point in volume coordinate system i.e., (metric scale 1 unit =
@@ -1767,6 +1830,80 @@ int HashTSDFVolumeGPU::getVisibleBlocks(int currFrameId, int frameThreshold) con
     return numVisibleBlocks;
 }
 
+void HashTSDFVolumeGPU::writeVolumeUnits(std::ostream& out) const
+{
+    CV_TRACE_FUNCTION();
+
+    Mat cpuData = volUnitsData.getMat(ACCESS_READ);
+    Mat cpuIndices = lastVisibleIndices.getMat(ACCESS_READ);
+
+    //! All allocated units are written, see HashTSDFVolumeCPU::writeVolumeUnits
+    writeVolumeUnitsHeader(out, hashTable.last);
+    const size_t rowSize = cpuData.cols * sizeof(TsdfVoxel);
+    for (int indx = 0; indx < hashTable.last; indx++)
+    {
+        const Vec4i& node = hashTable.data[indx];
+        out.write((const char*)node.val, 3 * sizeof(int));
+        out.write((const char*)cpuIndices.ptr<int>(indx), sizeof(int));
+        out.write(cpuData.ptr<char>(indx), rowSize);
+    }
+
+    if (!out)
+        CV_Error(Error::StsError, "Failed to write volume units");
+}
+
+void HashTSDFVolumeGPU::readVolumeUnits(std::istream& in)
+{
+    CV_TRACE_FUNCTION();
+
+    const int nUnits = readVolumeUnitsHeader(in);
+    reset();
+
+    int volCubed = volumeUnitResolution * volumeUnitResolution * volumeUnitResolution;
+    Mat cpuData(nUnits, volCubed, CV_8UC2);
+    Mat cpuIndices(nUnits, 1, CV_32S);
+    for (int i = 0; i < nUnits; i++)
+    {
+        Vec3i idx;
+        in.read((char*)idx.val, sizeof(idx.val));
+        in.read((char*)cpuIndices.ptr<int>(i), sizeof(int));
+        in.read(cpuData.ptr<char>(i), cpuData.cols * sizeof(TsdfVoxel));
+        if (!in)
+            CV_Error(Error::StsParseError, "Unexpected end of volume units data");
+
+        //! Units are inserted one by one, so they keep the order they were written in
+        int result;
+        while ((result = hashTable.insert(idx)) == 0)
+        {
+            hashTable.capacity *= 2;
+            hashTable.data.resize(hashTable.capacity);
+        }
+        if (result != 1)
+            CV_Error(Error::StsParseError, "Duplicate volume unit");
+    }
+
+    int buff_lvl = (int)(1 << bufferSizeDegree);
+    if (nUnits >= buff_lvl)
+    {
+        bufferSizeDegree = (int)(log2(nUnits) + 1);
+        buff_lvl = (int)(1 << bufferSizeDegree);
+
+        volUnitsDataCopy.create(buff_lvl, volCubed, rawType<TsdfVoxel>());
+        volUnitsData.create(buff_lvl, volCubed, CV_8UC2);
+        lastVisibleIndices.create(buff_lvl, 1, CV_32S);
+        isActiveFlags.create(buff_lvl, 1, CV_8U);
+    }
+
+    if (nUnits > 0)
+    {
+        Range r(0, nUnits);
+        cpuData.copyTo(volUnitsData.rowRange(r));
+        cpuData.copyTo(volUnitsDataCopy.rowRange(r));
+        cpuIndices.copyTo(lastVisibleIndices.rowRange(r));
+        isActiveFlags.rowRange(r).setTo(Scalar(0));
+    }
+}
+
 #endif
 
 //template<typename T>
@@ -6,6 +6,7 @@
 #define __OPENCV_HASH_TSDF_H__
 
 #include <opencv2/rgbd/volume.hpp>
+#include <iosfwd>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -29,6 +30,22 @@ class HashTSDFVolume : public Volume
     virtual int getVisibleBlocks(int currFrameId, int frameThreshold) const = 0;
     virtual size_t getTotalVolumeUnits() const = 0;
 
+    //! Writes all allocated volume units to the stream
+    virtual void writeVolumeUnits(std::ostream& out) const = 0;
+    //! Replaces the contents of the volume with the volume units written by writeVolumeUnits()
+    virtual void readVolumeUnits(std::istream& in) = 0;
+
+    //! Size of the voxel data of the allocated volume units in bytes
+    size_t getVolumeUnitsDataSize() const
+    {
+        return getTotalVolumeUnits() * volumeUnitResolution * volumeUnitResolution * volumeUnitResolution *
+               sizeof(TsdfVoxel);
+    }
+
+   protected:
+    void writeVolumeUnitsHeader(std::ostream& out, int nUnits) const;
+    int readVolumeUnitsHeader(std::istream& in) const;
+
    public:
     int maxWeight;
     float truncDist;
@@ -41,7 +58,7 @@ class HashTSDFVolume : public Volume
 };
 
 //template<typename T>
-Ptr<HashTSDFVolume> makeHashTSDFVolume(const VolumeParams& _volumeParams);
+CV_EXPORTS Ptr<HashTSDFVolume> makeHashTSDFVolume(const VolumeParams& _volumeParams);
 //template<typename T>
 Ptr<HashTSDFVolume> makeHashTSDFVolume(float _voxelSize, Matx44f _pose, float _raycastStepFactor, float _truncDist,
     int _maxWeight, float truncateThreshold, int volumeUnitResolution = 16);
@@ -94,9 +94,9 @@ void makeColoredFrameFromDepth(InputArray _depth, InputArray _rgb,
                         const Intr intr, const Intr rgb_intr, int levels, float depthFactor,
                         float sigmaDepth, float sigmaSpatial, int kernelSize,
                         float truncateThreshold);
-void buildPyramidPointsNormals(InputArray _points, InputArray _normals,
-                               OutputArrayOfArrays pyrPoints, OutputArrayOfArrays pyrNormals,
-                               int levels);
+CV_EXPORTS void buildPyramidPointsNormals(InputArray _points, InputArray _normals,
+                                          OutputArrayOfArrays pyrPoints, OutputArrayOfArrays pyrNormals,
+                                          int levels);
 
 } // namespace kinfu
 } // namespace cv
@@ -62,6 +62,10 @@ Ptr<Params> Params::defaultParams()
         p.volumeParams.raycastStepFactor   = 0.25f;                         // in voxel sizes
         p.volumeParams.depthTruncThreshold = p.truncateThreshold;
     }
+    //! Submap storage parameters
+    p.submapMemoryBudget = 0;  // megabytes, disabled
+    p.submapStorageDir   = String();
+
     //! Unused parameters
     p.tsdf_min_camera_movement = 0.f;              // meters, disabled
     p.lightPose                = Vec3f::all(0.f);  // meters
@@ -144,7 +148,9 @@ LargeKinfuImpl<MatType>::LargeKinfuImpl(const Params& _params)
 {
     icp = makeICP(params.intr, params.icpIterations, params.icpAngleThresh, params.icpDistThresh);
 
-    submapMgr = cv::makePtr<SubmapManager<MatType>>(params.volumeParams);
+    CV_Assert(params.submapMemoryBudget >= 0);
+    submapMgr = cv::makePtr<SubmapManager<MatType>>(params.volumeParams, size_t(params.submapMemoryBudget) << 20,
+                                                    params.submapStorageDir);
     reset();
     submapMgr->createNewSubmap(true);
 
@@ -292,6 +298,7 @@ bool LargeKinfuImpl<MatType>::updateT(const MatType& _depth)
 
     }
     CV_LOG_INFO(NULL, "Number of submaps: " << submapMgr->submapList.size());
+    CV_LOG_INFO(NULL, "Number of resident submaps: " << submapMgr->numOfResidentSubmaps());
 
     frameCounter++;
     return true;
@@ -8,11 +8,15 @@
 #include <opencv2/core/cvdef.h>
 
 #include <opencv2/core/affine.hpp>
+#include <algorithm>
+#include <set>
 #include <type_traits>
 #include <vector>
 
 #include "hash_tsdf.hpp"
+#include "submap_storage.hpp"
 #include "opencv2/core/mat.inl.hpp"
+#include "opencv2/core/utils/logger.hpp"
 #include "opencv2/rgbd/detail/pose_graph.hpp"
 
 namespace cv
@@ -42,7 +46,8 @@ class Submap
 
     Submap(int _id, const VolumeParams& volumeParams, const cv::Affine3f& _pose = cv::Affine3f::Identity(),
            int _startFrameId = 0)
-        : id(_id), pose(_pose), cameraPose(Affine3f::Identity()), startFrameId(_startFrameId), volume(makeHashTSDFVolume(volumeParams))
+        : id(_id), pose(_pose), cameraPose(Affine3f::Identity()), startFrameId(_startFrameId),
+          lastActiveFrameId(_startFrameId), volumeModified(false), volume(makeHashTSDFVolume(volumeParams))
     {
         std::cout << "Created volume\n";
     }
@@ -59,6 +64,10 @@ class Submap
         return volume->getVisibleBlocks(currFrameId, FRAME_VISIBILITY_THRESHOLD);
     }
 
+    //! The volume of an inactive submap may be evicted to the disk
+    bool isResident() const { return bool(volume); }
+    size_t getVolumeMemory() const { return volume ? volume->getVolumeUnitsDataSize() : 0; }
+
     float calcVisibilityRatio(int currFrameId) const
     {
         int allocate_blocks = getTotalAllocatedBlocks();
@@ -85,6 +94,10 @@ class Submap
 
     int startFrameId;
     int stopFrameId;
+    //! Used to pick the least recently active submaps for eviction
+    int lastActiveFrameId;
+    //! The volume differs from the copy on the disk, if there is one
+    bool volumeModified;
     //! TODO: Should we support submaps for regular volumes?
     static constexpr int FRAME_VISIBILITY_THRESHOLD = 5;
 
@@ -100,13 +113,16 @@ void Submap<MatType>::integrate(InputArray _depth, float depthFactor, const cv::
                                 const int currFrameId)
 {
     CV_Assert(currFrameId >= startFrameId);
+    CV_Assert(isResident());
     volume->integrate(_depth, depthFactor, cameraPose.matrix, intrinsics, currFrameId);
+    volumeModified = true;
 }
 
 template<typename MatType>
 void Submap<MatType>::raycast(const cv::Affine3f& _cameraPose, const cv::kinfu::Intr& intrinsics, cv::Size frameSize,
                               OutputArray points, OutputArray normals)
 {
+    CV_Assert(isResident());
     volume->raycast(_cameraPose.matrix, intrinsics, frameSize, points, normals);
 }
 
@@ -121,6 +137,11 @@ void Submap<MatType>::updatePyrPointsNormals(const int pyramidLevels)
 
 /**
  * @brief: Manages all the created submaps for a particular scene
+ *
+ * When the memory budget is set, the volumes of inactive submaps are moved to the disk
+ * in the least recently active order until the resident volumes fit into the budget.
+ * Writing and reading happen in the background; a submap that is being read back
+ * rejoins the active submaps once its volume is available.
  */
 template<typename MatType>
 class SubmapManager
@@ -145,10 +166,19 @@ class SubmapManager
     typedef std::map<int, Ptr<SubmapT>> IdToSubmapPtr;
     typedef std::unordered_map<int, ActiveSubmapData> IdToActiveSubmaps;
 
-    SubmapManager(const VolumeParams& _volumeParams) : volumeParams(_volumeParams) {}
+    //! The memory budget is given in bytes, 0 keeps all the submaps in memory
+    SubmapManager(const VolumeParams& _volumeParams, size_t _memoryBudget = 0, const String& _storageDir = String())
+        : volumeParams(_volumeParams), memoryBudget(_memoryBudget), storageDir(_storageDir)
+    {
+    }
     virtual ~SubmapManager() = default;
 
-    void reset() { submapList.clear(); };
+    void reset()
+    {
+        submapList.clear();
+        pendingSubmaps.clear();
+        storage.release();
+    };
 
     bool shouldCreateSubmap(int frameId);
     bool shouldChangeCurrSubmap(int _frameId, int toSubmapId);
@@ -159,6 +189,12 @@ class SubmapManager
     void removeSubmap(int _id);
     size_t numOfSubmaps(void) const { return submapList.size(); };
     size_t numOfActiveSubmaps(void) const { return activeSubmaps.size(); };
+    size_t numOfResidentSubmaps(void) const;
+
+    //! Makes the submap active again, its volume is read back asynchronously if it was evicted
+    void activateSubmap(int _id);
+    //! Picks up the loaded submaps and evicts inactive ones exceeding the memory budget
+    void updateStorage(int _frameId);
 
     Ptr<SubmapT> getSubmap(int _id) const;
     Ptr<SubmapT> getCurrentSubmap(void) const;
@@ -175,6 +211,16 @@ class SubmapManager
     IdToActiveSubmaps activeSubmaps;
 
     Ptr<detail::PoseGraph> poseGraph;
+
+   private:
+    void evictSubmap(const Ptr<SubmapT>& submap);
+
+    size_t memoryBudget;
+    String storageDir;
+    //! Created on the first eviction
+    Ptr<SubmapStorage> storage;
+    //! Submaps waiting for their volumes to be loaded before activation
+    std::set<int> pendingSubmaps;
 };
 
 template<typename MatType>
@@ -457,11 +503,7 @@ bool SubmapManager<MatType>::updateMap(int _frameId, std::vector<MatType> _frame
 
     for (std::vector<int>::const_iterator it = createNewConstraintsList.begin(); it != createNewConstraintsList.end(); ++it)
     {
-        int dataId = *it;
-        ActiveSubmapData newSubmapData;
-        newSubmapData.trackingAttempts = 0;
-        newSubmapData.type             = Type::LOOP_CLOSURE;
-        activeSubmaps[dataId]          = newSubmapData;
+        activateSubmap(*it);
     }
 
     if (shouldCreateSubmap(_frameId))
@@ -490,9 +532,118 @@ bool SubmapManager<MatType>::updateMap(int _frameId, std::vector<MatType> _frame
         }
     }
 
+    updateStorage(_frameId);
+
     return mapUpdated;
 }
 
+template<typename MatType>
+size_t SubmapManager<MatType>::numOfResidentSubmaps(void) const
+{
+    size_t count = 0;
+    for (const auto& submap : submapList)
+    {
+        if (submap->isResident())
+            count++;
+    }
+    return count;
+}
+
+template<typename MatType>
+void SubmapManager<MatType>::activateSubmap(int _id)
+{
+    if (activeSubmaps.count(_id))
+        return;
+
+    Ptr<SubmapT> submap = getSubmap(_id);
+    if (submap->isResident())
+    {
+        ActiveSubmapData newSubmapData;
+        newSubmapData.trackingAttempts = 0;
+        newSubmapData.type             = Type::LOOP_CLOSURE;
+        activeSubmaps[_id]             = newSubmapData;
+    }
+    else if (pendingSubmaps.insert(_id).second)
+    {
+        storage->load(_id);
+    }
+}
+
+template<typename MatType>
+void SubmapManager<MatType>::evictSubmap(const Ptr<SubmapT>& submap)
+{
+    CV_Assert(submap->isResident() && !activeSubmaps.count(submap->id));
+
+    if (!storage)
+        storage = makePtr<SubmapStorage>(volumeParams, storageDir);
+
+    //! An unmodified volume which is already on the disk is just released
+    if (submap->volumeModified || !storage->isStored(submap->id))
+        storage->store(submap->id, submap->volume);
+    submap->volume.reset();
+    submap->volumeModified = false;
+}
+
+template<typename MatType>
+void SubmapManager<MatType>::updateStorage(int _frameId)
+{
+    if (storage)
+    {
+        std::vector<SubmapStorage::Result> results;
+        storage->fetchResults(results);
+        for (const auto& result : results)
+        {
+            Ptr<SubmapT> submap = getSubmap(result.id);
+            bool isPending      = pendingSubmaps.erase(result.id) > 0;
+
+            //! A resident volume is never older than the one coming from the storage
+            if (result.volume && !submap->isResident())
+            {
+                submap->volume            = result.volume;
+                submap->volumeModified    = !result.upToDate;
+                submap->lastActiveFrameId = _frameId;
+            }
+            if (!submap->isResident())
+            {
+                CV_LOG_ERROR(NULL, "Failed to load submap " << result.id);
+                continue;
+            }
+            if (isPending)
+                activateSubmap(result.id);
+        }
+    }
+
+    for (const auto& it : activeSubmaps)
+    {
+        getSubmap(it.first)->lastActiveFrameId = _frameId;
+    }
+
+    if (memoryBudget == 0)
+        return;
+
+    size_t residentMemory = 0;
+    std::vector<Ptr<SubmapT>> inactiveSubmaps;
+    for (const auto& submap : submapList)
+    {
+        residentMemory += submap->getVolumeMemory();
+        if (submap->isResident() && !activeSubmaps.count(submap->id))
+            inactiveSubmaps.push_back(submap);
+    }
+
+    std::sort(inactiveSubmaps.begin(), inactiveSubmaps.end(), [](const Ptr<SubmapT>& a, const Ptr<SubmapT>& b) {
+        return a->lastActiveFrameId < b->lastActiveFrameId;
+    });
+
+    for (const auto& submap : inactiveSubmaps)
+    {
+        if (residentMemory <= memoryBudget)
+            break;
+        residentMemory -= submap->getVolumeMemory();
+        evictSubmap(submap);
+        CV_LOG_INFO(NULL, "Evicted submap " << submap->id);
+    }
+}
+
 template<typename MatType>
 Ptr<detail::PoseGraph> SubmapManager<MatType>::MapToPoseGraph()
 {
@@ -0,0 +1,204 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html
+
+#include "precomp.hpp"
+#include "submap_storage.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#include "opencv2/core/utils/logger.hpp"
+
+namespace cv
+{
+namespace kinfu
+{
+
+SubmapStorage::SubmapStorage(const VolumeParams& _volumeParams, const String& _directory)
+    : volumeParams(_volumeParams), directory(_directory)
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    , stopping(false)
+#endif
+{
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    worker = std::thread(&SubmapStorage::run, this);
+#endif
+}
+
+SubmapStorage::~SubmapStorage()
+{
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+        //! Nobody is going to read the stored volumes anymore
+        requests.clear();
+    }
+    cond.notify_one();
+    worker.join();
+#endif
+
+    for (const auto& it : files)
+        std::remove(it.second.c_str());
+}
+
+void SubmapStorage::store(int id, const std::shared_ptr<HashTSDFVolume>& volume)
+{
+    CV_Assert(volume);
+
+    Request request;
+    request.id     = id;
+    request.volume = volume;
+
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        getFilename(id);
+        requests.push_back(request);
+    }
+    cond.notify_one();
+#else
+    getFilename(id);
+    process(request);
+#endif
+}
+
+void SubmapStorage::load(int id)
+{
+    Request request;
+    request.id = id;
+
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        CV_Assert(files.count(id));
+
+        //! The volume has not been written yet, so it is given back right away
+        for (auto it = requests.begin(); it != requests.end(); ++it)
+        {
+            if (it->id == id && it->volume)
+            {
+                Result result;
+                result.id       = id;
+                result.volume   = it->volume;
+                result.upToDate = false;
+                results.push_back(result);
+                requests.erase(it);
+                return;
+            }
+        }
+        requests.push_back(request);
+    }
+    cond.notify_one();
+#else
+    CV_Assert(files.count(id));
+    process(request);
+#endif
+}
+
+bool SubmapStorage::isStored(int id) const
+{
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    std::lock_guard<std::mutex> lock(mtx);
+#endif
+    return files.count(id) > 0;
+}
+
+void SubmapStorage::fetchResults(std::vector<Result>& _results)
+{
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    std::lock_guard<std::mutex> lock(mtx);
+#endif
+    _results.clear();
+    std::swap(_results, results);
+}
+
+String SubmapStorage::getFilename(int id)
+{
+    auto it = files.find(id);
+    if (it != files.end())
+        return it->second;
+
+    String filename;
+    if (directory.empty())
+        filename = tempfile(cv::format("_submap%d.bin", id).c_str());
+    else
+        filename = directory + "/submap" + std::to_string(id) + ".bin";
+    files[id] = filename;
+    return filename;
+}
+
+void SubmapStorage::process(Request request)
+{
+    CV_TRACE_FUNCTION();
+
+    String filename;
+    {
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+        std::lock_guard<std::mutex> lock(mtx);
+#endif
+        filename = files.at(request.id);
+    }
+
+    Result result;
+    result.id = request.id;
+    try
+    {
+        if (request.volume)
+        {
+            std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!out)
+                CV_Error(Error::StsError, "Can't open " + filename + " for writing");
+            request.volume->writeVolumeUnits(out);
+            out.close();
+            if (!out)
+                CV_Error(Error::StsError, "Failed to write " + filename);
+            //! The volume is released here, unless it is still referenced elsewhere
+            return;
+        }
+
+        std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!in)
+            CV_Error(Error::StsError, "Can't open " + filename + " for reading");
+        Ptr<HashTSDFVolume> volume = makeHashTSDFVolume(volumeParams);
+        volume->readVolumeUnits(in);
+        result.volume   = volume;
+        result.upToDate = true;
+    }
+    catch (const cv::Exception& e)
+    {
+        CV_LOG_ERROR(NULL, "Submap " << request.id << ": " << e.what());
+        //! A volume that was not stored is given back to stay in memory
+        result.volume   = request.volume;
+        result.upToDate = false;
+    }
+
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    std::lock_guard<std::mutex> lock(mtx);
+#endif
+    results.push_back(result);
+}
+
+void SubmapStorage::run()
+{
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;)
+    {
+        cond.wait(lock, [this] { return stopping || !requests.empty(); });
+        if (stopping)
+            return;
+
+        Request request = requests.front();
+        requests.pop_front();
+
+        lock.unlock();
+        process(std::move(request));
+        lock.lock();
+    }
+#endif
+}
+
+}  // namespace kinfu
+}  // namespace cv
@@ -0,0 +1,88 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html
+
+#ifndef __OPENCV_RGBD_SUBMAP_STORAGE_HPP__
+#define __OPENCV_RGBD_SUBMAP_STORAGE_HPP__
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "hash_tsdf.hpp"
+
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace cv
+{
+namespace kinfu
+{
+
+/**
+ * @brief: Keeps the volumes of evicted submaps on disk
+ *
+ * Volumes are written and read back by a background thread, so that the caller only
+ * queues the requests and picks up the results later. The storage holds a reference to
+ * the volume being written until the write completes, i.e. its memory is released
+ * as soon as the data is on disk.
+ */
+class CV_EXPORTS SubmapStorage
+{
+   public:
+    struct Result
+    {
+        int id;
+        //! Empty if the volume could not be loaded
+        std::shared_ptr<HashTSDFVolume> volume;
+        //! The volume was read from the disk, otherwise it is the volume of a store request
+        //! that failed or was cancelled and the data on the disk is outdated
+        bool upToDate;
+    };
+
+    //! Temporary files are used when the directory is empty
+    SubmapStorage(const VolumeParams& volumeParams, const String& directory = String());
+    ~SubmapStorage();
+
+    //! Queues writing of the submap volume
+    void store(int id, const std::shared_ptr<HashTSDFVolume>& volume);
+    //! Queues reading of the submap volume stored before
+    void load(int id);
+    //! True if a volume of the submap was stored or is being stored
+    bool isStored(int id) const;
+    //! Moves out the results of the requests completed since the last call
+    void fetchResults(std::vector<Result>& results);
+
+   private:
+    struct Request
+    {
+        int id;
+        std::shared_ptr<HashTSDFVolume> volume;
+    };
+
+    void process(Request request);
+    String getFilename(int id);
+    void run();
+
+    VolumeParams volumeParams;
+    String directory;
+
+    std::map<int, String> files;
+    std::deque<Request> requests;
+    std::vector<Result> results;
+
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    mutable std::mutex mtx;
+    std::condition_variable cond;
+    bool stopping;
+    std::thread worker;
+#endif
+};
+
+}  // namespace kinfu
+}  // namespace cv
+#endif
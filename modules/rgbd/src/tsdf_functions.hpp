@@ -8,6 +8,8 @@
 #define __OPENCV_TSDF_FUNCTIONS_H__
 
 #include <opencv2/rgbd/volume.hpp>
+#include <atomic>
+#include <memory>
 #include "tsdf.hpp"
 #include "colored_tsdf.hpp"
 
@@ -176,6 +178,180 @@ public:
     }
 };
 
+//! Lock-free hash table from volume unit coordinates to volume unit indices.
+//! Open addressing with linear probing over flat arrays: a lookup reads a few
+//! adjacent slots and insertions claim their slot with a single CAS, so any
+//! number of threads may insert and look up at the same time. The indices are
+//! handed out consecutively, they never change and can address contiguous
+//! voxel storage. The table does not grow by itself: insert() reports a full
+//! table and the caller calls rehash() outside of the parallel section.
+class VolumeUnitHashTable
+{
+public:
+    static const int startCapacity = 8192;
+    //! each coordinate is packed into 21 bits of the key
+    static const int coordBits = 21;
+
+    VolumeUnitHashTable(int _capacity = startCapacity)
+    {
+        reset(_capacity);
+    }
+
+    void reset(int _capacity = startCapacity)
+    {
+        CV_Assert(_capacity > 0 && (_capacity & (_capacity - 1)) == 0);
+        cap = _capacity;
+        keys.reset(new std::atomic<uint64_t>[cap]);
+        values.reset(new std::atomic<int>[cap]);
+        for (int i = 0; i < cap; i++)
+        {
+            keys[i].store(emptyKey, std::memory_order_relaxed);
+            values[i].store(-1, std::memory_order_relaxed);
+        }
+        count.store(0);
+    }
+
+    int size() const { return count.load(std::memory_order_acquire); }
+    int capacity() const { return cap; }
+
+    //! returns the index of the volume unit or -1 if it is absent
+    int find(const Vec3i& idx) const
+    {
+        const uint64_t key = pack(idx);
+        const int mask = cap - 1;
+        for (int i = int(calc_hash(key) & uint64_t(mask)); ; i = (i + 1) & mask)
+        {
+            uint64_t k = keys[i].load(std::memory_order_acquire);
+            if (k == key)
+                return waitValue(i);
+            if (k == emptyKey)
+                return -1;
+        }
+    }
+
+    // 0 - need resize
+    // 1 - idx is inserted
+    // 2 - idx already exists
+    int insert(const Vec3i& idx, int& index)
+    {
+        const uint64_t key = pack(idx);
+        const int mask = cap - 1;
+        for (int i = int(calc_hash(key) & uint64_t(mask)); ; i = (i + 1) & mask)
+        {
+            uint64_t k = keys[i].load(std::memory_order_acquire);
+            if (k == emptyKey)
+            {
+                // keep the load factor below 3/4, so that probe sequences stay short
+                if (count.load(std::memory_order_relaxed) >= cap - cap / 4)
+                    return 0;
+                if (keys[i].compare_exchange_strong(k, key, std::memory_order_acq_rel))
+                {
+                    index = count.fetch_add(1, std::memory_order_acq_rel);
+                    values[i].store(index, std::memory_order_release);
+                    return 1;
+                }
+                // k now holds the key inserted by another thread
+            }
+            if (k == key)
+            {
+                index = waitValue(i);
+                return 2;
+            }
+        }
+    }
+
+    //! Grows the table keeping all the indices, must not run concurrently with anything else
+    void rehash(int newCapacity)
+    {
+        CV_Assert(newCapacity > size());
+        VolumeUnitHashTable table(newCapacity);
+        for (int i = 0; i < cap; i++)
+        {
+            uint64_t k = keys[i].load(std::memory_order_relaxed);
+            if (k != emptyKey)
+                table.place(k, values[i].load(std::memory_order_relaxed));
+        }
+        table.count.store(size());
+
+        cap = table.cap;
+        keys = std::move(table.keys);
+        values = std::move(table.values);
+    }
+
+    //! Calls f(idx, index) for every volume unit, must not run concurrently with insert()
+    template<typename F>
+    void forEach(F f) const
+    {
+        for (int i = 0; i < cap; i++)
+        {
+            uint64_t k = keys[i].load(std::memory_order_relaxed);
+            if (k != emptyKey)
+                f(unpack(k), values[i].load(std::memory_order_relaxed));
+        }
+    }
+
+private:
+    static const uint64_t emptyKey = ~uint64_t(0);
+    static const uint64_t coordMask = (uint64_t(1) << coordBits) - 1;
+
+    static inline uint64_t pack(const Vec3i& idx)
+    {
+        CV_DbgAssert(std::abs(idx[0]) < (1 << (coordBits - 1)) &&
+                     std::abs(idx[1]) < (1 << (coordBits - 1)) &&
+                     std::abs(idx[2]) < (1 << (coordBits - 1)));
+        // the highest bit stays zero, so that a key never equals emptyKey
+        return ((uint64_t(uint32_t(idx[0])) & coordMask) << (2 * coordBits)) |
+               ((uint64_t(uint32_t(idx[1])) & coordMask) << coordBits) |
+                (uint64_t(uint32_t(idx[2])) & coordMask);
+    }
+
+    static inline int unpackCoord(uint64_t key, int shift)
+    {
+        int v = int((key >> shift) & coordMask);
+        return (v & (1 << (coordBits - 1))) ? v - (1 << coordBits) : v;
+    }
+
+    static inline Vec3i unpack(uint64_t key)
+    {
+        return Vec3i(unpackCoord(key, 2 * coordBits), unpackCoord(key, coordBits), unpackCoord(key, 0));
+    }
+
+    static inline uint64_t calc_hash(uint64_t x)
+    {
+        // finalizer of MurmurHash3
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    //! the slot is claimed before its index is published, wait for the inserting thread
+    inline int waitValue(int i) const
+    {
+        int v;
+        while ((v = values[i].load(std::memory_order_acquire)) < 0)
+            ;
+        return v;
+    }
+
+    void place(uint64_t key, int value)
+    {
+        const int mask = cap - 1;
+        int i = int(calc_hash(key) & uint64_t(mask));
+        while (keys[i].load(std::memory_order_relaxed) != emptyKey)
+            i = (i + 1) & mask;
+        keys[i].store(key, std::memory_order_relaxed);
+        values[i].store(value, std::memory_order_relaxed);
+    }
+
+    int cap;
+    std::unique_ptr<std::atomic<uint64_t>[]> keys;
+    std::unique_ptr<std::atomic<int>[]> values;
+    std::atomic<int> count;
+};
+
 // TODO: remove this structure as soon as HashTSDFGPU data is completely on GPU;
 // until then CustomHashTable can be replaced by this one if needed
 
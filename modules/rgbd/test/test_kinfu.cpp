@@ -5,6 +5,7 @@
 // This code is also subject to the license terms in the LICENSE_KinectFusion.md file found in this module's directory
 
 #include "test_precomp.hpp"
+#include "../src/submap.hpp"
 
 // Inspired by Inigo Quilez' raymarching guide:
 // http://iquilezles.org/www/articles/distfunctions/distfunctions.htm
@@ -378,4 +379,85 @@ TEST( KinectFusion, DISABLED_hashTsdf )
     //! hashTSDF does not support non-equal volumeDims
     flyTest(true, false, true);
 }
+
+//! Fetched points come in the order the parallel fetch produced them
+static std::vector<Vec4f> sortedPoints(Mat points)
+{
+    std::vector<Vec4f> sorted(points.begin<Vec4f>(), points.end<Vec4f>());
+    std::sort(sorted.begin(), sorted.end(), [](const Vec4f& a, const Vec4f& b) {
+        return std::lexicographical_compare(a.val, a.val + 4, b.val, b.val + 4);
+    });
+    return sorted;
+}
+
+static void waitForStorage()
+{
+#ifndef OPENCV_DISABLE_THREAD_SUPPORT
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
+}
+
+//! LargeKinfu reactivates evicted submaps only on loop closure, so the submap manager it
+//! runs on is driven directly to make the eviction and the reload happen for sure
+TEST( LargeKinfu, submapEvictionAndReload )
+{
+    Ptr<large_kinfu::Params> params = large_kinfu::Params::hashTSDFParams(true);
+    Ptr<Scene> scene = Scene::create(false, params->frameSize, params->intr, params->depthFactor);
+    std::vector<Affine3f> poses = scene->getPoses();
+
+    //! Any resident inactive submap exceeds the budget of one byte
+    kinfu::SubmapManager<Mat> submapMgr(params->volumeParams, 1);
+    const int id = submapMgr.createNewSubmap(true);
+    Ptr<kinfu::Submap<Mat>> submap = submapMgr.getSubmap(id);
+
+    const int nFrames = 5;
+    for (int i = 0; i < nFrames; i++)
+    {
+        submap->cameraPose = poses[i];
+        submap->integrate(scene->depth(poses[i]), params->depthFactor, params->intr, i);
+        submapMgr.updateStorage(i);
+    }
+    ASSERT_TRUE(submap->isResident()) << "The current submap was evicted";
+
+    const Affine3f pose = submap->pose, cameraPose = submap->cameraPose;
+    Mat points, normals, cloud;
+    submap->raycast(cameraPose, params->intr, params->frameSize, points, normals);
+    submap->volume->fetchPointsNormals(cloud, noArray());
+    patchNaNs(points); patchNaNs(normals);
+    ASSERT_GT(cloud.total(), 0u);
+
+    //! Tracking moves on to a new submap and the first one becomes inactive
+    submapMgr.activeSubmaps.erase(id);
+    submapMgr.createNewSubmap(true, nFrames);
+    std::weak_ptr<kinfu::HashTSDFVolume> evictedVolume = submap->volume;
+    submapMgr.updateStorage(nFrames);
+    ASSERT_FALSE(submap->isResident());
+    ASSERT_EQ(1u, submapMgr.numOfResidentSubmaps());
+
+    //! The volume is released once it is on the disk, so the reload has to read it back
+    for (int attempt = 0; attempt < 1000 && !evictedVolume.expired(); attempt++)
+        waitForStorage();
+    ASSERT_TRUE(evictedVolume.expired()) << "The evicted volume was not written";
+
+    submapMgr.activateSubmap(id);
+    for (int attempt = 0; attempt < 1000 && !submapMgr.activeSubmaps.count(id); attempt++)
+    {
+        waitForStorage();
+        submapMgr.updateStorage(nFrames + 1);
+    }
+    ASSERT_EQ(1u, submapMgr.activeSubmaps.count(id)) << "The evicted submap was not reloaded";
+    ASSERT_TRUE(submap->isResident());
+
+    EXPECT_EQ(0, cvtest::norm(Mat(pose.matrix), Mat(submap->pose.matrix), NORM_INF));
+    EXPECT_EQ(0, cvtest::norm(Mat(cameraPose.matrix), Mat(submap->cameraPose.matrix), NORM_INF));
+
+    Mat loadedPoints, loadedNormals, loadedCloud;
+    submap->raycast(submap->cameraPose, params->intr, params->frameSize, loadedPoints, loadedNormals);
+    submap->volume->fetchPointsNormals(loadedCloud, noArray());
+    patchNaNs(loadedPoints); patchNaNs(loadedNormals);
+    EXPECT_EQ(0, cvtest::norm(points, loadedPoints, NORM_INF));
+    EXPECT_EQ(0, cvtest::norm(normals, loadedNormals, NORM_INF));
+    ASSERT_EQ(cloud.total(), loadedCloud.total());
+    EXPECT_TRUE(sortedPoints(cloud) == sortedPoints(loadedCloud));
+}
 }} // namespace
@@ -3,6 +3,7 @@
 // of this distribution and at http://opencv.org/license.html
 
 #include "test_precomp.hpp"
+#include "../src/hash_tsdf.hpp"
 
 namespace opencv_test {
 namespace {
@@ -451,6 +452,55 @@ void valid_points_test(bool isHashTSDF)
     ASSERT_LT(abs(0.5 - percentValidity), 0.3) << "percentValidity out of [0.3; 0.7] (percentValidity=" << percentValidity << ")";
 }
 
+//! Fetched points come in the order the parallel fetch produced them
+std::vector<Vec4f> sortedPoints(Mat points)
+{
+    std::vector<Vec4f> sorted(points.begin<Vec4f>(), points.end<Vec4f>());
+    std::sort(sorted.begin(), sorted.end(), [](const Vec4f& a, const Vec4f& b) {
+        return std::lexicographical_compare(a.val, a.val + 4, b.val, b.val + 4);
+    });
+    return sorted;
+}
+
+void volume_units_io_test()
+{
+    Settings settings(true, false);
+    Ptr<kinfu::HashTSDFVolume> volume = settings.volume.staticCast<kinfu::HashTSDFVolume>();
+    for (int i = 0; i < 3; i++)
+    {
+        Mat depth = settings.scene->depth(settings.poses[i]);
+        volume->integrate(depth, settings.params->depthFactor, settings.poses[i].matrix, settings.params->intr, i);
+    }
+
+    std::stringstream stream;
+    volume->writeVolumeUnits(stream);
+
+    Ptr<kinfu::Params> params = settings.params;
+    Ptr<kinfu::HashTSDFVolume> loaded = kinfu::makeVolume(params->volumeType, params->voxelSize,
+        params->volumePose.matrix, params->raycast_step_factor, params->tsdf_trunc_dist, params->tsdf_max_weight,
+        params->truncateThreshold, params->volumeDims).staticCast<kinfu::HashTSDFVolume>();
+    loaded->readVolumeUnits(stream);
+    ASSERT_EQ(volume->getTotalVolumeUnits(), loaded->getTotalVolumeUnits());
+
+    for (int i : { 0, 17 })
+    {
+        Mat points, normals, loadedPoints, loadedNormals;
+        volume->raycast(settings.poses[i].matrix, params->intr, params->frameSize, points, normals);
+        loaded->raycast(settings.poses[i].matrix, params->intr, params->frameSize, loadedPoints, loadedNormals);
+        patchNaNs(points); patchNaNs(normals);
+        patchNaNs(loadedPoints); patchNaNs(loadedNormals);
+        ASSERT_GT(counterOfValid(points), 0) << "There is no points in the raycast";
+        EXPECT_EQ(0, cvtest::norm(points, loadedPoints, NORM_INF));
+        EXPECT_EQ(0, cvtest::norm(normals, loadedNormals, NORM_INF));
+    }
+
+    Mat cloud, loadedCloud;
+    volume->fetchPointsNormals(cloud, noArray());
+    loaded->fetchPointsNormals(loadedCloud, noArray());
+    ASSERT_EQ(cloud.total(), loadedCloud.total());
+    EXPECT_TRUE(sortedPoints(cloud) == sortedPoints(loadedCloud));
+}
+
 #ifndef HAVE_OPENCL
 TEST(TSDF, raycast_normals) { normal_test(false, true, false, false); }
 TEST(TSDF, fetch_points_normals) { normal_test(false, false, true, false); }
@@ -461,6 +511,7 @@ TEST(HashTSDF, raycast_normals) { normal_test(true, true, false, false); }
 TEST(HashTSDF, fetch_points_normals) { normal_test(true, false, true, false); }
 TEST(HashTSDF, fetch_normals) { normal_test(true, false, false, true); }
 TEST(HashTSDF, valid_points) { valid_points_test(true); }
+TEST(HashTSDF, volume_units_io) { volume_units_io_test(); }
 #else
 TEST(TSDF_CPU, raycast_normals)
 {
@@ -517,6 +568,13 @@ TEST(HashTSDF_CPU, valid_points)
     valid_points_test(true);
     cv::ocl::setUseOpenCL(true);
 }
+
+TEST(HashTSDF_CPU, volume_units_io)
+{
+    cv::ocl::setUseOpenCL(false);
+    volume_units_io_test();
+    cv::ocl::setUseOpenCL(true);
+}
 #endif
 }
 }  // namespace
@@ -220,6 +220,18 @@ for (size_t i=0; i<results.size(); i++)
 }
 ~~~
 
+Training a large model takes time, so a trained detector can be stored with
+PPF3DDetector::saveModel. PPF3DDetector::loadModel maps the stored tables back into memory and
+the detector can be used for matching immediately:
+
+~~~{cpp}
+detector.saveModel("model.ppf");
+// ...
+ppf_match_3d::PPF3DDetector loaded;
+loaded.loadModel("model.ppf");
+loaded.match(pcTest, results, 1.0/10.0, 0.05);
+~~~
+
 Pose Registration via ICP
 -------------------------
 
@@ -59,6 +59,8 @@ namespace ppf_match_3d
 //! @addtogroup surface_matching
 //! @{
 
+class ICPScene;
+
 /**
 * @brief This class implements a very efficient and robust variant of the iterative closest point (ICP) algorithm.
 * The task is to register a 3D model (or point cloud) against a set of noisy target data. The variants are put together
@@ -95,6 +97,7 @@ public:
     m_numLevels = 6;
     m_sampleType = ICP_SAMPLING_TYPE_UNIFORM;
     m_numNeighborsCorr = 1;
+    m_poseUpdateThreshold = 0;
   }
 
   virtual ~ICP() { }
@@ -122,6 +125,7 @@ public:
     m_maxIterations = iterations;
     m_numLevels = numLevels;
     m_sampleType = sampleType;
+    m_poseUpdateThreshold = 0;
   }
 
   /**
@@ -151,6 +155,49 @@ public:
      */
   CV_WRAP int registerModelToScene(const Mat& srcPC, const Mat& dstPC, CV_IN_OUT std::vector<Pose3DPtr>& poses);
 
+  /**
+     *  \brief Prepares a scene for repeated registrations
+     *
+     *  @param [in] dstPC The input point cloud for the scene. Expected to have the normals (Nx6). Currently,
+     *  CV_32F is the only supported data type.
+     *
+     *  \details The scene is normalized, sampled for every pyramid level and indexed once. The result is kept
+     *  until the next call, so that refinePose and refinePoses can refine any number of poses, e.g. all the
+     *  hypotheses returned by PPF3DDetector::match or the poses of successive frames, without rebuilding the
+     *  indices. Unlike registerModelToScene, the normalization only depends on the scene.
+     */
+  CV_WRAP void setScene(const Mat& dstPC);
+
+  /**
+     *  \brief Refines a pose against the scene given to setScene
+     *
+     *  @param [in] srcPC The input point cloud for the model. Expected to have the normals (Nx6). Currently,
+     *  CV_32F is the only supported data type.
+     *  @param [in,out] pose Initial pose of the model on input, refined pose on output.
+     *  @param [out] residual The output registration error.
+     *  \return On successful termination, the function returns 0.
+     */
+  CV_WRAP int refinePose(const Mat& srcPC, CV_IN_OUT Matx44d& pose, CV_OUT double& residual);
+
+  /**
+     *  \brief Refines multiple poses against the scene given to setScene
+     *
+     *  @param [in] srcPC The input point cloud for the model. Expected to have the normals (Nx6). Currently,
+     *  CV_32F is the only supported data type.
+     *  @param [in,out] poses Initial poses on input, refined poses and their residuals on output.
+     *  \return On successful termination, the function returns 0.
+     */
+  CV_WRAP int refinePoses(const Mat& srcPC, CV_IN_OUT std::vector<Pose3DPtr>& poses);
+
+  /**
+     *  \brief Enables early termination of the iterations
+     *
+     *  @param [in] threshold The iterations of a pyramid level stop once an iteration changes the pose
+     *  by less than this value (norm of the difference of the normalized transformation matrices). Zero,
+     *  the default, disables the check.
+     */
+  CV_WRAP void setPoseUpdateThreshold(double threshold) { m_poseUpdateThreshold = threshold; }
+
 private:
   float m_tolerance;
   int m_maxIterations;
@@ -158,6 +205,8 @@ private:
   int m_numNeighborsCorr;
   int m_numLevels;
   int m_sampleType;
+  double m_poseUpdateThreshold;
+  Ptr<ICPScene> m_scene;
 
 };
 
@@ -73,6 +73,8 @@ namespace ppf_match_3d
 //! @addtogroup surface_matching
 //! @{
 
+class MappedFile;
+
 /**
   * @brief Struct, holding a node in the hashtable
   */
@@ -140,6 +142,28 @@ public:
     */
   CV_WRAP void match(const Mat& scene, CV_OUT std::vector<Pose3DPtr> &results, const double relativeSceneSampleStep=1.0/5.0, const double relativeSceneDistance=0.03);
 
+  /**
+    *  \brief Saves the trained model to a binary file.
+    *
+    *  @param [in] filename Name of the output file
+    *
+    *  \details The file contains the sampled model, the point pair features together with their alpha angles,
+    *  the hash table and the training and search parameters. Every table is stored as a flat, aligned array,
+    *  so that loadModel can use it in place.
+    */
+  CV_WRAP void saveModel(const String& filename) const;
+
+  /**
+    *  \brief Loads a model previously written by saveModel.
+    *
+    *  @param [in] filename Name of the model file
+    *
+    *  \details The file is memory-mapped and match() works directly on the mapped tables, so there is no
+    *  training or hash table construction involved. Several processes loading the same file share a single
+    *  copy in the page cache. The file must not be modified while it is in use by the detector.
+    */
+  CV_WRAP void loadModel(const String& filename);
+
   void read(const FileNode& fn);
   void write(FileStorage& fs) const;
 
@@ -149,8 +173,9 @@ protected:
   double sampling_step_relative, angle_step_relative, distance_step_relative;
   Mat sampled_pc, ppf;
   int num_ref_points;
-  hashtable_int* hash_table;
-  THash* hash_nodes;
+  Mat hash_slots; //!< open addressing directory, Nx1 CV_32SC3 (key, first node, number of nodes)
+  Mat hash_nodes; //!< Nx1 CV_32SC3, THash entries sorted by key
+  Ptr<MappedFile> model_file;
 
   double position_threshold, rotation_threshold;
   bool use_weighted_avg;
@@ -78,11 +78,7 @@ int main(int argc, char** argv)
     cout << "Running on 32 bits" << endl;
 #endif
     
-#ifdef _OPENMP
-    cout << "Running with OpenMP" << endl;
-#else
-    cout << "Running without OpenMP and without TBB" << endl;
-#endif
+    cout << "Running with " << cv::getNumThreads() << " threads" << endl;
     
     string modelFileName = (string)argv[1];
     string sceneFileName = (string)argv[2];
@@ -132,9 +128,10 @@ int main(int argc, char** argv)
     ICP icp(100, 0.005f, 2.5f, 8);
     int64 t1 = cv::getTickCount();
     
-    // Register for all selected poses
+    // Register for all selected poses, the scene is indexed only once
     cout << endl << "Performing ICP on " << N << " poses..." << endl;
-    icp.registerModelToScene(pc, pcTest, resultsSub);
+    icp.setScene(pcTest);
+    icp.refinePoses(pc, resultsSub);
     int64 t2 = cv::getTickCount();
     
     cout << endl << "ICP Elapsed Time " <<
@@ -199,20 +199,20 @@ static void minimizePointToPlaneMetric(Mat Src, Mat Dst, Vec3d& rpy, Vec3d& t)
   Mat b = Mat(Src.rows, 1, CV_64F);
   Mat rpy_t;
 
-#if defined _OPENMP
-#pragma omp parallel for
-#endif
-  for (int i=0; i<Src.rows; i++)
+  parallel_for_(Range(0, Src.rows), [&](const Range& range)
   {
-    const Vec3d srcPt(Src.ptr<double>(i));
-    const Vec3d dstPt(Dst.ptr<double>(i));
-    const Vec3d normals(Dst.ptr<double>(i) + 3);
-    const Vec3d sub = dstPt - srcPt;
-    const Vec3d axis = srcPt.cross(normals);
-
-    *b.ptr<double>(i) = sub.dot(normals);
-    hconcat(axis.reshape<1, 3>(), normals.reshape<1, 3>(), A.row(i));
-  }
+    for (int i=range.start; i<range.end; i++)
+    {
+      const Vec3d srcPt(Src.ptr<double>(i));
+      const Vec3d dstPt(Dst.ptr<double>(i));
+      const Vec3d normals(Dst.ptr<double>(i) + 3);
+      const Vec3d sub = dstPt - srcPt;
+      const Vec3d axis = srcPt.cross(normals);
+
+      *b.ptr<double>(i) = sub.dot(normals);
+      hconcat(axis.reshape<1, 3>(), normals.reshape<1, 3>(), A.row(i));
+    }
+  });
 
   cv::solve(A, b, rpy_t, DECOMP_SVD);
   rpy_t.rowRange(0, 3).copyTo(rpy);
@@ -242,14 +242,216 @@ static hashtable_int* getHashtable(int* data, size_t length, int numMaxElement)
   return hashtable;
 }
 
+// Runs the ICP iterations of a single pyramid level. srcPCT is the sampled model in its
+// current pose, dstPCS the sampled scene and flann the index built over dstPCS.
+// Returns the transformation refining srcPCT, fvalMin receives the lowest error.
+static Matx44d registerLevel(const Mat& srcPCT, const Mat& dstPCS, void* flann, const double TolP,
+                             const int MaxIterationsPyr, const float rejectionScale,
+                             const double poseUpdateThreshold, double& fvalMin)
+{
+  const bool useRobustReject = rejectionScale>0;
+
+  double fval_old=9999999999;
+  double fval_perc=0;
+  double fval_min=9999999999;
+  Mat Src_Moved = srcPCT.clone();
+
+  int i=0;
+
+  size_t numElSrc = (size_t)Src_Moved.rows;
+  int sizesResult[2] = {(int)numElSrc, 1};
+  float* distances = new float[numElSrc];
+  int* indices = new int[numElSrc];
+
+  Mat Indices(2, sizesResult, CV_32S, indices, 0);
+  Mat Distances(2, sizesResult, CV_32F, distances, 0);
+
+  // use robust weighting for outlier treatment
+  int* indicesModel = new int[numElSrc];
+  int* indicesScene = new int[numElSrc];
+
+  int* newI = new int[numElSrc];
+  int* newJ = new int[numElSrc];
+
+  Matx44d PoseX = Matx44d::eye();
+
+  bool converged = false;
+
+  while ( (!(fval_perc<(1+TolP) && fval_perc>(1-TolP))) && i<MaxIterationsPyr && !converged)
+  {
+    uint di=0, selInd = 0;
+
+    queryPCFlann(flann, Src_Moved, Indices, Distances);
+
+    for (di=0; di<numElSrc; di++)
+    {
+      newI[di] = di;
+      newJ[di] = indices[di];
+    }
+
+    if (useRobustReject)
+    {
+      int numInliers = 0;
+      float threshold = getRejectionThreshold(distances, Distances.rows, rejectionScale);
+      Mat acceptInd = Distances<threshold;
+
+      uchar *accPtr = (uchar*)acceptInd.data;
+      for (int l=0; l<acceptInd.rows; l++)
+      {
+        if (accPtr[l])
+        {
+          newI[numInliers] = l;
+          newJ[numInliers] = indices[l];
+          numInliers++;
+        }
+      }
+      numElSrc=numInliers;
+    }
+
+    // Step 2: Picky ICP
+    // Among the resulting corresponding pairs, if more than one scene point p_i
+    // is assigned to the same model point m_j, then select p_i that corresponds
+    // to the minimum distance
+
+    hashtable_int* duplicateTable = getHashtable(newJ, numElSrc, dstPCS.rows);
+
+    for (di=0; di<duplicateTable->size; di++)
+    {
+      hashnode_i *node = duplicateTable->nodes[di];
+
+      if (node)
+      {
+        // select the first node
+        size_t idx = reinterpret_cast<size_t>(node->data)-1;
+        int dup = (int)node->key-1;
+        size_t minIdxD = idx;
+        float minDist = distances[idx];
+
+        while ( node )
+        {
+          idx = reinterpret_cast<size_t>(node->data)-1;
+
+          if (distances[idx] < minDist)
+          {
+            minDist = distances[idx];
+            minIdxD = idx;
+          }
+
+          node = node->next;
+        }
+
+        indicesModel[ selInd ] = newI[ minIdxD ];
+        indicesScene[ selInd ] = dup ;
+        selInd++;
+      }
+    }
+
+    hashtableDestroy(duplicateTable);
+
+    if (selInd >= 6)
+    {
+
+      Mat Src_Match = Mat(selInd, srcPCT.cols, CV_64F);
+      Mat Dst_Match = Mat(selInd, srcPCT.cols, CV_64F);
+
+      for (di=0; di<selInd; di++)
+      {
+        const int indModel = indicesModel[di];
+        const int indScene = indicesScene[di];
+        const float *srcPt = srcPCT.ptr<float>(indModel);
+        const float *dstPt = dstPCS.ptr<float>(indScene);
+        double *srcMatchPt = Src_Match.ptr<double>(di);
+        double *dstMatchPt = Dst_Match.ptr<double>(di);
+        int ci=0;
+
+        for (ci=0; ci<srcPCT.cols; ci++)
+        {
+          srcMatchPt[ci] = (double)srcPt[ci];
+          dstMatchPt[ci] = (double)dstPt[ci];
+        }
+      }
+
+      Vec3d rpy, t;
+      minimizePointToPlaneMetric(Src_Match, Dst_Match, rpy, t);
+      if (cvIsNaN(cv::trace(rpy)) || cvIsNaN(cv::norm(t)))
+        break;
+      Matx44d PoseXNew;
+      getTransformMat(rpy, t, PoseXNew);
+
+      // stop as soon as an iteration hardly moves the model anymore
+      converged = poseUpdateThreshold > 0 && cv::norm(PoseXNew - PoseX) < poseUpdateThreshold;
+      PoseX = PoseXNew;
+      Src_Moved = transformPCPose(srcPCT, PoseX);
+
+      double fval = cv::norm(Src_Match, Dst_Match)/(double)(Src_Moved.rows);
+
+      // Calculate change in error between iterations
+      fval_perc=fval/fval_old;
+
+      // Store error value
+      fval_old=fval;
+
+      if (fval < fval_min)
+        fval_min = fval;
+    }
+    else
+      break;
+
+    i++;
+
+  }
+
+  delete[] newI;
+  delete[] newJ;
+  delete[] indicesModel;
+  delete[] indicesScene;
+  delete[] distances;
+  delete[] indices;
+
+  fvalMin = fval_min;
+  return PoseX;
+}
+
+// normalizes the scale of the xyz coordinates, the normals are left as they are
+static void scalePC(Mat pc, double scale)
+{
+  pc(cv::Range(0, pc.rows), cv::Range(0,3)) *= scale;
+}
+
+// maps a pose found in a frame translated by -mean and scaled by scale back to the input frame
+static void denormalizePose(Matx44d& pose, const Vec3d& mean, double scale)
+{
+  Matx33d Rpose;
+  Vec3d Cpose;
+  poseToRT(pose, Rpose, Cpose);
+  Cpose = Cpose / scale + mean - Rpose * mean;
+  rtToPose(Rpose, Cpose, pose);
+}
+
+// Normalized scene sampled and indexed for every pyramid level, see ICP::setScene
+class ICPScene
+{
+public:
+  ICPScene() : scale(1) {}
+
+  ~ICPScene()
+  {
+    for (size_t i = 0; i < indices.size(); i++)
+      destroyFlann(indices[i]);
+  }
+
+  Vec3d mean;
+  double scale;
+  std::vector<Mat> levels;
+  std::vector<void*> indices;
+};
+
 // source point clouds are assumed to contain their normals
 int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residual, Matx44d& pose)
 {
   int n = srcPC.rows;
   CV_CheckGT(n, 0, "");
 
-  const bool useRobustReject = m_rejectionScale>0;
-
   Mat srcTemp = srcPC.clone();
   Mat dstTemp = dstPC.clone();
   Vec3d meanSrc, meanDst;
@@ -264,8 +466,8 @@ int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residu
 
   double scale = (double)n / ((distSrc + distDst)*0.5);
 
-  srcTemp(cv::Range(0, srcTemp.rows), cv::Range(0,3)) *= scale;
-  dstTemp(cv::Range(0, dstTemp.rows), cv::Range(0,3)) *= scale;
+  scalePC(srcTemp, scale);
+  scalePC(dstTemp, scale);
 
   Mat srcPC0 = srcTemp;
   Mat dstPC0 = dstTemp;
@@ -273,8 +475,6 @@ int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residu
   // initialize pose
   pose = Matx44d::eye();
 
-  Mat M = Mat::eye(4,4,CV_64F);
-
   double tempResidual = 0;
 
 
@@ -298,187 +498,117 @@ int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residu
     Mat dstPCS = samplePCUniform(dstPC0, sampleStep);
     void* flann = indexPCFlann(dstPCS);
 
-    double fval_old=9999999999;
-    double fval_perc=0;
-    double fval_min=9999999999;
-    Mat Src_Moved = srcPCT.clone();
-
-    int i=0;
-
-    size_t numElSrc = (size_t)Src_Moved.rows;
-    int sizesResult[2] = {(int)numElSrc, 1};
-    float* distances = new float[numElSrc];
-    int* indices = new int[numElSrc];
-
-    Mat Indices(2, sizesResult, CV_32S, indices, 0);
-    Mat Distances(2, sizesResult, CV_32F, distances, 0);
-
-    // use robust weighting for outlier treatment
-    int* indicesModel = new int[numElSrc];
-    int* indicesScene = new int[numElSrc];
-
-    int* newI = new int[numElSrc];
-    int* newJ = new int[numElSrc];
-
-    Matx44d PoseX = Matx44d::eye();
-
-    while ( (!(fval_perc<(1+TolP) && fval_perc>(1-TolP))) && i<MaxIterationsPyr)
-    {
-      uint di=0, selInd = 0;
-
-      queryPCFlann(flann, Src_Moved, Indices, Distances);
-
-      for (di=0; di<numElSrc; di++)
-      {
-        newI[di] = di;
-        newJ[di] = indices[di];
-      }
-
-      if (useRobustReject)
-      {
-        int numInliers = 0;
-        float threshold = getRejectionThreshold(distances, Distances.rows, m_rejectionScale);
-        Mat acceptInd = Distances<threshold;
-
-        uchar *accPtr = (uchar*)acceptInd.data;
-        for (int l=0; l<acceptInd.rows; l++)
-        {
-          if (accPtr[l])
-          {
-            newI[numInliers] = l;
-            newJ[numInliers] = indices[l];
-            numInliers++;
-          }
-        }
-        numElSrc=numInliers;
-      }
-
-      // Step 2: Picky ICP
-      // Among the resulting corresponding pairs, if more than one scene point p_i
-      // is assigned to the same model point m_j, then select p_i that corresponds
-      // to the minimum distance
-
-      hashtable_int* duplicateTable = getHashtable(newJ, numElSrc, dstPCS.rows);
-
-      for (di=0; di<duplicateTable->size; di++)
-      {
-        hashnode_i *node = duplicateTable->nodes[di];
-
-        if (node)
-        {
-          // select the first node
-          size_t idx = reinterpret_cast<size_t>(node->data)-1;
-          int dup = (int)node->key-1;
-          size_t minIdxD = idx;
-          float minDist = distances[idx];
+    double fval_min;
+    Matx44d PoseX = registerLevel(srcPCT, dstPCS, flann, TolP, MaxIterationsPyr, m_rejectionScale,
+                                  m_poseUpdateThreshold, fval_min);
 
-          while ( node )
-          {
-            idx = reinterpret_cast<size_t>(node->data)-1;
-
-            if (distances[idx] < minDist)
-            {
-              minDist = distances[idx];
-              minIdxD = idx;
-            }
-
-            node = node->next;
-          }
+    pose = PoseX * pose;
+    residual = tempResidual;
 
-          indicesModel[ selInd ] = newI[ minIdxD ];
-          indicesScene[ selInd ] = dup ;
-          selInd++;
-        }
-      }
+    tempResidual = fval_min;
+    destroyFlann(flann);
+  }
 
-      hashtableDestroy(duplicateTable);
+  denormalizePose(pose, meanAvg, scale);
 
-      if (selInd >= 6)
-      {
+  residual = tempResidual;
 
-        Mat Src_Match = Mat(selInd, srcPCT.cols, CV_64F);
-        Mat Dst_Match = Mat(selInd, srcPCT.cols, CV_64F);
+  return 0;
+}
 
-        for (di=0; di<selInd; di++)
-        {
-          const int indModel = indicesModel[di];
-          const int indScene = indicesScene[di];
-          const float *srcPt = srcPCT.ptr<float>(indModel);
-          const float *dstPt = dstPCS.ptr<float>(indScene);
-          double *srcMatchPt = Src_Match.ptr<double>(di);
-          double *dstMatchPt = Dst_Match.ptr<double>(di);
-          int ci=0;
-
-          for (ci=0; ci<srcPCT.cols; ci++)
-          {
-            srcMatchPt[ci] = (double)srcPt[ci];
-            dstMatchPt[ci] = (double)dstPt[ci];
-          }
-        }
+void ICP::setScene(const Mat& dstPC)
+{
+  CV_CheckGT(dstPC.rows, 0, "");
+  CV_CheckGT(m_numLevels, 0, "");
 
-        Vec3d rpy, t;
-        minimizePointToPlaneMetric(Src_Match, Dst_Match, rpy, t);
-        if (cvIsNaN(cv::trace(rpy)) || cvIsNaN(cv::norm(t)))
-          break;
-        getTransformMat(rpy, t, PoseX);
-        Src_Moved = transformPCPose(srcPCT, PoseX);
+  Ptr<ICPScene> scene = makePtr<ICPScene>();
 
-        double fval = cv::norm(Src_Match, Dst_Match)/(double)(Src_Moved.rows);
+  Mat dstTemp = dstPC.clone();
+  computeMeanCols(dstTemp, scene->mean);
+  subtractColumns(dstTemp, scene->mean);
+  scene->scale = (double)dstTemp.rows / computeDistToOrigin(dstTemp);
+  scalePC(dstTemp, scene->scale);
+
+  // level l keeps every (2^l)-th point, as the model is sampled the same way
+  scene->levels.resize(m_numLevels);
+  scene->indices.resize(m_numLevels, NULL);
+  for (int level = 0; level < m_numLevels; level++)
+  {
+    scene->levels[level] = samplePCUniform(dstTemp, 1 << level);
+    scene->indices[level] = indexPCFlann(scene->levels[level]);
+  }
 
-        // Calculate change in error between iterations
-        fval_perc=fval/fval_old;
+  m_scene = scene;
+}
 
-        // Store error value
-        fval_old=fval;
+int ICP::refinePose(const Mat& srcPC, Matx44d& pose, double& residual)
+{
+  if (m_scene.empty())
+  {
+    CV_Error(cv::Error::StsError, "No scene is set. Call setScene before refining poses");
+  }
 
-        if (fval < fval_min)
-          fval_min = fval;
-      }
-      else
-        break;
+  const ICPScene& scene = *m_scene;
+  const int n = srcPC.rows;
+  CV_CheckGT(n, 0, "");
 
-      i++;
+  // bring the model in its initial pose into the normalized frame of the scene
+  Mat srcPC0 = transformPCPose(srcPC, pose);
+  subtractColumns(srcPC0, scene.mean);
+  scalePC(srcPC0, scene.scale);
 
-    }
+  Matx44d poseICP = Matx44d::eye();
+  residual = 0;
 
-    pose = PoseX * pose;
-    residual = tempResidual;
+  // walk the pyramid
+  for (int level = (int)scene.levels.size()-1; level >=0; level--)
+  {
+    const int numSamples = divUp(n, 1 << level);
+    const double TolP = m_tolerance*(double)(level+1)*(level+1);
+    const int MaxIterationsPyr = cvRound((double)m_maxIterations/(level+1));
+    const int sampleStep = cvRound((double)n/(double)numSamples);
 
-    delete[] newI;
-    delete[] newJ;
-    delete[] indicesModel;
-    delete[] indicesScene;
-    delete[] distances;
-    delete[] indices;
+    Mat srcPCT = transformPCPose(srcPC0, poseICP);
+    srcPCT = samplePCUniform(srcPCT, sampleStep);
 
-    tempResidual = fval_min;
-    destroyFlann(flann);
+    Matx44d PoseX = registerLevel(srcPCT, scene.levels[level], scene.indices[level], TolP, MaxIterationsPyr,
+                                  m_rejectionScale, m_poseUpdateThreshold, residual);
+    poseICP = PoseX * poseICP;
   }
 
-  Matx33d Rpose;
-  Vec3d Cpose;
-  poseToRT(pose, Rpose, Cpose);
-  Cpose = Cpose / scale + meanAvg - Rpose * meanAvg;
-  rtToPose(Rpose, Cpose, pose);
+  denormalizePose(poseICP, scene.mean, scene.scale);
+  pose = poseICP * pose;
 
-  residual = tempResidual;
+  return 0;
+}
 
+int ICP::refinePoses(const Mat& srcPC, std::vector<Pose3DPtr>& poses)
+{
+  parallel_for_(Range(0, (int)poses.size()), [&](const Range& range)
+  {
+    for (int i=range.start; i<range.end; i++)
+    {
+      Matx44d pose = poses[i]->pose;
+      refinePose(srcPC, pose, poses[i]->residual);
+      poses[i]->updatePose(pose);
+    }
+  });
   return 0;
 }
 
 // source point clouds are assumed to contain their normals
 int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, std::vector<Pose3DPtr>& poses)
 {
-  #if defined _OPENMP
-  #pragma omp parallel for
-  #endif
-  for (int i=0; i<(int)poses.size(); i++)
+  parallel_for_(Range(0, (int)poses.size()), [&](const Range& range)
   {
-    Matx44d poseICP = Matx44d::eye();
-    Mat srcTemp = transformPCPose(srcPC, poses[i]->pose);
-    registerModelToScene(srcTemp, dstPC, poses[i]->residual, poseICP);
-    poses[i]->appendPose(poseICP);
-  }
+    for (int i=range.start; i<range.end; i++)
+    {
+      Matx44d poseICP = Matx44d::eye();
+      Mat srcTemp = transformPCPose(srcPC, poses[i]->pose);
+      registerModelToScene(srcTemp, dstPC, poses[i]->residual, poseICP);
+      poses[i]->appendPose(poseICP);
+    }
+  });
   return 0;
 }
 
@@ -0,0 +1,137 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+#include "mapped_file.hpp"
+
+#if defined _WIN32 && !defined WINRT
+#  define PPF_MAPPED_FILE_WIN32 1
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#elif defined __unix__ || defined __APPLE__
+#  define PPF_MAPPED_FILE_POSIX 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace cv
+{
+namespace ppf_match_3d
+{
+
+MappedFile::MappedFile() : data_(NULL), size_(0), mapped_(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(const String& filename)
+{
+  close();
+
+#if defined PPF_MAPPED_FILE_WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+  {
+    CloseHandle(file);
+    return false;
+  }
+
+  // the view keeps the mapping object alive, so both handles can be closed right away
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping)
+    return false;
+
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!view)
+    return false;
+
+  data_ = (const uchar*)view;
+  size_ = (size_t)fileSize.QuadPart;
+  mapped_ = true;
+  return true;
+#elif defined PPF_MAPPED_FILE_POSIX
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED)
+    return false;
+
+  data_ = (const uchar*)view;
+  size_ = (size_t)st.st_size;
+  mapped_ = true;
+  return true;
+#else
+  FILE* f = fopen(filename.c_str(), "rb");
+  if (!f)
+    return false;
+
+  fseek(f, 0, SEEK_END);
+  long fileSize = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (fileSize <= 0)
+  {
+    fclose(f);
+    return false;
+  }
+
+  buffer_.resize((size_t)fileSize);
+  size_t status = fread(&buffer_[0], buffer_.size(), 1, f);
+  fclose(f);
+  if (status != 1)
+  {
+    buffer_.clear();
+    return false;
+  }
+
+  data_ = &buffer_[0];
+  size_ = buffer_.size();
+  return true;
+#endif
+}
+
+void MappedFile::close()
+{
+  if (mapped_)
+  {
+#if defined PPF_MAPPED_FILE_WIN32
+    UnmapViewOfFile((LPCVOID)data_);
+#elif defined PPF_MAPPED_FILE_POSIX
+    munmap((void*)data_, size_);
+#endif
+  }
+
+  std::vector<uchar>().swap(buffer_);
+  data_ = NULL;
+  size_ = 0;
+  mapped_ = false;
+}
+
+} // namespace ppf_match_3d
+
+} // namespace cv
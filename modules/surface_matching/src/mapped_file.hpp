@@ -0,0 +1,48 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef __OPENCV_SURFACE_MATCHING_MAPPED_FILE_HPP__
+#define __OPENCV_SURFACE_MATCHING_MAPPED_FILE_HPP__
+
+#include <vector>
+
+namespace cv
+{
+namespace ppf_match_3d
+{
+
+/**
+ *  \brief Read-only view of a whole file.
+ *
+ *  \details The file is memory-mapped where the platform supports it, so that the
+ *  pages are loaded on demand and shared between the processes mapping the same file.
+ *  On other platforms the contents are read into a private buffer.
+ */
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  bool open(const String& filename);
+  void close();
+
+  const uchar* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  const uchar* data_;
+  size_t size_;
+  bool mapped_;
+  std::vector<uchar> buffer_;
+};
+
+} // namespace ppf_match_3d
+
+} // namespace cv
+
+#endif
@@ -573,38 +573,38 @@ Mat transformPCPose(Mat pc, const Matx44d& Pose)
   Vec3d t;
   poseToRT(Pose, R, t);
 
-#if defined _OPENMP
-#pragma omp parallel for
-#endif
-  for (int i=0; i<pc.rows; i++)
+  parallel_for_(Range(0, pc.rows), [&](const Range& range)
   {
-    const float *pcData = pc.ptr<float>(i);
-    const Vec3f n1(&pcData[3]);
-
-    Vec4d p = Pose * Vec4d(pcData[0], pcData[1], pcData[2], 1);
-    Vec3d p2(p.val);
-
-    // p2[3] should normally be 1
-    if (fabs(p[3]) > EPS)
+    for (int i=range.start; i<range.end; i++)
     {
-      Mat((1.0 / p[3]) * p2).reshape(1, 1).convertTo(pct.row(i).colRange(0, 3), CV_32F);
-    }
+      const float *pcData = pc.ptr<float>(i);
+      const Vec3f n1(&pcData[3]);
 
-    // If the point cloud has normals,
-    // then rotate them as well
-    if (pc.cols == 6)
-    {
-      Vec3d n(n1), n2;
+      Vec4d p = Pose * Vec4d(pcData[0], pcData[1], pcData[2], 1);
+      Vec3d p2(p.val);
 
-      n2 = R * n;
-      double nNorm = cv::norm(n2);
+      // p2[3] should normally be 1
+      if (fabs(p[3]) > EPS)
+      {
+        Mat((1.0 / p[3]) * p2).reshape(1, 1).convertTo(pct.row(i).colRange(0, 3), CV_32F);
+      }
 
-      if (nNorm > EPS)
+      // If the point cloud has normals,
+      // then rotate them as well
+      if (pc.cols == 6)
       {
-        Mat((1.0 / nNorm) * n2).reshape(1, 1).convertTo(pct.row(i).colRange(3, 6), CV_32F);
+        Vec3d n(n1), n2;
+
+        n2 = R * n;
+        double nNorm = cv::norm(n2);
+
+        if (nNorm > EPS)
+        {
+          Mat((1.0 / nNorm) * n2).reshape(1, 1).convertTo(pct.row(i).colRange(3, 6), CV_32F);
+        }
       }
     }
-  }
+  });
 
   return pct;
 }
@@ -699,8 +699,6 @@ void meanCovLocalPCInd(const Mat& pc, const int* Indices, const int point_count,
 
 int computeNormalsPC3d(const Mat& PC, Mat& PCNormals, const int NumNeighbors, const bool FlipViewpoint, const Vec3f& viewpoint)
 {
-  int i;
-
   if (PC.cols!=3 && PC.cols!=6) // 3d data is expected
   {
     //return -1;
@@ -720,31 +718,31 @@ int computeNormalsPC3d(const Mat& PC, Mat& PCNormals, const int NumNeighbors, co
   destroyFlann(flannIndex);
   flannIndex = 0;
 
-#if defined _OPENMP
-#pragma omp parallel for
-#endif
-  for (i=0; i<PC.rows; i++)
+  parallel_for_(Range(0, PC.rows), [&](const Range& range)
   {
-    Matx33d C;
-    Vec3d mu;
-    const int* indLocal = Indices.ptr<int>(i);
+    for (int i=range.start; i<range.end; i++)
+    {
+      Matx33d C;
+      Vec3d mu;
+      const int* indLocal = Indices.ptr<int>(i);
 
-    // compute covariance matrix
-    meanCovLocalPCInd(PCNormals, indLocal, NumNeighbors, C, mu);
+      // compute covariance matrix
+      meanCovLocalPCInd(PCNormals, indLocal, NumNeighbors, C, mu);
 
-    // eigenvectors of covariance matrix
-    Mat eigVect, eigVal;
-    eigen(C, eigVal, eigVect);
-    eigVect.row(2).convertTo(PCNormals.row(i).colRange(3, 6), CV_32F);
+      // eigenvectors of covariance matrix
+      Mat eigVect, eigVal;
+      eigen(C, eigVal, eigVect);
+      eigVect.row(2).convertTo(PCNormals.row(i).colRange(3, 6), CV_32F);
 
-    if (FlipViewpoint)
-    {
-      Vec3f nr(PCNormals.ptr<float>(i) + 3);
-      Vec3f pci(PCNormals.ptr<float>(i));
-      flipNormalViewpoint(pci, viewpoint, nr);
-      Mat(nr).reshape(1, 1).copyTo(PCNormals.row(i).colRange(3, 6));
+      if (FlipViewpoint)
+      {
+        Vec3f nr(PCNormals.ptr<float>(i) + 3);
+        Vec3f pci(PCNormals.ptr<float>(i));
+        flipNormalViewpoint(pci, viewpoint, nr);
+        Mat(nr).reshape(1, 1).copyTo(PCNormals.row(i).colRange(3, 6));
+      }
     }
-  }
+  });
 
   return 1;
 }
@@ -40,6 +40,7 @@
 
 #include "precomp.hpp"
 #include "hash_murmur.hpp"
+#include "mapped_file.hpp"
 
 namespace cv
 {
@@ -48,6 +49,90 @@ namespace ppf_match_3d
 
 static const size_t PPF_LENGTH = 5;
 
+// Layout of the model files written by saveModel. Every table starts at a
+// PPF_MODEL_ALIGNMENT aligned offset, so that it can be used in place once mapped.
+static const char PPF_MODEL_MAGIC[8] = {'C', 'V', 'P', 'P', 'F', '3', 'D', '\0'};
+static const uint PPF_MODEL_VERSION = 2;
+static const uint PPF_MODEL_ENDIAN_TAG = 0x01020304;
+static const size_t PPF_MODEL_ALIGNMENT = 64;
+
+struct PPFModelHeader
+{
+  char magic[8];
+  uint version;
+  uint endianTag;
+
+  double angleStep, angleStepRadians, distanceStep;
+  double samplingStepRelative, angleStepRelative, distanceStepRelative;
+  double positionThreshold, rotationThreshold;
+  int useWeightedAvg, numRefPoints;
+
+  int sampledRows, sampledCols;
+  int ppfRows, ppfCols;
+  int numSlots, numNodes;
+
+  uint64 sampledOffset, ppfOffset, slotsOffset, nodesOffset;
+  uint64 fileSize;
+};
+
+// entry of the open addressing directory over the key sorted hash nodes,
+// an empty slot has no nodes
+struct HashSlot
+{
+  KeyType key;
+  int first, count;
+};
+
+// the probe sequence visits every slot at most once, even if the directory is full
+static inline const HashSlot* findHashSlot(const HashSlot* slots, uint mask, KeyType key)
+{
+  uint s = key & mask;
+  for (uint probe = 0; probe <= mask && slots[s].count; probe++, s = (s + 1) & mask)
+  {
+    if (slots[s].key == key)
+      return &slots[s];
+  }
+  return NULL;
+}
+
+// checks that everything match() indexes with stays inside the mapped tables
+static bool validateModelTables(const Mat& ppf, const Mat& slots, const Mat& nodes, int numRefPoints)
+{
+  const HashSlot* directory = slots.ptr<HashSlot>();
+  bool hasEmptySlot = false;
+  for (int s = 0; s < slots.rows; s++)
+  {
+    const HashSlot& slot = directory[s];
+    if (slot.count == 0)
+    {
+      hasEmptySlot = true;
+      continue;
+    }
+    if (slot.count < 0 || slot.first < 0 || (int64)slot.first + slot.count > nodes.rows)
+      return false;
+  }
+  if (!hasEmptySlot)
+    return false;
+
+  // the alpha angles of the model pairs come from atan2, the vote indices are derived from them
+  const THash* hashNodes = nodes.ptr<THash>();
+  for (int k = 0; k < nodes.rows; k++)
+  {
+    if ((unsigned)hashNodes[k].i >= (unsigned)numRefPoints || (unsigned)hashNodes[k].ppfInd >= (unsigned)ppf.rows)
+      return false;
+
+    const float alpha = ppf.ptr<float>(hashNodes[k].ppfInd)[PPF_LENGTH-1];
+    if (!(std::abs(alpha) <= (float)CV_PI))
+      return false;
+  }
+  return true;
+}
+
+static inline uint64 alignModelOffset(uint64 offset)
+{
+  return (offset + PPF_MODEL_ALIGNMENT - 1) & ~(uint64)(PPF_MODEL_ALIGNMENT - 1);
+}
+
 // routines for assisting sort
 static bool pose3DPtrCompare(const Pose3DPtr& a, const Pose3DPtr& b)
 {
@@ -125,9 +210,7 @@ PPF3DDetector::PPF3DDetector()
   angle_step_radians = (360.0/angle_step_relative)*M_PI/180.0;
   angle_step = angle_step_radians;
   trained = false;
-
-  hash_table = NULL;
-  hash_nodes = NULL;
+  num_ref_points = 0;
 
   setSearchParams();
 }
@@ -141,9 +224,7 @@ PPF3DDetector::PPF3DDetector(const double RelativeSamplingStep, const double Rel
   //SceneSampleStep = 1.0/RelativeSceneSampleStep;
   angle_step = angle_step_radians;
   trained = false;
-
-  hash_table = NULL;
-  hash_nodes = NULL;
+  num_ref_points = 0;
 
   setSearchParams();
 }
@@ -181,17 +262,63 @@ void PPF3DDetector::computePPFFeatures(const Vec3d& p1, const Vec3d& n1,
 
 void PPF3DDetector::clearTrainingModels()
 {
-  if (this->hash_nodes)
+  sampled_pc.release();
+  ppf.release();
+  hash_slots.release();
+  hash_nodes.release();
+  model_file.release();
+  num_ref_points = 0;
+  trained = false;
+}
+
+static bool hashNodeCompare(const THash& a, const THash& b)
+{
+  if (a.id != b.id)
+    return (KeyType)a.id < (KeyType)b.id;
+  return a.ppfInd < b.ppfInd;
+}
+
+// Bulk builds the PPF hash table. The nodes are sorted by key, so that all the
+// model pairs sharing a quantized feature are stored contiguously. An open
+// addressing directory with linear probing then maps every distinct key to its
+// run of nodes. Both tables are flat and can be stored and mapped as they are.
+static void buildHashTable(std::vector<THash>& nodes, Mat& slots, Mat& sortedNodes)
+{
+  std::sort(nodes.begin(), nodes.end(), hashNodeCompare);
+
+  int numKeys = 0;
+  for (size_t k = 0; k < nodes.size(); k++)
   {
-    free(this->hash_nodes);
-    this->hash_nodes=0;
+    if (k == 0 || nodes[k].id != nodes[k-1].id)
+      numKeys++;
   }
 
-  if (this->hash_table)
+  // keep the load factor at or below 1/2 so that the probe sequences stay short
+  const int numSlots = (int)next_power_of_two((uint)std::max(16, 2*numKeys));
+  const uint mask = (uint)numSlots - 1;
+  slots = Mat::zeros(numSlots, 1, CV_32SC3);
+  HashSlot* directory = slots.ptr<HashSlot>();
+
+  for (size_t first = 0; first < nodes.size(); )
   {
-    hashtableDestroy(this->hash_table);
-    this->hash_table=0;
+    const KeyType key = (KeyType)nodes[first].id;
+    size_t last = first + 1;
+    while (last < nodes.size() && (KeyType)nodes[last].id == key)
+      last++;
+
+    uint s = key & mask;
+    while (directory[s].count)
+      s = (s + 1) & mask;
+
+    directory[s].key = key;
+    directory[s].first = (int)first;
+    directory[s].count = (int)(last - first);
+    first = last;
   }
+
+  sortedNodes.create((int)nodes.size(), 1, CV_32SC3);
+  if (!nodes.empty())
+    memcpy(sortedNodes.ptr<THash>(), &nodes[0], nodes.size()*sizeof(THash));
 }
 
 PPF3DDetector::~PPF3DDetector()
@@ -204,6 +331,8 @@ void PPF3DDetector::trainModel(const Mat &PC)
 {
   CV_Assert(PC.type() == CV_32F || PC.type() == CV_32FC1);
 
+  clearTrainingModels();
+
   // compute bbox
   Vec2f xRange, yRange, zRange;
   computeBboxStd(PC, xRange, yRange, zRange);
@@ -218,66 +347,214 @@ void PPF3DDetector::trainModel(const Mat &PC)
 
   Mat sampled = samplePCByQuantization(PC, xRange, yRange, zRange, (float)sampling_step_relative,0);
 
-  int size = sampled.rows*sampled.rows;
-
-  hashtable_int* hashTable = hashtableCreate(size, NULL);
-
   int numPPF = sampled.rows*sampled.rows;
-  ppf = Mat(numPPF, PPF_LENGTH, CV_32FC1);
+  ppf = Mat::zeros(numPPF, PPF_LENGTH, CV_32FC1);
 
   // TODO: Maybe I could sample 1/5th of them here. Check the performance later.
   int numRefPoints = sampled.rows;
 
-  // pre-allocate the hash nodes
-  hash_nodes = (THash*)calloc(numRefPoints*numRefPoints, sizeof(THash));
+  // one hash node per ordered pair of distinct reference points. The nodes are
+  // only collected here, the table is built from them in one go afterwards.
+  std::vector<THash> hashNodes((size_t)numRefPoints*(numRefPoints-1));
 
-  // TODO : This can easily be parallelized. But we have to lock hashtable_insert.
-  // I realized that performance drops when this loop is parallelized (unordered
-  // inserts into the hashtable
-  // But it is still there to be investigated. For now, I leave this unparallelized
-  // since this is just a training part.
-  for (int i=0; i<numRefPoints; i++)
+  // every reference point writes its own rows of the PPF table and its own
+  // range of nodes, hence the reference points are processed independently
+  parallel_for_(Range(0, numRefPoints), [&](const Range& range)
   {
-    const Vec3f p1(sampled.ptr<float>(i));
-    const Vec3f n1(sampled.ptr<float>(i) + 3);
-
-    //printf("///////////////////// NEW REFERENCE ////////////////////////\n");
-    for (int j=0; j<numRefPoints; j++)
+    for (int i=range.start; i<range.end; i++)
     {
-      // cannot compute the ppf with myself
-      if (i!=j)
-      {
-        const Vec3f p2(sampled.ptr<float>(j));
-        const Vec3f n2(sampled.ptr<float>(j) + 3);
+      const Vec3f p1(sampled.ptr<float>(i));
+      const Vec3f n1(sampled.ptr<float>(i) + 3);
+      THash* rowNodes = hashNodes.data() + (size_t)i*(numRefPoints-1);
 
-        Vec4d f = Vec4d::all(0);
-        computePPFFeatures(p1, n1, p2, n2, f);
-        KeyType hashValue = hashPPF(f, angle_step_radians, distanceStep);
-        double alpha = computeAlpha(p1, n1, p2);
-        uint ppfInd = i*numRefPoints+j;
-
-        THash* hashNode = &hash_nodes[i*numRefPoints+j];
-        hashNode->id = hashValue;
-        hashNode->i = i;
-        hashNode->ppfInd = ppfInd;
-
-        hashtableInsertHashed(hashTable, hashValue, (void*)hashNode);
-
-        Mat(f).reshape(1, 1).convertTo(ppf.row(ppfInd).colRange(0, 4), CV_32F);
-        ppf.ptr<float>(ppfInd)[4] = (float)alpha;
+      //printf("///////////////////// NEW REFERENCE ////////////////////////\n");
+      for (int j=0; j<numRefPoints; j++)
+      {
+        // cannot compute the ppf with myself
+        if (i!=j)
+        {
+          const Vec3f p2(sampled.ptr<float>(j));
+          const Vec3f n2(sampled.ptr<float>(j) + 3);
+
+          Vec4d f = Vec4d::all(0);
+          computePPFFeatures(p1, n1, p2, n2, f);
+          KeyType hashValue = hashPPF(f, angle_step_radians, distanceStep);
+          double alpha = computeAlpha(p1, n1, p2);
+          uint ppfInd = i*numRefPoints+j;
+
+          THash* hashNode = &rowNodes[j < i ? j : j-1];
+          hashNode->id = hashValue;
+          hashNode->i = i;
+          hashNode->ppfInd = ppfInd;
+
+          Mat(f).reshape(1, 1).convertTo(ppf.row(ppfInd).colRange(0, 4), CV_32F);
+          ppf.ptr<float>(ppfInd)[4] = (float)alpha;
+        }
       }
     }
-  }
+  });
+
+  buildHashTable(hashNodes, hash_slots, hash_nodes);
 
   angle_step = angle_step_radians;
   distance_step = distanceStep;
-  hash_table = hashTable;
   num_ref_points = numRefPoints;
   sampled_pc = sampled;
   trained = true;
 }
 
+///////////////////////// MODEL I/O ////////////////////////////////////////
 
+static void writeModelSection(FILE* f, const Mat& m, uint64 offset)
+{
+  uint64 pos = (uint64)ftell(f);
+  CV_Assert(pos <= offset);
+
+  static const char padding[PPF_MODEL_ALIGNMENT] = {0};
+  if (offset > pos)
+    fwrite(padding, (size_t)(offset - pos), 1, f);
+
+  const size_t rowSize = m.cols * m.elemSize();
+  for (int r = 0; r < m.rows; r++)
+    fwrite(m.ptr(r), rowSize, 1, f);
+}
+
+void PPF3DDetector::saveModel(const String& filename) const
+{
+  if (!trained)
+  {
+    CV_Error(cv::Error::StsError, "The model is not trained. Cannot save an untrained model");
+  }
+
+  PPFModelHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, PPF_MODEL_MAGIC, sizeof(header.magic));
+  header.version = PPF_MODEL_VERSION;
+  header.endianTag = PPF_MODEL_ENDIAN_TAG;
+
+  header.angleStep = angle_step;
+  header.angleStepRadians = angle_step_radians;
+  header.distanceStep = distance_step;
+  header.samplingStepRelative = sampling_step_relative;
+  header.angleStepRelative = angle_step_relative;
+  header.distanceStepRelative = distance_step_relative;
+  header.positionThreshold = position_threshold;
+  header.rotationThreshold = rotation_threshold;
+  header.useWeightedAvg = use_weighted_avg ? 1 : 0;
+  header.numRefPoints = num_ref_points;
+
+  header.sampledRows = sampled_pc.rows;
+  header.sampledCols = sampled_pc.cols;
+  header.ppfRows = ppf.rows;
+  header.ppfCols = ppf.cols;
+  header.numSlots = hash_slots.rows;
+  header.numNodes = hash_nodes.rows;
+
+  header.sampledOffset = alignModelOffset(sizeof(header));
+  header.ppfOffset = alignModelOffset(header.sampledOffset + sampled_pc.total() * sampled_pc.elemSize());
+  header.slotsOffset = alignModelOffset(header.ppfOffset + ppf.total() * ppf.elemSize());
+  header.nodesOffset = alignModelOffset(header.slotsOffset + hash_slots.total() * hash_slots.elemSize());
+  header.fileSize = header.nodesOffset + hash_nodes.total() * hash_nodes.elemSize();
+
+  FILE* f = fopen(filename.c_str(), "wb");
+  if (!f)
+  {
+    CV_Error(cv::Error::StsError, "Cannot open " + filename + " for writing");
+  }
+
+  fwrite(&header, sizeof(header), 1, f);
+  writeModelSection(f, sampled_pc, header.sampledOffset);
+  writeModelSection(f, ppf, header.ppfOffset);
+  writeModelSection(f, hash_slots, header.slotsOffset);
+  writeModelSection(f, hash_nodes, header.nodesOffset);
+
+  const bool ok = !ferror(f) && (uint64)ftell(f) == header.fileSize;
+  fclose(f);
+
+  if (!ok)
+  {
+    CV_Error(cv::Error::StsError, "Failed to write the model to " + filename);
+  }
+}
+
+void PPF3DDetector::loadModel(const String& filename)
+{
+  clearTrainingModels();
+
+  Ptr<MappedFile> file = makePtr<MappedFile>();
+  if (!file->open(filename))
+  {
+    CV_Error(cv::Error::StsError, "Cannot open the model file " + filename);
+  }
+
+  const uchar* data = file->data();
+  const size_t fileSize = file->size();
+
+  PPFModelHeader header;
+  if (fileSize < sizeof(header))
+  {
+    CV_Error(cv::Error::StsParseError, "The model file " + filename + " is truncated");
+  }
+  memcpy(&header, data, sizeof(header));
+
+  if (memcmp(header.magic, PPF_MODEL_MAGIC, sizeof(header.magic)) != 0)
+  {
+    CV_Error(cv::Error::StsParseError, filename + " is not a PPF model file");
+  }
+  if (header.endianTag != PPF_MODEL_ENDIAN_TAG)
+  {
+    CV_Error(cv::Error::StsParseError, "The model file " + filename + " was written on a platform with different byte order");
+  }
+  if (header.version != PPF_MODEL_VERSION)
+  {
+    CV_Error(cv::Error::StsParseError, cv::format("Unsupported PPF model version %u (expected %u)", header.version, PPF_MODEL_VERSION));
+  }
+
+  CV_Assert(header.sampledRows > 0 && header.sampledCols >= 6);
+  CV_Assert(header.ppfRows > 0 && header.ppfCols == (int)PPF_LENGTH);
+  CV_Assert(header.numSlots > 0 && (header.numSlots & (header.numSlots - 1)) == 0 && header.numNodes >= 0);
+  CV_Assert(header.numRefPoints == header.sampledRows);
+  CV_Assert(header.fileSize == (uint64)fileSize);
+  if (!(header.angleStep > 0 && header.angleStep <= 2*CV_PI && header.distanceStep > 0 && cvIsInf(header.distanceStep) == 0))
+  {
+    CV_Error(cv::Error::StsParseError, "The model file " + filename + " is corrupted");
+  }
+
+  const uint64 sampledEnd = header.sampledOffset + (uint64)header.sampledRows * header.sampledCols * sizeof(float);
+  const uint64 ppfEnd = header.ppfOffset + (uint64)header.ppfRows * header.ppfCols * sizeof(float);
+  const uint64 slotsEnd = header.slotsOffset + (uint64)header.numSlots * sizeof(HashSlot);
+  const uint64 nodesEnd = header.nodesOffset + (uint64)header.numNodes * sizeof(THash);
+  if (sampledEnd > fileSize || ppfEnd > fileSize || slotsEnd > fileSize || nodesEnd > fileSize)
+  {
+    CV_Error(cv::Error::StsParseError, "The model file " + filename + " is corrupted");
+  }
+
+  // the tables are used in place, the mapping is released together with the model
+  sampled_pc = Mat(header.sampledRows, header.sampledCols, CV_32F, (void*)(data + header.sampledOffset));
+  ppf = Mat(header.ppfRows, header.ppfCols, CV_32F, (void*)(data + header.ppfOffset));
+  hash_slots = Mat(header.numSlots, 1, CV_32SC3, (void*)(data + header.slotsOffset));
+  hash_nodes = Mat(header.numNodes, 1, CV_32SC3, (void*)(data + header.nodesOffset));
+
+  if (!validateModelTables(ppf, hash_slots, hash_nodes, header.numRefPoints))
+  {
+    clearTrainingModels();
+    CV_Error(cv::Error::StsParseError, "The model file " + filename + " is corrupted");
+  }
+
+  angle_step = header.angleStep;
+  angle_step_radians = header.angleStepRadians;
+  distance_step = header.distanceStep;
+  sampling_step_relative = header.samplingStepRelative;
+  angle_step_relative = header.angleStepRelative;
+  distance_step_relative = header.distanceStepRelative;
+  position_threshold = header.positionThreshold;
+  rotation_threshold = header.rotationThreshold;
+  use_weighted_avg = header.useWeightedAvg != 0;
+  num_ref_points = header.numRefPoints;
+
+  model_file = file;
+  trained = true;
+}
 
 ///////////////////////// MATCHING ////////////////////////////////////////
 
@@ -333,75 +610,75 @@ void PPF3DDetector::clusterPoses(std::vector<Pose3DPtr>& poseList, int numPoses,
 
   if (use_weighted_avg)
   {
-#if defined _OPENMP
-#pragma omp parallel for
-#endif
     // uses weighting by the number of votes
-    for (int i=0; i<static_cast<int>(poseClusters.size()); i++)
+    parallel_for_(Range(0, static_cast<int>(poseClusters.size())), [&](const Range& range)
     {
-      // We could only average the quaternions. So I will make use of them here
-      Vec4d qAvg = Vec4d::all(0);
-      Vec3d tAvg = Vec3d::all(0);
+      for (int i=range.start; i<range.end; i++)
+      {
+        // We could only average the quaternions. So I will make use of them here
+        Vec4d qAvg = Vec4d::all(0);
+        Vec3d tAvg = Vec3d::all(0);
 
-      // Perform the final averaging
-      PoseCluster3DPtr curCluster = poseClusters[i];
-      std::vector<Pose3DPtr> curPoses = curCluster->poseList;
-      int curSize = (int)curPoses.size();
-      size_t numTotalVotes = 0;
+        // Perform the final averaging
+        PoseCluster3DPtr curCluster = poseClusters[i];
+        std::vector<Pose3DPtr> curPoses = curCluster->poseList;
+        int curSize = (int)curPoses.size();
+        size_t numTotalVotes = 0;
 
-      for (int j=0; j<curSize; j++)
-        numTotalVotes += curPoses[j]->numVotes;
+        for (int j=0; j<curSize; j++)
+          numTotalVotes += curPoses[j]->numVotes;
 
-      double wSum=0;
+        double wSum=0;
 
-      for (int j=0; j<curSize; j++)
-      {
-        const double w = (double)curPoses[j]->numVotes / (double)numTotalVotes;
+        for (int j=0; j<curSize; j++)
+        {
+          const double w = (double)curPoses[j]->numVotes / (double)numTotalVotes;
 
-        qAvg += w * curPoses[j]->q;
-        tAvg += w * curPoses[j]->t;
-        wSum += w;
-      }
+          qAvg += w * curPoses[j]->q;
+          tAvg += w * curPoses[j]->t;
+          wSum += w;
+        }
 
-      tAvg *= 1.0 / wSum;
-      qAvg *= 1.0 / wSum;
+        tAvg *= 1.0 / wSum;
+        qAvg *= 1.0 / wSum;
 
-      curPoses[0]->updatePoseQuat(qAvg, tAvg);
-      curPoses[0]->numVotes=curCluster->numVotes;
+        curPoses[0]->updatePoseQuat(qAvg, tAvg);
+        curPoses[0]->numVotes=curCluster->numVotes;
 
-      finalPoses[i]=curPoses[0]->clone();
-    }
+        finalPoses[i]=curPoses[0]->clone();
+      }
+    });
   }
   else
   {
-#if defined _OPENMP
-#pragma omp parallel for
-#endif
-    for (int i=0; i<static_cast<int>(poseClusters.size()); i++)
+    parallel_for_(Range(0, static_cast<int>(poseClusters.size())), [&](const Range& range)
     {
-      // We could only average the quaternions. So I will make use of them here
-      Vec4d qAvg = Vec4d::all(0);
-      Vec3d tAvg = Vec3d::all(0);
+      for (int i=range.start; i<range.end; i++)
+      {
+        // We could only average the quaternions. So I will make use of them here
+        Vec4d qAvg = Vec4d::all(0);
+        Vec3d tAvg = Vec3d::all(0);
 
-      // Perform the final averaging
-      PoseCluster3DPtr curCluster = poseClusters[i];
-      std::vector<Pose3DPtr> curPoses = curCluster->poseList;
-      const int curSize = (int)curPoses.size();
+        // Perform the final averaging
+        PoseCluster3DPtr curCluster = poseClusters[i];
+        std::vector<Pose3DPtr> curPoses = curCluster->poseList;
+        const int curSize = (int)curPoses.size();
 
-      for (int j=0; j<curSize; j++)
-      {
-        qAvg += curPoses[j]->q;
-        tAvg += curPoses[j]->t;
-      }
+        for (int j=0; j<curSize; j++)
+        {
+          qAvg += curPoses[j]->q;
+          tAvg += curPoses[j]->t;
+        }
 
-      tAvg *= 1.0 / curSize;
-      qAvg *= 1.0 / curSize;
+        tAvg *= 1.0 / curSize;
+        qAvg *= 1.0 / curSize;
 
-      curPoses[0]->updatePoseQuat(qAvg, tAvg);
-      curPoses[0]->numVotes=curCluster->numVotes;
+        curPoses[0]->updatePoseQuat(qAvg, tAvg);
+        curPoses[0]->numVotes=curCluster->numVotes;
 
-      finalPoses[i]=curPoses[0]->clone();
-    }
+        finalPoses[i]=curPoses[0]->clone();
+      }
+    });
   }
 
   poseClusters.clear();
@@ -425,6 +702,9 @@ void PPF3DDetector::match(const Mat& pc, std::vector<Pose3DPtr>& results, const
   uint n = num_ref_points;
   std::vector<Pose3DPtr> poseList;
   int sceneSamplingStep = scene_sample_step;
+  const HashSlot* hashSlots = hash_slots.ptr<HashSlot>();
+  const THash* hashNodes = hash_nodes.ptr<THash>();
+  const uint slotMask = (uint)hash_slots.rows - 1;
 
   // compute bbox
   Vec2f xRange, yRange, zRange;
@@ -438,153 +718,149 @@ void PPF3DDetector::match(const Mat& pc, std::vector<Pose3DPtr>& results, const
   float distanceSampleStep = diameter * RelativeSceneDistance;*/
   Mat sampled = samplePCByQuantization(pc, xRange, yRange, zRange, (float)relativeSceneDistance, 0);
 
-  // allocate the accumulator : Moved this to the inside of the loop
-  /*#if !defined (_OPENMP)
-     uint* accumulator = (uint*)calloc(numAngles*n, sizeof(uint));
-  #endif*/
+  // every sampled scene point casts its votes and produces exactly one pose,
+  // which is stored at its own index so that the list does not depend on the scheduling
+  const int numScenePoints = divUp(sampled.rows, sceneSamplingStep);
+  poseList.resize(numScenePoints);
 
-  poseList.reserve((sampled.rows/sceneSamplingStep)+4);
-
-#if defined _OPENMP
-#pragma omp parallel for
-#endif
-  for (int i = 0; i < sampled.rows; i += sceneSamplingStep)
+  // the scene points are split into one stripe per thread, every stripe owns an
+  // accumulator, which is cleared while it is being maximized and reused for the
+  // next scene point
+  parallel_for_(Range(0, numScenePoints), [&](const Range& range)
   {
-    uint refIndMax = 0, alphaIndMax = 0;
-    uint maxVotes = 0;
+    std::vector<uint> accumulatorBuf((size_t)numAngles*n, 0);
+    uint* accumulator = &accumulatorBuf[0];
+
+    for (int sceneInd = range.start; sceneInd < range.end; sceneInd++)
+    {
+      const int i = sceneInd * sceneSamplingStep;
+      uint refIndMax = 0, alphaIndMax = 0;
+      uint maxVotes = 0;
 
-    const Vec3f p1(sampled.ptr<float>(i));
-    const Vec3f n1(sampled.ptr<float>(i) + 3);
-    Vec3d tsg = Vec3d::all(0);
-    Matx33d Rsg = Matx33d::all(0), RInv = Matx33d::all(0);
+      const Vec3f p1(sampled.ptr<float>(i));
+      const Vec3f n1(sampled.ptr<float>(i) + 3);
+      Vec3d tsg = Vec3d::all(0);
+      Matx33d Rsg = Matx33d::all(0), RInv = Matx33d::all(0);
 
-    uint* accumulator = (uint*)calloc(numAngles*n, sizeof(uint));
-    computeTransformRT(p1, n1, Rsg, tsg);
+      computeTransformRT(p1, n1, Rsg, tsg);
 
-    // Tolga Birdal's notice:
-    // As a later update, we might want to look into a local neighborhood only
-    // To do this, simply search the local neighborhood by radius look up
-    // and collect the neighbors to compute the relative pose
+      // Tolga Birdal's notice:
+      // As a later update, we might want to look into a local neighborhood only
+      // To do this, simply search the local neighborhood by radius look up
+      // and collect the neighbors to compute the relative pose
 
-    for (int j = 0; j < sampled.rows; j ++)
-    {
-      if (i!=j)
+      for (int j = 0; j < sampled.rows; j ++)
       {
-        const Vec3f p2(sampled.ptr<float>(j));
-        const Vec3f n2(sampled.ptr<float>(j) + 3);
-        Vec3d p2t;
-        double alpha_scene;
-
-        Vec4d f = Vec4d::all(0);
-        computePPFFeatures(p1, n1, p2, n2, f);
-        KeyType hashValue = hashPPF(f, angle_step, distanceStep);
+        if (i!=j)
+        {
+          const Vec3f p2(sampled.ptr<float>(j));
+          const Vec3f n2(sampled.ptr<float>(j) + 3);
+          Vec3d p2t;
+          double alpha_scene;
 
-        p2t = tsg + Rsg * Vec3d(p2);
+          Vec4d f = Vec4d::all(0);
+          computePPFFeatures(p1, n1, p2, n2, f);
+          KeyType hashValue = hashPPF(f, angle_step, distanceStep);
 
-        alpha_scene=atan2(-p2t[2], p2t[1]);
+          p2t = tsg + Rsg * Vec3d(p2);
 
-        if ( alpha_scene != alpha_scene)
-        {
-          continue;
-        }
+          alpha_scene=atan2(-p2t[2], p2t[1]);
 
-        if (sin(alpha_scene)*p2t[2]<0.0)
-          alpha_scene=-alpha_scene;
+          if ( alpha_scene != alpha_scene)
+          {
+            continue;
+          }
 
-        alpha_scene=-alpha_scene;
+          if (sin(alpha_scene)*p2t[2]<0.0)
+            alpha_scene=-alpha_scene;
 
-        hashnode_i* node = hashtableGetBucketHashed(hash_table, (hashValue));
+          alpha_scene=-alpha_scene;
 
-        while (node)
-        {
-          THash* tData = (THash*) node->data;
-          int corrI = (int)tData->i;
-          int ppfInd = (int)tData->ppfInd;
-          float* ppfCorrScene = ppf.ptr<float>(ppfInd);
-          double alpha_model = (double)ppfCorrScene[PPF_LENGTH-1];
-          double alpha = alpha_model - alpha_scene;
-
-          /*  Tolga Birdal's note: Map alpha to the indices:
-                  atan2 generates results in (-pi pi]
-                  That's why alpha should be in range [-2pi 2pi]
-                  So the quantization would be :
-                  numAngles * (alpha+2pi)/(4pi)
-                  */
-
-          //printf("%f\n", alpha);
-          int alpha_index = (int)(numAngles*(alpha + 2*M_PI) / (4*M_PI));
-
-          uint accIndex = corrI * numAngles + alpha_index;
-
-          accumulator[accIndex]++;
-          node = node->next;
+          const HashSlot* slot = findHashSlot(hashSlots, slotMask, hashValue);
+          if (!slot)
+            continue;
+
+          for (int k = slot->first; k < slot->first + slot->count; k++)
+          {
+            const THash* tData = &hashNodes[k];
+            int corrI = (int)tData->i;
+            int ppfInd = (int)tData->ppfInd;
+            float* ppfCorrScene = ppf.ptr<float>(ppfInd);
+            double alpha_model = (double)ppfCorrScene[PPF_LENGTH-1];
+            double alpha = alpha_model - alpha_scene;
+
+            /*  Tolga Birdal's note: Map alpha to the indices:
+                    atan2 generates results in (-pi pi]
+                    That's why alpha should be in range [-2pi 2pi]
+                    So the quantization would be :
+                    numAngles * (alpha+2pi)/(4pi)
+                    */
+
+            //printf("%f\n", alpha);
+            int alpha_index = (int)(numAngles*(alpha + 2*M_PI) / (4*M_PI));
+
+            uint accIndex = corrI * numAngles + alpha_index;
+
+            accumulator[accIndex]++;
+          }
         }
       }
-    }
 
-    // Maximize the accumulator
-    for (uint k = 0; k < n; k++)
-    {
-      for (int j = 0; j < numAngles; j++)
+      // Maximize the accumulator
+      for (uint k = 0; k < n; k++)
       {
-        const uint accInd = k*numAngles + j;
-        const uint accVal = accumulator[ accInd ];
-        if (accVal > maxVotes)
+        for (int j = 0; j < numAngles; j++)
         {
-          maxVotes = accVal;
-          refIndMax = k;
-          alphaIndMax = j;
+          const uint accInd = k*numAngles + j;
+          const uint accVal = accumulator[ accInd ];
+          if (accVal > maxVotes)
+          {
+            maxVotes = accVal;
+            refIndMax = k;
+            alphaIndMax = j;
+          }
+
+          accumulator[accInd] = 0;
         }
-
-#if !defined (_OPENMP)
-        accumulator[accInd ] = 0;
-#endif
       }
-    }
 
-    // invert Tsg : Luckily rotation is orthogonal: Inverse = Transpose.
-    // We are not required to invert.
-    Vec3d tInv, tmg;
-    Matx33d Rmg;
-    RInv = Rsg.t();
-    tInv = -RInv * tsg;
+      // invert Tsg : Luckily rotation is orthogonal: Inverse = Transpose.
+      // We are not required to invert.
+      Vec3d tInv, tmg;
+      Matx33d Rmg;
+      RInv = Rsg.t();
+      tInv = -RInv * tsg;
 
-    Matx44d TsgInv;
-    rtToPose(RInv, tInv, TsgInv);
+      Matx44d TsgInv;
+      rtToPose(RInv, tInv, TsgInv);
 
-    // TODO : Compute pose
-    const Vec3f pMax(sampled_pc.ptr<float>(refIndMax));
-    const Vec3f nMax(sampled_pc.ptr<float>(refIndMax) + 3);
+      // TODO : Compute pose
+      const Vec3f pMax(sampled_pc.ptr<float>(refIndMax));
+      const Vec3f nMax(sampled_pc.ptr<float>(refIndMax) + 3);
 
-    computeTransformRT(pMax, nMax, Rmg, tmg);
+      computeTransformRT(pMax, nMax, Rmg, tmg);
 
-    Matx44d Tmg;
-    rtToPose(Rmg, tmg, Tmg);
+      Matx44d Tmg;
+      rtToPose(Rmg, tmg, Tmg);
 
-    // convert alpha_index to alpha
-    int alpha_index = alphaIndMax;
-    double alpha = (alpha_index*(4*M_PI))/numAngles-2*M_PI;
+      // convert alpha_index to alpha
+      int alpha_index = alphaIndMax;
+      double alpha = (alpha_index*(4*M_PI))/numAngles-2*M_PI;
 
-    // Equation 2:
-    Matx44d Talpha;
-    Matx33d R;
-    Vec3d t = Vec3d::all(0);
-    getUnitXRotation(alpha, R);
-    rtToPose(R, t, Talpha);
+      // Equation 2:
+      Matx44d Talpha;
+      Matx33d R;
+      Vec3d t = Vec3d::all(0);
+      getUnitXRotation(alpha, R);
+      rtToPose(R, t, Talpha);
 
-    Matx44d rawPose = TsgInv * (Talpha * Tmg);
+      Matx44d rawPose = TsgInv * (Talpha * Tmg);
 
-    Pose3DPtr pose(new Pose3D(alpha, refIndMax, maxVotes));
-    pose->updatePose(rawPose);
-    #if defined (_OPENMP)
-    #pragma omp critical
-    #endif
-    {
-      poseList.push_back(pose);
+      Pose3DPtr pose(new Pose3D(alpha, refIndMax, maxVotes));
+      pose->updatePose(rawPose);
+      poseList[sceneInd] = pose;
     }
-
-    free(accumulator);
-  }
+  }, getNumThreads());
 
   // TODO : Make the parameters relative if not arguments.
   //double MinMatchScore = 0.5;
@@ -45,10 +45,12 @@ the use of this software, even if advised of the possibility of such damage.
 #include "opencv2/surface_matching/ppf_match_3d.hpp"
 #include "opencv2/surface_matching/icp.hpp"
 #include "opencv2/surface_matching/ppf_helpers.hpp"
+#include "opencv2/core/utility.hpp"
 
 #include <string>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <math.h>
 #include <ctime>
 
@@ -56,10 +58,6 @@ the use of this software, even if advised of the possibility of such damage.
 #include <iostream>
 #include <algorithm>
 
-#if defined (_OPENMP)
-#include<omp.h>
-#endif
-
 #include <sstream>  // flann dependency, needed in precomp now
 #include "opencv2/flann.hpp"
 
@@ -347,6 +347,8 @@ class CV_EXPORTS_W TrackerMOSSE : public cv::legacy::Tracker
 
 * The %MultiTracker is naive implementation of multiple object tracking.
 * It process the tracked objects independently without any optimization accross the tracked objects.
+* KCF, CSRT, MOSSE and MedianFlow trackers are updated in parallel and share the frame-level
+* preprocessing (colour conversions, downscaling), other trackers are updated sequentially.
 */
 class CV_EXPORTS_W MultiTracker : public Algorithm
 {
@@ -365,7 +367,7 @@ public:
   /**
   * \brief Add a new object to be tracked.
   *
-  * @param newTracker tracking algorithm to be used
+  * @param newTracker tracking algorithm to be used, a tracker already added to the MultiTracker is rejected
   * @param image input image
   * @param boundingBox a rectangle represents ROI of the tracked object
   */
@@ -430,7 +432,7 @@ public:
   /** @brief Add a new target to a tracking-list and initialize the tracker with a known bounding box that surrounded the target
   @param image The initial frame
   @param boundingBox The initial bounding box of target
-  @param tracker_algorithm Multi-tracker algorithm
+  @param tracker_algorithm Multi-tracker algorithm, a tracker already in the tracking-list is rejected
 
   @return True if new target initialization went succesfully, false otherwise
   */
@@ -439,6 +441,8 @@ public:
   /** @brief Update all trackers from the tracking-list, find a new most likely bounding boxes for the targets
   @param image The current frame
 
+  KCF, CSRT, MOSSE and MedianFlow trackers are updated in parallel, see MultiTracker.
+
   @return True means that all targets were located and false means that tracker couldn't locate one of the targets in
   current frame. Note, that latter *does not* imply that tracker has failed, maybe target is indeed
   missing from the frame (say, out of sight)
@@ -99,4 +99,63 @@ PERF_TEST_P(Tracking, TLD, testing::ValuesIn(getTrackingParams()))
     runTrackingTest(tracker, GetParam());
 }
 
+//==================================================================================================
+
+typedef perf::TestBaseWithParam<tuple<string, int> > MultiTracking;
+
+PERF_TEST_P(MultiTracking, update, testing::Combine(testing::Values("KCF", "CSRT"), testing::Values(8, 40)))
+{
+    const int N = 10;
+    string trackerType = get<0>(GetParam());
+    int targets = get<1>(GetParam());
+
+    string videoPath = findDataFile("cv/tracking/faceocc2/data/faceocc2.webm");
+    VideoCapture c;
+    c.open(videoPath);
+    ASSERT_TRUE(c.isOpened()) << videoPath;
+
+    std::vector<Mat> frames;
+    for (int i = 0; i < N; ++i)
+    {
+        Mat frame;
+        c >> frame;
+        ASSERT_FALSE(frame.empty()) << "i=" << i;
+        frames.push_back(frame);
+    }
+
+    // targets are spread over the frame, so that every tracker does a similar amount of work
+    const Size targetSize(40, 40);
+    const int cols = (frames[0].cols - targetSize.width) / targetSize.width;
+    std::vector<Rect2d> boxes;
+    for (int t = 0; t < targets; t++)
+    {
+        int x = (t % cols) * targetSize.width;
+        int y = ((t / cols) * targetSize.height) % (frames[0].rows - targetSize.height);
+        boxes.push_back(Rect2d(Point2d(x, y), targetSize));
+    }
+
+    PERF_SAMPLE_BEGIN();
+    {
+        legacy::MultiTracker multiTracker;
+        for (int t = 0; t < targets; t++)
+        {
+            Ptr<legacy::Tracker> tracker;
+            if (trackerType == "KCF")
+                tracker = legacy::TrackerKCF::create();
+            else
+                tracker = legacy::TrackerCSRT::create();
+            multiTracker.add(tracker, frames[0], boxes[t]);
+        }
+        for (int i = 1; i < N; ++i)
+        {
+            std::vector<Rect2d> result;
+            multiTracker.update(frames[i], result);
+            ASSERT_EQ((size_t)targets, result.size());
+        }
+    }
+    PERF_SAMPLE_END();
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -3,13 +3,14 @@
 // of this distribution and at http://opencv.org/license.html.
 
 #include "opencv2/tracking/tracking_legacy.hpp"
+#include "../trackerSharedFrame.hpp"
 
 namespace cv {
 namespace legacy {
 inline namespace tracking {
 namespace impl {
 
-class TrackerCSRTImpl CV_FINAL : public legacy::TrackerCSRT
+class TrackerCSRTImpl CV_FINAL : public legacy::TrackerCSRT, public tracking_internal::SharedFrameTracker
 {
 public:
     cv::tracking::impl::TrackerCSRTImpl impl;
@@ -45,6 +46,15 @@ public:
         boundingBox = bb;
         return res;
     }
+    bool updateShared(tracking_internal::SharedFrame& frame, Rect2d& boundingBox) CV_OVERRIDE
+    {
+        if (!isInit)
+            return false;
+        Rect bb;
+        bool res = impl.update(frame, bb);
+        boundingBox = bb;
+        return res;
+    }
 
     virtual void setInitialMask(InputArray mask) CV_OVERRIDE
     {
@@ -40,6 +40,7 @@
  //M*/
 
 #include "opencv2/tracking/tracking_legacy.hpp"
+#include "../trackerSharedFrame.hpp"
 
 namespace cv {
 namespace legacy {
@@ -49,7 +50,7 @@ namespace impl {
 /*---------------------------
 |  TrackerKCF
 |---------------------------*/
-class TrackerKCFImpl CV_FINAL : public legacy::TrackerKCF
+class TrackerKCFImpl CV_FINAL : public legacy::TrackerKCF, public tracking_internal::SharedFrameTracker
 {
 public:
     cv::tracking::impl::TrackerKCFImpl impl;
@@ -84,6 +85,15 @@ public:
         boundingBox = bb;
         return res;
     }
+    bool updateShared(tracking_internal::SharedFrame& frame, Rect2d& boundingBox) CV_OVERRIDE
+    {
+        if (!isInit)
+            return false;
+        Rect bb;
+        bool res = impl.update(frame, bb);
+        boundingBox = bb;
+        return res;
+    }
     void setFeatureExtractor(void (*f)(const Mat, const Rect, Mat&), bool pca_func = false) CV_OVERRIDE
     {
         impl.setFeatureExtractor(f, pca_func);
@@ -16,6 +16,7 @@
 #include "precomp.hpp"
 
 #include "opencv2/tracking/tracking_legacy.hpp"
+#include "trackerSharedFrame.hpp"
 
 namespace cv {
 inline namespace tracking {
@@ -34,7 +35,7 @@ const double psrThreshold=5.7; // no detection, if PSR is smaller than this
 
 }  // namespace
 
-struct MosseImpl CV_FINAL : legacy::TrackerMOSSE
+struct MosseImpl CV_FINAL : legacy::TrackerMOSSE, tracking_internal::SharedFrameTracker
 {
 protected:
 
@@ -187,6 +188,14 @@ protected:
         return true;
     }
 
+    // only the patches are converted to gray, there is nothing to take from the shared frame
+    virtual bool updateShared( tracking_internal::SharedFrame& frame, Rect2d& boundingBox ) CV_OVERRIDE
+    {
+        if (!isInit)
+            return false;
+        return updateImpl(frame.getImage(), boundingBox);
+    }
+
     virtual bool updateImpl( const Mat& image, Rect2d& boundingBox ) CV_OVERRIDE
     {
         if (H.empty()) // not initialized
@@ -41,6 +41,9 @@
 
 #include "precomp.hpp"
 #include "multiTracker.hpp"
+#include "trackerSharedFrame.hpp"
+
+#include <algorithm>
 
 #include "opencv2/tracking/tracking_legacy.hpp"
 
@@ -57,6 +60,10 @@ using namespace impl;
 		if (!tracker)
 			return false;
 
+		//The same tracker can't follow two targets
+		if (std::find(trackers.begin(), trackers.end(), tracker) != trackers.end())
+			return false;
+
 		if (!tracker->init(image, boundingBox))
 			return false;
 
@@ -82,11 +89,9 @@ using namespace impl;
 
     bool MultiTracker_Alt::update(InputArray image)
 	{
-		for (int i = 0; i < (int)trackers.size(); i++)
-			if (!trackers[i]->update(image, boundingBoxes[i]))
-				return false;
-
-		return true;
+		//All targets are updated, independent trackers in parallel over the shared frame
+		std::vector<uchar> status = tracking_internal::updateTrackers(trackers, image, boundingBoxes);
+		return std::find(status.begin(), status.end(), (uchar)0) == status.end();
 	}
 
 	//Multitracker TLD
@@ -41,6 +41,9 @@
 
 #include "precomp.hpp"
 #include "opencv2/tracking/tracking_legacy.hpp"
+#include "trackerSharedFrame.hpp"
+
+#include <algorithm>
 
 namespace cv {
 namespace legacy {
@@ -55,6 +58,10 @@ inline namespace tracking {
   // add a new tracked object
   bool MultiTracker::add( Ptr<Tracker> newTracker, InputArray image, const Rect2d& boundingBox )
   {
+    // the same tracker can't follow two objects, it would also be updated from two threads at once
+    if (std::find(trackerList.begin(), trackerList.end(), newTracker) != trackerList.end())
+      return false;
+
     // add the tracker algorithm to the trackers list
     trackerList.push_back(newTracker);
 
@@ -83,11 +90,9 @@ inline namespace tracking {
   // update position of the tracked objects, the result is stored in internal storage
   bool MultiTracker::update(InputArray image)
   {
-    bool status = true;
-    for(unsigned i=0;i< trackerList.size(); i++){
-      status &= trackerList[i]->update(image, objects[i]);
-    }
-    return status;
+    // independent trackers are updated in parallel over the shared frame
+    std::vector<uchar> status = tracking_internal::updateTrackers(trackerList, image, objects);
+    return std::find(status.begin(), status.end(), (uchar)0) == status.end();
   };
 
   // update position of the tracked objects, the result is copied to external variable
@@ -7,6 +7,7 @@
 #include "trackerCSRTSegmentation.hpp"
 #include "trackerCSRTUtils.hpp"
 #include "trackerCSRTScaleEstimation.hpp"
+#include "trackerSharedFrame.hpp"
 
 namespace cv {
 inline namespace tracking {
@@ -37,9 +38,12 @@ public:
     // Tracker API
     virtual void init(InputArray image, const Rect& boundingBox) CV_OVERRIDE;
     virtual bool update(InputArray image, Rect& boundingBox) CV_OVERRIDE;
+    //! takes the colour conversions from the frame shared with other trackers
+    bool update(tracking_internal::SharedFrame& sharedFrame, Rect& boundingBox);
     virtual void setInitialMask(InputArray mask) CV_OVERRIDE;
 
 protected:
+    bool updateFrame(const Mat& image, const Mat& hsv_img, Rect& boundingBox);
     void update_csr_filter(const Mat &image, const Mat &my_mask);
     void update_histograms(const Mat &image, const Rect &region);
     void extract_histograms(const Mat &image, cv::Rect region, Histogram &hf, Histogram &hb);
@@ -455,6 +459,22 @@ bool TrackerCSRTImpl::update(InputArray image_, Rect& boundingBox)
     else
         image = image_.getMat();
 
+    Mat hsv_img;
+    if(params.use_segmentation)
+        hsv_img = bgr2hsv(image);
+    return updateFrame(image, hsv_img, boundingBox);
+}
+
+bool TrackerCSRTImpl::update(tracking_internal::SharedFrame& sharedFrame, Rect& boundingBox)
+{
+    Mat hsv_img;
+    if(params.use_segmentation)
+        hsv_img = sharedFrame.get(tracking_internal::SharedFrame::CSRT_HSV);
+    return updateFrame(sharedFrame.get(tracking_internal::SharedFrame::BGR), hsv_img, boundingBox);
+}
+
+bool TrackerCSRTImpl::updateFrame(const Mat& image, const Mat& hsv_img, Rect& boundingBox)
+{
     object_center = estimate_new_position(image);
     if (object_center.x < 0 && object_center.y < 0)
         return false;
@@ -468,7 +488,6 @@ bool TrackerCSRTImpl::update(InputArray image_, Rect& boundingBox)
 
     //update tracker
     if(params.use_segmentation) {
-        Mat hsv_img = bgr2hsv(image);
         update_histograms(hsv_img, bounding_box);
         filter_mask = segment_region(hsv_img, object_center,
                 template_size,original_target_size, current_scale_factor);
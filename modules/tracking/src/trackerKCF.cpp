@@ -42,8 +42,12 @@
 #include "precomp.hpp"
 
 #include "opencl_kernels_tracking.hpp"
+#include "trackerSharedFrame.hpp"
 #include <complex>
 #include <cmath>
+#include <map>
+#include <memory>
+#include <tuple>
 
 namespace cv {
 inline namespace tracking {
@@ -64,6 +68,17 @@ namespace impl {
     void modelUpdateImpl() CV_OVERRIDE {}
   };
 
+  /**
+  * \brief Data depending only on the window, it is shared by the trackers with the same window
+  * and must not be modified
+  */
+  struct TrackerKCFWindow
+  {
+    Mat hann; 	//hann window filter
+    Mat hann_cn; //10 dimensional hann-window filter for CN features
+    Mat yf; 	// FFT of the gaussian training response
+  };
+
 
 /*---------------------------
 |  TrackerKCF
@@ -78,26 +93,30 @@ public:
 
     virtual void init(InputArray image, const Rect& boundingBox) CV_OVERRIDE;
     virtual bool update(InputArray image, Rect& boundingBox) CV_OVERRIDE;
+    //! takes the downscaled image from the frame shared with other trackers
+    bool update(tracking_internal::SharedFrame& sharedFrame, Rect& boundingBox);
     void setFeatureExtractor(void (*f)(const Mat, const Rect, Mat&), bool pca_func = false) CV_OVERRIDE;
 
     TrackerKCF::Params params;
     Ptr<TrackerKCFModel> model;
 
 protected:
+    bool updateFrame(const Mat& img, const Mat& gray, const Size& imageSize, Rect& boundingBoxResult);
+    std::shared_ptr<const TrackerKCFWindow> getWindow(const Size2d& winSize, float _output_sigma) const;
     void createHanningWindow(OutputArray dest, const cv::Size winSize, const int type) const;
     void inline fft2(const Mat src, std::vector<Mat> & dest, std::vector<Mat> & layers_data) const;
     void inline fft2(const Mat src, Mat & dest) const;
     void inline ifft2(const Mat src, Mat & dest) const;
-    void inline pixelWiseMult(const std::vector<Mat> src1, const std::vector<Mat>  src2, std::vector<Mat>  & dest, const int flags, const bool conjB=false) const;
-    void inline sumChannels(std::vector<Mat> src, Mat & dest) const;
+    void inline pixelWiseMult(const std::vector<Mat> & src1, const std::vector<Mat> & src2, std::vector<Mat>  & dest, const int flags, const bool conjB=false) const;
+    void inline sumChannels(const std::vector<Mat> & src, Mat & dest) const;
     void inline updateProjectionMatrix(const Mat src, Mat & old_cov,Mat &  proj_matrix,float pca_rate, int compressed_sz,
-                                       std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat pca_data, Mat new_cov, Mat w, Mat u, Mat v);
+                                       std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat & pca_data, Mat & new_cov, Mat & w, Mat & u, Mat & v);
     void inline compress(const Mat proj_matrix, const Mat src, Mat & dest, Mat & data, Mat & compressed) const;
-    bool getSubWindow(const Mat img, const Rect roi, Mat& feat, Mat& patch, TrackerKCF::MODE desc = GRAY) const;
+    bool getSubWindow(const Mat img, const Mat gray, const Rect roi, Mat& feat, Mat& patch, Mat& gray_patch, TrackerKCF::MODE desc = GRAY) const;
     bool getSubWindow(const Mat img, const Rect roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& )) const;
     void extractCN(Mat patch_data, Mat & cnFeatures) const;
     void denseGaussKernel(const float sigma, const Mat , const Mat y_data, Mat & k_data,
-                          std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> xyf_v, Mat xy, Mat xyf ) const;
+                          std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> & xyf_v, Mat & xy, Mat & xyf ) const;
     void calcResponse(const Mat alphaf_data, const Mat kf_data, Mat & response_data, Mat & spec_data) const;
     void calcResponse(const Mat alphaf_data, const Mat alphaf_den_data, const Mat kf_data, Mat & response_data, Mat & spec_data, Mat & spec2_data) const;
 
@@ -111,10 +130,11 @@ protected:
 private:
     float output_sigma;
     Rect2d roi;
+    std::shared_ptr<const TrackerKCFWindow> window; // shared with the trackers of the same window size
     Mat hann; 	//hann window filter
     Mat hann_cn; //10 dimensional hann-window filter for CN features,
 
-    Mat y,yf; 	// training response and its FFT
+    Mat yf; 	// FFT of the training response
     Mat x; 	// observation and its FFT
     Mat k,kf;	// dense gaussian kernel and its FFT
     Mat kf_lambda; // kf+lambda
@@ -132,10 +152,11 @@ private:
     Mat data_temp, compress_data;
     std::vector<Mat> layers_pca_data;
     std::vector<Scalar> average_data;
-    Mat img_Patch;
+    Mat img_Patch, gray_Patch;
 
     // storage for the extracted features, KRLS model, KRLS compressed model
     Mat X[2],Z[2],Zc[2];
+    Mat X_pca; // features to be compressed
 
     // storage of the extracted features
     std::vector<Mat> features_pca;
@@ -145,6 +166,10 @@ private:
 
     // optimization variables for updateProjectionMatrix
     Mat data_pca, new_covar,w_data,u_data,vt_data;
+    Mat mixed_covar, proj_vars, proj_scaled, next_covar;
+#ifdef HAVE_OPENCL
+    UMat new_covar_umat;
+#endif
 
     // custom feature extractor
     bool use_custom_extractor_pca;
@@ -193,6 +218,8 @@ private:
   void TrackerKCFImpl::init(InputArray image, const Rect& boundingBox)
   {
     frame=0;
+    // the covariance of the feature compression is learned from the first frame again
+    old_cov_mtx.release();
     roi.x = cvRound(boundingBox.x);
     roi.y = cvRound(boundingBox.y);
     roi.width = cvRound(boundingBox.width);
@@ -217,27 +244,11 @@ private:
     roi.width*=2;
     roi.height*=2;
 
-    // initialize the hann window filter
-    createHanningWindow(hann, roi.size(), CV_32F);
-
-    // hann window filter for CN feature
-    Mat _layer[] = {hann, hann, hann, hann, hann, hann, hann, hann, hann, hann};
-    merge(_layer, 10, hann_cn);
-
-    // create gaussian response
-    y=Mat::zeros((int)roi.height,(int)roi.width,CV_32F);
-    for(int i=0;i<int(roi.height);i++){
-      for(int j=0;j<int(roi.width);j++){
-        y.at<float>(i,j) =
-                static_cast<float>((i-roi.height/2+1)*(i-roi.height/2+1)+(j-roi.width/2+1)*(j-roi.width/2+1));
-      }
-    }
-
-    y*=(float)output_sigma;
-    cv::exp(y,y);
-
-    // perform fourier transfor to the gaussian response
-    fft2(y,yf);
+    // hann window filters and the FFT of the gaussian response
+    window = getWindow(roi.size(), output_sigma);
+    hann = window->hann;
+    hann_cn = window->hann_cn;
+    yf = window->yf;
 
     if (image.channels() == 1) { // disable CN for grayscale images
       params.desc_pca &= ~(CN);
@@ -279,9 +290,6 @@ private:
    */
   bool TrackerKCFImpl::update(InputArray image, Rect& boundingBoxResult)
   {
-    double minVal, maxVal;	// min-max response
-    Point minLoc,maxLoc;	// min-max location
-
     CV_Assert(image.channels() == 1 || image.channels() == 3);
 
     Mat img;
@@ -289,7 +297,35 @@ private:
     if (resizeImage)
         resize(image, img, Size(image.cols()/2, image.rows()/2), 0, 0, INTER_LINEAR_EXACT);
     else
-        image.copyTo(img);
+        img = image.getMat();
+
+    return updateFrame(img, Mat(), image.size(), boundingBoxResult);
+  }
+
+  bool TrackerKCFImpl::update(tracking_internal::SharedFrame& sharedFrame, Rect& boundingBoxResult)
+  {
+    typedef tracking_internal::SharedFrame SharedFrame;
+    const Mat& image = sharedFrame.getImage();
+    CV_Assert(image.channels() == 1 || image.channels() == 3);
+
+    // the grayscale conversion is done once per frame for all the trackers
+    Mat gray;
+    if(((params.desc_npca | params.desc_pca) & GRAY) == GRAY)
+        gray = sharedFrame.get(resizeImage ? SharedFrame::HALF_SIZE_GRAY : SharedFrame::GRAY);
+
+    if (resizeImage)
+        return updateFrame(sharedFrame.get(SharedFrame::HALF_SIZE), gray, image.size(), boundingBoxResult);
+    return updateFrame(image, gray, image.size(), boundingBoxResult);
+  }
+
+  /*
+   * the frame is only read, so it can be shared with other trackers,
+   * the grayscale frame is optional, otherwise the patches are converted
+   */
+  bool TrackerKCFImpl::updateFrame(const Mat& img, const Mat& gray, const Size& imageSize, Rect& boundingBoxResult)
+  {
+    double minVal, maxVal;	// min-max response
+    Point minLoc,maxLoc;	// min-max location
 
     // detection part
     if(frame>0){
@@ -297,7 +333,7 @@ private:
       // extract and pre-process the patch
       // get non compressed descriptors
       for(unsigned i=0;i<descriptors_npca.size()-extractor_npca.size();i++){
-        if(!getSubWindow(img,roi, features_npca[i], img_Patch, descriptors_npca[i]))return false;
+        if(!getSubWindow(img,gray,roi, features_npca[i], img_Patch, gray_Patch, descriptors_npca[i]))return false;
       }
       //get non-compressed custom descriptors
       for(unsigned i=0,j=(unsigned)(descriptors_npca.size()-extractor_npca.size());i<extractor_npca.size();i++,j++){
@@ -307,18 +343,20 @@ private:
 
       // get compressed descriptors
       for(unsigned i=0;i<descriptors_pca.size()-extractor_pca.size();i++){
-        if(!getSubWindow(img,roi, features_pca[i], img_Patch, descriptors_pca[i]))return false;
+        if(!getSubWindow(img,gray,roi, features_pca[i], img_Patch, gray_Patch, descriptors_pca[i]))return false;
       }
       //get compressed custom descriptors
       for(unsigned i=0,j=(unsigned)(descriptors_pca.size()-extractor_pca.size());i<extractor_pca.size();i++,j++){
         if(!getSubWindow(img,roi, features_pca[j], extractor_pca[i]))return false;
       }
-      if(features_pca.size()>0)merge(features_pca,X[0]);
+      if(features_pca.size()>0)merge(features_pca,X_pca);
 
       //compress the features and the KRSL model
       if(params.desc_pca !=0){
-        compress(proj_mtx,X[0],X[0],data_temp,compress_data);
+        compress(proj_mtx,X_pca,X[0],data_temp,compress_data);
         compress(proj_mtx,Z[0],Zc[0],data_temp,compress_data);
+      }else{
+        X[0] = X_pca;
       }
 
       // copy the compressed KRLS model
@@ -369,7 +407,7 @@ private:
     // extract the patch for learning purpose
     // get non compressed descriptors
     for(unsigned i=0;i<descriptors_npca.size()-extractor_npca.size();i++){
-      if(!getSubWindow(img,roi, features_npca[i], img_Patch, descriptors_npca[i]))return false;
+      if(!getSubWindow(img,gray,roi, features_npca[i], img_Patch, gray_Patch, descriptors_npca[i]))return false;
     }
     //get non-compressed custom descriptors
     for(unsigned i=0,j=(unsigned)(descriptors_npca.size()-extractor_npca.size());i<extractor_npca.size();i++,j++){
@@ -379,21 +417,21 @@ private:
 
     // get compressed descriptors
     for(unsigned i=0;i<descriptors_pca.size()-extractor_pca.size();i++){
-      if(!getSubWindow(img,roi, features_pca[i], img_Patch, descriptors_pca[i]))return false;
+      if(!getSubWindow(img,gray,roi, features_pca[i], img_Patch, gray_Patch, descriptors_pca[i]))return false;
     }
     //get compressed custom descriptors
     for(unsigned i=0,j=(unsigned)(descriptors_pca.size()-extractor_pca.size());i<extractor_pca.size();i++,j++){
       if(!getSubWindow(img,roi, features_pca[j], extractor_pca[i]))return false;
     }
-    if(features_pca.size()>0)merge(features_pca,X[0]);
+    if(features_pca.size()>0)merge(features_pca,X_pca);
 
     //update the training data
     if(frame==0){
-      Z[0] = X[0].clone();
+      Z[0] = X_pca.clone();
       Z[1] = X[1].clone();
     }else{
-      Z[0]=(1.0-params.interp_factor)*Z[0]+params.interp_factor*X[0];
-      Z[1]=(1.0-params.interp_factor)*Z[1]+params.interp_factor*X[1];
+      addWeighted(Z[0], 1.0-params.interp_factor, X_pca, params.interp_factor, 0.0, Z[0]);
+      addWeighted(Z[1], 1.0-params.interp_factor, X[1], params.interp_factor, 0.0, Z[1]);
     }
 
     if(params.desc_pca !=0 || use_custom_extractor_pca){
@@ -405,7 +443,9 @@ private:
 
       // feature compression
       updateProjectionMatrix(Z[0],old_cov_mtx,proj_mtx,params.pca_learning_rate,params.compressed_size,layers_pca_data,average_data,data_pca, new_covar,w_data,u_data,vt_data);
-      compress(proj_mtx,X[0],X[0],data_temp,compress_data);
+      compress(proj_mtx,X_pca,X[0],data_temp,compress_data);
+    }else{
+      X[0] = X_pca;
     }
 
     // merge all features
@@ -428,9 +468,9 @@ private:
     // Kernel Regularized Least-Squares, calculate alphas
     denseGaussKernel(params.sigma,x,x,k,layers,vxf,vyf,vxyf,xy_data,xyf_data);
 
-    // compute the fourier transform of the kernel and add a small value
+    // compute the fourier transform of the kernel and add a small value to its real part
     fft2(k,kf);
-    kf_lambda=kf+params.lambda;
+    add(kf, Scalar(params.lambda), kf_lambda);
 
     float den;
     if(params.split_coeff){
@@ -454,8 +494,8 @@ private:
       alphaf=new_alphaf.clone();
       if(params.split_coeff)alphaf_den=new_alphaf_den.clone();
     }else{
-      alphaf=(1.0-params.interp_factor)*alphaf+params.interp_factor*new_alphaf;
-      if(params.split_coeff)alphaf_den=(1.0-params.interp_factor)*alphaf_den+params.interp_factor*new_alphaf_den;
+      addWeighted(alphaf, 1.0-params.interp_factor, new_alphaf, params.interp_factor, 0.0, alphaf);
+      if(params.split_coeff)addWeighted(alphaf_den, 1.0-params.interp_factor, new_alphaf_den, params.interp_factor, 0.0, alphaf_den);
     }
 
     frame++;
@@ -464,7 +504,7 @@ private:
     int y1 = cvRound(boundingBox.y);
     int x2 = cvRound(boundingBox.x + boundingBox.width);
     int y2 = cvRound(boundingBox.y + boundingBox.height);
-    boundingBoxResult = Rect(x1, y1, x2 - x1, y2 - y1) & Rect(Point(0, 0), image.size());
+    boundingBoxResult = Rect(x1, y1, x2 - x1, y2 - y1) & Rect(Point(0, 0), imageSize);
 
     return true;
   }
@@ -474,6 +514,60 @@ private:
   |  implementation of the KCF functions
   |-------------------------------------*/
 
+  /*
+   * window filters and the FFT of the gaussian response are computed once
+   * for all the trackers with the same window size and output sigma
+   */
+  std::shared_ptr<const TrackerKCFWindow> TrackerKCFImpl::getWindow(const Size2d& winSize, float _output_sigma) const {
+    typedef std::tuple<double, double, float> WindowKey;
+    static Mutex mutex;
+    static std::map<WindowKey, std::weak_ptr<const TrackerKCFWindow> > windows;
+
+    const WindowKey key(winSize.width, winSize.height, _output_sigma);
+    AutoLock lock(mutex);
+
+    std::shared_ptr<const TrackerKCFWindow> sharedWindow = windows[key].lock();
+    if(sharedWindow)
+      return sharedWindow;
+
+    std::shared_ptr<TrackerKCFWindow> newWindow = std::make_shared<TrackerKCFWindow>();
+
+    // initialize the hann window filter
+    createHanningWindow(newWindow->hann, winSize, CV_32F);
+
+    // hann window filter for CN feature
+    const Mat& h = newWindow->hann;
+    Mat _layer[] = {h, h, h, h, h, h, h, h, h, h};
+    merge(_layer, 10, newWindow->hann_cn);
+
+    // create gaussian response
+    Mat y=Mat::zeros((int)winSize.height,(int)winSize.width,CV_32F);
+    for(int i=0;i<int(winSize.height);i++){
+      for(int j=0;j<int(winSize.width);j++){
+        y.at<float>(i,j) =
+                static_cast<float>((i-winSize.height/2+1)*(i-winSize.height/2+1)+(j-winSize.width/2+1)*(j-winSize.width/2+1));
+      }
+    }
+
+    y*=(float)_output_sigma;
+    cv::exp(y,y);
+
+    // perform fourier transfor to the gaussian response
+    fft2(y,newWindow->yf);
+
+    // forget the windows of the released trackers
+    for(auto it = windows.begin(); it != windows.end();){
+      if(it->second.expired())
+        it = windows.erase(it);
+      else
+        ++it;
+    }
+
+    sharedWindow = newWindow;
+    windows[key] = sharedWindow;
+    return sharedWindow;
+  }
+
   /*
    * hann window filter
    */
@@ -514,7 +608,8 @@ private:
   }
 
   /*
-   * simplification of fourier transform function in opencv
+   * simplification of fourier transform function in opencv,
+   * the destination buffers are reused while the window size is the same
    */
   void inline TrackerKCFImpl::fft2(const Mat src, Mat & dest) const {
     dft(src,dest,DFT_COMPLEX_OUTPUT);
@@ -538,7 +633,7 @@ private:
   /*
    * Point-wise multiplication of two Multichannel Mat data
    */
-  void inline TrackerKCFImpl::pixelWiseMult(const std::vector<Mat> src1, const std::vector<Mat>  src2, std::vector<Mat>  & dest, const int flags, const bool conjB) const {
+  void inline TrackerKCFImpl::pixelWiseMult(const std::vector<Mat> & src1, const std::vector<Mat> & src2, std::vector<Mat>  & dest, const int flags, const bool conjB) const {
     for(unsigned i=0;i<src1.size();i++){
       mulSpectrums(src1[i], src2[i], dest[i],flags,conjB);
     }
@@ -547,10 +642,10 @@ private:
   /*
    * Combines all channels in a multi-channels Mat data into a single channel
    */
-  void inline TrackerKCFImpl::sumChannels(std::vector<Mat> src, Mat & dest) const {
-    dest=src[0].clone();
+  void inline TrackerKCFImpl::sumChannels(const std::vector<Mat> & src, Mat & dest) const {
+    src[0].copyTo(dest);
     for(unsigned i=1;i<src.size();i++){
-      dest+=src[i];
+      add(dest, src[i], dest);
     }
   }
 
@@ -584,7 +679,7 @@ private:
    * obtains the projection matrix using PCA
    */
   void inline TrackerKCFImpl::updateProjectionMatrix(const Mat src, Mat & old_cov,Mat &  proj_matrix, float pca_rate, int compressed_sz,
-                                                     std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat pca_data, Mat new_cov, Mat w, Mat u, Mat vt) {
+                                                     std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat & pca_data, Mat & new_cov, Mat & w, Mat & u, Mat & vt) {
     CV_Assert(compressed_sz<=src.channels());
 
     split(src,layers_pca);
@@ -596,46 +691,53 @@ private:
 
     // calc covariance matrix
     merge(layers_pca,pca_data);
-    pca_data=pca_data.reshape(1,src.rows*src.cols);
+    Mat pca_mat=pca_data.reshape(1,src.rows*src.cols);
 
 #ifdef HAVE_OPENCL
     bool oclSucceed = false;
-    Size s(pca_data.cols, pca_data.cols);
-    UMat result(s, pca_data.type());
-    if (oclTransposeMM(pca_data, 1.0f/(float)(src.rows*src.cols-1), result)) {
-      if(old_cov.rows==0) old_cov=result.getMat(ACCESS_READ).clone();
-      SVD::compute((1.0-pca_rate)*old_cov + pca_rate * result.getMat(ACCESS_READ), w, u, vt);
+    Size s(pca_mat.cols, pca_mat.cols);
+    new_covar_umat.create(s, pca_mat.type());
+    if (oclTransposeMM(pca_mat, 1.0f/(float)(src.rows*src.cols-1), new_covar_umat)) {
+      Mat result = new_covar_umat.getMat(ACCESS_READ);
+      if(old_cov.rows==0) old_cov=result.clone();
+      addWeighted(old_cov, 1.0-pca_rate, result, pca_rate, 0.0, mixed_covar);
+      SVD::compute(mixed_covar, w, u, vt);
       oclSucceed = true;
     }
 #define TMM_VERIFICATION 0
 
     if (oclSucceed == false || TMM_VERIFICATION) {
-      new_cov=1.0f/(float)(src.rows*src.cols-1)*(pca_data.t()*pca_data);
+      new_cov=1.0f/(float)(src.rows*src.cols-1)*(pca_mat.t()*pca_mat);
 #if TMM_VERIFICATION
       for(int i = 0; i < new_cov.rows; i++)
         for(int j = 0; j < new_cov.cols; j++)
-          if (abs(new_cov.at<float>(i, j) - result.getMat(ACCESS_RW).at<float>(i , j)) > abs(new_cov.at<float>(i, j)) * 1e-3)
-            printf("error @ i %d j %d got %G expected %G \n", i, j, result.getMat(ACCESS_RW).at<float>(i , j), new_cov.at<float>(i, j));
+          if (abs(new_cov.at<float>(i, j) - new_covar_umat.getMat(ACCESS_RW).at<float>(i , j)) > abs(new_cov.at<float>(i, j)) * 1e-3)
+            printf("error @ i %d j %d got %G expected %G \n", i, j, new_covar_umat.getMat(ACCESS_RW).at<float>(i , j), new_cov.at<float>(i, j));
 #endif
       if(old_cov.rows==0)old_cov=new_cov.clone();
-      SVD::compute((1.0f - pca_rate) * old_cov + pca_rate * new_cov, w, u, vt);
+      addWeighted(old_cov, 1.0-pca_rate, new_cov, pca_rate, 0.0, mixed_covar);
+      SVD::compute(mixed_covar, w, u, vt);
     }
 #else
-    new_cov=1.0/(float)(src.rows*src.cols-1)*(pca_data.t()*pca_data);
+    new_cov=1.0/(float)(src.rows*src.cols-1)*(pca_mat.t()*pca_mat);
     if(old_cov.rows==0)old_cov=new_cov.clone();
 
     // calc PCA
-    SVD::compute((1.0-pca_rate)*old_cov+pca_rate*new_cov, w, u, vt);
+    addWeighted(old_cov, 1.0-pca_rate, new_cov, pca_rate, 0.0, mixed_covar);
+    SVD::compute(mixed_covar, w, u, vt);
 #endif
     // extract the projection matrix
-    proj_matrix=u(Rect(0,0,compressed_sz,src.channels())).clone();
-    Mat proj_vars=Mat::eye(compressed_sz,compressed_sz,proj_matrix.type());
+    u(Rect(0,0,compressed_sz,src.channels())).copyTo(proj_matrix);
+    proj_vars.create(compressed_sz,compressed_sz,proj_matrix.type());
+    proj_vars.setTo(Scalar::all(0));
     for(int i=0;i<compressed_sz;i++){
       proj_vars.at<float>(i,i)=w.at<float>(i);
     }
 
-    // update the covariance matrix
-    old_cov=(1.0-pca_rate)*old_cov+pca_rate*proj_matrix*proj_vars*proj_matrix.t();
+    // update the covariance matrix, the result goes to the second buffer as old_cov is an input
+    gemm(proj_matrix, proj_vars, 1.0, noArray(), 0.0, proj_scaled);
+    gemm(proj_scaled, proj_matrix, pca_rate, old_cov, 1.0-pca_rate, next_covar, GEMM_2_T);
+    cv::swap(old_cov, next_covar);
   }
 
   /*
@@ -644,13 +746,13 @@ private:
   void inline TrackerKCFImpl::compress(const Mat proj_matrix, const Mat src, Mat & dest, Mat & data, Mat & compressed) const {
     data=src.reshape(1,src.rows*src.cols);
     compressed=data*proj_matrix;
-    dest=compressed.reshape(proj_matrix.cols,src.rows).clone();
+    compressed.reshape(proj_matrix.cols,src.rows).copyTo(dest);
   }
 
   /*
    * obtain the patch and apply hann window filter to it
    */
-  bool TrackerKCFImpl::getSubWindow(const Mat img, const Rect _roi, Mat& feat, Mat& patch, TrackerKCF::MODE desc) const {
+  bool TrackerKCFImpl::getSubWindow(const Mat img, const Mat gray, const Rect _roi, Mat& feat, Mat& patch, Mat& gray_patch, TrackerKCF::MODE desc) const {
 
     Rect region=_roi;
 
@@ -670,8 +772,6 @@ private:
     if (region.empty())
         return false;
 
-    patch=img(region).clone();
-
     // add some padding to compensate when the patch is outside image border
     int addTop,addBottom, addLeft, addRight;
     addTop=region.y-_roi.y;
@@ -679,25 +779,29 @@ private:
     addLeft=region.x-_roi.x;
     addRight=(_roi.width+_roi.x>img.cols?_roi.width+_roi.x-img.cols:0);
 
-    copyMakeBorder(patch,patch,addTop,addBottom,addLeft,addRight,BORDER_REPLICATE);
-    if(patch.rows==0 || patch.cols==0)return false;
+    // the patches have the window size, so their buffers are reused from frame to frame
+    const int borderType = BORDER_REPLICATE | BORDER_ISOLATED;
 
     // extract the desired descriptors
     switch(desc){
       case CN:
         CV_Assert(img.channels() == 3);
+        copyMakeBorder(img(region),patch,addTop,addBottom,addLeft,addRight,borderType);
         extractCN(patch,feat);
-        feat=feat.mul(hann_cn); // hann window filter
+        multiply(feat,hann_cn,feat); // hann window filter
         break;
       default: // GRAY
-        if(img.channels()>1)
-          cvtColor(patch,feat, COLOR_BGR2GRAY);
-        else
-          feat=patch;
+        if(!gray.empty())
+          copyMakeBorder(gray(region),gray_patch,addTop,addBottom,addLeft,addRight,borderType);
+        else if(img.channels()>1){
+          copyMakeBorder(img(region),patch,addTop,addBottom,addLeft,addRight,borderType);
+          cvtColor(patch,gray_patch, COLOR_BGR2GRAY);
+        }else
+          copyMakeBorder(img(region),gray_patch,addTop,addBottom,addLeft,addRight,borderType);
         //feat.convertTo(feat,CV_32F);
-        feat.convertTo(feat,CV_32F, 1.0/255.0, -0.5);
+        gray_patch.convertTo(feat,CV_32F, 1.0/255.0, -0.5);
         //feat=feat/255.0-0.5; // normalize to range -0.5 .. 0.5
-        feat=feat.mul(hann); // hann window filter
+        multiply(feat,hann,feat); // hann window filter
         break;
     }
 
@@ -740,20 +844,21 @@ private:
   /* Convert BGR to ColorNames
    */
   void TrackerKCFImpl::extractCN(Mat patch_data, Mat & cnFeatures) const {
-    Vec3b & pixel = patch_data.at<Vec3b>(0,0);
     unsigned index;
 
-    if(cnFeatures.type() != CV_32FC(10))
-      cnFeatures = Mat::zeros(patch_data.rows,patch_data.cols,CV_32FC(10));
+    // every element is written below
+    cnFeatures.create(patch_data.rows,patch_data.cols,CV_32FC(10));
 
     for(int i=0;i<patch_data.rows;i++){
-      for(int j=0;j<patch_data.cols;j++){
-        pixel=patch_data.at<Vec3b>(i,j);
-        index=(unsigned)(floor((float)pixel[2]/8)+32*floor((float)pixel[1]/8)+32*32*floor((float)pixel[0]/8));
+      const Vec3b* pixel = patch_data.ptr<Vec3b>(i);
+      float* cn = cnFeatures.ptr<float>(i);
+      for(int j=0;j<patch_data.cols;j++,cn+=10){
+        // 32 levels per color channel
+        index=(unsigned)((pixel[j][2]>>3)+32*(pixel[j][1]>>3)+32*32*(pixel[j][0]>>3));
 
         //copy the values
         for(int _k=0;_k<10;_k++){
-          cnFeatures.at<Vec<float,10> >(i,j)[_k]=ColorNames[index][_k];
+          cn[_k]=ColorNames[index][_k];
         }
       }
     }
@@ -764,39 +869,42 @@ private:
    *  dense gauss kernel function
    */
   void TrackerKCFImpl::denseGaussKernel(const float sigma, const Mat x_data, const Mat y_data, Mat & k_data,
-                                        std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> xyf_v, Mat xy, Mat xyf ) const {
+                                        std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> & xyf_v, Mat & xy, Mat & xyf ) const {
     double normX, normY;
 
     fft2(x_data,xf_data,layers_data);
-    fft2(y_data,yf_data,layers_data);
-
     normX=norm(x_data);
     normX*=normX;
-    normY=norm(y_data);
-    normY*=normY;
 
-    pixelWiseMult(xf_data,yf_data,xyf_v,0,true);
+    // the spectrum of x is reused for the kernel auto-correlation
+    const bool autoCorrelation = x_data.data == y_data.data && x_data.size() == y_data.size();
+    if(!autoCorrelation){
+      fft2(y_data,yf_data,layers_data);
+      normY=norm(y_data);
+      normY*=normY;
+    }else{
+      normY=normX;
+    }
+
+    pixelWiseMult(xf_data,autoCorrelation ? xf_data : yf_data,xyf_v,0,true);
     sumChannels(xyf_v,xyf);
-    ifft2(xyf,xyf);
+    ifft2(xyf,xy);
 
     if(params.wrap_kernel){
-      shiftRows(xyf, x_data.rows/2);
-      shiftCols(xyf, x_data.cols/2);
+      shiftRows(xy, x_data.rows/2);
+      shiftCols(xy, x_data.cols/2);
     }
 
     //(xx + yy - 2 * xy) / numel(x)
-    xy=(normX+normY-2*xyf)/(x_data.rows*x_data.cols*x_data.channels());
+    const double numel = (double)x_data.rows*x_data.cols*x_data.channels();
+    xy.convertTo(xy, -1, -2.0/numel, (normX+normY)/numel);
 
     // TODO: check wether we really need thresholding or not
-    //threshold(xy,xy,0.0,0.0,THRESH_TOZERO);//max(0, (xx + yy - 2 * xy) / numel(x))
-    for(int i=0;i<xy.rows;i++){
-      for(int j=0;j<xy.cols;j++){
-        if(xy.at<float>(i,j)<0.0)xy.at<float>(i,j)=0.0;
-      }
-    }
+    //max(0, (xx + yy - 2 * xy) / numel(x))
+    max(xy, 0.0, xy);
 
     float sig=-1.0f/(sigma*sigma);
-    xy=sig*xy;
+    xy.convertTo(xy, -1, sig);
     exp(xy,k_data);
 
   }
@@ -43,6 +43,7 @@
 #include "opencv2/tracking/tracking_legacy.hpp"
 
 #include "tracking_utils.hpp"
+#include "trackerSharedFrame.hpp"
 #include <algorithm>
 #include <limits.h>
 
@@ -72,7 +73,7 @@ namespace impl {
  * optimize (allocation<-->reallocation)
  */
 
-class TrackerMedianFlowImpl : public legacy::TrackerMedianFlow
+class TrackerMedianFlowImpl : public legacy::TrackerMedianFlow, public tracking_internal::SharedFrameTracker
 {
 public:
     TrackerMedianFlowImpl(TrackerMedianFlow::Params paramsIn = TrackerMedianFlow::Params()) {params=paramsIn;isInit=false;}
@@ -81,7 +82,9 @@ public:
 private:
     bool initImpl( const Mat& image, const Rect2d& boundingBox ) CV_OVERRIDE;
     bool updateImpl( const Mat& image, Rect2d& boundingBox ) CV_OVERRIDE;
-    bool medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& oldBox);
+    bool updateShared( tracking_internal::SharedFrame& frame, Rect2d& boundingBox ) CV_OVERRIDE;
+    bool updateGray( const Mat& image, const Mat& image_gray, Rect2d& boundingBox );
+    bool medianFlowImpl(Mat oldImage,Mat newImage_gray,Rect2d& oldBox);
     Rect2d vote(const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,const Rect2d& oldRect,Point2f& mD);
     float dist(Point2f p1,Point2f p2);
     std::string type2str(int type);
@@ -151,10 +154,25 @@ bool TrackerMedianFlowImpl::initImpl( const Mat& image, const Rect2d& boundingBo
 }
 
 bool TrackerMedianFlowImpl::updateImpl( const Mat& image, Rect2d& boundingBox ){
+    Mat image_gray;
+    if (image.channels() != 1)
+        cvtColor( image, image_gray, COLOR_BGR2GRAY );
+    else
+        image_gray = image;
+    return updateGray(image, image_gray, boundingBox);
+}
+
+bool TrackerMedianFlowImpl::updateShared( tracking_internal::SharedFrame& frame, Rect2d& boundingBox ){
+    if (!isInit)
+        return false;
+    return updateGray(frame.getImage(), frame.get(tracking_internal::SharedFrame::GRAY), boundingBox);
+}
+
+bool TrackerMedianFlowImpl::updateGray( const Mat& image, const Mat& image_gray, Rect2d& boundingBox ){
     Mat oldImage=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getImage();
 
     Rect2d oldBox=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getBoundingBox();
-    if(!medianFlowImpl(oldImage,image,oldBox)){
+    if(!medianFlowImpl(oldImage,image_gray,oldBox)){
         return false;
     }
     boundingBox=oldBox;
@@ -196,20 +214,15 @@ size_t filterPointsInVectors(std::vector<T>& status, std::vector<Point2f>& vec1,
     return first_bad_idx;
 }
 
-bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& oldBox){
+bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage_gray,Rect2d& oldBox){
     std::vector<Point2f> pointsToTrackOld,pointsToTrackNew;
 
-    Mat oldImage_gray,newImage_gray;
+    Mat oldImage_gray;
     if (oldImage.channels() != 1)
         cvtColor( oldImage, oldImage_gray, COLOR_BGR2GRAY );
     else
         oldImage.copyTo(oldImage_gray);
 
-    if (newImage.channels() != 1)
-        cvtColor( newImage, newImage_gray, COLOR_BGR2GRAY );
-    else
-        newImage.copyTo(newImage_gray);
-
     //"open ended" grid
     for(int i=0;i<params.pointsInGrid;i++){
         for(int j=0;j<params.pointsInGrid;j++){
@@ -0,0 +1,111 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+#include "trackerSharedFrame.hpp"
+#include "trackerCSRTUtils.hpp"
+
+#include <set>
+
+namespace cv {
+namespace tracking_internal {
+
+SharedFrame::SharedFrame(const Mat& _image) : image(_image)
+{
+    for (int i = 0; i < KIND_COUNT; i++)
+        ready[i] = false;
+}
+
+const Mat& SharedFrame::get(Kind kind)
+{
+    CV_Assert(kind >= 0 && kind < KIND_COUNT);
+
+    AutoLock lock(mutex[kind]);
+    if (!ready[kind])
+    {
+        compute(kind, derived[kind]);
+        ready[kind] = true;
+    }
+    return derived[kind];
+}
+
+void SharedFrame::compute(Kind kind, Mat& dst)
+{
+    switch (kind)
+    {
+    case GRAY:
+        if (image.channels() == 1)
+            dst = image;
+        else
+            cvtColor(image, dst, COLOR_BGR2GRAY);
+        break;
+    case BGR:
+        if (image.channels() == 1)
+            cvtColor(image, dst, COLOR_GRAY2BGR);
+        else
+            dst = image;
+        break;
+    case CSRT_HSV:
+        dst = bgr2hsv(get(BGR));
+        break;
+    case HALF_SIZE:
+        resize(image, dst, Size(image.cols / 2, image.rows / 2), 0, 0, INTER_LINEAR_EXACT);
+        break;
+    case HALF_SIZE_GRAY:
+    {
+        const Mat& half = get(HALF_SIZE);
+        if (half.channels() == 1)
+            dst = half;
+        else
+            cvtColor(half, dst, COLOR_BGR2GRAY);
+        break;
+    }
+    default:
+        CV_Error(Error::StsBadArg, "Unknown kind of the shared frame data");
+    }
+}
+
+std::vector<uchar> updateTrackers(const std::vector<Ptr<legacy::Tracker> >& trackers, InputArray image,
+                                  std::vector<Rect2d>& boundingBoxes)
+{
+    CV_Assert(trackers.size() == boundingBoxes.size());
+
+    std::vector<uchar> status(trackers.size(), (uchar)0);
+    if (image.empty())
+        return status;
+
+    //! A tracker listed more than once is updated sequentially after its first entry,
+    //! so that no tracker is updated from two threads
+    std::vector<int> sharedIdx, serialIdx;
+    std::set<const legacy::Tracker*> sharedTrackers;
+    for (int i = 0; i < (int)trackers.size(); i++)
+    {
+        if (dynamic_cast<SharedFrameTracker*>(trackers[i].get()) && sharedTrackers.insert(trackers[i].get()).second)
+            sharedIdx.push_back(i);
+        else
+            serialIdx.push_back(i);
+    }
+
+    if (!sharedIdx.empty())
+    {
+        SharedFrame frame(image.getMat());
+        parallel_for_(Range(0, (int)sharedIdx.size()), [&](const Range& range)
+        {
+            for (int k = range.start; k < range.end; k++)
+            {
+                int i = sharedIdx[k];
+                SharedFrameTracker* tracker = dynamic_cast<SharedFrameTracker*>(trackers[i].get());
+                status[i] = tracker->updateShared(frame, boundingBoxes[i]) ? 1 : 0;
+            }
+        });
+    }
+
+    for (int i : serialIdx)
+        status[i] = trackers[i]->update(image, boundingBoxes[i]) ? 1 : 0;
+
+    return status;
+}
+
+}  // namespace tracking_internal
+}  // namespace cv
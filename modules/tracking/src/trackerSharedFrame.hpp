@@ -0,0 +1,65 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef OPENCV_TRACKER_SHARED_FRAME
+#define OPENCV_TRACKER_SHARED_FRAME
+
+#include "opencv2/tracking/tracking_legacy.hpp"
+
+namespace cv {
+namespace tracking_internal {
+
+/** Frame-level preprocessing shared by the trackers updated on the same frame.
+* Every derived image is computed once, by the first tracker asking for it,
+* and may be requested from several threads at the same time.*/
+class SharedFrame
+{
+public:
+    enum Kind
+    {
+        GRAY      = 0, //!< single channel image
+        BGR       = 1, //!< three channel image
+        CSRT_HSV  = 2, //!< HSV image with the hue scaled to [0, 255], see bgr2hsv()
+        HALF_SIZE = 3, //!< image downscaled twice with INTER_LINEAR_EXACT
+        HALF_SIZE_GRAY = 4, //!< single channel HALF_SIZE image
+        KIND_COUNT
+    };
+
+    explicit SharedFrame(const Mat& image);
+
+    const Mat& getImage() const { return image; }
+    const Mat& get(Kind kind);
+
+private:
+    SharedFrame(const SharedFrame&);
+    SharedFrame& operator=(const SharedFrame&);
+
+    void compute(Kind kind, Mat& dst);
+
+    Mat image;
+    Mat derived[KIND_COUNT];
+    bool ready[KIND_COUNT];
+    Mutex mutex[KIND_COUNT];
+};
+
+/** Implemented by the trackers which may be updated concurrently with other trackers
+* and take the frame-level preprocessing from a shared frame.*/
+class SharedFrameTracker
+{
+public:
+    virtual ~SharedFrameTracker() {}
+    virtual bool updateShared(SharedFrame& frame, Rect2d& boundingBox) = 0;
+};
+
+/** Updates all the trackers on the same frame, the result of i-th tracker is stored in boundingBoxes[i].
+* Trackers implementing SharedFrameTracker run in parallel, the rest and repeated entries of the same tracker
+* are updated one by one afterwards, so the results do not depend on the number of threads.
+* @return per-tracker statuses*/
+std::vector<uchar> updateTrackers(const std::vector<Ptr<legacy::Tracker> >& trackers, InputArray image,
+                                  std::vector<Rect2d>& boundingBoxes);
+
+}  // namespace tracking_internal
+}  // namespace cv
+
+#endif
@@ -233,4 +233,157 @@ TEST_P(DistanceAndOverlap, Scaled_Data_CSRT_legacy)
 
 INSTANTIATE_TEST_CASE_P(Tracking, DistanceAndOverlap, TESTSET_NAMES);
 
+static Ptr<legacy::Tracker> createMultiTrackerTarget(int t)
+{
+  switch (t % 3)
+  {
+  case 0: return legacy::TrackerKCF::create();
+  case 1: return legacy::TrackerMOSSE::create();
+  default: return legacy::TrackerMedianFlow::create();
+  }
+}
+
+TEST(MultiTracker, parallel_update)
+{
+  // textured scene panning across the view, so that every target moves
+  const int N = 10, targets = 9;
+  const Size frameSize(320, 240), targetSize(48, 48);
+  RNG rng(12345);
+  Mat scene(frameSize.height + 2 * N, frameSize.width + 3 * N, CV_8UC3);
+  rng.fill(scene, RNG::UNIFORM, 0, 256);
+  GaussianBlur(scene, scene, Size(7, 7), 2);
+  std::vector<Mat> frames;
+  for (int i = 0; i < N; i++)
+    frames.push_back(scene(Rect(Point(3 * i, 2 * i), frameSize)).clone());
+
+  std::vector<Rect2d> boxes;
+  for (int t = 0; t < targets; t++)
+    boxes.push_back(Rect2d(Point2d(20 + (t % 3) * 96, 20 + (t / 3) * 72), targetSize));
+
+  legacy::MultiTracker parallel, serial;
+  std::vector<Ptr<legacy::Tracker> > single;
+  for (int t = 0; t < targets; t++)
+  {
+    ASSERT_TRUE(parallel.add(createMultiTrackerTarget(t), frames[0], boxes[t]));
+    ASSERT_TRUE(serial.add(createMultiTrackerTarget(t), frames[0], boxes[t]));
+    single.push_back(createMultiTrackerTarget(t));
+    ASSERT_TRUE(single.back()->init(frames[0], boxes[t]));
+  }
+
+  std::vector<Rect2d> singleBoxes(boxes);
+  const int nThreads = getNumThreads();
+  for (int i = 1; i < N; i++)
+  {
+    std::vector<Rect2d> parallelBoxes, serialBoxes;
+    bool parallelStatus = parallel.update(frames[i], parallelBoxes);
+
+    setNumThreads(1);
+    bool serialStatus = serial.update(frames[i], serialBoxes);
+    bool singleStatus = true;
+    for (int t = 0; t < targets; t++)
+      singleStatus &= single[t]->update(frames[i], singleBoxes[t]);
+    setNumThreads(nThreads);
+
+    EXPECT_EQ(serialStatus, parallelStatus) << "frame " << i;
+    EXPECT_EQ(singleStatus, parallelStatus) << "frame " << i;
+    ASSERT_EQ((size_t)targets, parallelBoxes.size());
+    for (int t = 0; t < targets; t++)
+    {
+      EXPECT_EQ(serialBoxes[t], parallelBoxes[t]) << "frame " << i << ", target " << t;
+      EXPECT_EQ(singleBoxes[t], parallelBoxes[t]) << "frame " << i << ", target " << t;
+    }
+  }
+}
+
+TEST(MultiTracker, reject_same_tracker)
+{
+  Mat frame(240, 320, CV_8UC3);
+  theRNG().fill(frame, RNG::UNIFORM, 0, 256);
+  Ptr<legacy::Tracker> tracker = legacy::TrackerKCF::create();
+
+  legacy::MultiTracker multiTracker;
+  ASSERT_TRUE(multiTracker.add(tracker, frame, Rect2d(10, 10, 40, 40)));
+  EXPECT_FALSE(multiTracker.add(tracker, frame, Rect2d(100, 100, 40, 40)));
+  EXPECT_EQ((size_t)1, multiTracker.getObjects().size());
+
+  legacy::MultiTracker_Alt multiTrackerAlt;
+  ASSERT_TRUE(multiTrackerAlt.addTarget(frame, Rect2d(10, 10, 40, 40), tracker));
+  EXPECT_FALSE(multiTrackerAlt.addTarget(frame, Rect2d(100, 100, 40, 40), tracker));
+  EXPECT_EQ(1, multiTrackerAlt.targetNum);
+}
+
+// textured target moving over a textured background by a known shift per frame
+static void makeMovingTargetSequence(std::vector<Mat>& frames, std::vector<Rect>& gt)
+{
+  const int N = 20;
+  const Size frameSize(320, 240), targetSize(40, 40);
+  const Point step(3, 2);
+  RNG rng(4321);
+  Mat background(frameSize, CV_8UC3), target(targetSize, CV_8UC3);
+  rng.fill(background, RNG::UNIFORM, 64, 192);
+  GaussianBlur(background, background, Size(9, 9), 3);
+  rng.fill(target, RNG::UNIFORM, 0, 256);
+  GaussianBlur(target, target, Size(3, 3), 1);
+
+  frames.clear();
+  gt.clear();
+  for (int i = 0; i < N; i++)
+  {
+    Rect box(Point(60, 60) + step * i, targetSize);
+    Mat frame = background.clone();
+    target.copyTo(frame(box));
+    frames.push_back(frame);
+    gt.push_back(box);
+  }
+}
+
+TEST(TrackerKCF, synthetic_sequence)
+{
+  std::vector<Mat> frames;
+  std::vector<Rect> gt;
+  makeMovingTargetSequence(frames, gt);
+
+  std::vector<Rect> boxes(frames.size());
+  {
+    Ptr<Tracker> tracker = TrackerKCF::create();
+    tracker->init(frames[0], gt[0]);
+    boxes[0] = gt[0];
+    for (size_t i = 1; i < frames.size(); i++)
+    {
+      ASSERT_TRUE(tracker->update(frames[i], boxes[i])) << "frame " << i;
+      EXPECT_LE(norm(boxes[i].tl() - gt[i].tl()), 3.0) << "frame " << i;
+      EXPECT_EQ(gt[i].size(), boxes[i].size()) << "frame " << i;
+    }
+  }
+
+  // the buffers of a tracker initialized again do not keep anything from the previous run
+  {
+    Ptr<Tracker> tracker = TrackerKCF::create();
+    Rect box = gt.back();
+    tracker->init(frames.back(), box);
+    tracker->update(frames[frames.size() - 2], box);
+
+    tracker->init(frames[0], gt[0]);
+    for (size_t i = 1; i < frames.size(); i++)
+    {
+      ASSERT_TRUE(tracker->update(frames[i], box)) << "frame " << i;
+      EXPECT_EQ(boxes[i], box) << "frame " << i;
+    }
+  }
+
+  // trackers of the same window size share the window data, an interleaved one must not change the result
+  {
+    Ptr<Tracker> tracker = TrackerKCF::create(), other = TrackerKCF::create();
+    Rect box = gt[0], otherBox(Point(200, 150), gt[0].size());
+    tracker->init(frames[0], box);
+    other->init(frames[0], otherBox);
+    for (size_t i = 1; i < frames.size(); i++)
+    {
+      other->update(frames[i], otherBox);
+      ASSERT_TRUE(tracker->update(frames[i], box)) << "frame " << i;
+      EXPECT_EQ(boxes[i], box) << "frame " << i;
+    }
+  }
+}
+
 }} // namespace
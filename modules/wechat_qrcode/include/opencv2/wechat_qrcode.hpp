@@ -50,6 +50,21 @@ public:
      */
     CV_WRAP std::vector<std::string> detectAndDecode(InputArray img, OutputArrayOfArrays points = noArray());
 
+    /**
+     * @brief  Both detects and decodes QR codes in a batch of images, e.g. frames of several cameras.
+     * The detector model runs a single forward pass for all the images of the same size,
+     * the super resolution model does the same for the crops of the same size,
+     * and the QR codes of all the images are decoded in parallel.
+     * The results are the same as the ones of detectAndDecode called for every image,
+     * the adaptive binarizer order (see setAdaptiveBinarizerOrder) is updated after the whole batch.
+     *
+     * @param imgs grayscale or color (BGR) images.
+     * @param points output vertices of the found QR code quadrangles, a vector per image.
+     * @return decoded strings, a vector per image.
+     */
+    CV_WRAP std::vector<std::vector<std::string>> detectAndDecodeBatch(InputArrayOfArrays imgs,
+                                                                       CV_OUT std::vector<std::vector<Mat>>& points);
+
     /**
     * @brief set scale factor
     * QR code detector use neural network to detect QR.
@@ -66,6 +81,27 @@ public:
 
     CV_WRAP float getScaleFactor();
 
+    /**
+    * @brief enable parallel decoding
+    * Every detected QR code is decoded at several scales with several binarizers.
+    * By default these attempts run one after another until one of them succeeds.
+    * In the parallel mode they run concurrently and the attempts which can not change the result
+    * are cancelled once one of them succeeds. The results are the same as in the default mode.
+    */
+    CV_WRAP void setParallelDecode(bool enable);
+
+    CV_WRAP bool getParallelDecode();
+
+    /**
+    * @brief enable adaptive binarizer order
+    * The binarizer which decoded the last QR code is tried first for the next one,
+    * so the images taken in the same conditions are usually decoded by the first attempt.
+    * The order is kept between detectAndDecode calls.
+    */
+    CV_WRAP void setAdaptiveBinarizerOrder(bool enable);
+
+    CV_WRAP bool getAdaptiveBinarizerOrder();
+
 protected:
     class Impl;
     Ptr<Impl> p;
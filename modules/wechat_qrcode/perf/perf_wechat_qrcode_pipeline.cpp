@@ -93,6 +93,73 @@ PERF_TEST_P_(Perf_Objdetect_QRCode_Multi, detect_and_decode)
     SANITY_CHECK_NOTHING();
 }
 
+typedef ::perf::TestBaseWithParam< tuple< std::string, int > > Perf_Objdetect_QRCode_Batch;
+
+PERF_TEST_P_(Perf_Objdetect_QRCode_Batch, detect_and_decode)
+{
+    std::string model_path = get<0>(GetParam());
+    int batch_size = get<1>(GetParam());
+    const std::string root = "cv/qrcode/";
+
+    // frames of the same size, as from several cameras
+    std::vector< Mat > frames;
+    for (int i = 0; i < batch_size; i++)
+    {
+        std::string image_path = findDataFile(root + qrcode_images_name[i % 3]);
+        Mat src = imread(image_path, IMREAD_GRAYSCALE);
+        ASSERT_FALSE(src.empty()) << "Can't read image: " << image_path;
+        Mat frame(Size(640, 480), CV_8UC1, Scalar(255));
+        resize(src, frame(Rect(0, 0, 320, 320)), Size(320, 320), 0, 0, INTER_AREA);
+        frames.push_back(frame);
+    }
+
+    std::vector< std::vector< Mat > > corners;
+    std::vector< std::vector< std::string > > decoded_info;
+    auto detector = createQRDetectorWithDNN(model_path);
+    // warmup
+    if (!model_path.empty())
+    {
+        decoded_info = detector.detectAndDecodeBatch(frames, corners);
+    }
+    TEST_CYCLE()
+    {
+        decoded_info = detector.detectAndDecodeBatch(frames, corners);
+        ASSERT_EQ((size_t)batch_size, decoded_info.size());
+    }
+    SANITY_CHECK_NOTHING();
+}
+
+typedef ::perf::TestBaseWithParam< tuple< std::string, std::string > > Perf_Objdetect_QRCode_FullHD;
+
+// a small code in a large frame, the time goes mostly to the binarizers without the detector
+PERF_TEST_P_(Perf_Objdetect_QRCode_FullHD, detect_and_decode)
+{
+    std::string model_path = get<0>(GetParam());
+    std::string name_current_image = get<1>(GetParam());
+    const std::string root = "cv/qrcode/";
+
+    std::string image_path = findDataFile(root + name_current_image);
+    Mat src = imread(image_path, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(src.empty()) << "Can't read image: " << image_path;
+    Mat frame(Size(1920, 1080), CV_8UC1, Scalar(255));
+    resize(src, frame(Rect(800, 340, 400, 400)), Size(400, 400), 0, 0, INTER_AREA);
+
+    std::vector< Mat > corners;
+    std::vector< String > decoded_info;
+    auto detector = createQRDetectorWithDNN(model_path);
+    // warmup
+    if (!model_path.empty())
+    {
+        decoded_info = detector.detectAndDecode(frame, corners);
+    }
+    TEST_CYCLE()
+    {
+        decoded_info = detector.detectAndDecode(frame, corners);
+        ASSERT_FALSE(decoded_info.empty());
+    }
+    SANITY_CHECK_NOTHING();
+}
+
 typedef ::perf::TestBaseWithParam< tuple<std::string, std::string, Size> >Perf_Objdetect_Not_QRCode;
 
 PERF_TEST_P_(Perf_Objdetect_Not_QRCode, detect_and_decode)
@@ -148,11 +215,21 @@ INSTANTIATE_TEST_CASE_P(/*nothing*/, Perf_Objdetect_QRCode_Multi,
             ::testing::ValuesIn(qrcode_model_path),
             ::testing::ValuesIn(qrcode_images_multiple)
       ));
+INSTANTIATE_TEST_CASE_P(/*nothing*/, Perf_Objdetect_QRCode_Batch,
+      ::testing::Combine(
+            ::testing::ValuesIn(qrcode_model_path),
+            ::testing::Values(1, 4, 8)
+      ));
+INSTANTIATE_TEST_CASE_P(/*nothing*/, Perf_Objdetect_QRCode_FullHD,
+      ::testing::Combine(
+            ::testing::ValuesIn(qrcode_model_path),
+            ::testing::Values("version_1_top.jpg", "version_5_top.jpg", "link_wiki_cv.jpg")
+      ));
 INSTANTIATE_TEST_CASE_P(/*nothing*/, Perf_Objdetect_Not_QRCode,
       ::testing::Combine(
             ::testing::ValuesIn(qrcode_model_path),
             ::testing::Values("zero", "random", "chessboard"),
-            ::testing::Values(Size(640, 480),   Size(1280, 720))
+            ::testing::Values(Size(640, 480),   Size(1280, 720), Size(1920, 1080))
       ));
 
 } // namespace
@@ -54,6 +54,10 @@ void BinarizerMgr::SwitchBinarizer() {
     m_iNowRotateIndex = (m_iNowRotateIndex + 1) % m_vecRotateBinarizer.size();
 }
 
+void BinarizerMgr::ResetBinarizer() {
+    m_iNowRotateIndex = 0;
+}
+
 int BinarizerMgr::GetCurBinarizer() {
     if (m_iNextOnceBinarizer != -1) return m_iNextOnceBinarizer;
     return m_vecRotateBinarizer[m_iNowRotateIndex];
@@ -35,6 +35,9 @@ public:
 
     void SwitchBinarizer();
 
+    // starts the rotation from the first binarizer
+    void ResetBinarizer();
+
     int GetCurBinarizer();
 
     void SetNextOnceBinarizer(int iBinarizerIndex);
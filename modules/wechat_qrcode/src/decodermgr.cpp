@@ -19,31 +19,48 @@ using zxing::UnicomBlock;
 namespace cv {
 namespace wechat_qrcode {
 int DecoderMgr::decodeImage(cv::Mat src, bool use_nn_detector, vector<string>& results, vector<vector<Point2f>>& zxing_points) {
+    binarizer_mgr_.ResetBinarizer();
+    // Four Binarizers
+    return TryBinarizers(src, use_nn_detector, 4, results, zxing_points);
+}
+
+int DecoderMgr::decodeImage(cv::Mat src, bool use_nn_detector, BinarizerMgr::BINARIZER binarizer,
+                            vector<string>& results, vector<vector<Point2f>>& zxing_points) {
+    binarizer_mgr_.SetNextOnceBinarizer(binarizer);
+    int ret = TryBinarizers(src, use_nn_detector, 1, results, zxing_points);
+    binarizer_mgr_.SetNextOnceBinarizer(-1);
+    return ret;
+}
+
+void DecoderMgr::setBinarizerOrder(const vector<BinarizerMgr::BINARIZER>& order) {
+    binarizer_mgr_.SetBinarizer(order);
+}
+
+int DecoderMgr::TryBinarizers(cv::Mat src, bool use_nn_detector, int tryBinarizeTime,
+                               vector<string>& results, vector<vector<Point2f>>& zxing_points) {
     int width = src.cols;
     int height = src.rows;
     if (width <= 20 || height <= 20)
         return -1;  // image data is not enough for providing reliable results
 
-    std::vector<uint8_t> scaled_img_data(src.data, src.data + width * height);
-    zxing::ArrayRef<uint8_t> scaled_img_zx =
-        zxing::ArrayRef<uint8_t>(new zxing::Array<uint8_t>(scaled_img_data));
-
     vector<zxing::Ref<zxing::Result>> zx_results;
 
     decode_hints_.setUseNNDetector(use_nn_detector);
 
-    Ref<ImgSource> source;
-    qbarUicomBlock_ = new UnicomBlock(width, height);
+    // the binarizers only read the luminances, so they are copied once for all the attempts
+    if (source_ == NULL) {
+        source_ = ImgSource::create(src);
+    } else {
+        source_->reset(src);
+    }
+    if (qbarUicomBlock_ == NULL) {
+        qbarUicomBlock_ = new UnicomBlock(width, height);
+    } else {
+        qbarUicomBlock_->Resize(width, height);
+    }
 
-    // Four Binarizers
-    int tryBinarizeTime = 4;
     for (int tb = 0; tb < tryBinarizeTime; tb++) {
-        if (source == NULL || height * width > source->getMaxSize()) {
-            source = ImgSource::create(scaled_img_zx.data(), width, height);
-        } else {
-            source->reset(scaled_img_zx.data(), width, height);
-        }
-        int ret = TryDecode(source, zx_results);
+        int ret = TryDecode(source_, zx_results);
         if (!ret) {
             for(size_t k = 0; k < zx_results.size(); k++) {
                 results.emplace_back(zx_results[k]->getText()->getText());
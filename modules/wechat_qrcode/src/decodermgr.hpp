@@ -21,6 +21,8 @@
 namespace cv {
 namespace wechat_qrcode {
 
+// Keeps the decoding buffers between the calls, so it should be reused for the subsequent images.
+// It is not thread-safe, every thread needs its own DecoderMgr.
 class DecoderMgr {
 public:
     DecoderMgr() { reader_ = new zxing::qrcode::QRCodeReader(); };
@@ -28,7 +30,18 @@ public:
 
     int decodeImage(cv::Mat src, bool use_nn_detector, vector<string>& result, vector<vector<Point2f>>& zxing_points);
 
+    // tries the given binarizer only
+    int decodeImage(cv::Mat src, bool use_nn_detector, BinarizerMgr::BINARIZER binarizer,
+                    vector<string>& result, vector<vector<Point2f>>& zxing_points);
+
+    // order in which decodeImage tries the binarizers
+    void setBinarizerOrder(const vector<BinarizerMgr::BINARIZER>& order);
+
+    // binarizer which decoded the image if the binarizer order is tried and decodeImage returns 0
+    int getCurBinarizer() { return binarizer_mgr_.GetCurBinarizer(); }
+
 private:
+    zxing::Ref<ImgSource> source_;
     zxing::Ref<zxing::UnicomBlock> qbarUicomBlock_;
     zxing::DecodeHints decode_hints_;
 
@@ -39,6 +52,9 @@ private:
                                      zxing::DecodeHints hints);
 
     int TryDecode(zxing::Ref<zxing::LuminanceSource> source, vector<zxing::Ref<zxing::Result>>& result);
+
+    int TryBinarizers(cv::Mat src, bool use_nn_detector, int tryBinarizeTime, vector<string>& result,
+                      vector<vector<Point2f>>& zxing_points);
 };
 
 }  // namespace wechat_qrcode
@@ -15,25 +15,36 @@ int SSDDetector::init(const string& proto_path, const string& model_path) {
 }
 
 vector<Mat> SSDDetector::forward(Mat img, const int target_width, const int target_height) {
-    int img_w = img.cols;
-    int img_h = img.rows;
-    Mat input;
-    resize(img, input, Size(target_width, target_height), 0, 0, INTER_CUBIC);
+    return forward(vector<Mat>(1, img), target_width, target_height)[0];
+}
+
+vector<vector<Mat>> SSDDetector::forward(const vector<Mat>& imgs, const int target_width,
+                                         const int target_height) {
+    vector<Mat> inputs(imgs.size());
+    for (size_t i = 0; i < imgs.size(); i++) {
+        resize(imgs[i], inputs[i], Size(target_width, target_height), 0, 0, INTER_CUBIC);
+    }
 
-    dnn::blobFromImage(input, input, 1.0 / 255, Size(input.cols, input.rows), {0.0f, 0.0f, 0.0f},
-                       false, false);
-    net_.setInput(input, "data");
+    Mat blob;
+    dnn::blobFromImages(inputs, blob, 1.0 / 255, Size(target_width, target_height),
+                        {0.0f, 0.0f, 0.0f}, false, false);
+    net_.setInput(blob, "data");
 
     auto prob = net_.forward("detection_output");
-    vector<Mat> point_list;
+    vector<vector<Mat>> point_lists(imgs.size());
     // the shape is (1,1,100,7)=>(batch,channel,count,dim)
+    // the detections of all the images are in the same list
     for (int row = 0; row < prob.size[2]; row++) {
         const float* prob_score = prob.ptr<float>(0, 0, row);
-        // prob_score[0] is not used.
+        // prob_score[0] is the index of the image in the batch.
         // prob_score[1]==1 stands for qrcode
+        const int img_idx = cvRound(prob_score[0]);
+        if (img_idx < 0 || img_idx >= (int)imgs.size()) continue;
         if (prob_score[1] == 1 && prob_score[2] > 1E-5) {
             // add a safe score threshold due to https://github.com/opencv/opencv_contrib/issues/2877
             // prob_score[2] is the probability of the qrcode, which is not used.
+            const int img_w = imgs[img_idx].cols;
+            const int img_h = imgs[img_idx].rows;
             auto point = Mat(4, 2, CV_32FC1);
             float x0 = CLIP(prob_score[3] * img_w, 0.0f, img_w - 1.0f);
             float y0 = CLIP(prob_score[4] * img_h, 0.0f, img_h - 1.0f);
@@ -48,10 +59,10 @@ vector<Mat> SSDDetector::forward(Mat img, const int target_width, const int targ
             point.at<float>(2, 1) = y1;
             point.at<float>(3, 0) = x0;
             point.at<float>(3, 1) = y1;
-            point_list.push_back(point);
+            point_lists[img_idx].push_back(point);
         }
     }
-    return point_list;
+    return point_lists;
 }
 }  // namespace wechat_qrcode
 }  // namespace cv
\ No newline at end of file
@@ -21,6 +21,10 @@ public:
     ~SSDDetector(){};
     int init(const std::string& proto_path, const std::string& model_path);
     std::vector<Mat> forward(Mat img, const int target_width, const int target_height);
+    // detects the QR codes in all the images by a single forward pass,
+    // every image is resized to the same target size
+    std::vector<std::vector<Mat>> forward(const std::vector<Mat>& imgs, const int target_width,
+                                          const int target_height);
 
 private:
     dnn::Net net_;
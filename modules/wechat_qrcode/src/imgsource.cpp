@@ -19,20 +19,15 @@ namespace cv {
 namespace wechat_qrcode {
 
 // Initialize the ImgSource
-ImgSource::ImgSource(unsigned char* pixels, int width, int height)
-    : Super(width, height) {
-    luminances = new unsigned char[width * height];
-    memset(luminances, 0, width * height);
-
-    rgbs = pixels;
-
-    dataWidth = width;
-    dataHeight = height;
+ImgSource::ImgSource(const Mat& img)
+    : Super(img.cols, img.rows) {
+    dataWidth = img.cols;
+    dataHeight = img.rows;
     left = 0;
     top = 0;
 
     // Make gray luminances first
-    makeGray();
+    makeGray(img);
 }
 
 // Added for crop function
@@ -55,20 +50,14 @@ ImgSource::ImgSource(unsigned char* pixels, int width, int height, int left_, in
         return;
     }
 
-    luminances = new unsigned char[width * height];
-
     // Make gray luminances first
     makeGray();
 }
 
-ImgSource::~ImgSource() {
-    if (luminances != NULL) {
-        delete[] luminances;
-    }
-}
+ImgSource::~ImgSource() {}
 
-Ref<ImgSource> ImgSource::create(unsigned char* pixels, int width, int height) {
-    return Ref<ImgSource>(new ImgSource(pixels, width, height));
+Ref<ImgSource> ImgSource::create(const Mat& img) {
+    return Ref<ImgSource>(new ImgSource(img));
 }
 
 Ref<ImgSource> ImgSource::create(unsigned char* pixels, int width, int height, int left, int top,
@@ -77,16 +66,15 @@ Ref<ImgSource> ImgSource::create(unsigned char* pixels, int width, int height, i
     return Ref<ImgSource>(new ImgSource(pixels, width, height, left, top, cropWidth, cropHeight, err_handler));
 }
 
-void ImgSource::reset(unsigned char* pixels, int width, int height) {
-    rgbs = pixels;
+void ImgSource::reset(const Mat& img) {
     left = 0;
     top = 0;
 
-    setWidth(width);
-    setHeight(height);
-    dataWidth = width;
-    dataHeight = height;
-    makeGrayReset();
+    setWidth(img.cols);
+    setHeight(img.rows);
+    dataWidth = img.cols;
+    dataHeight = img.rows;
+    makeGray(img);
 }
 
 ArrayRef<char> ImgSource::getRow(int y, zxing::ArrayRef<char> row,
@@ -103,7 +91,7 @@ ArrayRef<char> ImgSource::getRow(int y, zxing::ArrayRef<char> row,
     int offset = (y + top) * dataWidth + left;
 
     char* rowPtr = &row[0];
-    arrayCopy(luminances, offset, rowPtr, 0, width);
+    arrayCopy((const unsigned char*)&_matrix[0], offset, rowPtr, 0, width);
 
     return row;
 }
@@ -129,14 +117,14 @@ ArrayRef<char> ImgSource::getMatrix() const {
     // If the width matches the full width of the underlying data, perform a
     // single copy.
     if (width == dataWidth) {
-        arrayCopy(luminances, inputOffset, &newMatrix[0], 0, area);
+        arrayCopy((const unsigned char*)&_matrix[0], inputOffset, &newMatrix[0], 0, area);
         return newMatrix;
     }
 
     // Otherwise copy one cropped row at a time.
     for (int y = 0; y < height; y++) {
         int outputOffset = y * width;
-        arrayCopy(luminances, inputOffset, &newMatrix[0], outputOffset, width);
+        arrayCopy((const unsigned char*)&_matrix[0], inputOffset, &newMatrix[0], outputOffset, width);
         inputOffset += dataWidth;
     }
     return newMatrix;
@@ -149,12 +137,23 @@ void ImgSource::makeGray() {
     arrayCopy(rgbs, 0, &_matrix[0], 0, area);
 }
 
-void ImgSource::makeGrayReset() {
+void ImgSource::makeGray(const Mat& img) {
+    CV_Assert(img.type() == CV_8UC1);
     int area = dataWidth * dataHeight;
-    arrayCopy(rgbs, 0, &_matrix[0], 0, area);
+    if (!_matrix) {
+        _matrix = zxing::ArrayRef<char>(area);
+    } else {
+        // keeps the capacity, so the steady state decoding does not allocate
+        _matrix->values().resize(area);
+    }
+    for (int y = 0; y < dataHeight; y++) {
+        arrayCopy(img.ptr(y), 0, &_matrix[0], y * dataWidth, dataWidth);
+    }
+    // the crops are made from the copy, the image may be released by the caller
+    rgbs = (unsigned char*)&_matrix[0];
 }
 
-void ImgSource::arrayCopy(unsigned char* src, int inputOffset, char* dst, int outputOffset,
+void ImgSource::arrayCopy(const unsigned char* src, int inputOffset, char* dst, int outputOffset,
                           int length) const {
     const unsigned char* srcPtr = src + inputOffset;
     char* dstPtr = dst + outputOffset;
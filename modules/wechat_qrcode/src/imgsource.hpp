@@ -10,6 +10,7 @@
 
 #ifndef __OPENCV_WECHAT_QRCODE_IMGSOURCE_HPP__
 #define __OPENCV_WECHAT_QRCODE_IMGSOURCE_HPP__
+#include "opencv2/core.hpp"
 #include "zxing/common/bytematrix.hpp"
 #include "zxing/errorhandler.hpp"
 #include "zxing/luminance_source.hpp"
@@ -20,29 +21,30 @@ private:
     typedef LuminanceSource Super;
     zxing::ArrayRef<char> _matrix;
     unsigned char* rgbs;
-    unsigned char* luminances;
     int dataWidth;
     int dataHeight;
     int left;
     int top;
     void makeGray();
-    void makeGrayReset();
+    void makeGray(const cv::Mat& img);
 
-    void arrayCopy(unsigned char* src, int inputOffset, char* dst, int outputOffset,
+    void arrayCopy(const unsigned char* src, int inputOffset, char* dst, int outputOffset,
                    int length) const;
 
 
     ~ImgSource();
 
 public:
-    ImgSource(unsigned char* pixels, int width, int height);
+    explicit ImgSource(const cv::Mat& img);
     ImgSource(unsigned char* pixels, int width, int height, int left, int top, int cropWidth,
               int cropHeight, zxing::ErrorHandler& err_handler);
 
-    static zxing::Ref<ImgSource> create(unsigned char* pixels, int width, int height);
+    // copies the 8-bit single channel image, the image may be not continuous
+    static zxing::Ref<ImgSource> create(const cv::Mat& img);
     static zxing::Ref<ImgSource> create(unsigned char* pixels, int width, int height, int left,
                                         int top, int cropWidth, int cropHeight, zxing::ErrorHandler& err_handler);
-    void reset(unsigned char* pixels, int width, int height);
+    // reuses the luminance buffer, it is reallocated only if the image is larger than all the previous ones
+    void reset(const cv::Mat& img);
     zxing::ArrayRef<char> getRow(int y, zxing::ArrayRef<char> row,
                                     zxing::ErrorHandler& err_handler) const override;
     zxing::ArrayRef<char> getMatrix() const override;
@@ -55,8 +57,6 @@ public:
     bool isRotateSupported() const override;
     zxing::Ref<LuminanceSource> rotateCounterClockwise(
         zxing::ErrorHandler& err_handler) const override;
-
-    int getMaxSize() { return dataHeight * dataWidth; }
 };
 }  // namespace wechat_qrcode
 }  // namespace cv
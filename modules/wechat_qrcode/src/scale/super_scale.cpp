@@ -17,28 +17,81 @@ int SuperScale::init(const std::string &proto_path, const std::string &model_pat
     return 0;
 }
 
-Mat SuperScale::processImageScale(const Mat &src, float scale, const bool &use_sr,
+Mat SuperScale::processImageScale(const Mat &src, float scale, const bool &use_sr, Mat &buffer,
                                   int sr_max_size) {
-    Mat dst = src;
+    // the buffer never refers to src, so writing to it can not change the source image
     if (scale == 1.0) {  // src
-        return dst;
+        return src;
     }
 
-    int width = src.cols;
-    int height = src.rows;
     if (scale == 2.0) {  // upsample
-        int SR_TH = sr_max_size;
-        if (use_sr && (int)sqrt(width * height * 1.0) < SR_TH && net_loaded_) {
-            int ret = superResoutionScale(src, dst);
-            if (ret == 0) return dst;
+        if (useSuperResolution(src, scale, use_sr, sr_max_size)) {
+            int ret = superResoutionScale(src, buffer);
+            if (ret == 0) return buffer;
         }
 
-        { resize(src, dst, Size(), scale, scale, INTER_CUBIC); }
+        { resize(src, buffer, Size(), scale, scale, INTER_CUBIC); }
     } else if (scale < 1.0) {  // downsample
-        resize(src, dst, Size(), scale, scale, INTER_AREA);
+        resize(src, buffer, Size(), scale, scale, INTER_AREA);
+    } else {
+        return src;
     }
 
-    return dst;
+    return buffer;
+}
+
+vector<Mat> SuperScale::processImageScale(const vector<Mat> &srcs, const vector<float> &scales,
+                                          const bool &use_sr, int sr_max_size) {
+    CV_Assert(srcs.size() == scales.size());
+    vector<Mat> dsts(srcs.size());
+    vector<size_t> sr_idx;
+    for (size_t i = 0; i < srcs.size(); i++) {
+        if (useSuperResolution(srcs[i], scales[i], use_sr, sr_max_size)) {
+            sr_idx.push_back(i);
+        } else {
+            dsts[i] = processImageScale(srcs[i], scales[i], use_sr, dsts[i], sr_max_size);
+        }
+    }
+
+    // a blob needs the images of the same size
+    while (!sr_idx.empty()) {
+        const Size size = srcs[sr_idx[0]].size();
+        vector<Mat> batch;
+        vector<size_t> batch_idx, rest_idx;
+        for (size_t i : sr_idx) {
+            if (srcs[i].size() == size) {
+                batch.push_back(srcs[i]);
+                batch_idx.push_back(i);
+            } else {
+                rest_idx.push_back(i);
+            }
+        }
+        sr_idx.swap(rest_idx);
+
+        Mat blob;
+        dnn::blobFromImages(batch, blob, 1.0 / 255, size, {0.0f}, false, false);
+        srnet_.setInput(blob);
+        auto prob = srnet_.forward();
+
+        for (size_t k = 0; k < batch_idx.size(); k++) {
+            Mat &dst = dsts[batch_idx[k]];
+            dst.create(prob.size[2], prob.size[3], CV_8UC1);
+            for (int row = 0; row < prob.size[2]; row++) {
+                const float *prob_score = prob.ptr<float>((int)k, 0, row);
+                for (int col = 0; col < prob.size[3]; col++) {
+                    float pixel = prob_score[col] * 255.0;
+                    dst.at<uint8_t>(row, col) = static_cast<uint8_t>(CLIP(pixel, 0.0f, 255.0f));
+                }
+            }
+        }
+    }
+    return dsts;
+}
+
+bool SuperScale::useSuperResolution(const Mat &src, float scale, const bool &use_sr,
+                                    int sr_max_size) {
+    int SR_TH = sr_max_size;
+    return scale == 2.0 && use_sr && (int)sqrt(src.cols * src.rows * 1.0) < SR_TH && net_loaded_;
 }
 
 int SuperScale::superResoutionScale(const Mat &src, Mat &dst) {
@@ -48,7 +101,7 @@ int SuperScale::superResoutionScale(const Mat &src, Mat &dst) {
     srnet_.setInput(blob);
     auto prob = srnet_.forward();
 
-    dst = Mat(prob.size[2], prob.size[3], CV_8UC1);
+    dst.create(prob.size[2], prob.size[3], CV_8UC1);
 
     for (int row = 0; row < prob.size[2]; row++) {
         const float *prob_score = prob.ptr<float>(0, 0, row);
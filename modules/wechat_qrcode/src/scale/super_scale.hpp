@@ -19,12 +19,19 @@ public:
     SuperScale(){};
     ~SuperScale(){};
     int init(const std::string &proto_path, const std::string &model_path);
-    Mat processImageScale(const Mat &src, float scale, const bool &use_sr, int sr_max_size = 160);
+    // the scaled image is written to buffer, it is reallocated only if the size changes
+    Mat processImageScale(const Mat &src, float scale, const bool &use_sr, Mat &buffer,
+                          int sr_max_size = 160);
+    // scales srcs[i] by scales[i], the images of the same size upsampled by the super resolution
+    // model share a forward pass
+    std::vector<Mat> processImageScale(const std::vector<Mat> &srcs, const std::vector<float> &scales,
+                                       const bool &use_sr, int sr_max_size = 160);
 
 private:
     dnn::Net srnet_;
     bool net_loaded_ = false;
     int superResoutionScale(const cv::Mat &src, cv::Mat &dst);
+    bool useSuperResolution(const Mat &src, float scale, const bool &use_sr, int sr_max_size);
 };
 
 }  // namespace wechat_qrcode
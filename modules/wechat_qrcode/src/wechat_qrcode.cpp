@@ -13,11 +13,18 @@
 #include "opencv2/core/utils/filesystem.hpp"
 #include "scale/super_scale.hpp"
 #include "zxing/result.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
 namespace cv {
 namespace wechat_qrcode {
 class WeChatQRCode::Impl {
 public:
-    Impl() {}
+    Impl() {
+        binarizer_order_ = {BinarizerMgr::Hybrid, BinarizerMgr::FastWindow,
+                            BinarizerMgr::SimpleAdaptive, BinarizerMgr::AdaptiveThreshold};
+    }
     ~Impl() {}
     /**
      * @brief detect QR codes from the given image
@@ -37,13 +44,59 @@ public:
      */
     std::vector<std::string> decode(const Mat& img, std::vector<Mat>& candidate_points,
                                     std::vector<Mat>& points);
+    /**
+     * @brief detect and decode QR codes in a batch of images, see WeChatQRCode::detectAndDecodeBatch
+     *
+     * @param imgs grayscale images.
+     * @param points succussfully decoded qrcode with bounding box points, a vector per image.
+     * @return vector<vector<string>> decoded strings, a vector per image.
+     */
+    std::vector<std::vector<std::string>> detectAndDecodeBatch(const std::vector<Mat>& imgs,
+                                                               std::vector<std::vector<Mat>>& points);
     int applyDetector(const Mat& img, std::vector<Mat>& points);
+    Size getDetectSize(const Mat& img);
     Mat cropObj(const Mat& img, const Mat& point, Align& aligner);
+    /**
+     * @brief map the points decoded from a candidate back to the image and drop the duplicates
+     *
+     * @param decode_results results of the image, the ones of the candidate are at the end.
+     */
+    void addDecodedPoints(Mat& point, Align& aligner, float cur_scale,
+                          const std::vector<std::vector<Point2f>>& zxing_points,
+                          std::vector<std::string>& decode_results, std::vector<Mat>& points);
+    void updateBinarizerOrder(int binarizer);
     std::vector<float> getScaleList(const int width, const int height);
+    /**
+     * @brief decode a cropped QR code trying the scales one by one and the binarizers in
+     * binarizer_order_ for every scale.
+     *
+     * @return index of the scale the QR code is decoded at, -1 if it is not decoded.
+     */
+    int decodeScales(const Mat& cropped_img, const std::vector<float>& scale_list,
+                     std::vector<std::string>& results, std::vector<std::vector<Point2f>>& zxing_points);
+    /**
+     * @brief the same as decodeScales, but all the scale and binarizer attempts run concurrently.
+     * The attempts after a successful one are cancelled, the result is the one of the first
+     * successful attempt in the sequential order, so it does not depend on the number of threads.
+     */
+    int decodeScalesParallel(const Mat& cropped_img, const std::vector<float>& scale_list,
+                             std::vector<std::string>& results, std::vector<std::vector<Point2f>>& zxing_points);
     std::shared_ptr<SSDDetector> detector_;
     std::shared_ptr<SuperScale> super_resolution_model_;
     bool use_nn_detector_, use_nn_sr_;
     float scaleFactor = -1.f;
+    bool parallelDecode = false;
+    bool adaptiveBinarizerOrder = false;
+    // the binarizer which decoded the last QR code goes first in the adaptive mode
+    std::vector<BinarizerMgr::BINARIZER> binarizer_order_;
+    int last_binarizer_ = -1;
+
+    // the decoders and the scaled images keep their buffers between the calls
+    std::unique_ptr<DecoderMgr> acquireDecoder();
+    void releaseDecoder(std::unique_ptr<DecoderMgr> decoder);
+    Mutex decoders_mutex_;
+    std::vector<std::unique_ptr<DecoderMgr>> decoders_;
+    std::vector<Mat> scale_buffers_;
 };
 
 WeChatQRCode::WeChatQRCode(const String& detector_prototxt_path,
@@ -80,12 +133,13 @@ WeChatQRCode::WeChatQRCode(const String& detector_prototxt_path,
     }
 }
 
-vector<string> WeChatQRCode::detectAndDecode(InputArray img, OutputArrayOfArrays points) {
+// returns the grayscale image, empty if the image is too small
+static Mat getInputImage(InputArray img) {
     CV_Assert(!img.empty());
     CV_CheckDepthEQ(img.depth(), CV_8U, "");
 
     if (img.cols() <= 20 || img.rows() <= 20) {
-        return vector<string>();  // image data is not enough for providing reliable results
+        return Mat();  // image data is not enough for providing reliable results
     }
     Mat input_img;
     int incn = img.channels();
@@ -95,6 +149,14 @@ vector<string> WeChatQRCode::detectAndDecode(InputArray img, OutputArrayOfArrays
     } else {
         input_img = img.getMat();
     }
+    return input_img;
+}
+
+vector<string> WeChatQRCode::detectAndDecode(InputArray img, OutputArrayOfArrays points) {
+    Mat input_img = getInputImage(img);
+    if (input_img.empty()) {
+        return vector<string>();
+    }
     auto candidate_points = p->detect(input_img);
     auto res_points = vector<Mat>();
     auto ret = p->decode(input_img, candidate_points, res_points);
@@ -112,6 +174,15 @@ vector<string> WeChatQRCode::detectAndDecode(InputArray img, OutputArrayOfArrays
     return ret;
 }
 
+vector<vector<string>> WeChatQRCode::detectAndDecodeBatch(InputArrayOfArrays imgs,
+                                                          vector<vector<Mat>>& points) {
+    vector<Mat> input_imgs(imgs.total());
+    for (size_t i = 0; i < input_imgs.size(); i++) {
+        input_imgs[i] = getInputImage(imgs.getMat((int)i));
+    }
+    return p->detectAndDecodeBatch(input_imgs, points);
+}
+
 void WeChatQRCode::setScaleFactor(float _scaleFactor) {
     if (_scaleFactor > 0 && _scaleFactor <= 1.f)
         p->scaleFactor = _scaleFactor;
@@ -123,6 +194,22 @@ float WeChatQRCode::getScaleFactor() {
     return p->scaleFactor;
 };
 
+void WeChatQRCode::setParallelDecode(bool enable) {
+    p->parallelDecode = enable;
+}
+
+bool WeChatQRCode::getParallelDecode() {
+    return p->parallelDecode;
+}
+
+void WeChatQRCode::setAdaptiveBinarizerOrder(bool enable) {
+    p->adaptiveBinarizerOrder = enable;
+}
+
+bool WeChatQRCode::getAdaptiveBinarizerOrder() {
+    return p->adaptiveBinarizerOrder;
+}
+
 vector<string> WeChatQRCode::Impl::decode(const Mat& img, vector<Mat>& candidate_points,
                                           vector<Mat>& points) {
     if (candidate_points.size() == 0) {
@@ -139,57 +226,269 @@ vector<string> WeChatQRCode::Impl::decode(const Mat& img, vector<Mat>& candidate
         }
         // scale_list contains different scale ratios
         auto scale_list = getScaleList(cropped_img.cols, cropped_img.rows);
-        for (auto cur_scale : scale_list) {
-            Mat scaled_img =
-                super_resolution_model_->processImageScale(cropped_img, cur_scale, use_nn_sr_);
-            string result;
-            DecoderMgr decodemgr;
-            vector<vector<Point2f>> zxing_points, check_points;
-            auto ret = decodemgr.decodeImage(scaled_img, use_nn_detector_, decode_results, zxing_points);
-            if (ret == 0) {
-                for(size_t i = 0; i <zxing_points.size(); i++){
-                    vector<Point2f> points_qr = zxing_points[i];
-                    for (auto&& pt: points_qr) {
-                        pt /= cur_scale;
-                    }
-
-                    if (use_nn_detector_)
-                        points_qr = aligner.warpBack(points_qr);
-                    for (int j = 0; j < 4; ++j) {
-                        point.at<float>(j, 0) = points_qr[j].x;
-                        point.at<float>(j, 1) = points_qr[j].y;
-                    }
-                    // try to find duplicate qr corners
-                    bool isDuplicate = false;
-                    for (const auto &tmp_points: check_points) {
-                        const float eps = 10.f;
-                        for (size_t j = 0; j < tmp_points.size(); j++) {
-                            if (abs(tmp_points[j].x - points_qr[j].x) < eps &&
-                                abs(tmp_points[j].y - points_qr[j].y) < eps) {
-                                isDuplicate = true;
-                            }
-                            else {
-                                isDuplicate = false;
-                                break;
-                            }
-                        }
-                    }
-                    if (isDuplicate == false) {
-                        points.push_back(point);
-                        check_points.push_back(points_qr);
-                    }
-                    else {
-                        decode_results.erase(decode_results.begin() + i, decode_results.begin() + i + 1);
-                    }
+        vector<vector<Point2f>> zxing_points;
+        int scale_idx = parallelDecode
+                            ? decodeScalesParallel(cropped_img, scale_list, decode_results, zxing_points)
+                            : decodeScales(cropped_img, scale_list, decode_results, zxing_points);
+        if (scale_idx >= 0) {
+            updateBinarizerOrder(last_binarizer_);
+            addDecodedPoints(point, aligner, scale_list[scale_idx], zxing_points, decode_results, points);
+        }
+    }
+
+    return decode_results;
+}
+
+void WeChatQRCode::Impl::addDecodedPoints(Mat& point, Align& aligner, float cur_scale,
+                                          const vector<vector<Point2f>>& zxing_points,
+                                          vector<string>& decode_results, vector<Mat>& points) {
+    vector<vector<Point2f>> check_points;
+    for(size_t i = 0; i <zxing_points.size(); i++){
+        vector<Point2f> points_qr = zxing_points[i];
+        for (auto&& pt: points_qr) {
+            pt /= cur_scale;
+        }
+
+        if (use_nn_detector_)
+            points_qr = aligner.warpBack(points_qr);
+        for (int j = 0; j < 4; ++j) {
+            point.at<float>(j, 0) = points_qr[j].x;
+            point.at<float>(j, 1) = points_qr[j].y;
+        }
+        // try to find duplicate qr corners
+        bool isDuplicate = false;
+        for (const auto &tmp_points: check_points) {
+            const float eps = 10.f;
+            for (size_t j = 0; j < tmp_points.size(); j++) {
+                if (abs(tmp_points[j].x - points_qr[j].x) < eps &&
+                    abs(tmp_points[j].y - points_qr[j].y) < eps) {
+                    isDuplicate = true;
+                }
+                else {
+                    isDuplicate = false;
+                    break;
+                }
+            }
+        }
+        if (isDuplicate == false) {
+            points.push_back(point);
+            check_points.push_back(points_qr);
+        }
+        else {
+            decode_results.erase(decode_results.begin() + i, decode_results.begin() + i + 1);
+        }
+    }
+}
+
+void WeChatQRCode::Impl::updateBinarizerOrder(int binarizer) {
+    if (!adaptiveBinarizerOrder) return;
+    auto it = std::find(binarizer_order_.begin(), binarizer_order_.end(), binarizer);
+    if (it != binarizer_order_.end())
+        std::rotate(binarizer_order_.begin(), it, it + 1);
+}
+
+vector<vector<string>> WeChatQRCode::Impl::detectAndDecodeBatch(const vector<Mat>& imgs,
+                                                                vector<vector<Mat>>& points) {
+    const int num_imgs = (int)imgs.size();
+    vector<vector<Mat>> candidate_points(num_imgs);
+    if (use_nn_detector_) {
+        // a blob needs the inputs of the same size, the images with the same detector size share it
+        vector<Size> detect_sizes(num_imgs);
+        vector<bool> detected(num_imgs, false);
+        for (int i = 0; i < num_imgs; i++) {
+            if (!imgs[i].empty()) detect_sizes[i] = getDetectSize(imgs[i]);
+        }
+        for (int i = 0; i < num_imgs; i++) {
+            if (imgs[i].empty() || detected[i]) continue;
+            vector<Mat> batch;
+            vector<int> batch_idx;
+            for (int j = i; j < num_imgs; j++) {
+                if (!imgs[j].empty() && !detected[j] && detect_sizes[j] == detect_sizes[i]) {
+                    batch.push_back(imgs[j]);
+                    batch_idx.push_back(j);
+                    detected[j] = true;
                 }
-                break;
             }
+            auto batch_points = detector_->forward(batch, detect_sizes[i].width, detect_sizes[i].height);
+            for (size_t k = 0; k < batch_idx.size(); k++) {
+                candidate_points[batch_idx[k]] = batch_points[k];
+            }
+        }
+    } else {
+        for (int i = 0; i < num_imgs; i++) {
+            if (!imgs[i].empty()) candidate_points[i] = detect(imgs[i]);
+        }
+    }
+
+    struct Candidate {
+        int img_idx;
+        Mat point;
+        Mat cropped_img;
+        Align aligner;
+        vector<float> scale_list;
+        int scale_idx;
+        int binarizer;
+        vector<string> results;
+        vector<vector<Point2f>> zxing_points;
+    };
+    vector<Candidate> candidates;
+    for (int i = 0; i < num_imgs; i++) {
+        for (auto& point : candidate_points[i]) {
+            Candidate candidate;
+            candidate.img_idx = i;
+            candidate.point = point;
+            if (use_nn_detector_) {
+                candidate.cropped_img = cropObj(imgs[i], point, candidate.aligner);
+            } else {
+                candidate.cropped_img = imgs[i];
+            }
+            candidate.scale_list = getScaleList(candidate.cropped_img.cols, candidate.cropped_img.rows);
+            candidate.scale_idx = -1;
+            candidate.binarizer = -1;
+            candidates.push_back(candidate);
         }
     }
 
+    // every round tries the next scale of the candidates not decoded yet, so the crops
+    // upsampled by the super resolution model in a round share its forward pass
+    const vector<BinarizerMgr::BINARIZER> binarizer_order = binarizer_order_;
+    for (int round = 0;; round++) {
+        vector<int> pending;
+        vector<Mat> srcs;
+        vector<float> scales;
+        for (int c = 0; c < (int)candidates.size(); c++) {
+            const Candidate& candidate = candidates[c];
+            if (candidate.scale_idx < 0 && round < (int)candidate.scale_list.size()) {
+                pending.push_back(c);
+                srcs.push_back(candidate.cropped_img);
+                scales.push_back(candidate.scale_list[round]);
+            }
+        }
+        if (pending.empty()) break;
+
+        vector<Mat> scaled_imgs = super_resolution_model_->processImageScale(srcs, scales, use_nn_sr_);
+        parallel_for_(Range(0, (int)pending.size()), [&](const Range& range) {
+            std::unique_ptr<DecoderMgr> decodemgr = acquireDecoder();
+            decodemgr->setBinarizerOrder(binarizer_order);
+            for (int k = range.start; k < range.end; k++) {
+                Candidate& candidate = candidates[pending[k]];
+                auto ret = decodemgr->decodeImage(scaled_imgs[k], use_nn_detector_, candidate.results,
+                                                  candidate.zxing_points);
+                if (ret == 0) {
+                    candidate.scale_idx = round;
+                    candidate.binarizer = decodemgr->getCurBinarizer();
+                }
+            }
+            releaseDecoder(std::move(decodemgr));
+        });
+    }
+
+    vector<vector<string>> decode_results(num_imgs);
+    points.assign(num_imgs, vector<Mat>());
+    for (auto& candidate : candidates) {
+        if (candidate.scale_idx < 0) continue;
+        vector<string>& img_results = decode_results[candidate.img_idx];
+        img_results.insert(img_results.end(), candidate.results.begin(), candidate.results.end());
+        updateBinarizerOrder(candidate.binarizer);
+        addDecodedPoints(candidate.point, candidate.aligner, candidate.scale_list[candidate.scale_idx],
+                         candidate.zxing_points, img_results, points[candidate.img_idx]);
+    }
     return decode_results;
 }
 
+int WeChatQRCode::Impl::decodeScales(const Mat& cropped_img, const vector<float>& scale_list,
+                                     vector<string>& results, vector<vector<Point2f>>& zxing_points) {
+    if (scale_buffers_.size() < scale_list.size()) scale_buffers_.resize(scale_list.size());
+    std::unique_ptr<DecoderMgr> decodemgr = acquireDecoder();
+    decodemgr->setBinarizerOrder(binarizer_order_);
+    int scale_idx = -1;
+    for (size_t s = 0; s < scale_list.size(); s++) {
+        Mat scaled_img = super_resolution_model_->processImageScale(cropped_img, scale_list[s], use_nn_sr_,
+                                                                    scale_buffers_[s]);
+        auto ret = decodemgr->decodeImage(scaled_img, use_nn_detector_, results, zxing_points);
+        if (ret == 0) {
+            last_binarizer_ = decodemgr->getCurBinarizer();
+            scale_idx = (int)s;
+            break;
+        }
+    }
+    releaseDecoder(std::move(decodemgr));
+    return scale_idx;
+}
+
+int WeChatQRCode::Impl::decodeScalesParallel(const Mat& cropped_img, const vector<float>& scale_list,
+                                             vector<string>& results, vector<vector<Point2f>>& zxing_points) {
+    struct Attempt {
+        vector<string> results;
+        vector<vector<Point2f>> zxing_points;
+    };
+    const int num_binarizers = (int)binarizer_order_.size();
+    const int num_attempts = (int)scale_list.size() * num_binarizers;
+    vector<Attempt> attempts(num_attempts);
+    // the scaled images are made by the first attempt needing them,
+    // the super resolution network can not run concurrently
+    if (scale_buffers_.size() < scale_list.size()) scale_buffers_.resize(scale_list.size());
+    vector<Mat> scaled_imgs(scale_list.size());
+    vector<bool> scaled(scale_list.size(), false);
+    Mutex scale_mutex;
+    std::atomic<int> first_success(num_attempts);
+
+    // an attempt per stripe, so the attempts start in the sequential order
+    parallel_for_(Range(0, num_attempts), [&](const Range& range) {
+        for (int t = range.start; t < range.end; t++) {
+            // an earlier attempt has succeeded already
+            if (first_success.load() < t) break;
+
+            const int s = t / num_binarizers;
+            Mat scaled_img;
+            {
+                AutoLock lock(scale_mutex);
+                if (!scaled[s]) {
+                    scaled_imgs[s] = super_resolution_model_->processImageScale(
+                        cropped_img, scale_list[s], use_nn_sr_, scale_buffers_[s]);
+                    scaled[s] = true;
+                }
+                scaled_img = scaled_imgs[s];
+            }
+
+            // zxing objects are not thread-safe, every attempt has its own ones
+            std::unique_ptr<DecoderMgr> decodemgr = acquireDecoder();
+            auto ret = decodemgr->decodeImage(scaled_img, use_nn_detector_, binarizer_order_[t % num_binarizers],
+                                              attempts[t].results, attempts[t].zxing_points);
+            releaseDecoder(std::move(decodemgr));
+            if (ret == 0) {
+                int cur = first_success.load();
+                while (t < cur && !first_success.compare_exchange_weak(cur, t)) {
+                }
+            }
+        }
+    }, num_attempts);
+
+    const int t = first_success.load();
+    if (t == num_attempts) return -1;
+    results.insert(results.end(), attempts[t].results.begin(), attempts[t].results.end());
+    zxing_points = attempts[t].zxing_points;
+    last_binarizer_ = binarizer_order_[t % num_binarizers];
+    return t / num_binarizers;
+}
+
+std::unique_ptr<DecoderMgr> WeChatQRCode::Impl::acquireDecoder() {
+    {
+        AutoLock lock(decoders_mutex_);
+        if (!decoders_.empty()) {
+            std::unique_ptr<DecoderMgr> decoder = std::move(decoders_.back());
+            decoders_.pop_back();
+            return decoder;
+        }
+    }
+    return std::unique_ptr<DecoderMgr>(new DecoderMgr());
+}
+
+void WeChatQRCode::Impl::releaseDecoder(std::unique_ptr<DecoderMgr> decoder) {
+    AutoLock lock(decoders_mutex_);
+    decoders_.push_back(std::move(decoder));
+}
+
 vector<Mat> WeChatQRCode::Impl::detect(const Mat& img) {
     auto points = vector<Mat>();
 
@@ -215,6 +514,13 @@ vector<Mat> WeChatQRCode::Impl::detect(const Mat& img) {
 }
 
 int WeChatQRCode::Impl::applyDetector(const Mat& img, vector<Mat>& points) {
+    Size detect_size = getDetectSize(img);
+    points = detector_->forward(img, detect_size.width, detect_size.height);
+
+    return 0;
+}
+
+Size WeChatQRCode::Impl::getDetectSize(const Mat& img) {
     int img_w = img.cols;
     int img_h = img.rows;
 
@@ -223,10 +529,7 @@ int WeChatQRCode::Impl::applyDetector(const Mat& img, vector<Mat>& points) {
     const float tmpScaleFactor = scaleFactor == -1.f ? min(1.f, sqrt(targetArea / (img_w * img_h))) : scaleFactor;
     int detect_width = img_w * tmpScaleFactor;
     int detect_height = img_h * tmpScaleFactor;
-
-    points = detector_->forward(img, detect_width, detect_height);
-
-    return 0;
+    return Size(detect_width, detect_height);
 }
 
 Mat WeChatQRCode::Impl::cropObj(const Mat& img, const Mat& point, Align& aligner) {
@@ -6,6 +6,7 @@
 // Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
 #include "../../../precomp.hpp"
 #include "adaptive_threshold_mean_binarizer.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 using zxing::AdaptiveThresholdMeanBinarizer;
 
 namespace {
@@ -51,7 +52,6 @@ int AdaptiveThresholdMeanBinarizer::binarizeImage(ErrorHandler& err_handler) {
         auto src = (unsigned char*)source.getMatrix()->data();
         auto dst = matrix->getPtr();
         cv::Mat mDst;
-        mDst = cv::Mat::zeros(cv::Size(width, height), CV_8UC1);
         TransBufferToMat(src, mDst, width, height);
         cv::Mat result;
         int bs = width / 10;
@@ -71,11 +71,7 @@ int AdaptiveThresholdMeanBinarizer::binarizeImage(ErrorHandler& err_handler) {
 
 int AdaptiveThresholdMeanBinarizer::TransBufferToMat(unsigned char* pBuffer, cv::Mat& mDst,
                                                      int nWidth, int nHeight) {
-    for (int j = 0; j < nHeight; ++j) {
-        unsigned char* data = mDst.ptr<unsigned char>(j);
-        unsigned char* pSubBuffer = pBuffer + (nHeight - 1 - j) * nWidth;
-        memcpy(data, pSubBuffer, nWidth);
-    }
+    cv::flip(cv::Mat(nHeight, nWidth, CV_8UC1, pBuffer), mDst, 0);
     return 0;
 }
 
@@ -86,13 +82,16 @@ int AdaptiveThresholdMeanBinarizer::TransMatToBuffer(cv::Mat mSrc, unsigned char
     nHeight = mSrc.rows;
     for (int j = 0; j < nHeight; ++j) {
         unsigned char* pdi = ppBuffer + j * nWidth;
-        for (int z = 0; z < nWidth; ++z) {
-            int nj = nHeight - j - 1;
-            int value = *(uchar*)(mSrc.ptr<uchar>(nj) + z);
-            if (value > 120)
-                pdi[z] = 0;
-            else
-                pdi[z] = 1;
+        const uchar* psi = mSrc.ptr<uchar>(nHeight - j - 1);
+        int z = 0;
+#if CV_SIMD
+        const cv::v_uint8 thresh = cv::vx_setall_u8(120), one = cv::vx_setall_u8(1);
+        for (; z <= nWidth - cv::v_uint8::nlanes; z += cv::v_uint8::nlanes) {
+            cv::v_store(pdi + z, (cv::vx_load(psi + z) <= thresh) & one);
+        }
+#endif
+        for (; z < nWidth; ++z) {
+            pdi[z] = psi[z] > 120 ? 0 : 1;
         }
     }
     return 0;
@@ -9,6 +9,7 @@
 // Licensed under the Apache License, Version 2.0 (the "License").
 #include "../../../precomp.hpp"
 #include "fast_window_binarizer.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 using zxing::FastWindowBinarizer;
 
 
@@ -21,22 +22,33 @@ static int min(int a, int b) { return a < b ? a : b; }
 
 static int max(int a, int b) { return a > b ? a : b; }
 
+// dst[x] = src[x] < threshold[x]
+inline void thresholdRow(const unsigned char* src, const unsigned char* threshold,
+                         unsigned char* dst, int n) {
+    int x = 0;
+#if CV_SIMD
+    const cv::v_uint8 one = cv::vx_setall_u8(1);
+    for (; x <= n - cv::v_uint8::nlanes; x += cv::v_uint8::nlanes) {
+        cv::v_store(dst + x, (cv::vx_load(src + x) < cv::vx_load(threshold + x)) & one);
+    }
+#endif
+    for (; x < n; x++) {
+        dst[x] = src[x] < threshold[x] ? 1 : 0;
+    }
+}
+
 }  // namespace
 
 FastWindowBinarizer::FastWindowBinarizer(Ref<LuminanceSource> source)
     : GlobalHistogramBinarizer(source), matrix_(NULL), cached_row_(NULL) {
     width = source->getWidth();
     height = source->getHeight();
-    int aw = width / BLOCK_SIZE;
-    int ah = height / BLOCK_SIZE;
 
-    int ah2 = ah;
-    int ow2 = aw + 1;
-
-    _luminancesInt = new int[width * height];
-    _blockTotals = new int[ah * aw];
-    _totals = new int[(ah + 1) * (aw + 1)];
-    _rowTotals = new int[ah2 * ow2];
+    // only binarizeImage0 needs these, they are allocated on its first call
+    _luminancesInt = NULL;
+    _blockTotals = NULL;
+    _totals = NULL;
+    _rowTotals = NULL;
 
     _internal = new unsigned int[(height + 1) * (width + 1)];
 }
@@ -135,29 +147,12 @@ void FastWindowBinarizer::cumulative(int* data, int* output, int _width, int _he
 
 void FastWindowBinarizer::fastIntegral(const unsigned char* inputMatrix,
                                        unsigned int* outputMatrix) {
-    // memset(outputMatrix,0,sizeof(int)*(height+1)*(width+1));
-    // unsigned int *columnSum = new unsigned int[width]; // sum of each column
-    // calculate integral of the first line
-    outputMatrix[0] = outputMatrix[width + 1] = 0;
-    for (int i = 0; i < width; i++) {
-        // columnSum[i]=inputMatrix[i];
-        outputMatrix[i + 1] = 0;
-        outputMatrix[width + 1 + i + 1] = outputMatrix[width + 1 + i] + inputMatrix[i];
-    }
-    for (int i = 1; i < height; i++) {
-        const unsigned char* psi = inputMatrix + i * width;
-        unsigned int* pdi = outputMatrix + (i + 1) * (width + 1);
-        // first column of each line
-        pdi[0] = 0;
-        pdi[1] = psi[0];
-        int row_sum = psi[0];
-        // other columns
-        for (int j = 1; j < width; j++) {
-            row_sum += psi[j];
-            pdi[j + 1] = pdi[j + 1 - width - 1] + row_sum;
-        }
-    }
-    return;
+    // the sums fit into int for the image sizes we get, the layout is the same:
+    // (height + 1) x (width + 1) with zero first row and column
+    cv::Mat src(height, width, CV_8UC1, (void*)inputMatrix);
+    cv::Mat sum(height + 1, width + 1, CV_32SC1, outputMatrix);
+    cv::integral(src, sum, CV_32S);
+    CV_DbgAssert(sum.data == (uchar*)outputMatrix);
 }
 
 int FastWindowBinarizer::binarizeImage1(ErrorHandler& err_handler) {
@@ -189,6 +184,9 @@ void FastWindowBinarizer::fastWindow(const unsigned char* src, unsigned char* ds
     int aw = width / BLOCK_SIZE;
     int ah = height / BLOCK_SIZE;
     memset(dst, 0, sizeof(char) * height * width);
+    // averages of a row of blocks expanded to the pixels, the pixels right
+    // of the last whole block stay 0 as do the rows below the last one
+    std::vector<unsigned char> rowAvg(aw * BLOCK_SIZE);
     for (int ai = 0; ai < ah; ai++) {
         int top = max(0, ((ai - r + 1) * BLOCK_SIZE));
         int bottom = min(height, (ai + r) * BLOCK_SIZE);
@@ -200,19 +198,12 @@ void FastWindowBinarizer::fastWindow(const unsigned char* src, unsigned char* ds
             unsigned int block = pb[right] + pt[left] - pt[right] - pb[left];
             int pixels = (bottom - top) * (right - left);
             int avg = (int)block / pixels;
-            for (int bi = ai * BLOCK_SIZE; bi < height && bi < (ai + 1) * BLOCK_SIZE; bi++) {
-                const unsigned char* psi = src + bi * width;
-                unsigned char* pdi = dst + bi * width;
-                for (int bj = aj * BLOCK_SIZE; bj < width && bj < (aj + 1) * BLOCK_SIZE; bj++) {
-                    if ((int)psi[bj] < avg)
-                        pdi[bj] = 1;
-                    else
-                        pdi[bj] = 0;
-                }
-            }
+            memset(&rowAvg[aj * BLOCK_SIZE], avg, BLOCK_SIZE);
+        }
+        for (int bi = ai * BLOCK_SIZE; bi < (ai + 1) * BLOCK_SIZE; bi++) {
+            thresholdRow(src + bi * width, &rowAvg[0], dst + bi * width, aw * BLOCK_SIZE);
         }
     }
-    // delete [] _internal;
     return;
 }
 
@@ -231,6 +222,13 @@ int FastWindowBinarizer::binarizeImage0(ErrorHandler& err_handler) {
 
         ArrayRef<char> _luminances = source.getMatrix();
 
+        if (!_luminancesInt) {
+            _luminancesInt = new int[width * height];
+            _blockTotals = new int[ah * aw];
+            _totals = new int[(ah + 1) * ow];
+            _rowTotals = new int[ah * ow];
+        }
+
         // Get luminances for int value first
         for (int i = 0; i < width * height; i++) {
             _luminancesInt[i] = _luminances[i] & 0xff;
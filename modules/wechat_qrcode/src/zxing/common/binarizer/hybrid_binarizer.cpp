@@ -9,6 +9,7 @@
 // Licensed under the Apache License, Version 2.0 (the "License").
 #include "../../../precomp.hpp"
 #include "hybrid_binarizer.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 using zxing::HybridBinarizer;
 using zxing::BINARIZER_BLOCK;
@@ -133,6 +134,22 @@ namespace {
 inline int cap(int value, int min, int max) {
     return value < min ? min : value > max ? max : value;
 }
+
+// dst[x] = src[x] <= threshold[x]. The comparison needs to be <= so that
+// black == 0 pixels are black even if the threshold is 0.
+inline void thresholdRow(const unsigned char* src, const unsigned char* threshold,
+                         unsigned char* dst, int n) {
+    int x = 0;
+#if CV_SIMD
+    const cv::v_uint8 one = cv::vx_setall_u8(1);
+    for (; x <= n - cv::v_uint8::nlanes; x += cv::v_uint8::nlanes) {
+        cv::v_store(dst + x, (cv::vx_load(src + x) <= cv::vx_load(threshold + x)) & one);
+    }
+#endif
+    for (; x < n; x++) {
+        dst[x] = src[x] <= threshold[x] ? 1 : 0;
+    }
+}
 }  // namespace
 
 
@@ -180,6 +197,11 @@ void HybridBinarizer::calculateThresholdForBlock(Ref<ByteMatrix>& _luminances, i
 
     int blockArea = ((2 * THRES_BLOCKSIZE + 1) * (2 * THRES_BLOCKSIZE + 1));
 
+    // thresholds of a row of blocks, expanded to the pixels. The last block of a row and
+    // the last row of blocks overlap the previous ones, the later block wins as before.
+    std::vector<unsigned char> rowThresholds(width);
+    unsigned char* thresholds = &rowThresholds[0];
+
     for (int y = 0; y < subHeight; y++) {
         int yoffset = y << SIZE_POWER;
         if (yoffset > maxYOffset) {
@@ -193,20 +215,22 @@ void HybridBinarizer::calculateThresholdForBlock(Ref<ByteMatrix>& _luminances, i
             int left = cap(x, THRES_BLOCKSIZE, subWidth - THRES_BLOCKSIZE - 1);
             int top = cap(y, THRES_BLOCKSIZE, subHeight - THRES_BLOCKSIZE - 1);
 
-            int sum = 0;
-            // int sum2 = 0;
-
             int offset1 = (top - THRES_BLOCKSIZE) * blockIntegralWidth + left - THRES_BLOCKSIZE;
             int offset2 = (top + THRES_BLOCKSIZE + 1) * blockIntegralWidth + left - THRES_BLOCKSIZE;
 
             int blocksize = THRES_BLOCKSIZE * 2 + 1;
 
-            sum = blockIntegral[offset1] - blockIntegral[offset1 + blocksize] -
-                  blockIntegral[offset2] + blockIntegral[offset2 + blocksize];
+            int sum = blockIntegral[offset1] - blockIntegral[offset1 + blocksize] -
+                      blockIntegral[offset2] + blockIntegral[offset2 + blocksize];
 
             int average = sum / blockArea;
-            thresholdBlock(_luminances, xoffset, yoffset, average, matrix, err_handler);
+            memset(thresholds + xoffset, average, block_size);
+        }
+
+        for (int yy = 0; yy < block_size; yy++) {
+            unsigned char* src = _luminances->getByteRow(yoffset + yy, err_handler);
             if (err_handler.ErrCode()) return;
+            thresholdRow(src, thresholds, matrix->getPtr() + (yoffset + yy) * width, width);
         }
     }
 }
@@ -308,10 +332,61 @@ int HybridBinarizer::initBlocks() {
 
     const int minDynamicRange = 24;
 
+    if (width < BLOCK_SIZE || height < BLOCK_SIZE) {
+        // too small for the blocks, binarizeByBlock falls back to the histogram
+        for (int i = 0; i < subWidth * subHeight; i++) {
+            blocks_[i].sum = blocks_[i].min = blocks_[i].max = blocks_[i].threshold = 0;
+        }
+        return 1;
+    }
+
+    // sum, min and max of every column over a row of blocks, the blocks reduce them after.
+    // Unlike the per-block loop before, min and max are always complete, it does not change
+    // the thresholds: they are only used while the range is not above minDynamicRange.
+    std::vector<unsigned short> colSum(width);
+    std::vector<unsigned char> colMin(width), colMax(width);
+
     for (int y = 0; y < subHeight; y++) {
         int yoffset = y << BLOCK_SIZE_POWER;
         int maxYOffset = height - BLOCK_SIZE;
         if (yoffset > maxYOffset) yoffset = maxYOffset;
+        const unsigned char* rows = bytes + yoffset * width;
+
+        int c = 0;
+#if CV_SIMD
+        for (; c <= width - cv::v_uint8::nlanes; c += cv::v_uint8::nlanes) {
+            cv::v_uint8 v = cv::vx_load(rows + c);
+            cv::v_uint8 vmin = v, vmax = v;
+            cv::v_uint16 sum0, sum1;
+            cv::v_expand(v, sum0, sum1);
+            for (int yy = 1; yy < BLOCK_SIZE; yy++) {
+                v = cv::vx_load(rows + yy * width + c);
+                vmin = cv::v_min(vmin, v);
+                vmax = cv::v_max(vmax, v);
+                cv::v_uint16 v0, v1;
+                cv::v_expand(v, v0, v1);
+                sum0 += v0;
+                sum1 += v1;
+            }
+            cv::v_store(&colMin[c], vmin);
+            cv::v_store(&colMax[c], vmax);
+            cv::v_store(&colSum[c], sum0);
+            cv::v_store(&colSum[c] + cv::v_uint16::nlanes, sum1);
+        }
+#endif
+        for (; c < width; c++) {
+            int sum = 0, min = 0xFF, max = 0;
+            for (int yy = 0; yy < BLOCK_SIZE; yy++) {
+                int pixel = rows[yy * width + c];
+                sum += pixel;
+                min = std::min(min, pixel);
+                max = std::max(max, pixel);
+            }
+            colSum[c] = (unsigned short)sum;
+            colMin[c] = (unsigned char)min;
+            colMax[c] = (unsigned char)max;
+        }
+
         for (int x = 0; x < subWidth; x++) {
             int xoffset = x << BLOCK_SIZE_POWER;
             int maxXOffset = width - BLOCK_SIZE;
@@ -319,32 +394,10 @@ int HybridBinarizer::initBlocks() {
             int sum = 0;
             int min = 0xFF;
             int max = 0;
-            for (int yy = 0, offset = yoffset * width + xoffset; yy < BLOCK_SIZE;
-                 yy++, offset += width) {
-                for (int xx = 0; xx < BLOCK_SIZE; xx++) {
-                    // int pixel = luminances->bytes[offset + xx] & 0xFF;
-                    int pixel = bytes[offset + xx];
-                    sum += pixel;
-
-                    // still looking for good contrast
-                    if (pixel < min) {
-                        min = pixel;
-                    }
-                    if (pixel > max) {
-                        max = pixel;
-                    }
-                }
-
-                // short-circuit min/max tests once dynamic range is met
-                if (max - min > minDynamicRange) {
-                    // finish the rest of the rows quickly
-                    for (yy++, offset += width; yy < BLOCK_SIZE; yy++, offset += width) {
-                        for (int xx = 0; xx < BLOCK_SIZE; xx += 2) {
-                            sum += bytes[offset + xx];
-                            sum += bytes[offset + xx + 1];
-                        }
-                    }
-                }
+            for (int xx = xoffset; xx < xoffset + BLOCK_SIZE; xx++) {
+                sum += colSum[xx];
+                min = std::min(min, (int)colMin[xx]);
+                max = std::max(max, (int)colMax[xx]);
             }
 
             blocks_[y * subWidth + x].min = min;
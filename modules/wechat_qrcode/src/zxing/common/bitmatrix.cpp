@@ -9,6 +9,7 @@
 // Licensed under the Apache License, Version 2.0 (the "License").
 #include "../../precomp.hpp"
 #include "bitmatrix.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 using zxing::ArrayRef;
 using zxing::BitArray;
@@ -16,6 +17,28 @@ using zxing::BitMatrix;
 using zxing::ErrorHandler;
 using zxing::Ref;
 
+namespace {
+// the matrix keeps a byte per module, so the bits are 0 or 1 and flipping is xor with 1
+inline void xorRow(unsigned char* dst, const unsigned char* src, int n) {
+    int x = 0;
+#if CV_SIMD
+    for (; x <= n - cv::v_uint8::nlanes; x += cv::v_uint8::nlanes)
+        cv::v_store(dst + x, cv::vx_load(dst + x) ^ cv::vx_load(src + x));
+#endif
+    for (; x < n; x++) dst[x] ^= src[x];
+}
+
+inline void flipRow(unsigned char* dst, int n) {
+    int x = 0;
+#if CV_SIMD
+    const cv::v_uint8 one = cv::vx_setall_u8(1);
+    for (; x <= n - cv::v_uint8::nlanes; x += cv::v_uint8::nlanes)
+        cv::v_store(dst + x, cv::vx_load(dst + x) ^ one);
+#endif
+    for (; x < n; x++) dst[x] ^= 1;
+}
+}  // namespace
+
 void BitMatrix::init(int _width, int _height, ErrorHandler& err_handler) {
     if (_width < 1 || _height < 1) {
         err_handler = IllegalArgumentErrorHandler("Both dimensions must be greater than 0");
@@ -100,15 +123,7 @@ void BitMatrix::xxor(Ref<BitMatrix> _bits) {
         return;
     }
 
-    for (int y = 0; y < height && y < _bits->getHeight(); ++y) {
-        bool* rowPtrA = _bits->getRowBoolPtr(y);
-        bool* rowPtrB = getRowBoolPtr(y);
-
-        for (int x = 0; x < width && x < _bits->getWidth(); ++x) {
-            rowPtrB[x] = rowPtrB[x] ^ rowPtrA[x];
-        }
-        setRowBool(y, rowPtrB);
-    }
+    xorRow(getPtr(), _bits->getPtr(), width * height);
 }
 
 BitMatrix::~BitMatrix() {}
@@ -118,10 +133,7 @@ void BitMatrix::flip(int x, int y) {
 }
 
 void BitMatrix::flipAll() {
-    bool* matrixBits = (bool*)bits->data();
-    for (int i = 0; i < bits->size(); i++) {
-        matrixBits[i] = !matrixBits[i];
-    }
+    flipRow(bits->data(), bits->size());
 }
 
 void BitMatrix::flipRegion(int left, int top, int _width, int _height, ErrorHandler& err_handler) {
@@ -141,9 +153,7 @@ void BitMatrix::flipRegion(int left, int top, int _width, int _height, ErrorHand
     }
 
     for (int y = top; y < bottom; y++) {
-        for (int x = left; x < right; x++) {
-            bits[rowOffsets[y] + x] ^= 1;
-        }
+        flipRow(bits->data() + rowOffsets[y] + left, _width);
     }
 }
 
@@ -164,10 +174,7 @@ void BitMatrix::setRegion(int left, int top, int _width, int _height, ErrorHandl
     }
 
     for (int y = top; y < bottom; y++) {
-        for (int x = left; x < right; x++) {
-            bits[rowOffsets[y] + x] = true;
-            // bits[rowOffsets[y]+x] |= 0xFF;
-        }
+        memset(bits->data() + rowOffsets[y] + left, 1, _width);
     }
 }
 
@@ -16,20 +16,27 @@ UnicomBlock::~UnicomBlock() {}
 
 void UnicomBlock::Init() {
     if (m_bInit) return;
-    m_vcIndex = std::vector<unsigned int>(m_iHeight * m_iWidth, 0);
-    m_vcCount = std::vector<unsigned int>(m_iHeight * m_iWidth, 0);
-    m_vcMinPnt = std::vector<int>(m_iHeight * m_iWidth, 0);
-    m_vcMaxPnt = std::vector<int>(m_iHeight * m_iWidth, 0);
-    m_vcQueue = std::vector<int>(m_iHeight * m_iWidth, 0);
+    m_vcIndex.assign(m_iHeight * m_iWidth, 0);
+    m_vcCount.assign(m_iHeight * m_iWidth, 0);
+    m_vcMinPnt.assign(m_iHeight * m_iWidth, 0);
+    m_vcMaxPnt.assign(m_iHeight * m_iWidth, 0);
+    m_vcQueue.assign(m_iHeight * m_iWidth, 0);
     m_bInit = true;
 }
 
 void UnicomBlock::Reset(Ref<BitMatrix> poImage) {
     m_poImage = poImage;
-    memset(&m_vcIndex[0], 0, m_vcIndex.size() * sizeof(short));
+    memset(&m_vcIndex[0], 0, m_vcIndex.size() * sizeof(m_vcIndex[0]));
     m_iNowIdx = 0;
 }
 
+void UnicomBlock::Resize(int iMaxHeight, int iMaxWidth) {
+    if (iMaxHeight == m_iHeight && iMaxWidth == m_iWidth) return;
+    m_iHeight = iMaxHeight;
+    m_iWidth = iMaxWidth;
+    m_bInit = false;
+}
+
 unsigned short UnicomBlock::GetUnicomBlockIndex(int y, int x) {
     if (y >= m_iHeight || x >= m_iWidth) return 0;
     if (m_vcIndex[y * m_iWidth + x]) return m_vcIndex[y * m_iWidth + x];
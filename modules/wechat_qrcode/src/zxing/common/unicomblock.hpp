@@ -18,6 +18,8 @@ public:
 
     void Init();
     void Reset(Ref<BitMatrix> poImage);
+    // the buffers are reallocated by the next Init only if they are too small
+    void Resize(int iMaxHeight, int iMaxWidth);
 
     unsigned short GetUnicomBlockIndex(int y, int x);
 
@@ -408,6 +408,58 @@ TEST(Objdetect_QRCode_Tiny, regression) {
     ASSERT_EQ(expect_msg, decoded_info[0]);
 }
 
+static Mat makeQRCodeImage(const String& msg, int version, Size imageSize, int pixInBlob) {
+    QRCodeEncoder::Params params;
+    params.version = version;
+    Ptr<QRCodeEncoder> qrcode_enc = cv::QRCodeEncoder::create(params);
+    Mat qrImage;
+    qrcode_enc->encode(msg, qrImage);
+    Mat image(imageSize, CV_8UC1, Scalar(255));
+    Size qrSize = Size((21+(params.version-1)*4)*pixInBlob,(21+(params.version-1)*4)*pixInBlob);
+    Mat roiImage = image(Rect((image.cols - qrSize.width)/2, (image.rows - qrSize.height)/2,
+                              qrSize.width, qrSize.height));
+    cv::resize(qrImage, roiImage, qrSize, 1., 1., INTER_NEAREST);
+    return image;
+}
+
+// the decoders and their buffers are reused between the calls, so a small image in between
+// must not affect the result for a large one
+TEST(Objdetect_QRCode_Reuse, large_small_large) {
+    string path_detect_prototxt, path_detect_caffemodel, path_sr_prototxt, path_sr_caffemodel;
+    string model_version = "_2021-01";
+    path_detect_prototxt = findDataFile("dnn/wechat"+model_version+"/detect.prototxt", false);
+    path_detect_caffemodel = findDataFile("dnn/wechat"+model_version+"/detect.caffemodel", false);
+    path_sr_prototxt = findDataFile("dnn/wechat"+model_version+"/sr.prototxt", false);
+    path_sr_caffemodel = findDataFile("dnn/wechat"+model_version+"/sr.caffemodel", false);
+
+    auto detector = wechat_qrcode::WeChatQRCode(path_detect_prototxt, path_detect_caffemodel, path_sr_prototxt,
+                                                path_sr_caffemodel);
+
+    const cv::String large_msg = "OpenCV large", small_msg = "OpenCV";
+    Mat largeImage = makeQRCodeImage(large_msg, 5, Size(3024, 4032), 24);
+    Mat smallImage = makeQRCodeImage(small_msg, 4, Size(80, 80), 2);
+
+    vector<Mat> points1, points2, points3;
+    auto decoded_info1 = detector.detectAndDecode(largeImage, points1);
+    ASSERT_EQ(1ull, decoded_info1.size());
+    ASSERT_EQ(large_msg, decoded_info1[0]);
+
+    auto decoded_info2 = detector.detectAndDecode(smallImage, points2);
+    ASSERT_EQ(1ull, decoded_info2.size());
+    ASSERT_EQ(small_msg, decoded_info2[0]);
+
+    auto decoded_info3 = detector.detectAndDecode(largeImage, points3);
+    ASSERT_EQ(decoded_info1, decoded_info3);
+    ASSERT_EQ(points1.size(), points3.size());
+    EXPECT_EQ(0, cvtest::norm(points1[0], points3[0], NORM_INF));
+
+    vector<Mat> points4;
+    auto decoded_info4 = detector.detectAndDecode(smallImage, points4);
+    ASSERT_EQ(decoded_info2, decoded_info4);
+    ASSERT_EQ(points2.size(), points4.size());
+    EXPECT_EQ(0, cvtest::norm(points2[0], points4[0], NORM_INF));
+}
+
 
 typedef testing::TestWithParam<std::string> Objdetect_QRCode_Easy_Multi;
 TEST_P(Objdetect_QRCode_Easy_Multi, regression) {
@@ -455,6 +507,82 @@ TEST_P(Objdetect_QRCode_Easy_Multi, regression) {
 std::string qrcode_model_path[] = {"", "dnn/wechat_2021-01"};
 INSTANTIATE_TEST_CASE_P(/**/, Objdetect_QRCode_Easy_Multi, testing::ValuesIn(qrcode_model_path));
 
+typedef testing::TestWithParam<std::string> Objdetect_QRCode_Parallel;
+TEST_P(Objdetect_QRCode_Parallel, same_as_sequential) {
+    const std::string name_current_image = GetParam();
+    std::string image_path = findDataFile("qrcode/" + name_current_image);
+    Mat src = imread(image_path, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(src.empty()) << "Can't read image: " << image_path;
+
+    auto detector = wechat_qrcode::WeChatQRCode();
+    vector<Mat> points;
+    auto decoded_info = detector.detectAndDecode(src, points);
+
+    auto parallel_detector = wechat_qrcode::WeChatQRCode();
+    parallel_detector.setParallelDecode(true);
+    ASSERT_TRUE(parallel_detector.getParallelDecode());
+    vector<Mat> parallel_points;
+    auto parallel_decoded_info = parallel_detector.detectAndDecode(src, parallel_points);
+
+    ASSERT_EQ(decoded_info, parallel_decoded_info);
+    ASSERT_EQ(points.size(), parallel_points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        EXPECT_EQ(0, cvtest::norm(points[i], parallel_points[i], NORM_INF));
+    }
+
+    // the adaptive order only changes the order the binarizers are tried in
+    parallel_detector.setAdaptiveBinarizerOrder(true);
+    for (int iter = 0; iter < 2; iter++) {
+        auto adaptive_decoded_info = parallel_detector.detectAndDecode(src);
+        EXPECT_EQ(decoded_info.size(), adaptive_decoded_info.size());
+    }
+}
+INSTANTIATE_TEST_CASE_P(/**/, Objdetect_QRCode_Parallel, testing::Values("version_1_top.jpg", "kanji.jpg",
+                                                                          "link_wiki_cv.jpg"));
+
+TEST_P(Objdetect_QRCode_Easy_Multi, batch) {
+    string path_detect_prototxt, path_detect_caffemodel, path_sr_prototxt, path_sr_caffemodel;
+    string model_path = GetParam();
+
+    if (!model_path.empty()) {
+        path_detect_prototxt = findDataFile(model_path + "/detect.prototxt", false);
+        path_detect_caffemodel = findDataFile(model_path + "/detect.caffemodel", false);
+        path_sr_prototxt = findDataFile(model_path + "/sr.prototxt", false);
+        path_sr_caffemodel = findDataFile(model_path + "/sr.caffemodel", false);
+    }
+
+    auto detector = wechat_qrcode::WeChatQRCode(path_detect_prototxt, path_detect_caffemodel, path_sr_prototxt,
+                                                path_sr_caffemodel);
+
+    vector<Mat> imgs;
+    const std::string names[] = {"version_1_top.jpg", "kanji.jpg", "link_wiki_cv.jpg", "version_1_top.jpg"};
+    for (const auto& name : names) {
+        std::string image_path = findDataFile("qrcode/" + name);
+        imgs.push_back(imread(image_path, IMREAD_GRAYSCALE));
+        ASSERT_FALSE(imgs.back().empty()) << "Can't read image: " << image_path;
+    }
+    // a color image and an image without QR codes
+    Mat color;
+    cvtColor(imgs[1], color, COLOR_GRAY2BGR);
+    imgs.push_back(color);
+    imgs.push_back(Mat(480, 640, CV_8UC1, Scalar(0)));
+
+    vector<vector<Mat>> batch_points;
+    auto batch_info = detector.detectAndDecodeBatch(imgs, batch_points);
+    ASSERT_EQ(imgs.size(), batch_info.size());
+    ASSERT_EQ(imgs.size(), batch_points.size());
+    for (size_t i = 0; i < imgs.size(); i++) {
+        vector<Mat> points;
+        auto decoded_info = detector.detectAndDecode(imgs[i], points);
+        ASSERT_EQ(decoded_info, batch_info[i]) << "image " << i;
+        ASSERT_EQ(points.size(), batch_points[i].size()) << "image " << i;
+        for (size_t j = 0; j < points.size(); j++) {
+            EXPECT_LE(cvtest::norm(points[j], batch_points[i][j], NORM_INF), 1.) << "image " << i;
+        }
+    }
+    EXPECT_TRUE(batch_info.back().empty());
+}
+
 TEST(Objdetect_QRCode_bug, issue_3478) {
     auto detector = wechat_qrcode::WeChatQRCode();
     std::string image_path = findDataFile("qrcode/issue_3478.png");
@@ -412,6 +412,19 @@ public:
      */
     virtual void compute( InputArray image, OutputArray descriptors ) = 0;
 
+    /** @brief Computes the descriptors of all the roi pixels band by band.
+
+    The smoothed orientation layers are only computed for a band of rows at a time, so the memory used
+    does not grow with the image height. The descriptors are the ones of compute( image, roi, descriptors ).
+     * @param image image to extract descriptors
+     * @param roi region of interest within image
+     * @param descriptors resulted descriptors array for roi image pixels in row-major order; a CV_32F array
+     * of roi.area() rows and descriptorSize() columns provided by the caller, such as a view of a larger
+     * matrix, is filled in place
+     * @param memoryBudget maximal number of bytes used by the layers of a band, the bands are at least one row high
+     */
+    virtual void computeDense( InputArray image, Rect roi, OutputArray descriptors, size_t memoryBudget = 256 << 20 ) = 0;
+
     /**
      * @param y position y on image
      * @param x position x on image
@@ -1067,6 +1080,21 @@ public:
         const std::vector<Mat>& imageSignatures,
         std::vector<float>& distances) const = 0;
 
+    /**
+    * @brief Computes Signature Quadratic Form Distance between each of the query signatures
+    *       and each of the image signatures.
+    * @param querySignatures Vector of query signatures.
+    * @param imageSignatures Vector of signatures to measure distance from the query signatures.
+    * @param distances Output matrix of CV_32F type with one row for each query signature
+    *       and one column for each image signature.
+    * @note The matrix is computed in parallel by tiles of queries and images, which is much faster
+    *       than calling computeQuadraticFormDistances for each query on large signature databases.
+    */
+    CV_WRAP virtual void computeQuadraticFormDistanceMatrix(
+        const std::vector<Mat>& querySignatures,
+        const std::vector<Mat>& imageSignatures,
+        OutputArray distances) const = 0;
+
 };
 
 /**
@@ -30,4 +30,21 @@ PERF_TEST_P(daisy, extract, testing::Values(DAISY_IMAGES))
     SANITY_CHECK_NOTHING();
 }
 
+PERF_TEST_P(daisy, extract_dense_bands, testing::Values(DAISY_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    declare.in(frame).time(90);
+
+    Ptr<DAISY> descriptor = DAISY::create();
+
+    Mat_<float> descriptors;
+    // compute all daisies in image, with the layers of 64MB bands
+    TEST_CYCLE() descriptor->computeDense(frame, Rect(0, 0, frame.cols, frame.rows), descriptors, 64 << 20);
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -0,0 +1,53 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+enum { FREAK_DESCRIPTOR, ORB_DESCRIPTOR, BRISK_DESCRIPTOR };
+CV_ENUM(BinaryDescriptorType, FREAK_DESCRIPTOR, ORB_DESCRIPTOR, BRISK_DESCRIPTOR)
+
+typedef tuple<std::string, BinaryDescriptorType> BinaryDescriptorParams;
+typedef perf::TestBaseWithParam<BinaryDescriptorParams> binary_descriptor;
+
+#define FREAK_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+static Ptr<Feature2D> createBinaryDescriptor(int type)
+{
+    switch (type)
+    {
+    case FREAK_DESCRIPTOR: return FREAK::create();
+    case ORB_DESCRIPTOR: return ORB::create();
+    case BRISK_DESCRIPTOR: return BRISK::create();
+    }
+    CV_Error(Error::StsBadArg, "Unknown descriptor type");
+}
+
+// FREAK against the binary descriptors of features2d, on the same keypoints
+PERF_TEST_P(binary_descriptor, extract, testing::Combine(testing::Values(FREAK_IMAGES), BinaryDescriptorType::all()))
+{
+    string filename = getDataPath(get<0>(GetParam()));
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Ptr<ORB> detector = ORB::create(5000);
+    vector<KeyPoint> points;
+    detector->detect(frame, points);
+
+    Ptr<Feature2D> descriptor = createBinaryDescriptor(get<1>(GetParam()));
+    Mat descriptors;
+    declare.in(frame);
+
+    TEST_CYCLE()
+    {
+        vector<KeyPoint> keypoints = points;
+        descriptor->compute(frame, keypoints, descriptors);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,51 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// matches of keypoints moved by a rotation and a scale change, a third of them are wrong
+static void generateMatches(int count, const Size& size, vector<KeyPoint>& keypoints1,
+                            vector<KeyPoint>& keypoints2, vector<DMatch>& matches)
+{
+    RNG rng(12345);
+    Mat M = getRotationMatrix2D(Point2f(size.width * 0.5f, size.height * 0.5f), 30, 0.8);
+
+    keypoints1.clear();
+    keypoints2.clear();
+    matches.clear();
+    for (int i = 0; i < count; i++)
+    {
+        Point2f p1(rng.uniform(0.f, (float)size.width), rng.uniform(0.f, (float)size.height));
+        Point2f p2((float)(M.at<double>(0, 0) * p1.x + M.at<double>(0, 1) * p1.y + M.at<double>(0, 2)),
+                   (float)(M.at<double>(1, 0) * p1.x + M.at<double>(1, 1) * p1.y + M.at<double>(1, 2)));
+        if (i % 3 == 0 || !Rect(0, 0, size.width, size.height).contains(p2))
+            p2 = Point2f(rng.uniform(0.f, (float)size.width), rng.uniform(0.f, (float)size.height));
+
+        keypoints1.push_back(KeyPoint(p1, 7.f));
+        keypoints2.push_back(KeyPoint(p2, 7.f));
+        matches.push_back(DMatch(i, i, 0.f));
+    }
+}
+
+typedef tuple<int, bool, bool> GMSParams;
+typedef perf::TestBaseWithParam<GMSParams> gms;
+
+PERF_TEST_P(gms, match, testing::Combine(testing::Values(10000, 50000), testing::Bool(), testing::Bool()))
+{
+    const int count = get<0>(GetParam());
+    const bool withRotation = get<1>(GetParam());
+    const bool withScale = get<2>(GetParam());
+    const Size size(640, 480);
+
+    vector<KeyPoint> keypoints1, keypoints2;
+    vector<DMatch> matches, matchesGMS;
+    generateMatches(count, size, keypoints1, keypoints2, matches);
+
+    TEST_CYCLE() matchGMS(size, size, keypoints1, keypoints2, matches, matchesGMS, withRotation, withScale);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -33,4 +33,28 @@ PERF_TEST_P(latch, extract, testing::Values(LATCH_IMAGES))
 }
 #endif // NONFREE
 
+PERF_TEST_P(latch, extract_5k, testing::Values(LATCH_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    // a frame worth of oriented keypoints
+    Ptr<ORB> detector = ORB::create(5000, 1.2f, 8, 31, 0, 2, ORB::HARRIS_SCORE, 31, 0);
+    vector<KeyPoint> points;
+    detector->detect(frame, points);
+
+    Ptr<LATCH> descriptor = LATCH::create();
+    Mat descriptors;
+    declare.in(frame);
+
+    TEST_CYCLE()
+    {
+        vector<KeyPoint> keypoints = points;
+        descriptor->compute(frame, keypoints, descriptors);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
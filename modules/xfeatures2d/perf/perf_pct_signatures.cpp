@@ -0,0 +1,61 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// a database of signatures of the size produced by the default PCTSignatures
+static void generateSignatures(int count, RNG& rng, std::vector<Mat>& signatures)
+{
+    signatures.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        Mat& signature = signatures[i];
+        signature.create(rng.uniform(20, 60), 8, CV_32F);
+        rng.fill(signature, RNG::UNIFORM, 0.f, 1.f);
+    }
+}
+
+typedef perf::TestBaseWithParam<int> pct_sqfd;
+
+PERF_TEST_P(pct_sqfd, distances_10k, testing::Values(1, 16))
+{
+    const int queryCount = GetParam();
+    RNG rng(12345);
+    std::vector<Mat> queries, images;
+    generateSignatures(queryCount, rng, queries);
+    generateSignatures(10000, rng, images);
+
+    Ptr<PCTSignaturesSQFD> sqfd = PCTSignaturesSQFD::create();
+    Mat distances;
+
+    TEST_CYCLE() sqfd->computeQuadraticFormDistanceMatrix(queries, images, distances);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<std::string> pct_signatures;
+
+PERF_TEST_P(pct_signatures, compute_batch, testing::Values("cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png", "stitching/a3.png"))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_COLOR);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    // a batch of images of the same size
+    std::vector<Mat> images(8);
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        flip(frame, images[i], (int)i % 3 - 1);
+    }
+
+    Ptr<PCTSignatures> pctSignatures = PCTSignatures::create();
+    std::vector<Mat> signatures;
+
+    TEST_CYCLE() pctSignatures->computeSignatures(images, signatures);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -53,6 +53,8 @@
 #include <fstream>
 #include <stdlib.h>
 
+#include "opencv2/core/hal/intrin.hpp"
+
 namespace cv
 {
 namespace xfeatures2d
@@ -175,6 +177,14 @@ public:
      */
     virtual void compute( InputArray image, OutputArray descriptors ) CV_OVERRIDE;
 
+    /**
+     * @param image image to extract descriptors
+     * @param roi region of interest within image
+     * @param descriptors resulted descriptors array for roi image pixels
+     * @param memoryBudget maximal number of bytes used by the layers of a band
+     */
+    virtual void computeDense( InputArray image, Rect roi, OutputArray descriptors, size_t memoryBudget ) CV_OVERRIDE;
+
     /**
      * @param y position y on image
      * @param x position x on image
@@ -362,6 +372,9 @@ private:
 
     inline void update_selected_cubes();
 
+    // number of image rows needed above and below a band of dense descriptors
+    inline int band_margin() const;
+
 }; // END DAISY_Impl CLASS
 
 
@@ -612,15 +625,17 @@ static void normalize_descriptor( float* desc, const DAISY::NormalizationType nr
         CV_Error( Error::StsInternal, "No such normalization" );
 }
 
-static void ni_get_histogram( float* histogram, const int y, const int x, const int shift, const Mat* hcube )
+// the rows of hcube start at the row y_off of the image
+static void ni_get_histogram( float* histogram, const int y, const int x, const int shift, const Mat* hcube,
+                              const int y_off = 0 )
 {
 
-    if ( ! Point( x, y ).inside(
+    if ( ! Point( x, y - y_off ).inside(
            Rect( 0, 0, hcube->size[1]-1, hcube->size[0]-1 ) )
        ) return;
 
     int _hist_th_q_no = hcube->size[2];
-    const float* hptr = hcube->ptr<float>(y,x,0);
+    const float* hptr = hcube->ptr<float>(y - y_off,x,0);
     for( int h=0; h<_hist_th_q_no; h++ )
     {
       int hi = h+shift;
@@ -629,12 +644,13 @@ static void ni_get_histogram( float* histogram, const int y, const int x, const
     }
 }
 
-static void bi_get_histogram( float* histogram, const double y, const double x, const int shift, const Mat* hcube )
+static void bi_get_histogram( float* histogram, const double y, const double x, const int shift, const Mat* hcube,
+                              const int y_off = 0 )
 {
     int mnx = int( x );
     int mny = int( y );
     int _hist_th_q_no = hcube->size[2];
-    if( mnx >= hcube->size[1]-2  || mny >= hcube->size[0]-2 )
+    if( mnx >= hcube->size[1]-2  || mny - y_off >= hcube->size[0]-2 )
     {
       memset(histogram, 0, sizeof(float)*_hist_th_q_no);
       return;
@@ -642,10 +658,10 @@ static void bi_get_histogram( float* histogram, const double y, const double x,
 
     // A C --> pixel positions
     // B D
-    const float* A = hcube->ptr<float>( mny   ,  mnx   , 0);
-    const float* B = hcube->ptr<float>((mny+1),  mnx   , 0);
-    const float* C = hcube->ptr<float>( mny   , (mnx+1), 0);
-    const float* D = hcube->ptr<float>((mny+1), (mnx+1), 0);
+    const float* A = hcube->ptr<float>( mny-y_off   ,  mnx   , 0);
+    const float* B = hcube->ptr<float>((mny-y_off+1),  mnx   , 0);
+    const float* C = hcube->ptr<float>( mny-y_off   , (mnx+1), 0);
+    const float* D = hcube->ptr<float>((mny-y_off+1), (mnx+1), 0);
 
     double alpha = mnx+1-x;
     double beta  = mny+1-y;
@@ -675,13 +691,14 @@ static void bi_get_histogram( float* histogram, const double y, const double x,
     }
 }
 
-static void ti_get_histogram( float* histogram, const double y, const double x, const double shift, const Mat* hcube )
+static void ti_get_histogram( float* histogram, const double y, const double x, const double shift, const Mat* hcube,
+                              const int y_off = 0 )
 {
     int ishift = int( shift );
     double layer_alpha  = shift - ishift;
 
     float thist[MAX_CUBE_NO];
-    bi_get_histogram( thist, y, x, ishift, hcube );
+    bi_get_histogram( thist, y, x, ishift, hcube, y_off );
 
     int _hist_th_q_no = hcube->size[2];
     for( int h=0; h<_hist_th_q_no-1; h++ )
@@ -689,19 +706,21 @@ static void ti_get_histogram( float* histogram, const double y, const double x,
     histogram[_hist_th_q_no-1] = (float) ((1-layer_alpha)*thist[_hist_th_q_no-1]+layer_alpha*thist[0]);
 }
 
-static void i_get_histogram( float* histogram, const double y, const double x, const double shift, const Mat* hcube )
+static void i_get_histogram( float* histogram, const double y, const double x, const double shift, const Mat* hcube,
+                             const int y_off = 0 )
 {
     int ishift = (int)shift;
     double fshift = shift-ishift;
-    if     ( fshift < 0.01 ) bi_get_histogram( histogram, y, x, ishift  , hcube );
-    else if( fshift > 0.99 ) bi_get_histogram( histogram, y, x, ishift+1, hcube );
-    else                     ti_get_histogram( histogram, y, x,  shift  , hcube );
+    if     ( fshift < 0.01 ) bi_get_histogram( histogram, y, x, ishift  , hcube, y_off );
+    else if( fshift > 0.99 ) bi_get_histogram( histogram, y, x, ishift+1, hcube, y_off );
+    else                     ti_get_histogram( histogram, y, x,  shift  , hcube, y_off );
 }
 
 static void ni_get_descriptor( const double y, const double x, const int orientation, float* descriptor, const std::vector<Mat>* layers,
-                               const Mat* _oriented_grid_points, const double* _orientation_shift_table, const int _th_q_no )
+                               const Mat* _oriented_grid_points, const double* _orientation_shift_table, const int _th_q_no,
+                               const int y_off = 0 )
 {
-    CV_Assert( y >= 0 && y < layers->at(0).size[0] );
+    CV_Assert( y >= y_off && y < y_off + layers->at(0).size[0] );
     CV_Assert( x >= 0 && x < layers->at(0).size[1] );
     CV_Assert( orientation >= 0 && orientation < 360 );
     CV_Assert( !layers->empty() );
@@ -718,7 +737,7 @@ static void ni_get_descriptor( const double y, const double x, const int orienta
     int ix = (int)x; if( x - ix > 0.5 ) ix++;
 
     // center
-    ni_get_histogram( descriptor, iy, ix, ishift, &layers->at(g_selected_cubes[0]) );
+    ni_get_histogram( descriptor, iy, ix, ishift, &layers->at(g_selected_cubes[0]), y_off );
 
     double yy, xx;
     float* histogram=0;
@@ -736,19 +755,20 @@ static void ni_get_descriptor( const double y, const double x, const int orienta
          ix = (int)xx; if( xx - ix > 0.5 ) ix++;
 
          if ( ! Point2f( (float)xx, (float)yy ).inside(
-                Rect( 0, 0, layers->at(0).size[1]-1, layers->at(0).size[0]-1 ) )
+                Rect( 0, y_off, layers->at(0).size[1]-1, layers->at(0).size[0]-1 ) )
             ) continue;
 
          histogram = descriptor + region*_hist_th_q_no;
-         ni_get_histogram( histogram, iy, ix, ishift, &layers->at(g_selected_cubes[r]) );
+         ni_get_histogram( histogram, iy, ix, ishift, &layers->at(g_selected_cubes[r]), y_off );
       }
     }
 }
 
 static void i_get_descriptor( const double y, const double x, const int orientation, float* descriptor, const std::vector<Mat>* layers,
-                              const Mat* _oriented_grid_points, const double *_orientation_shift_table, const int _th_q_no )
+                              const Mat* _oriented_grid_points, const double *_orientation_shift_table, const int _th_q_no,
+                              const int y_off = 0 )
 {
-    CV_Assert( y >= 0 && y < layers->at(0).size[0] );
+    CV_Assert( y >= y_off && y < y_off + layers->at(0).size[0] );
     CV_Assert( x >= 0 && x < layers->at(0).size[1] );
     CV_Assert( orientation >= 0 && orientation < 360 );
     CV_Assert( !layers->empty() );
@@ -759,7 +779,7 @@ static void i_get_descriptor( const double y, const double x, const int orientat
     int _hist_th_q_no = layers->at(0).size[2];
     double shift = _orientation_shift_table[orientation];
 
-    i_get_histogram( descriptor, y, x, shift, &layers->at(g_selected_cubes[0]) );
+    i_get_histogram( descriptor, y, x, shift, &layers->at(g_selected_cubes[0]), y_off );
 
     int r, rdt, region;
     double yy, xx;
@@ -777,11 +797,11 @@ static void i_get_descriptor( const double y, const double x, const int orientat
          xx = x + grid.at<double>(2*region + 1);
 
          if ( ! Point2f( (float)xx, (float)yy ).inside(
-                Rect( 0, 0, layers->at(0).size[1]-1, layers->at(0).size[0]-1 ) )
+                Rect( 0, y_off, layers->at(0).size[1]-1, layers->at(0).size[0]-1 ) )
             ) continue;
 
          histogram = descriptor + region*_hist_th_q_no;
-         i_get_histogram( histogram, yy, xx, shift, &layers->at(r) );
+         i_get_histogram( histogram, yy, xx, shift, &layers->at(r), y_off );
       }
     }
 }
@@ -914,14 +934,15 @@ static bool i_get_descriptor_h( const double y, const double x, const int orient
 
 static void get_unnormalized_descriptor( const double y, const double x, const int orientation, float* descriptor,
             const std::vector<Mat>* m_smoothed_gradient_layers, const Mat* m_oriented_grid_points,
-            const double* m_orientation_shift_table, const int m_th_q_no, const bool m_enable_interpolation )
+            const double* m_orientation_shift_table, const int m_th_q_no, const bool m_enable_interpolation,
+            const int y_off = 0 )
 {
     if( m_enable_interpolation )
       i_get_descriptor( y, x, orientation, descriptor, m_smoothed_gradient_layers,
-                        m_oriented_grid_points, m_orientation_shift_table, m_th_q_no );
+                        m_oriented_grid_points, m_orientation_shift_table, m_th_q_no, y_off );
     else
      ni_get_descriptor( y, x, orientation, descriptor, m_smoothed_gradient_layers,
-                        m_oriented_grid_points, m_orientation_shift_table, m_th_q_no);
+                        m_oriented_grid_points, m_orientation_shift_table, m_th_q_no, y_off );
 }
 
 static void get_descriptor( const double y, const double x, const int orientation, float* descriptor,
@@ -1024,16 +1045,19 @@ inline void DAISY_Impl::compute_grid_points()
     compute_oriented_grid_points();
 }
 
+// the descriptor of the roi pixel (y,x) is the row (y-roi.y)*roi.width+(x-roi.x),
+// the rows of the layers start at the row y_off of the image
 struct ComputeDescriptorsInvoker : ParallelLoopBody
 {
-    ComputeDescriptorsInvoker( Mat* _descriptors, Mat* _image, Rect* _roi,
+    ComputeDescriptorsInvoker( Mat* _descriptors, Rect* _roi,
                                std::vector<Mat>* _layers, Mat* _orientation_map,
                                Mat* _oriented_grid_points, double* _orientation_shift_table,
-                               int _th_q_no, bool _enable_interpolation )
+                               int _th_q_no, bool _enable_interpolation, int _y_off = 0 )
     {
       x_off = _roi->x;
       x_end = _roi->x + _roi->width;
-      image = _image;
+      y_roi = _roi->y;
+      y_off = _y_off;
       layers = _layers;
       th_q_no = _th_q_no;
       descriptors = _descriptors;
@@ -1050,7 +1074,7 @@ struct ComputeDescriptorsInvoker : ParallelLoopBody
       {
         for( int x = x_off; x < x_end; x++ )
         {
-          index = y*image->cols + x;
+          index = (y - y_roi)*(x_end - x_off) + (x - x_off);
           orientation = 0;
           if( !orientation_map->empty() )
               orientation = (int) orientation_map->at<ushort>( y, x );
@@ -1058,19 +1082,20 @@ struct ComputeDescriptorsInvoker : ParallelLoopBody
               orientation = 0;
           get_unnormalized_descriptor( y, x, orientation, descriptors->ptr<float>( index ),
                                        layers, oriented_grid_points, orientation_shift_table,
-                                       th_q_no, enable_interpolation );
+                                       th_q_no, enable_interpolation, y_off );
         }
       }
     }
 
     int th_q_no;
     int x_off, x_end;
+    int y_roi, y_off;
     std::vector<Mat>* layers;
     Mat *descriptors;
     Mat *orientation_map;
     bool enable_interpolation;
     double* orientation_shift_table;
-    Mat *image, *oriented_grid_points;
+    Mat *oriented_grid_points;
 };
 
 // Computes the descriptor by sampling convoluted orientation maps.
@@ -1085,7 +1110,7 @@ inline void DAISY_Impl::compute_descriptors( Mat* m_dense_descriptors )
     m_dense_descriptors->setTo( Scalar(0) );
 
     parallel_for_( Range(y_off, y_end),
-        ComputeDescriptorsInvoker( m_dense_descriptors, &m_image, &m_roi, &m_smoothed_gradient_layers,
+        ComputeDescriptorsInvoker( m_dense_descriptors, &m_roi, &m_smoothed_gradient_layers,
                                    &m_orientation_map, &m_oriented_grid_points, m_orientation_shift_table,
                                    m_th_q_no, m_enable_interpolation )
     );
@@ -1188,14 +1213,41 @@ struct ComputeHistogramsInvoker : ParallelLoopBody
 
     void operator ()(const cv::Range& range) const CV_OVERRIDE
     {
+      const Mat& src = layers->at(r+1);
+      Mat& dst = layers->at(r);
+      const int width = dst.size[1];
       for (int y = range.start; y < range.end; ++y)
       {
-        for( int x = 0; x < layers->at(r).size[1]; x++ )
+        int x = 0;
+#if CV_SIMD128
+        // blocks of 4 orientations x 4 pixels are transposed
+        if( _hist_th_q_no % 4 == 0 )
+        {
+          for( ; x <= width - 4; x += 4 )
+          {
+            float* hist = dst.ptr<float>(y,x,0);
+            for( int h = 0; h < _hist_th_q_no; h += 4 )
+            {
+              v_float32x4 a0 = v_load(src.ptr<float>(h  ,y,x));
+              v_float32x4 a1 = v_load(src.ptr<float>(h+1,y,x));
+              v_float32x4 a2 = v_load(src.ptr<float>(h+2,y,x));
+              v_float32x4 a3 = v_load(src.ptr<float>(h+3,y,x));
+              v_float32x4 b0, b1, b2, b3;
+              v_transpose4x4(a0, a1, a2, a3, b0, b1, b2, b3);
+              v_store(hist + h, b0);
+              v_store(hist + _hist_th_q_no + h, b1);
+              v_store(hist + 2*_hist_th_q_no + h, b2);
+              v_store(hist + 3*_hist_th_q_no + h, b3);
+            }
+          }
+        }
+#endif
+        for( ; x < width; x++ )
         {
-          float* hist = layers->at(r).ptr<float>(y,x,0);
+          float* hist = dst.ptr<float>(y,x,0);
           for( int h = 0; h < _hist_th_q_no; h++ )
           {
-            hist[h] = layers->at(r+1).at<float>(h,y,x);
+            hist[h] = src.at<float>(h,y,x);
           }
         }
       }
@@ -1628,6 +1680,91 @@ void DAISY_Impl::compute( InputArray _image, OutputArray _descriptors )
     normalize_descriptors( &descriptors );
 }
 
+// rows needed around a band of descriptors for its layers to be the ones of the whole image:
+// the supports of the gradient and smoothing filters plus the radius of the descriptor
+inline int DAISY_Impl::band_margin() const
+{
+    // 5x5 gaussian and derivative of layered_gradient, smoothing of initialize
+    int margin = 2 + 1 + filter_size( (float)sqrt(g_sigma_init*g_sigma_init-0.25f), 5.0f ) / 2;
+
+    // incremental smoothing of compute_smoothed_gradient_layers
+    for( int r=0; r<m_rad_q_no; r++ )
+    {
+      double sigma;
+      if( r == 0 )
+        sigma = m_cube_sigmas.at<double>(0);
+      else
+        sigma = sqrt( m_cube_sigmas.at<double>(r  ) * m_cube_sigmas.at<double>(r  )
+                    - m_cube_sigmas.at<double>(r-1) * m_cube_sigmas.at<double>(r-1) );
+      margin += filter_size( sigma, 5.0f ) / 2;
+    }
+
+    // grid points and their rounding or interpolation
+    return margin + cvCeil( m_rad ) + 2;
+}
+
+// full scope with roi, band by band
+void DAISY_Impl::computeDense( InputArray _image, Rect roi, OutputArray _descriptors, size_t memoryBudget )
+{
+    // do nothing if no image
+    if( _image.getMat().empty() )
+      return;
+
+    CV_Assert( m_h_matrix.empty() );
+    CV_Assert( ! m_use_orientation );
+
+    set_image( _image );
+    CV_Assert( ( roi & Rect( 0, 0, m_image.cols, m_image.rows ) ) == roi );
+
+    m_roi = roi;
+
+    set_parameters();
+
+    // a preallocated (possibly strided) output is filled in place
+    _descriptors.create( m_roi.width*m_roi.height, m_descriptor_size, CV_32F );
+
+    Mat descriptors = _descriptors.getMat();
+    descriptors.setTo( Scalar(0) );
+
+    if( m_roi.empty() )
+      return;
+
+    // the m_rad_q_no+1 cubes of a band and a reorganized one are alive at once
+    const Mat image = m_image;
+    const int margin = band_margin();
+    const int64 row_bytes = (int64)(m_rad_q_no + 2) * m_hist_th_q_no * image.cols * sizeof(float);
+    const int band_rows = (int)std::max( (int64)1,
+                          std::min( (int64)m_roi.height, (int64)(memoryBudget / (size_t)row_bytes) - 2*margin ) );
+
+    for( int y = m_roi.y; y < m_roi.y + m_roi.height; y += band_rows )
+    {
+      Rect band( m_roi.x, y, m_roi.width, std::min( band_rows, m_roi.y + m_roi.height - y ) );
+      const int y_off = std::max( band.y - margin, 0 );
+      const int y_end = std::min( band.y + band.height + margin, image.rows );
+
+      // smoothed layers of the band rows and their margins only
+      m_image = image.rowRange( y_off, y_end );
+      initialize_single_descriptor_mode();
+
+      // the descriptors of the band are written straight to the output rows
+      Mat band_descriptors = descriptors.rowRange( (band.y - m_roi.y)*m_roi.width,
+                                                   (band.y - m_roi.y + band.height)*m_roi.width );
+
+      parallel_for_( Range(band.y, band.y + band.height),
+          ComputeDescriptorsInvoker( &band_descriptors, &band, &m_smoothed_gradient_layers,
+                                     &m_orientation_map, &m_oriented_grid_points, m_orientation_shift_table,
+                                     m_th_q_no, m_enable_interpolation, y_off )
+      );
+
+      parallel_for_( Range(0, band_descriptors.rows),
+          NormalizeDescriptorsInvoker( &band_descriptors, m_nrm_type, m_grid_point_number, m_hist_th_q_no, m_descriptor_size )
+      );
+    }
+
+    m_image = image;
+    m_smoothed_gradient_layers.clear();
+}
+
 // constructor
 DAISY_Impl::DAISY_Impl( float _radius, int _q_radius, int _q_theta, int _q_hist,
              DAISY::NormalizationType _norm, InputArray _H, bool _interpolation, bool _use_orientation )
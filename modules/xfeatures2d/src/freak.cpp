@@ -41,6 +41,8 @@
 #include <iomanip>
 #include <string.h>
 
+#include "opencv2/core/hal/intrin.hpp"
+
 namespace cv
 {
 namespace xfeatures2d
@@ -106,15 +108,25 @@ protected:
 
     void buildPattern();
 
+    struct PatternPoint;
+
     template <typename imgType, typename iiType>
-    imgType meanIntensity( InputArray image, InputArray integral, const float kp_x, const float kp_y,
-                          const unsigned int scale, const unsigned int rot, const unsigned int point );
+    imgType meanIntensity( const Mat& image, const Mat& integral, const float kp_x, const float kp_y,
+                          const PatternPoint& point ) const;
+
+    template <typename imgType, typename iiType>
+    void meanIntensities( const Mat& image, const Mat& integral, const float kp_x, const float kp_y,
+                          const unsigned int scale, const unsigned int rot, imgType *values ) const;
+
+    template <typename srcMatType, typename iiMatType>
+    int estimateOrientation( const Mat& image, const Mat& integral, KeyPoint& keypoint,
+                             const int scaleIdx, srcMatType *pointsValue ) const;
 
     template <typename srcMatType, typename iiMatType>
     void computeDescriptors( InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors );
 
     template <typename srcMatType>
-    void extractDescriptor(srcMatType *pointsValue, void ** ptr);
+    void extractDescriptor(const srcMatType *pointsValue, uchar *desc) const;
 
     bool orientationNormalized; //true if the orientation is normalized, false otherwise
     bool scaleNormalized; //true if the scale is normalized, false otherwise
@@ -150,6 +162,7 @@ protected:
     std::vector<PatternPoint> patternLookup; // look-up table for the pattern points (position+sigma of all points at all scales and orientation)
     int patternSizes[NB_SCALES]; // size of the pattern at a specific scale (used to check if a point is within image boundaries)
     DescriptionPair descriptionPairs[NB_PAIRS];
+    int pairsOrder[2][NB_PAIRS]; // points of the description pairs in the order of the descriptor bits
     OrientationPair orientationPairs[NB_ORIENPAIRS];
 };
 
@@ -331,6 +344,16 @@ void FREAK_Impl::buildPattern()
         for( int i = 0; i < FREAK::NB_PAIRS; ++i )
              descriptionPairs[i] = allPairs[FREAK_DEF_PAIRS[i]];
     }
+
+    // the descriptor bits keep the layout of the former SSE2 implementation: the bit b of the
+    // byte 16*n+l is the pair 128*n+16*b+15-l (the first 128 comparisons remain globally the same)
+    for( int k = 0; k < FREAK::NB_PAIRS; ++k )
+    {
+        const int byteIdx = k/8;
+        const DescriptionPair& pair = descriptionPairs[(byteIdx/16)*128 + (k%8)*16 + 15 - byteIdx%16];
+        pairsOrder[0][k] = pair.i;
+        pairsOrder[1][k] = pair.j;
+    }
 }
 
 void FREAK_Impl::compute( InputArray _image, std::vector<KeyPoint>& keypoints, OutputArray _descriptors )
@@ -379,86 +402,70 @@ void FREAK_Impl::compute( InputArray _image, std::vector<KeyPoint>& keypoints, O
 }
 
 template <typename srcMatType>
-void FREAK_Impl::extractDescriptor(srcMatType *pointsValue, void ** ptr)
+void FREAK_Impl::extractDescriptor(const srcMatType *pointsValue, uchar *desc) const
 {
-    std::bitset<FREAK::NB_PAIRS>** ptrScalar = (std::bitset<FREAK::NB_PAIRS>**) ptr;
-
-    // extracting descriptor preserving the order of SSE version
-    int cnt = 0;
-    for( int n = 7; n < FREAK::NB_PAIRS; n += 128)
+    // the bit b of the byte n of the descriptor is the comparison of the pair 8*n+b in the bits order
+    for( int n = 0; n < FREAK::NB_PAIRS/8; ++n )
     {
-        for( int m = 8; m--; )
-        {
-            int nm = n-m;
-            for(int kk = nm+15*8; kk >= nm; kk-=8, ++cnt)
-            {
-                (*ptrScalar)->set(kk, pointsValue[descriptionPairs[cnt].i] >= pointsValue[descriptionPairs[cnt].j]);
-            }
-        }
+        uchar byte = 0;
+        for( int b = 0; b < 8; ++b )
+            byte |= (uchar)((pointsValue[pairsOrder[0][8*n+b]] >= pointsValue[pairsOrder[1][8*n+b]]) << b);
+        desc[n] = byte;
     }
-    --(*ptrScalar);
 }
 
-#if CV_SSE2
+#if CV_SIMD128
 template <>
-void FREAK_Impl::extractDescriptor(uchar *pointsValue, void ** ptr)
+void FREAK_Impl::extractDescriptor(const uchar *pointsValue, uchar *desc) const
 {
-    __m128i** ptrSSE = (__m128i**) ptr;
-
-    // note that comparisons order is modified in each block (but first 128 comparisons remain globally the same-->does not affect the 128,384 bits segmanted matching strategy)
-    int cnt = 0;
-    for( int n = FREAK::NB_PAIRS/128; n-- ; )
+    // 16 comparisons are packed into 2 bytes of the descriptor by their sign mask
+    for( int n = 0; n < FREAK::NB_PAIRS; n += 16 )
     {
-        __m128i result128 = _mm_setzero_si128();
-        for( int m = 128/16; m--; cnt += 16 )
-        {
-            __m128i operand1 = _mm_set_epi8(pointsValue[descriptionPairs[cnt+0].i],
-                                            pointsValue[descriptionPairs[cnt+1].i],
-                                            pointsValue[descriptionPairs[cnt+2].i],
-                                            pointsValue[descriptionPairs[cnt+3].i],
-                                            pointsValue[descriptionPairs[cnt+4].i],
-                                            pointsValue[descriptionPairs[cnt+5].i],
-                                            pointsValue[descriptionPairs[cnt+6].i],
-                                            pointsValue[descriptionPairs[cnt+7].i],
-                                            pointsValue[descriptionPairs[cnt+8].i],
-                                            pointsValue[descriptionPairs[cnt+9].i],
-                                            pointsValue[descriptionPairs[cnt+10].i],
-                                            pointsValue[descriptionPairs[cnt+11].i],
-                                            pointsValue[descriptionPairs[cnt+12].i],
-                                            pointsValue[descriptionPairs[cnt+13].i],
-                                            pointsValue[descriptionPairs[cnt+14].i],
-                                            pointsValue[descriptionPairs[cnt+15].i]);
-
-            __m128i operand2 = _mm_set_epi8(pointsValue[descriptionPairs[cnt+0].j],
-                                            pointsValue[descriptionPairs[cnt+1].j],
-                                            pointsValue[descriptionPairs[cnt+2].j],
-                                            pointsValue[descriptionPairs[cnt+3].j],
-                                            pointsValue[descriptionPairs[cnt+4].j],
-                                            pointsValue[descriptionPairs[cnt+5].j],
-                                            pointsValue[descriptionPairs[cnt+6].j],
-                                            pointsValue[descriptionPairs[cnt+7].j],
-                                            pointsValue[descriptionPairs[cnt+8].j],
-                                            pointsValue[descriptionPairs[cnt+9].j],
-                                            pointsValue[descriptionPairs[cnt+10].j],
-                                            pointsValue[descriptionPairs[cnt+11].j],
-                                            pointsValue[descriptionPairs[cnt+12].j],
-                                            pointsValue[descriptionPairs[cnt+13].j],
-                                            pointsValue[descriptionPairs[cnt+14].j],
-                                            pointsValue[descriptionPairs[cnt+15].j]);
-
-            __m128i workReg = _mm_min_epu8(operand1, operand2); // emulated "not less than" for 8-bit UNSIGNED integers
-            workReg = _mm_cmpeq_epi8(workReg, operand2);        // emulated "not less than" for 8-bit UNSIGNED integers
-
-            workReg = _mm_and_si128(_mm_set1_epi16(short(0x8080 >> m)), workReg); // merge the last 16 bits with the 128bits std::vector until full
-            result128 = _mm_or_si128(result128, workReg);
-        }
-        (**ptrSSE) = result128;
-        ++(*ptrSSE);
+        v_uint8x16 operand1 = v_lut(pointsValue, pairsOrder[0] + n);
+        v_uint8x16 operand2 = v_lut(pointsValue, pairsOrder[1] + n);
+        int bits = v_signmask(operand1 >= operand2);
+        desc[n/8] = (uchar)bits;
+        desc[n/8 + 1] = (uchar)(bits >> 8);
     }
-    (*ptrSSE) -= 8;
 }
 #endif
 
+template <typename srcMatType, typename iiMatType>
+int FREAK_Impl::estimateOrientation( const Mat& image, const Mat& integral, KeyPoint& keypoint,
+                                     const int scaleIdx, srcMatType *pointsValue ) const
+{
+    if( !orientationNormalized )
+    {
+        keypoint.angle = 0.0; // assign 0° to all keypoints
+        return 0;
+    }
+
+    // get the points intensity value in the un-rotated pattern
+    meanIntensities<srcMatType, iiMatType>(image, integral, keypoint.pt.x, keypoint.pt.y, scaleIdx, 0, pointsValue);
+
+    int direction0 = 0;
+    int direction1 = 0;
+    for( int m = 45; m--; )
+    {
+        //iterate through the orientation pairs
+        const int delta = (pointsValue[ orientationPairs[m].i ]-pointsValue[ orientationPairs[m].j ]);
+        direction0 += delta*(orientationPairs[m].weight_dx)/2048;
+        direction1 += delta*(orientationPairs[m].weight_dy)/2048;
+    }
+
+    keypoint.angle = static_cast<float>(atan2((float)direction1,(float)direction0)*(180.0/CV_PI));//estimate orientation
+
+    int thetaIdx = cvRound(FREAK_NB_ORIENTATION*keypoint.angle*(1/360.0));
+
+    if( thetaIdx < 0 )
+        thetaIdx += FREAK_NB_ORIENTATION;
+
+    if( thetaIdx >= FREAK_NB_ORIENTATION )
+        thetaIdx -= FREAK_NB_ORIENTATION;
+
+    return thetaIdx;
+}
+
 template <typename srcMatType, typename iiMatType>
 void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& keypoints, OutputArray _descriptors ){
 
@@ -469,10 +476,6 @@ void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& k
     const std::vector<int>::iterator ScaleIdxBegin = kpScaleIdx.begin(); // used in std::vector erase function
     const std::vector<cv::KeyPoint>::iterator kpBegin = keypoints.begin(); // used in std::vector erase function
     const float sizeCst = static_cast<float>(FREAK::NB_SCALES/(FREAK_LOG2* nOctaves));
-    srcMatType pointsValue[FREAK_NB_POINTS];
-    int thetaIdx = 0;
-    int direction0;
-    int direction1;
 
     // compute the scale index corresponding to the keypoint size and remove keypoints close to the border
     if( scaleNormalized )
@@ -525,131 +528,65 @@ void FREAK_Impl::computeDescriptors( InputArray _image, std::vector<KeyPoint>& k
         _descriptors.setTo(Scalar::all(0));
         Mat descriptors = _descriptors.getMat();
 
-        void *ptr = descriptors.data+(keypoints.size()-1)*descriptors.step[0];
-
-        for( size_t k = keypoints.size(); k--; ) {
-            // estimate orientation (gradient)
-            if( !orientationNormalized )
-            {
-                thetaIdx = 0; // assign 0° to all keypoints
-                keypoints[k].angle = 0.0;
-            }
-            else
+        // the keypoints are described in parallel
+        parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
+        {
+            srcMatType pointsValue[FREAK_NB_POINTS];
+            for( int k = range.start; k < range.end; ++k )
             {
-                // get the points intensity value in the un-rotated pattern
-                for( int i = FREAK_NB_POINTS; i--; ) {
-                    pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                          keypoints[k].pt.x, keypoints[k].pt.y,
-                                                                          kpScaleIdx[k], 0, i);
-                }
-                direction0 = 0;
-                direction1 = 0;
-                for( int m = 45; m--; )
-                {
-                    //iterate through the orientation pairs
-                    const int delta = (pointsValue[ orientationPairs[m].i ]-pointsValue[ orientationPairs[m].j ]);
-                    direction0 += delta*(orientationPairs[m].weight_dx)/2048;
-                    direction1 += delta*(orientationPairs[m].weight_dy)/2048;
-                }
-
-                keypoints[k].angle = static_cast<float>(atan2((float)direction1,(float)direction0)*(180.0/CV_PI));//estimate orientation
+                // estimate orientation (gradient)
+                const int thetaIdx = estimateOrientation<srcMatType, iiMatType>(image, imgIntegral, keypoints[k], kpScaleIdx[k], pointsValue);
 
-                thetaIdx = cvRound(FREAK_NB_ORIENTATION*keypoints[k].angle*(1/360.0));
-
-                if( thetaIdx < 0 )
-                    thetaIdx += FREAK_NB_ORIENTATION;
-
-                if( thetaIdx >= FREAK_NB_ORIENTATION )
-                    thetaIdx -= FREAK_NB_ORIENTATION;
+                // extract descriptor at the computed orientation
+                meanIntensities<srcMatType, iiMatType>(image, imgIntegral, keypoints[k].pt.x, keypoints[k].pt.y,
+                                                       kpScaleIdx[k], thetaIdx, pointsValue);
+                extractDescriptor<srcMatType>(pointsValue, descriptors.ptr(k));
             }
-            // extract descriptor at the computed orientation
-            for( int i = FREAK_NB_POINTS; i--; ) {
-                pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                      keypoints[k].pt.x, keypoints[k].pt.y,
-                                                                      kpScaleIdx[k], thetaIdx, i);
-            }
-
-            // Extract descriptor
-            extractDescriptor<srcMatType>(pointsValue, &ptr);
-        }
+        });
     }
     else // extract all possible comparisons for selection
     {
         _descriptors.create((int)keypoints.size(), 128, CV_8U);
         _descriptors.setTo(Scalar::all(0));
         Mat descriptors = _descriptors.getMat();
-        std::bitset<1024>* ptr = (std::bitset<1024>*) (descriptors.data+(keypoints.size()-1)*descriptors.step[0]);
 
-        for( size_t k = keypoints.size(); k--; )
+        parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
         {
-            //estimate orientation (gradient)
-            if( !orientationNormalized )
+            srcMatType pointsValue[FREAK_NB_POINTS];
+            for( int k = range.start; k < range.end; ++k )
             {
-                thetaIdx = 0;//assign 0° to all keypoints
-                keypoints[k].angle = 0.0;
-            }
-            else
-            {
-                //get the points intensity value in the un-rotated pattern
-                for( int i = FREAK_NB_POINTS;i--; )
-                    pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                          keypoints[k].pt.x,keypoints[k].pt.y,
-                                                                          kpScaleIdx[k], 0, i);
-
-                direction0 = 0;
-                direction1 = 0;
-                for( int m = 45; m--; )
-                {
-                    //iterate through the orientation pairs
-                    const int delta = (pointsValue[ orientationPairs[m].i ]-pointsValue[ orientationPairs[m].j ]);
-                    direction0 += delta*(orientationPairs[m].weight_dx)/2048;
-                    direction1 += delta*(orientationPairs[m].weight_dy)/2048;
-                }
-
-                keypoints[k].angle = static_cast<float>(atan2((float)direction1,(float)direction0)*(180.0/CV_PI)); //estimate orientation
+                std::bitset<1024>* ptr = (std::bitset<1024>*) descriptors.ptr(k);
 
-                thetaIdx = cvRound(FREAK_NB_ORIENTATION*keypoints[k].angle*(1/360.0));
+                //estimate orientation (gradient)
+                const int thetaIdx = estimateOrientation<srcMatType, iiMatType>(image, imgIntegral, keypoints[k], kpScaleIdx[k], pointsValue);
 
-                if( thetaIdx < 0 )
-                    thetaIdx += FREAK_NB_ORIENTATION;
+                // get the points intensity value in the rotated pattern
+                meanIntensities<srcMatType, iiMatType>(image, imgIntegral, keypoints[k].pt.x, keypoints[k].pt.y,
+                                                       kpScaleIdx[k], thetaIdx, pointsValue);
 
-                if( thetaIdx >= FREAK_NB_ORIENTATION )
-                    thetaIdx -= FREAK_NB_ORIENTATION;
-            }
-            // get the points intensity value in the rotated pattern
-            for( int i = FREAK_NB_POINTS; i--; ) {
-                pointsValue[i] = meanIntensity<srcMatType, iiMatType>(image, imgIntegral,
-                                                                      keypoints[k].pt.x, keypoints[k].pt.y,
-                                                                      kpScaleIdx[k], thetaIdx, i);
-            }
-
-            int cnt(0);
-            for( int i = 1; i < FREAK_NB_POINTS; ++i )
-            {
-                //(generate all the pairs)
-                for( int j = 0; j < i; ++j )
+                int cnt(0);
+                for( int i = 1; i < FREAK_NB_POINTS; ++i )
                 {
-                    ptr->set(cnt, pointsValue[i] >= pointsValue[j] );
-                    ++cnt;
+                    //(generate all the pairs)
+                    for( int j = 0; j < i; ++j )
+                    {
+                        ptr->set(cnt, pointsValue[i] >= pointsValue[j] );
+                        ++cnt;
+                    }
                 }
             }
-            --ptr;
-        }
+        });
     }
 }
 
 // simply take average on a square patch, not even gaussian approx
 template <typename imgType, typename iiType>
-imgType FREAK_Impl::meanIntensity( InputArray _image, InputArray _integral,
+imgType FREAK_Impl::meanIntensity( const Mat& image, const Mat& integral,
                               const float kp_x,
                               const float kp_y,
-                              const unsigned int scale,
-                              const unsigned int rot,
-                              const unsigned int point)
+                              const PatternPoint& FreakPoint ) const
 {
-    Mat image = _image.getMat(), integral = _integral.getMat();
     // get point position in image
-    const PatternPoint& FreakPoint = patternLookup[scale*FREAK_NB_ORIENTATION*FREAK_NB_POINTS + rot*FREAK_NB_POINTS + point];
     const float xf = FreakPoint.x+kp_x;
     const float yf = FreakPoint.y+kp_y;
     const int x = int(xf);
@@ -696,6 +633,62 @@ imgType FREAK_Impl::meanIntensity( InputArray _image, InputArray _integral,
     return static_cast<imgType>(ret_val);
 }
 
+// mean intensities of all the pattern points of a keypoint
+template <typename imgType, typename iiType>
+void FREAK_Impl::meanIntensities( const Mat& image, const Mat& integral,
+                                  const float kp_x,
+                                  const float kp_y,
+                                  const unsigned int scale,
+                                  const unsigned int rot,
+                                  imgType *values ) const
+{
+    const PatternPoint* points = &patternLookup[scale*FREAK_NB_ORIENTATION*FREAK_NB_POINTS + rot*FREAK_NB_POINTS];
+    int i = 0;
+
+#if CV_SIMD128
+    if( integral.depth() == CV_32S )
+    {
+        // the borders of the patches of 4 points are computed at once and their corners are gathered
+        const int* ii = integral.ptr<int>();
+        const v_int32x4 vstep = v_setall_s32((int)(integral.step/sizeof(int)));
+        const v_float32x4 vkp_x = v_setall_f32(kp_x), vkp_y = v_setall_f32(kp_y), vone = v_setall_f32(1.f);
+        int top_left[4], top_right[4], bottom_left[4], bottom_right[4], sums[4], areas[4];
+
+        for( ; i <= FREAK_NB_POINTS - 4; i += 4 )
+        {
+            v_float32x4 x, y, radius;
+            v_load_deinterleave((const float*)(points + i), x, y, radius);
+            const v_float32x4 xf = x + vkp_x;
+            const v_float32x4 yf = y + vkp_y;
+
+            const v_int32x4 x_left = v_round(xf - radius);
+            const v_int32x4 y_top = v_round(yf - radius);
+            const v_int32x4 x_right = v_round(xf + radius + vone);
+            const v_int32x4 y_bottom = v_round(yf + radius + vone);
+
+            v_store(top_left, y_top*vstep + x_left);
+            v_store(top_right, y_top*vstep + x_right);
+            v_store(bottom_left, y_bottom*vstep + x_left);
+            v_store(bottom_right, y_bottom*vstep + x_right);
+            v_store(sums, v_lut(ii, bottom_right) - v_lut(ii, bottom_left) + v_lut(ii, top_left) - v_lut(ii, top_right));
+            v_store(areas, (x_right - x_left) * (y_bottom - y_top));
+
+            for( int k = 0; k < 4; ++k )
+            {
+                // the smallest points are interpolated
+                if( points[i+k].sigma < 0.5 )
+                    values[i+k] = meanIntensity<imgType, iiType>(image, integral, kp_x, kp_y, points[i+k]);
+                else
+                    values[i+k] = static_cast<imgType>((sums[k] + areas[k]/2) / areas[k]);
+            }
+        }
+    }
+#endif
+
+    for( ; i < FREAK_NB_POINTS; ++i )
+        values[i] = meanIntensity<imgType, iiType>(image, integral, kp_x, kp_y, points[i]);
+}
+
 // pair selection algorithm from a set of training images and corresponding keypoints
 std::vector<int> FREAK_Impl::selectPairs(const std::vector<Mat>& images
                                         , std::vector<std::vector<KeyPoint> >& keypoints
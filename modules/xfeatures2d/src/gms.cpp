@@ -65,6 +65,90 @@ const int mRotationPatterns[8][9] = {
 // 5 level scales
 const double mScaleRatios[5] = { 1.0, 1.0 / 2, 1.0 / std::sqrt(2.0), std::sqrt(2.0), 2.0 };
 
+// Number of matches between the cells of the left and the right grids. Only the cell pairs
+// holding matches are kept, listed per left cell by increasing right cell.
+struct CellPairHistogram
+{
+    // The pairs of the left cell i are [cellStart[i], cellStart[i + 1])
+    vector<int> cellStart;
+    vector<int> rightCell;
+    vector<int> count;
+
+    // Index  : grid_idx_left
+    // Value  : how many matches from idx_left
+    vector<int> pointsLeft;
+
+    void build(const vector<int> &leftIndex, const vector<int> &rightIndex, const int numberLeft, const int numberRight);
+
+    int get(const int left, const int right) const
+    {
+        vector<int>::const_iterator first = rightCell.begin() + cellStart[left];
+        vector<int>::const_iterator last = rightCell.begin() + cellStart[left + 1];
+        vector<int>::const_iterator it = std::lower_bound(first, last, right);
+        return (it != last && *it == right) ? count[it - rightCell.begin()] : 0;
+    }
+};
+
+void CellPairHistogram::build(const vector<int> &leftIndex, const vector<int> &rightIndex, const int numberLeft, const int numberRight)
+{
+    const size_t numberMatches = leftIndex.size();
+
+    pointsLeft.assign(numberLeft, 0);
+    for (size_t i = 0; i < numberMatches; i++)
+    {
+        if (leftIndex[i] < 0 || rightIndex[i] < 0 || rightIndex[i] >= numberRight) continue;
+        pointsLeft[leftIndex[i]]++;
+    }
+
+    // Bucket the right cells of the matches by left cell
+    vector<int> start(numberLeft + 1, 0);
+    for (int i = 0; i < numberLeft; i++)
+        start[i + 1] = start[i] + pointsLeft[i];
+
+    vector<int> cells(start[numberLeft]);
+    vector<int> pos(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < numberMatches; i++)
+    {
+        if (leftIndex[i] < 0 || rightIndex[i] < 0 || rightIndex[i] >= numberRight) continue;
+        cells[pos[leftIndex[i]]++] = rightIndex[i];
+    }
+
+    cellStart.assign(numberLeft + 1, 0);
+    rightCell.clear();
+    count.clear();
+    for (int i = 0; i < numberLeft; i++)
+    {
+        std::sort(cells.begin() + start[i], cells.begin() + start[i + 1]);
+        for (int k = start[i]; k < start[i + 1]; k++)
+        {
+            if (k > start[i] && cells[k] == cells[k - 1])
+            {
+                count.back()++;
+            }
+            else
+            {
+                rightCell.push_back(cells[k]);
+                count.push_back(1);
+            }
+        }
+        cellStart[i + 1] = (int) rightCell.size();
+    }
+}
+
+// Right grid of a scale, with the motion statistics of the 4 left grid types
+struct ScaleGrid
+{
+    Size gridSize;
+    int gridNumber;
+    Mat gridNeighbor;
+
+    // Index  : match
+    // Value  : grid_idx_right
+    vector<int> rightIndex;
+
+    CellPairHistogram motionStatistics[4];
+};
+
 class GMSMatcher
 {
 public:
@@ -85,6 +169,15 @@ public:
         // Initialize the neighbor of left grid
         mGridNeighborLeft = Mat::zeros(mGridNumberLeft, 9, CV_32SC1);
         initalizeNeighbors(mGridNeighborLeft, mGridSizeLeft);
+
+        // The left cells of the matches don't depend on the scale
+        for (int gridType = 1; gridType <= 4; gridType++)
+        {
+            vector<int> &leftIndex = mvLeftIndex[gridType - 1];
+            leftIndex.resize(mNumberMatches);
+            for (size_t i = 0; i < mNumberMatches; i++)
+                leftIndex[i] = getGridIndexLeft(mvP1[mvMatches[i].first], gridType);
+        }
     }
 
     ~GMSMatcher() {}
@@ -105,45 +198,27 @@ private:
     size_t mNumberMatches;
 
     // Grid Size
-    Size mGridSizeLeft, mGridSizeRight;
+    Size mGridSizeLeft;
     int mGridNumberLeft;
-    int mGridNumberRight;
 
-    // x      : left grid idx
-    // y      : right grid idx
-    // value  : how many matches from idx_left to idx_right
-    Mat mMotionStatistics;
+    // Index  : match
+    // Value  : grid_idx_left, per grid type
+    vector<int> mvLeftIndex[4];
 
-    //
-    vector<int> mNumberPointsInPerCellLeft;
-
-    // Inldex  : grid_idx_left
-    // Value   : grid_idx_right
-    vector<int> mCellPairs;
-
-    // Every Matches has a cell-pair
-    // first  : grid_idx_left
-    // second : grid_idx_right
-    vector<pair<int, int> > mvMatchPairs;
-
-    // Inlier Mask for output
-    vector<bool> mvbInlierMask;
+    // Right grids, per scale
+    ScaleGrid mScaleGrids[5];
 
     //
     Mat mGridNeighborLeft;
-    Mat mGridNeighborRight;
 
     double mThresholdFactor;
 
 
-    // Assign Matches to Cell Pairs
-    void assignMatchPairs(const int GridType);
-
     void convertMatches(const vector<DMatch> &vDMatches, vector<pair<int, int> > &vMatches);
 
-    int getGridIndexLeft(const Point2f &pt, const int type);
+    int getGridIndexLeft(const Point2f &pt, const int type) const;
 
-    int getGridIndexRight(const Point2f &pt);
+    static int getGridIndexRight(const Point2f &pt, const Size &gridSize);
 
     vector<int> getNB9(const int idx, const Size& GridSize);
 
@@ -151,41 +226,16 @@ private:
 
     void normalizePoints(const vector<KeyPoint> &kp, const Size &size, vector<Point2f> &npts);
 
-    // Run
-    int run(const int rotationType);
+    // Run a scale and rotation hypothesis, return the number of inliers
+    int run(const int scale, const int rotationType, vector<int> &cellPairs, vector<uchar> &inlierMask) const;
 
+    // Assign the matches to the cells of the right grid of a scale
     void setScale(const int scale);
 
     // Verify Cell Pairs
-    void verifyCellPairs(const int rotationType);
+    void verifyCellPairs(const ScaleGrid &grid, const int gridType, const int rotationType, vector<int> &cellPairs) const;
 };
 
-void GMSMatcher::assignMatchPairs(const int gridType)
-{
-    for (size_t i = 0; i < mNumberMatches; i++)
-    {
-        Point2f &lp = mvP1[mvMatches[i].first];
-        Point2f &rp = mvP2[mvMatches[i].second];
-
-        int lgidx = mvMatchPairs[i].first = getGridIndexLeft(lp, gridType);
-        int rgidx = -1;
-
-        if (gridType == 1)
-        {
-            rgidx = mvMatchPairs[i].second = getGridIndexRight(rp);
-        }
-        else
-        {
-            rgidx = mvMatchPairs[i].second;
-        }
-
-        if (lgidx < 0 || rgidx < 0) continue;
-
-        mMotionStatistics.at<int>(lgidx, rgidx)++;
-        mNumberPointsInPerCellLeft[lgidx]++;
-    }
-}
-
 // Convert OpenCV DMatch to Match (pair<int, int>)
 void GMSMatcher::convertMatches(const vector<DMatch> &vDMatches, vector<pair<int, int> > &vMatches)
 {
@@ -194,7 +244,7 @@ void GMSMatcher::convertMatches(const vector<DMatch> &vDMatches, vector<pair<int
         vMatches[i] = pair<int, int>(vDMatches[i].queryIdx, vDMatches[i].trainIdx);
 }
 
-int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
+int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type) const
 {
     int x = 0, y = 0;
 
@@ -225,78 +275,66 @@ int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
     return x + y * mGridSizeLeft.width;
 }
 
-int GMSMatcher::getGridIndexRight(const Point2f &pt)
+int GMSMatcher::getGridIndexRight(const Point2f &pt, const Size &gridSize)
 {
-    int x = cvFloor(pt.x * mGridSizeRight.width);
-    int y = cvFloor(pt.y * mGridSizeRight.height);
+    int x = cvFloor(pt.x * gridSize.width);
+    int y = cvFloor(pt.y * gridSize.height);
 
-    return x + y * mGridSizeRight.width;
+    return x + y * gridSize.width;
 }
 
 int GMSMatcher::getInlierMask(vector<bool> &vbInliers, const bool withRotation, const bool withScale)
 {
-    int max_inlier = 0;
+    const int numberScales = withScale ? 5 : 1;
+    const int numberRotations = withRotation ? 8 : 1;
+    const int numberHypotheses = numberScales * numberRotations;
 
-    if (!withScale && !withRotation)
-    {
-        setScale(0);
-        max_inlier = run(1);
-        vbInliers = mvbInlierMask;
-        return max_inlier;
-    }
+    for (int scale = 0; scale < numberScales; scale++)
+        setScale(scale);
 
-    if (withRotation && withScale)
+    // The motion statistics depend on the scale and the grid type only, they are shared by the rotations
+    parallel_for_(Range(0, numberScales * 4), [&](const Range& range)
     {
-        for (int scale = 0; scale < 5; scale++)
+        for (int job = range.start; job < range.end; job++)
         {
-            setScale(scale);
-            for (int rotationType = 1; rotationType <= 8; rotationType++)
-            {
-                int num_inlier = run(rotationType);
-
-                if (num_inlier > max_inlier)
-                {
-                    vbInliers = mvbInlierMask;
-                    max_inlier = num_inlier;
-                }
-            }
+            ScaleGrid &grid = mScaleGrids[job / 4];
+            const int gridType = job % 4 + 1;
+            grid.motionStatistics[gridType - 1].build(mvLeftIndex[gridType - 1], grid.rightIndex,
+                                                      mGridNumberLeft, grid.gridNumber);
         }
-        return max_inlier;
-    }
+    });
 
-    if (withRotation && !withScale)
+    // The hypotheses are evaluated concurrently
+    vector<vector<uchar> > inlierMasks(numberHypotheses);
+    vector<int> numberInliers(numberHypotheses, 0);
+    parallel_for_(Range(0, numberHypotheses), [&](const Range& range)
     {
-        setScale(0);
-        for (int rotationType = 1; rotationType <= 8; rotationType++)
-        {
-            int num_inlier = run(rotationType);
+        vector<int> cellPairs;
+        for (int h = range.start; h < range.end; h++)
+            numberInliers[h] = run(h / numberRotations, h % numberRotations + 1, cellPairs, inlierMasks[h]);
+    });
 
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
-        }
-        return max_inlier;
+    if (numberHypotheses == 1)
+    {
+        vbInliers.assign(inlierMasks[0].begin(), inlierMasks[0].end());
+        return numberInliers[0];
     }
 
-    if (!withRotation && withScale)
+    // Keep the first hypothesis with the most inliers, in the scale then rotation order
+    int max_inlier = 0;
+    int best = -1;
+    for (int h = 0; h < numberHypotheses; h++)
     {
-        for (int scale = 0; scale < 5; scale++)
+        if (numberInliers[h] > max_inlier)
         {
-            setScale(scale);
-            int num_inlier = run(1);
-
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
-
+            best = h;
+            max_inlier = numberInliers[h];
         }
-        return max_inlier;
     }
 
+    if (best >= 0)
+        vbInliers.assign(inlierMasks[best].begin(), inlierMasks[best].end());
+
     return max_inlier;
 }
 
@@ -349,74 +387,72 @@ void GMSMatcher::normalizePoints(const vector<KeyPoint> &kp, const Size &size, v
     }
 }
 
-int GMSMatcher::run(const int rotationType)
+int GMSMatcher::run(const int scale, const int rotationType, vector<int> &cellPairs, vector<uchar> &inlierMask) const
 {
-    mvbInlierMask.assign(mNumberMatches, false);
-
-    // Initialize Motion Statisctics
-    mMotionStatistics = Mat::zeros(mGridNumberLeft, mGridNumberRight, CV_32SC1);
-    mvMatchPairs.assign(mNumberMatches, pair<int, int>(0, 0));
+    const ScaleGrid &grid = mScaleGrids[scale];
+    inlierMask.assign(mNumberMatches, 0);
 
     for (int gridType = 1; gridType <= 4; gridType++)
     {
-        // initialize
-        mMotionStatistics.setTo(0);
-        mCellPairs.assign(mGridNumberLeft, -1);
-        mNumberPointsInPerCellLeft.assign(mGridNumberLeft, 0);
-
-        assignMatchPairs(gridType);
-        verifyCellPairs(rotationType);
+        verifyCellPairs(grid, gridType, rotationType, cellPairs);
 
         // Mark inliers
+        const vector<int> &leftIndex = mvLeftIndex[gridType - 1];
         for (size_t i = 0; i < mNumberMatches; i++)
         {
-            if (mvMatchPairs[i].first >= 0 && mCellPairs[mvMatchPairs[i].first] == mvMatchPairs[i].second)
-                mvbInlierMask[i] = true;
+            if (leftIndex[i] >= 0 && cellPairs[leftIndex[i]] == grid.rightIndex[i])
+                inlierMask[i] = 1;
         }
     }
 
-    return (int) count(mvbInlierMask.begin(), mvbInlierMask.end(), true); //number of inliers
+    return (int) count(inlierMask.begin(), inlierMask.end(), (uchar) 1); //number of inliers
 }
 
 void GMSMatcher::setScale(const int scale)
 {
+    ScaleGrid &grid = mScaleGrids[scale];
+
     // Set Scale
-    mGridSizeRight.width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
-    mGridSizeRight.height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
-    mGridNumberRight = mGridSizeRight.width * mGridSizeRight.height;
+    grid.gridSize.width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
+    grid.gridSize.height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
+    grid.gridNumber = grid.gridSize.width * grid.gridSize.height;
 
     // Initialize the neighbor of right grid
-    mGridNeighborRight = Mat::zeros(mGridNumberRight, 9, CV_32SC1);
-    initalizeNeighbors(mGridNeighborRight, mGridSizeRight);
+    grid.gridNeighbor = Mat::zeros(grid.gridNumber, 9, CV_32SC1);
+    initalizeNeighbors(grid.gridNeighbor, grid.gridSize);
+
+    grid.rightIndex.resize(mNumberMatches);
+    for (size_t i = 0; i < mNumberMatches; i++)
+        grid.rightIndex[i] = getGridIndexRight(mvP2[mvMatches[i].second], grid.gridSize);
 }
 
-void GMSMatcher::verifyCellPairs(const int rotationType)
+void GMSMatcher::verifyCellPairs(const ScaleGrid &grid, const int gridType, const int rotationType, vector<int> &cellPairs) const
 {
+    const CellPairHistogram &motionStatistics = grid.motionStatistics[gridType - 1];
     const int *CurrentRP = mRotationPatterns[rotationType - 1];
 
+    cellPairs.assign(mGridNumberLeft, -1);
+
     for (int i = 0; i < mGridNumberLeft; i++)
     {
-        if (sum(mMotionStatistics.row(i))[0] == 0)
-        {
-            mCellPairs[i] = -1;
+        if (motionStatistics.pointsLeft[i] == 0)
             continue;
-        }
 
+        // The right cells are listed in increasing order, so the first maximum is kept
         int max_number = 0;
-        for (int j = 0; j < mGridNumberRight; j++)
+        for (int k = motionStatistics.cellStart[i]; k < motionStatistics.cellStart[i + 1]; k++)
         {
-            int *value = mMotionStatistics.ptr<int>(i);
-            if (value[j] > max_number)
+            if (motionStatistics.count[k] > max_number)
             {
-                mCellPairs[i] = j;
-                max_number = value[j];
+                cellPairs[i] = motionStatistics.rightCell[k];
+                max_number = motionStatistics.count[k];
             }
         }
 
-        int idx_grid_rt = mCellPairs[i];
+        int idx_grid_rt = cellPairs[i];
 
         const int *NB9_lt = mGridNeighborLeft.ptr<int>(i);
-        const int *NB9_rt = mGridNeighborRight.ptr<int>(idx_grid_rt);
+        const int *NB9_rt = grid.gridNeighbor.ptr<int>(idx_grid_rt);
 
         int score = 0;
         double thresh = 0;
@@ -429,15 +465,15 @@ void GMSMatcher::verifyCellPairs(const int rotationType)
             if (ll == -1 || rr == -1)
                 continue;
 
-            score += mMotionStatistics.at<int>(ll, rr);
-            thresh += mNumberPointsInPerCellLeft[ll];
+            score += motionStatistics.get(ll, rr);
+            thresh += motionStatistics.pointsLeft[ll];
             numpair++;
         }
 
         thresh = mThresholdFactor * std::sqrt(thresh / numpair);
 
         if (score < thresh)
-            mCellPairs[i] = -2;
+            cellPairs[i] = -2;
     }
 }
 
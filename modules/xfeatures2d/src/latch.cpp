@@ -47,6 +47,8 @@
 #include <algorithm>
 #include <vector>
 
+#include "opencv2/core/hal/intrin.hpp"
+
 #include <iostream>
 #include <iomanip>
 
@@ -87,10 +89,8 @@ namespace cv
             virtual void compute(InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors) CV_OVERRIDE;
 
         protected:
-            typedef void(*PixelTestFn)(const Mat& input_image, const std::vector<KeyPoint>& keypoints, OutputArray, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size);
             void setSamplingPoints();
             int bytes_;
-            PixelTestFn test_fn_;
             bool rotationInvariance_;
             int half_ssd_size_;
             double sigma_;
@@ -107,353 +107,169 @@ namespace cv
         {
             return (Feature2D::getDefaultName() + ".LATCH");
         }
-        void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size);
-
 
-        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        // Computes the offsets in the image of the three patches of every test, rotated by the keypoint
+        // orientation. Returns the largest horizontal offset.
+        static int computeTestOffsets(const std::vector<int> &points, int ntests, bool rotationInvariance, float cos_theta, float sin_theta, int step, int *offsets)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            int max_x = -INT_MAX;
+            for (int k = 0; k < ntests * 3; k++)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 1; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
-        }
+                int x = points[2 * k];
+                int y = points[2 * k + 1];
 
+                if (rotationInvariance){
+                    int x2 = (int)(((float)x)*cos_theta - ((float)y)*sin_theta);
+                    int y2 = (int)(((float)x)*sin_theta + ((float)y)*cos_theta);
 
-        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 2; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
+                    x = std::min(std::max(x2, -24), 24);
+                    y = std::min(std::max(y2, -24), 24);
                 }
-            }
-        }
-
 
-        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 4; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
+                offsets[k] = y * step + x;
+                max_x = std::max(max_x, x);
             }
+            return max_x;
         }
 
-
-
-        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        // Sums of the squared differences between the patches a and b, and c and b
+        static inline void patchSSD(const uchar *a, const uchar *b, const uchar *c, int step, int half_ssd_size, int &suma, int &sumc)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            int K = half_ssd_size;
+            suma = sumc = 0;
+            for (int iy = -K; iy <= K; iy++)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 8; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
-        }
+                const uchar * Mi_a = a + iy * step;
+                const uchar * Mi_b = b + iy * step;
+                const uchar * Mi_c = c + iy * step;
 
+                for (int ix = -K; ix <= K; ix++)
+                {
+                    int difa = Mi_a[ix] - Mi_b[ix];
+                    suma += difa * difa;
 
-        static void pixelTests16(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 16; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
+                    int difc = Mi_c[ix] - Mi_b[ix];
+                    sumc += difc * difc;
                 }
             }
         }
 
-
-        static void pixelTests32(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+#if CV_SIMD128
+        // Same as patchSSD, the rows of the patches are read by 8 pixels, up to 7 pixels past their right border
+        static inline void patchSSD_SIMD(const uchar *a, const uchar *b, const uchar *c, int step, int half_ssd_size, const v_int16x8 &tail_mask, int &suma, int &sumc)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            int K = half_ssd_size;
+            int width = 2 * K + 1;
+            v_int32x4 vsuma = v_setzero_s32(), vsumc = v_setzero_s32();
+            for (int iy = -K; iy <= K; iy++)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 32; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
+                const uchar * Mi_a = a + iy * step - K;
+                const uchar * Mi_b = b + iy * step - K;
+                const uchar * Mi_c = c + iy * step - K;
 
-                        count += 6;
-                    }
+                int ix = 0;
+                for (; ix <= width - 8; ix += 8)
+                {
+                    v_int16x8 vb = v_reinterpret_as_s16(v_load_expand(Mi_b + ix));
+                    v_int16x8 difa = v_reinterpret_as_s16(v_load_expand(Mi_a + ix)) - vb;
+                    v_int16x8 difc = v_reinterpret_as_s16(v_load_expand(Mi_c + ix)) - vb;
+                    vsuma += v_dotprod(difa, difa);
+                    vsumc += v_dotprod(difc, difc);
                 }
-            }
-        }
-
-
-        static void pixelTests64(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 64; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
+                if (ix < width)
+                {
+                    v_int16x8 vb = v_reinterpret_as_s16(v_load_expand(Mi_b + ix));
+                    v_int16x8 difa = (v_reinterpret_as_s16(v_load_expand(Mi_a + ix)) - vb) & tail_mask;
+                    v_int16x8 difc = (v_reinterpret_as_s16(v_load_expand(Mi_c + ix)) - vb) & tail_mask;
+                    vsuma += v_dotprod(difa, difa);
+                    vsumc += v_dotprod(difc, difc);
                 }
             }
+            suma = v_reduce_sum(vsuma);
+            sumc = v_reduce_sum(vsumc);
         }
+#endif
 
-        void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size)
-
+        // Computes the descriptors of the keypoints in parallel, bit j of byte ix is the test 8 * ix + 7 - j
+        static void pixelTests(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
         {
-            int ax = points[count];
-            int ay = points[count + 1];
-
-            int	bx = points[count + 2];
-            int	by = points[count + 3];
-
-            int cx = points[count + 4];
-            int cy = points[count + 5];
-
-            int ax2 = ax;
-            int ay2 = ay;
-            int bx2 = bx;
-            int by2 = by;
-            int cx2 = cx;
-            int cy2 = cy;
-
-            if (rotationInvariance){
-
-
-                ax2 =(int)(((float)ax)*cos_theta - ((float)ay)*sin_theta);
-                ay2 = (int)(((float)ax)*sin_theta + ((float)ay)*cos_theta);
-                bx2 = (int)(((float)bx)*cos_theta - ((float)by)*sin_theta);
-                by2 = (int)(((float)bx)*sin_theta + ((float)by)*cos_theta);
-                cx2 = (int)(((float)cx)*cos_theta - ((float)cy)*sin_theta);
-                cy2 = (int)(((float)cx)*sin_theta + ((float)cy)*cos_theta);
-
-
-                if (ax2 > 24)
-                    ax2 = 24;
-                if (ax2<-24)
-                    ax2 = -24;
-
-                if (ay2>24)
-                    ay2 = 24;
-                if (ay2<-24)
-                    ay2 = -24;
-
-                if (bx2>24)
-                    bx2 = 24;
-                if (bx2<-24)
-                    bx2 = -24;
-
-                if (by2>24)
-                    by2 = 24;
-                if (by2<-24)
-                    by2 = -24;
-
-                if (cx2>24)
-                    cx2 = 24;
-                if (cx2<-24)
-                    cx2 = -24;
-
-                if (cy2>24)
-                    cy2 = 24;
-                if (cy2 < -24)
-                    cy2 = -24;
-
-            }
-
-
-            ax2 += (int)(pt.pt.x + 0.5);
-            ay2 += (int)(pt.pt.y + 0.5);
-
-            bx2 += (int)(pt.pt.x + 0.5);
-            by2 += (int)(pt.pt.y + 0.5);
-
-            cx2 += (int)(pt.pt.x + 0.5);
-            cy2 += (int)(pt.pt.y + 0.5);
-
-
-            int K = half_ssd_size;
-            for (int iy = -K; iy <= K; iy++)
+            const int bytes = descriptors.cols;
+            const int ntests = bytes * 8;
+            const int step = (int)grayImage.step;
+            const int K = half_ssd_size;
+
+#if CV_SIMD128
+            // the lanes of the last chunk of 8 pixels past the patch width are masked
+            const int width = 2 * K + 1;
+            const int simd_width = alignSize(width, 8);
+            short tail[8];
+            for (int k = 0; k < 8; k++)
+                tail[k] = (short)(k < width % 8 ? -1 : 0);
+            const v_int16x8 tail_mask = v_load(tail);
+#endif
+
+            parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
             {
-                const uchar * Mi_a = grayImage.ptr<uchar>(ay2 + iy);
-                const uchar * Mi_b = grayImage.ptr<uchar>(by2 + iy);
-                const uchar * Mi_c = grayImage.ptr<uchar>(cy2 + iy);
+                AutoBuffer<int> _offsets(ntests * 3);
+                int *offsets = _offsets.data();
 
-                for (int ix = -K; ix <= K; ix++)
+                for (int i = range.start; i < range.end; ++i)
                 {
-                    double difa = Mi_a[ax2 + ix] - Mi_b[bx2 + ix];
-                    suma += (int)((difa)*(difa));
-
-                    double difc = Mi_c[cx2 + ix] - Mi_b[bx2 + ix];
-                    sumc += (int)((difc)*(difc));
+                    uchar* desc = descriptors.ptr(i);
+                    const KeyPoint& pt = keypoints[i];
+
+                    //handling keypoint orientation
+                    float angle = pt.angle;
+                    angle *= (float)(CV_PI / 180.f);
+                    float cos_theta = cos(angle);
+                    float sin_theta = sin(angle);
+
+                    // the rotated offsets are shared by all the tests of the keypoint
+                    int max_x = computeTestOffsets(points, ntests, rotationInvariance, cos_theta, sin_theta, step, offsets);
+
+                    int x = (int)(pt.pt.x + 0.5);
+                    int y = (int)(pt.pt.y + 0.5);
+                    const uchar *center = grayImage.ptr<uchar>(y) + x;
+
+#if CV_SIMD128
+                    // the chunks read past the patches must stay in the image rows
+                    bool useSIMD = x + max_x - K + simd_width <= grayImage.cols;
+#else
+                    CV_UNUSED(max_x);
+#endif
+
+                    for (int ix = 0; ix < bytes; ix++){
+                        desc[ix] = 0;
+                        for (int j = 7; j >= 0; j--){
+                            const int *test = offsets + (ix * 8 + 7 - j) * 3;
+
+                            int suma = 0;
+                            int sumc = 0;
+
+#if CV_SIMD128
+                            if (useSIMD)
+                                patchSSD_SIMD(center + test[0], center + test[1], center + test[2], step, K, tail_mask, suma, sumc);
+                            else
+#endif
+                                patchSSD(center + test[0], center + test[1], center + test[2], step, K, suma, sumc);
+                            desc[ix] += (uchar)((suma < sumc) << j);
+                        }
+                    }
                 }
-            }
-
+            });
         }
 
 
-
         void LATCHDescriptorExtractorImpl::setBytes(int bytes)
         {
-          switch (bytes)
-          {
-          case 1:
-              test_fn_ = pixelTests1;
-              break;
-          case 2:
-              test_fn_ = pixelTests2;
-              break;
-          case 4:
-              test_fn_ = pixelTests4;
-              break;
-          case 8:
-              test_fn_ = pixelTests8;
-              break;
-          case 16:
-              test_fn_ = pixelTests16;
-              break;
-          case 32:
-              test_fn_ = pixelTests32;
-              break;
-          case 64:
-              test_fn_ = pixelTests64;
-              break;
-          default:
+          if (bytes != 1 && bytes != 2 && bytes != 4 && bytes != 8 && bytes != 16 && bytes != 32 && bytes != 64)
               CV_Error(Error::StsBadArg, "descriptorSize must be 1,2, 4, 8, 16, 32, or 64");
-          }
           bytes_ = bytes;
           setSamplingPoints();
         }
 
         LATCHDescriptorExtractorImpl::LATCHDescriptorExtractorImpl(int bytes, bool rotationInvariance, int half_ssd_size, double sigma) :
-            bytes_(bytes), test_fn_(NULL), rotationInvariance_(rotationInvariance), half_ssd_size_(half_ssd_size), sigma_(sigma)
+            bytes_(bytes), rotationInvariance_(rotationInvariance), half_ssd_size_(half_ssd_size), sigma_(sigma)
         {
             setBytes(bytes_);
         }
@@ -557,7 +373,7 @@ namespace cv
             //Mat descriptors = _descriptors.getMat();
 
 
-            test_fn_(grayImage, keypoints, descriptors, sampling_points_, rotationInvariance_, half_ssd_size_);
+            pixelTests(grayImage, keypoints, descriptors, sampling_points_, rotationInvariance_, half_ssd_size_);
         }
 
 
@@ -64,6 +64,8 @@ References:
 #ifdef __cplusplus
 #include "constants.hpp"
 
+#include "opencv2/core/hal/intrin.hpp"
+
 namespace cv
 {
     namespace xfeatures2d
@@ -207,6 +209,168 @@ namespace cv
                 }
                 CV_Error(Error::StsBadArg, "Distance function not implemented!");
             }
+
+
+            /**
+            * @brief Distance functions split into the accumulation of one dimension and the final step,
+            *       so that they can be evaluated for several centroids at once.
+            *       The results are the same as those of the distance functions above.
+            */
+            struct DistanceL0_25
+            {
+                static inline float accumulate(float result, float difference) { return result + std::sqrt(std::sqrt(std::abs(difference))); }
+                static inline float finish(float result) { result *= result; return result * result; }
+#if CV_SIMD128
+                static inline v_float32x4 accumulate(const v_float32x4& result, const v_float32x4& difference) { return result + v_sqrt(v_sqrt(v_abs(difference))); }
+                static inline v_float32x4 finish(v_float32x4 result) { result = result * result; return result * result; }
+#endif
+            };
+
+            struct DistanceL0_5
+            {
+                static inline float accumulate(float result, float difference) { return result + std::sqrt(std::abs(difference)); }
+                static inline float finish(float result) { return result * result; }
+#if CV_SIMD128
+                static inline v_float32x4 accumulate(const v_float32x4& result, const v_float32x4& difference) { return result + v_sqrt(v_abs(difference)); }
+                static inline v_float32x4 finish(const v_float32x4& result) { return result * result; }
+#endif
+            };
+
+            struct DistanceL1
+            {
+                static inline float accumulate(float result, float difference) { return result + std::abs(difference); }
+                static inline float finish(float result) { return result; }
+#if CV_SIMD128
+                static inline v_float32x4 accumulate(const v_float32x4& result, const v_float32x4& difference) { return result + v_abs(difference); }
+                static inline v_float32x4 finish(const v_float32x4& result) { return result; }
+#endif
+            };
+
+            struct DistanceL2
+            {
+                static inline float accumulate(float result, float difference) { return result + difference * difference; }
+                static inline float finish(float result) { return std::sqrt(result); }
+#if CV_SIMD128
+                static inline v_float32x4 accumulate(const v_float32x4& result, const v_float32x4& difference) { return result + difference * difference; }
+                static inline v_float32x4 finish(const v_float32x4& result) { return v_sqrt(result); }
+#endif
+            };
+
+            struct DistanceL2Squared
+            {
+                static inline float accumulate(float result, float difference) { return result + difference * difference; }
+                static inline float finish(float result) { return result; }
+#if CV_SIMD128
+                static inline v_float32x4 accumulate(const v_float32x4& result, const v_float32x4& difference) { return result + difference * difference; }
+                static inline v_float32x4 finish(const v_float32x4& result) { return result; }
+#endif
+            };
+
+            struct DistanceL5
+            {
+                static inline float accumulate(float result, float difference)
+                {
+                    return result + std::abs(difference) * difference * difference * difference * difference;
+                }
+                static inline float finish(float result) { return std::pow(result, (float)0.2); }
+#if CV_SIMD128
+                static inline v_float32x4 accumulate(const v_float32x4& result, const v_float32x4& difference)
+                {
+                    return result + v_abs(difference) * difference * difference * difference * difference;
+                }
+                static inline v_float32x4 finish(const v_float32x4& result)
+                {
+                    float buf[4];
+                    v_store(buf, result);
+                    for (int k = 0; k < 4; k++)
+                    {
+                        buf[k] = finish(buf[k]);
+                    }
+                    return v_load(buf);
+                }
+#endif
+            };
+
+            struct DistanceLInfinity
+            {
+                static inline float accumulate(float result, float difference) { return difference > result ? difference : result; }
+                static inline float finish(float result) { return result; }
+#if CV_SIMD128
+                static inline v_float32x4 accumulate(const v_float32x4& result, const v_float32x4& difference) { return v_max(result, difference); }
+                static inline v_float32x4 finish(const v_float32x4& result) { return result; }
+#endif
+            };
+
+
+            template <typename Distance>
+            static inline void computeDistancesT(
+                const float* point,
+                const float* centroids, int count,
+                float* distances)
+            {
+                int j = 0;
+#if CV_SIMD128
+                v_float32x4 vpoint[SIGNATURE_DIMENSION];
+                for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                {
+                    vpoint[d] = v_setall_f32(point[d]);
+                }
+                for (; j <= count - 4; j += 4)
+                {
+                    v_float32x4 result = v_setzero_f32();
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        result = Distance::accumulate(result, v_load(centroids + d * count + j) - vpoint[d]);
+                    }
+                    v_store(distances + j, Distance::finish(result));
+                }
+#endif
+                for (; j < count; j++)
+                {
+                    float result = (float)0.0;
+                    for (int d = 1; d < SIGNATURE_DIMENSION; ++d)
+                    {
+                        result = Distance::accumulate(result, centroids[d * count + j] - point[d]);
+                    }
+                    distances[j] = Distance::finish(result);
+                }
+            }
+
+
+            /**
+            * @brief Computes distances between one point and a list of centroids using given distance function.
+            * @param distanceFunction Distance function selector.
+            * @param point The point - SIGNATURE_DIMENSION values, the first one is the weight.
+            * @param centroids The list of centroids transposed (one centroid in each column),
+            *       dimension d of centroid j is at centroids[d * count + j].
+            * @param count Number of centroids.
+            * @param distances Output distances, distances[j] == computeDistance(centroids, j, point).
+            */
+            static inline void computeDistances(
+                const int distanceFunction,
+                const float* point,
+                const float* centroids, int count,
+                float* distances)
+            {
+                switch (distanceFunction)
+                {
+                case PCTSignatures::L0_25:
+                    return computeDistancesT<DistanceL0_25>(point, centroids, count, distances);
+                case PCTSignatures::L0_5:
+                    return computeDistancesT<DistanceL0_5>(point, centroids, count, distances);
+                case PCTSignatures::L1:
+                    return computeDistancesT<DistanceL1>(point, centroids, count, distances);
+                case PCTSignatures::L2:
+                    return computeDistancesT<DistanceL2>(point, centroids, count, distances);
+                case PCTSignatures::L2SQUARED:
+                    return computeDistancesT<DistanceL2Squared>(point, centroids, count, distances);
+                case PCTSignatures::L5:
+                    return computeDistancesT<DistanceL5>(point, centroids, count, distances);
+                case PCTSignatures::L_INFINITY:
+                    return computeDistancesT<DistanceLInfinity>(point, centroids, count, distances);
+                }
+                CV_Error(Error::StsBadArg, "Distance function not implemented!");
+            }
         }
     }
 }
@@ -141,7 +141,8 @@ namespace cv
 
 
                     // Main iterations cycle. Our implementation has fixed number of iterations.
-                    for (int iteration = 0; iteration < mIterationCount; iteration++)
+                    std::vector<int> closest(samples.rows);
+                    for (int iteration = 0; iteration < mIterationCount && clusters.rows > 0; iteration++)
                     {
                         // Prepare space for new centroid values.
                         Mat tmpCentroids(clusters.size(), clusters.type());
@@ -151,9 +152,10 @@ namespace cv
                         clusters(Rect(WEIGHT_IDX, 0, 1, clusters.rows)).setTo(cv::Scalar::all(0));
 
                         // Compute affiliation of points and sum new coordinates for centroids.
+                        findClosestClusters(clusters, samples, closest);
                         for (int iSample = 0; iSample < samples.rows; iSample++)
                         {
-                            int iClosest = findClosestCluster(clusters, samples, iSample);
+                            int iClosest = closest[iSample];
                             for (int iDimension = 1; iDimension < SIGNATURE_DIMENSION; iDimension++)
                             {
                                 tmpCentroids.at<float>(iClosest, iDimension) += samples.at<float>(iSample, iDimension);
@@ -269,27 +271,41 @@ namespace cv
 
 
                 /**
-                * @brief Find closest cluster to selected point.
+                * @brief Find closest cluster to each of the points, in parallel.
+                *       The sums of the coordinates are then accumulated in the order of the points,
+                *       so the centroids do not depend on the number of threads.
                 * @param clusters List of cluster centroids.
                 * @param points List of points.
-                * @param pointIdx Index to the list of points (the point for which the closest cluster is being found).
-                * @return Index to clusters list pointing at the closest cluster.
+                * @param closest Output index to clusters list of the closest cluster, for each point.
                 */
-                int findClosestCluster(const Mat& clusters, const Mat& points, const int pointIdx) const    // HOT PATH: 35%
+                void findClosestClusters(const Mat& clusters, const Mat& points, std::vector<int>& closest) const    // HOT PATH: 35%
                 {
-                    int iClosest = 0;
-                    float minDistance = computeDistance(mDistanceFunction, clusters, 0, points, pointIdx);
+                    // one centroid in each column, the distances to all of them are computed at once
+                    Mat centroids;
+                    transpose(clusters, centroids);
 
-                    for (int iCluster = 1; iCluster < clusters.rows; iCluster++)
+                    parallel_for_(Range(0, points.rows), [&](const Range& range)
                     {
-                        float distance = computeDistance(mDistanceFunction, clusters, iCluster, points, pointIdx);
-                        if (distance < minDistance)
+                        AutoBuffer<float> _distances(clusters.rows);
+                        float* distances = _distances.data();
+
+                        for (int pointIdx = range.start; pointIdx < range.end; pointIdx++)
                         {
-                            iClosest = iCluster;
-                            minDistance = distance;
+                            computeDistances(mDistanceFunction, points.ptr<float>(pointIdx), centroids.ptr<float>(), clusters.rows, distances);
+
+                            int iClosest = 0;
+                            float minDistance = distances[0];
+                            for (int iCluster = 1; iCluster < clusters.rows; iCluster++)
+                            {
+                                if (distances[iCluster] < minDistance)
+                                {
+                                    iClosest = iCluster;
+                                    minDistance = distances[iCluster];
+                                }
+                            }
+                            closest[pointIdx] = iClosest;
                         }
-                    }
-                    return iClosest;
+                    });
                 }
 
 
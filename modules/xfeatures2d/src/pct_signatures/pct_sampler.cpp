@@ -198,8 +198,25 @@ namespace cv
                     Mat image = _image.getMat();
                     _samples.create((int)(mInitSamplingPoints.size()), SIGNATURE_DIMENSION, CV_32F);
                     Mat samples = _samples.getMat();
+                    if (samples.empty())
+                    {
+                        return;
+                    }
                     GrayscaleBitmap grayscaleBitmap(image, mGrayscaleBits);
 
+                    // gather the pixels of all the sample points and convert them to Lab at once
+                    Mat rgbPixels(1, samples.rows, image.type());
+                    const size_t pixelSize = image.elemSize();
+                    for (int iSample = 0; iSample < samples.rows; iSample++)
+                    {
+                        int x = (int)(mInitSamplingPoints[iSample].x * (image.cols));
+                        int y = (int)(mInitSamplingPoints[iSample].y * (image.rows));
+                        memcpy(rgbPixels.ptr(0, iSample), image.ptr(y, x), pixelSize);
+                    }
+                    Mat labPixels;
+                    rgbPixels.convertTo(rgbPixels, CV_32FC3, 1.0 / 255);
+                    cvtColor(rgbPixels, labPixels, COLOR_BGR2Lab);
+
                     // sample each sample point
                     for (int iSample = 0; iSample < (int)(mInitSamplingPoints.size()); iSample++)
                     {
@@ -212,11 +229,7 @@ namespace cv
                         samples.at<float>(iSample, Y_IDX) = (float)((float)y / (float)image.rows * mWeights[Y_IDX] + mTranslations[Y_IDX]);
 
                         // get Lab pixel color
-                        Mat rgbPixel(image, Rect(x, y, 1, 1));
-                        Mat labPixel;
-                        rgbPixel.convertTo(rgbPixel, CV_32FC3, 1.0 / 255);
-                        cvtColor(rgbPixel, labPixel, COLOR_BGR2Lab);
-                        Vec3f labColor = labPixel.at<Vec3f>(0, 0);
+                        Vec3f labColor = labPixels.at<Vec3f>(0, iSample);
 
                         // Lab color normalized
                         samples.at<float>(iSample, L_IDX) = (float)(std::floor(labColor[0] + 0.5) / L_COLOR_RANGE * mWeights[L_IDX] + mTranslations[L_IDX]);
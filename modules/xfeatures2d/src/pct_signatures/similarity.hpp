@@ -120,6 +120,58 @@ namespace cv
                 }
                 CV_Error(Error::StsNotImplemented, "Similarity function not implemented!");
             }
+
+
+            /**
+            * @brief Computes similarities between one point and a list of centroids.
+            * @param centroids The list of centroids transposed (one centroid in each column),
+            *       see computeDistances.
+            * @param similarities Output similarities, similarities[j] == computeSimilarity(centroids, j, point).
+            */
+            static inline void computeSimilarities(
+                const int distancefunction,
+                const int similarity,
+                const float similarityParameter,
+                const float* point,
+                const float* centroids, int count,
+                float* similarities)
+            {
+                computeDistances(distancefunction, point, centroids, count, similarities);
+
+                int j = 0;
+                switch (similarity)
+                {
+                case PCTSignatures::MINUS:
+                    for (; j < count; j++)
+                    {
+                        similarities[j] = -similarities[j];
+                    }
+                    return;
+                case PCTSignatures::GAUSSIAN:
+                    for (; j < count; j++)
+                    {
+                        float distance = similarities[j];
+                        similarities[j] = exp(-similarityParameter * distance * distance);
+                    }
+                    return;
+                case PCTSignatures::HEURISTIC:
+                {
+#if CV_SIMD128
+                    v_float32x4 vone = v_setall_f32(1.f), valpha = v_setall_f32(similarityParameter);
+                    for (; j <= count - 4; j += 4)
+                    {
+                        v_store(similarities + j, vone / (valpha + v_load(similarities + j)));
+                    }
+#endif
+                    for (; j < count; j++)
+                    {
+                        similarities[j] = 1 / (similarityParameter + similarities[j]);
+                    }
+                    return;
+                }
+                }
+                CV_Error(Error::StsNotImplemented, "Similarity function not implemented!");
+            }
         }
     }
 }
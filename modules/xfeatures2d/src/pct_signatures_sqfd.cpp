@@ -91,33 +91,81 @@ namespace cv
                     const std::vector<Mat>& imageSignatures,
                     std::vector<float>& distances) const CV_OVERRIDE;
 
+                void computeQuadraticFormDistanceMatrix(
+                    const std::vector<Mat>& querySignatures,
+                    const std::vector<Mat>& imageSignatures,
+                    OutputArray distances) const CV_OVERRIDE;
+
+
+                /**
+                * @brief Computes the sum of weighted similarities over all pairs of centroids of two signatures.
+                * @param centroids0 The first signature transposed (one centroid in each column).
+                * @param signature1 The second signature.
+                * @param similarities Buffer for centroids0.cols similarities.
+                */
+                float computePartialSQFD(
+                    const Mat& centroids0,
+                    const Mat& signature1,
+                    float* similarities) const;
+
+                /**
+                * @brief Computes the SQFD of two signatures given the partial SQFDs of each of them with itself.
+                */
+                float computeSQFD(
+                    const Mat& centroids0, float partialSQFD0,
+                    const Mat& signature1, float partialSQFD1,
+                    float* similarities) const
+                {
+                    float result = 0;
+                    result += partialSQFD0;
+                    result += partialSQFD1;
+                    result -= computePartialSQFD(centroids0, signature1, similarities) * 2;
+
+                    return sqrt(result);
+                }
 
             private:
                 int mDistanceFunction;
                 int mSimilarityFunction;
                 float mSimilarityParameter;
 
-                float computePartialSQFD(
-                    const Mat& signature0,
-                    const Mat& signature1) const;
-
             };
 
 
+            static void checkSignature(const Mat& signature)
+            {
+                if (signature.cols != SIGNATURE_DIMENSION)
+                {
+                    CV_Error_(Error::StsBadArg, ("Signature dimension must be %d!", SIGNATURE_DIMENSION));
+                }
+
+                if (signature.rows <= 0)
+                {
+                    CV_Error(Error::StsBadArg, "Signature count must be greater than 0!");
+                }
+
+                CV_Assert(signature.type() == CV_32FC1);
+            }
+
+
             /**
             * @brief Class implementing parallel computing of SQFD distance for multiple images.
             */
             class Parallel_computeSQFDs : public ParallelLoopBody
             {
             private:
-                const PCTSignaturesSQFD* mPctSignaturesSQFDAlgorithm;
+                const PCTSignaturesSQFD_Impl* mPctSignaturesSQFDAlgorithm;
                 const Mat* mSourceSignature;
                 const std::vector<Mat>* mImageSignatures;
                 std::vector<float>* mDistances;
 
+                Mat mSourceCentroids;
+                float mSourcePartialSQFD;
+                int mMaxSignatureSize;
+
             public:
                 Parallel_computeSQFDs(
-                    const PCTSignaturesSQFD* pctSignaturesSQFDAlgorithm,
+                    const PCTSignaturesSQFD_Impl* pctSignaturesSQFDAlgorithm,
                     const Mat* sourceSignature,
                     const std::vector<Mat>* imageSignatures,
                     std::vector<float>* distances)
@@ -127,24 +175,171 @@ namespace cv
                     mDistances(distances)
                 {
                     mDistances->resize(imageSignatures->size());
-                }
+                    mSourcePartialSQFD = 0;
+                    mMaxSignatureSize = 0;
+                    if (imageSignatures->empty())
+                    {
+                        return;
+                    }
 
-                void operator()(const Range& range) const CV_OVERRIDE
-                {
                     if (mSourceSignature->empty())
                     {
                         CV_Error(Error::StsBadArg, "Source signature is empty!");
                     }
+                    checkSignature(*mSourceSignature);
+
+                    mMaxSignatureSize = mSourceSignature->rows;
+                    for (size_t i = 0; i < imageSignatures->size(); i++)
+                    {
+                        mMaxSignatureSize = std::max(mMaxSignatureSize, (*imageSignatures)[i].rows);
+                    }
+
+                    // the part of the distances depending only on the source signature is computed once
+                    AutoBuffer<float> similarities(mMaxSignatureSize);
+                    transpose(*mSourceSignature, mSourceCentroids);
+                    mSourcePartialSQFD = mPctSignaturesSQFDAlgorithm->computePartialSQFD(
+                        mSourceCentroids, *mSourceSignature, similarities.data());
+                }
+
+                void operator()(const Range& range) const CV_OVERRIDE
+                {
+                    AutoBuffer<float> similarities(mMaxSignatureSize);
+                    Mat centroids;
 
                     for (int i = range.start; i < range.end; i++)
                     {
-                        if (mImageSignatures[i].empty())
+                        const Mat& imageSignature = (*mImageSignatures)[i];
+                        if (imageSignature.empty())
                         {
                             CV_Error_(Error::StsBadArg, ("Signature ID: %d is empty!", i));
                         }
+                        checkSignature(imageSignature);
+
+                        transpose(imageSignature, centroids);
+                        float partialSQFD = mPctSignaturesSQFDAlgorithm->computePartialSQFD(
+                            centroids, imageSignature, similarities.data());
+
+                        (*mDistances)[i] = mPctSignaturesSQFDAlgorithm->computeSQFD(
+                            mSourceCentroids, mSourcePartialSQFD, imageSignature, partialSQFD, similarities.data());
+                    }
+                }
+            };
+
+
+            /**
+            * @brief Class implementing parallel computing of the partial SQFD of signatures with themselves.
+            *       The signatures are transposed on the way when centroids is not NULL.
+            */
+            class Parallel_computePartialSQFDs : public ParallelLoopBody
+            {
+            private:
+                const PCTSignaturesSQFD_Impl* mPctSignaturesSQFDAlgorithm;
+                const std::vector<Mat>* mSignatures;
+                std::vector<float>* mPartialSQFDs;
+                std::vector<Mat>* mCentroids;
+                int mMaxSignatureSize;
+
+            public:
+                Parallel_computePartialSQFDs(
+                    const PCTSignaturesSQFD_Impl* pctSignaturesSQFDAlgorithm,
+                    const std::vector<Mat>* signatures,
+                    std::vector<float>* partialSQFDs,
+                    std::vector<Mat>* centroids,
+                    int maxSignatureSize)
+                    : mPctSignaturesSQFDAlgorithm(pctSignaturesSQFDAlgorithm),
+                    mSignatures(signatures),
+                    mPartialSQFDs(partialSQFDs),
+                    mCentroids(centroids),
+                    mMaxSignatureSize(maxSignatureSize)
+                {
+                    mPartialSQFDs->resize(signatures->size());
+                    if (mCentroids)
+                    {
+                        mCentroids->resize(signatures->size());
+                    }
+                }
+
+                void operator()(const Range& range) const CV_OVERRIDE
+                {
+                    AutoBuffer<float> similarities(mMaxSignatureSize);
+                    Mat centroids;
+
+                    for (int i = range.start; i < range.end; i++)
+                    {
+                        Mat& signatureCentroids = mCentroids ? (*mCentroids)[i] : centroids;
+                        transpose((*mSignatures)[i], signatureCentroids);
+                        (*mPartialSQFDs)[i] = mPctSignaturesSQFDAlgorithm->computePartialSQFD(
+                            signatureCentroids, (*mSignatures)[i], similarities.data());
+                    }
+                }
+            };
+
+
+            /**
+            * @brief Class implementing parallel computing of the SQFD distance matrix by tiles.
+            *       The image signatures of a tile stay in cache while they are compared with all the queries
+            *       of the tile, and so do the transposed query signatures.
+            */
+            class Parallel_computeSQFDMatrix : public ParallelLoopBody
+            {
+            private:
+                const PCTSignaturesSQFD_Impl* mPctSignaturesSQFDAlgorithm;
+                const std::vector<Mat>* mQueryCentroids;
+                const std::vector<float>* mQueryPartialSQFDs;
+                const std::vector<Mat>* mImageSignatures;
+                const std::vector<float>* mImagePartialSQFDs;
+                Mat* mDistances;
+                int mMaxSignatureSize;
+                int mImageTiles;
+
+            public:
+                static const int QUERY_TILE_SIZE = 16;
+                static const int IMAGE_TILE_SIZE = 64;
+
+                Parallel_computeSQFDMatrix(
+                    const PCTSignaturesSQFD_Impl* pctSignaturesSQFDAlgorithm,
+                    const std::vector<Mat>* queryCentroids,
+                    const std::vector<float>* queryPartialSQFDs,
+                    const std::vector<Mat>* imageSignatures,
+                    const std::vector<float>* imagePartialSQFDs,
+                    Mat* distances,
+                    int maxSignatureSize)
+                    : mPctSignaturesSQFDAlgorithm(pctSignaturesSQFDAlgorithm),
+                    mQueryCentroids(queryCentroids),
+                    mQueryPartialSQFDs(queryPartialSQFDs),
+                    mImageSignatures(imageSignatures),
+                    mImagePartialSQFDs(imagePartialSQFDs),
+                    mDistances(distances),
+                    mMaxSignatureSize(maxSignatureSize)
+                {
+                    mImageTiles = divUp(distances->cols, IMAGE_TILE_SIZE);
+                }
+
+                int getTileCount() const
+                {
+                    return divUp(mDistances->rows, QUERY_TILE_SIZE) * mImageTiles;
+                }
 
-                        (*mDistances)[i] = mPctSignaturesSQFDAlgorithm->computeQuadraticFormDistance(
-                            *mSourceSignature, (*mImageSignatures)[i]);
+                void operator()(const Range& range) const CV_OVERRIDE
+                {
+                    AutoBuffer<float> similarities(mMaxSignatureSize);
+
+                    for (int tile = range.start; tile < range.end; tile++)
+                    {
+                        int queryStart = (tile / mImageTiles) * QUERY_TILE_SIZE;
+                        int queryEnd = std::min(queryStart + QUERY_TILE_SIZE, mDistances->rows);
+                        int imageStart = (tile % mImageTiles) * IMAGE_TILE_SIZE;
+                        int imageEnd = std::min(imageStart + IMAGE_TILE_SIZE, mDistances->cols);
+
+                        for (int i = imageStart; i < imageEnd; i++)
+                        {
+                            for (int q = queryStart; q < queryEnd; q++)
+                            {
+                                mDistances->at<float>(q, i) = mPctSignaturesSQFDAlgorithm->computeSQFD(
+                                    (*mQueryCentroids)[q], (*mQueryPartialSQFDs)[q],
+                                    (*mImageSignatures)[i], (*mImagePartialSQFDs)[i], similarities.data());
+                            }
+                        }
                     }
                 }
             };
@@ -163,23 +358,19 @@ namespace cv
                 Mat signature0 = _signature0.getMat();
                 Mat signature1 = _signature1.getMat();
 
-                if (signature0.cols != SIGNATURE_DIMENSION || signature1.cols != SIGNATURE_DIMENSION)
-                {
-                    CV_Error_(Error::StsBadArg, ("Signature dimension must be %d!", SIGNATURE_DIMENSION));
-                }
-
-                if (signature0.rows <= 0 || signature1.rows <= 0)
-                {
-                    CV_Error(Error::StsBadArg, "Signature count must be greater than 0!");
-                }
+                checkSignature(signature0);
+                checkSignature(signature1);
 
                 // compute sqfd
-                float result = 0;
-                result += computePartialSQFD(signature0, signature0);
-                result += computePartialSQFD(signature1, signature1);
-                result -= computePartialSQFD(signature0, signature1) * 2;
-
-                return sqrt(result);
+                AutoBuffer<float> similarities(std::max(signature0.rows, signature1.rows));
+                Mat centroids0, centroids1;
+                transpose(signature0, centroids0);
+                transpose(signature1, centroids1);
+
+                return computeSQFD(
+                    centroids0, computePartialSQFD(centroids0, signature0, similarities.data()),
+                    signature1, computePartialSQFD(centroids1, signature1, similarities.data()),
+                    similarities.data());
             }
 
             void PCTSignaturesSQFD_Impl::computeQuadraticFormDistances(
@@ -191,18 +382,86 @@ namespace cv
                     Parallel_computeSQFDs(this, &sourceSignature, &imageSignatures, &distances));
             }
 
+            void PCTSignaturesSQFD_Impl::computeQuadraticFormDistanceMatrix(
+                      const std::vector<Mat>& querySignatures,
+                      const std::vector<Mat>& imageSignatures,
+                      OutputArray _distances) const
+            {
+                int maxSignatureSize = 0;
+                for (size_t i = 0; i < querySignatures.size(); i++)
+                {
+                    if (querySignatures[i].empty())
+                    {
+                        CV_Error_(Error::StsBadArg, ("Query signature ID: %d is empty!", (int)i));
+                    }
+                    checkSignature(querySignatures[i]);
+                    maxSignatureSize = std::max(maxSignatureSize, querySignatures[i].rows);
+                }
+                for (size_t i = 0; i < imageSignatures.size(); i++)
+                {
+                    if (imageSignatures[i].empty())
+                    {
+                        CV_Error_(Error::StsBadArg, ("Signature ID: %d is empty!", (int)i));
+                    }
+                    checkSignature(imageSignatures[i]);
+                    maxSignatureSize = std::max(maxSignatureSize, imageSignatures[i].rows);
+                }
+
+                _distances.create((int)querySignatures.size(), (int)imageSignatures.size(), CV_32F);
+                Mat distances = _distances.getMat();
+                if (distances.empty())
+                {
+                    return;
+                }
+
+                // the queries are kept transposed, the partial SQFDs of the signatures with themselves
+                // are computed once for the whole matrix
+                std::vector<Mat> queryCentroids;
+                std::vector<float> queryPartialSQFDs, imagePartialSQFDs;
+                parallel_for_(Range(0, (int)querySignatures.size()),
+                    Parallel_computePartialSQFDs(this, &querySignatures, &queryPartialSQFDs, &queryCentroids, maxSignatureSize));
+                parallel_for_(Range(0, (int)imageSignatures.size()),
+                    Parallel_computePartialSQFDs(this, &imageSignatures, &imagePartialSQFDs, NULL, maxSignatureSize));
+
+                Parallel_computeSQFDMatrix body(this, &queryCentroids, &queryPartialSQFDs,
+                    &imageSignatures, &imagePartialSQFDs, &distances, maxSignatureSize);
+                parallel_for_(Range(0, body.getTileCount()), body);
+            }
+
             float PCTSignaturesSQFD_Impl::computePartialSQFD(
-                      const Mat& signature0,
-                      const Mat& signature1) const
+                      const Mat& centroids0,
+                      const Mat& signature1,
+                      float* similarities) const
             {
+                CV_DbgAssert(centroids0.isContinuous() && centroids0.rows == SIGNATURE_DIMENSION);
+
+                const int count0 = centroids0.cols;
+                const float* weights0 = centroids0.ptr<float>(WEIGHT_IDX);
+
+                // the similarities of a centroid of signature1 with all the centroids of signature0 at once
                 float result = 0;
-                for (int i = 0; i < signature0.rows; i++)
+                for (int j = 0; j < signature1.rows; j++)
                 {
-                    for (int j = 0; j < signature1.rows; j++)
+                    const float* point = signature1.ptr<float>(j);
+                    const float weight1 = point[WEIGHT_IDX];
+                    computeSimilarities(mDistanceFunction, mSimilarityFunction, mSimilarityParameter,
+                        point, centroids0.ptr<float>(), count0, similarities);
+
+                    float partial = 0;
+                    int i = 0;
+#if CV_SIMD128
+                    v_float32x4 vweight1 = v_setall_f32(weight1), vpartial = v_setzero_f32();
+                    for (; i <= count0 - 4; i += 4)
+                    {
+                        vpartial += v_load(weights0 + i) * vweight1 * v_load(similarities + i);
+                    }
+                    partial = v_reduce_sum(vpartial);
+#endif
+                    for (; i < count0; i++)
                     {
-                        result += signature0.at<float>(i, WEIGHT_IDX) * signature1.at<float>(j, WEIGHT_IDX)
-                            * computeSimilarity(mDistanceFunction, mSimilarityFunction, mSimilarityParameter, signature0, i, signature1, j);
+                        partial += weights0[i] * weight1 * similarities[i];
                     }
+                    result += partial;
                 }
                 return result;
             }
@@ -0,0 +1,42 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+TEST(Features2d_DAISY, dense_bands)
+{
+    Mat image = imread(cvtest::findDataFile("shared/lena.png"), IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image.empty());
+    resize(image, image, Size(256, 200), 0, 0, INTER_AREA);
+
+    const Rect roi(10, 20, 200, 160);
+    for (int norm = DAISY::NRM_NONE; norm <= DAISY::NRM_SIFT; norm++)
+    {
+        Ptr<DAISY> daisy = DAISY::create(15, 3, 8, 8, (DAISY::NormalizationType)norm);
+
+        Mat expected;
+        daisy->compute(image, roi, expected);
+        ASSERT_EQ(roi.area(), expected.rows);
+
+        // a budget of a few bands, written into a view of a larger matrix
+        Mat buffer(roi.area(), daisy->descriptorSize() + 8, CV_32F, Scalar::all(-1));
+        Mat descriptors = buffer.colRange(4, 4 + daisy->descriptorSize());
+        daisy->computeDense(image, roi, descriptors, 8 << 20);
+
+        ASSERT_EQ(buffer.data + 4 * sizeof(float), descriptors.data);
+        EXPECT_LE(cvtest::norm(expected, descriptors, NORM_INF), 1e-5) << "norm " << norm;
+        EXPECT_EQ(0, cvtest::norm(buffer.colRange(0, 4), Mat(roi.area(), 4, CV_32F, Scalar::all(-1)), NORM_INF));
+        EXPECT_EQ(0, cvtest::norm(buffer.colRange(4 + daisy->descriptorSize(), buffer.cols),
+                                  Mat(roi.area(), 4, CV_32F, Scalar::all(-1)), NORM_INF));
+
+        // a single band
+        Mat single;
+        daisy->computeDense(image, roi, single, (size_t)1 << 30);
+        EXPECT_LE(cvtest::norm(expected, single, NORM_INF), 1e-5) << "norm " << norm;
+    }
+}
+
+}} // namespace
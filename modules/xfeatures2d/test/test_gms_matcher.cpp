@@ -113,4 +113,50 @@ void CV_GMSMatcherTest::run( int )
 
 TEST(XFeatures2d_GMSMatcher, gms_matcher_regression) { CV_GMSMatcherTest test; test.safe_run(); }
 
+TEST(XFeatures2d_GMSMatcher, parallel_hypotheses)
+{
+    // keypoints rotated by 90 degrees and scaled down, a third of the matches are wrong
+    const Size size(640, 480);
+    RNG rng(0);
+    vector<KeyPoint> keypoints1, keypoints2;
+    vector<DMatch> matches;
+    for (int i = 0; i < 12000; i++)
+    {
+        Point2f p1(rng.uniform(0.f, (float)size.width), rng.uniform(0.f, (float)size.height));
+        Point2f p2(320.f + (p1.y - 240.f) * 0.7f, 240.f - (p1.x - 320.f) * 0.7f);
+        if (i % 3 == 0)
+            p2 = Point2f(rng.uniform(0.f, (float)size.width), rng.uniform(0.f, (float)size.height));
+        keypoints1.push_back(KeyPoint(p1, 7.f));
+        keypoints2.push_back(KeyPoint(p2, 7.f));
+        matches.push_back(DMatch(i, i, 0.f));
+    }
+
+    int prev_threads = getNumThreads();
+    for (int comb = 0; comb < 4; comb++)
+    {
+        const bool withRotation = (comb & 1) != 0, withScale = (comb & 2) != 0;
+
+        setNumThreads(1);
+        vector<DMatch> serial;
+        matchGMS(size, size, keypoints1, keypoints2, matches, serial, withRotation, withScale);
+        setNumThreads(prev_threads);
+        vector<DMatch> parallel;
+        matchGMS(size, size, keypoints1, keypoints2, matches, parallel, withRotation, withScale);
+
+        ASSERT_EQ(serial.size(), parallel.size());
+        for (size_t i = 0; i < serial.size(); i++)
+            EXPECT_EQ(serial[i].queryIdx, parallel[i].queryIdx);
+
+        if (withRotation)
+        {
+            ASSERT_FALSE(parallel.empty());
+            int nbCorrectMatches = 0;
+            for (size_t i = 0; i < parallel.size(); i++)
+                nbCorrectMatches += parallel[i].queryIdx % 3 != 0;
+            EXPECT_GT(nbCorrectMatches / (double)parallel.size(), 0.95);
+        }
+    }
+    setNumThreads(prev_threads);
+}
+
 }} // namespace
@@ -0,0 +1,102 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// signatures of various sizes, with weights in (0, 1] and coordinates in [0, 1)
+static void generateSignatures(int count, RNG& rng, std::vector<Mat>& signatures)
+{
+    signatures.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        Mat& signature = signatures[i];
+        signature.create(rng.uniform(1, 40), 8, CV_32F);
+        rng.fill(signature, RNG::UNIFORM, 0.f, 1.f);
+        signature.col(0) = 1.f - signature.col(0);
+    }
+}
+
+// SQFD computed pair by pair with the L2 distance
+static double referenceSQFD(const Mat& signature0, const Mat& signature1, int similarityFunction, double alpha)
+{
+    const Mat* signatures[2] = { &signature0, &signature1 };
+    double partial[2][2] = { { 0, 0 }, { 0, 0 } };
+    for (int s0 = 0; s0 < 2; s0++)
+        for (int s1 = 0; s1 < 2; s1++)
+            for (int i = 0; i < signatures[s0]->rows; i++)
+                for (int j = 0; j < signatures[s1]->rows; j++)
+                {
+                    double distance = cvtest::norm(signatures[s0]->row(i).colRange(1, 8), signatures[s1]->row(j).colRange(1, 8), NORM_L2);
+                    double similarity = similarityFunction == PCTSignatures::GAUSSIAN
+                        ? std::exp(-alpha * distance * distance) : 1 / (alpha + distance);
+                    partial[s0][s1] += signatures[s0]->at<float>(i, 0) * signatures[s1]->at<float>(j, 0) * similarity;
+                }
+    return std::sqrt(partial[0][0] + partial[1][1] - 2 * partial[0][1]);
+}
+
+TEST(Features2d_PCTSignaturesSQFD, distance_matrix)
+{
+    RNG rng(12345);
+    std::vector<Mat> queries, images;
+    generateSignatures(20, rng, queries);
+    generateSignatures(150, rng, images);
+
+    const int similarityFunctions[] = { PCTSignatures::GAUSSIAN, PCTSignatures::HEURISTIC };
+    for (int k = 0; k < 2; k++)
+    {
+        Ptr<PCTSignaturesSQFD> sqfd = PCTSignaturesSQFD::create(PCTSignatures::L2, similarityFunctions[k], 1.f);
+
+        Mat distances;
+        sqfd->computeQuadraticFormDistanceMatrix(queries, images, distances);
+        ASSERT_EQ(CV_32F, distances.type());
+        ASSERT_EQ(Size((int)images.size(), (int)queries.size()), distances.size());
+
+        for (int q = 0; q < (int)queries.size(); q++)
+        {
+            // all the ways of computing a distance agree exactly
+            std::vector<float> row;
+            sqfd->computeQuadraticFormDistances(queries[q], images, row);
+            ASSERT_EQ(images.size(), row.size());
+            for (int i = 0; i < (int)images.size(); i++)
+            {
+                EXPECT_EQ(row[i], distances.at<float>(q, i)) << "query " << q << " image " << i;
+                if (i % 10 == 0)
+                {
+                    EXPECT_EQ(sqfd->computeQuadraticFormDistance(queries[q], images[i]), distances.at<float>(q, i));
+                    EXPECT_NEAR(referenceSQFD(queries[q], images[i], similarityFunctions[k], 1.0), distances.at<float>(q, i), 1e-2);
+                }
+            }
+        }
+    }
+}
+
+TEST(Features2d_PCTSignatures, batch)
+{
+    const char* names[] = { "shared/lena.png", "shared/baboon.png", "shared/fruits.png" };
+    std::vector<Mat> images;
+    for (int i = 0; i < 3; i++)
+    {
+        Mat image = imread(cvtest::findDataFile(names[i]), IMREAD_COLOR);
+        ASSERT_FALSE(image.empty()) << names[i];
+        images.push_back(image);
+    }
+
+    Ptr<PCTSignatures> pctSignatures = PCTSignatures::create();
+    std::vector<Mat> signatures;
+    pctSignatures->computeSignatures(images, signatures);
+    ASSERT_EQ(images.size(), signatures.size());
+
+    // the signatures do not depend on the number of threads
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        Mat signature;
+        pctSignatures->computeSignature(images[i], signature);
+        ASSERT_FALSE(signature.empty());
+        EXPECT_EQ(0, cvtest::norm(signature, signatures[i], NORM_INF)) << names[i];
+    }
+}
+
+}} // namespace
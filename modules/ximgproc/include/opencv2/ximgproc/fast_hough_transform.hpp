@@ -128,7 +128,9 @@ typedef enum {
 * @param   makeSkew    Specifies to do or not to do image skewing, see cv::HoughDeskewOption
 *
 * The function calculates the fast Hough transform for full, half or quarter
-* range of angles.
+* range of angles. The levels of the transform of large images are computed in parallel.
+* Every quarter of the transform is computed in a buffer of the destination size
+* and its ping-pong copy, unlike RadonTransform the scratch memory is not bounded.
 */
 CV_EXPORTS_W void FastHoughTransform( InputArray  src,
                                       OutputArray dst,
@@ -137,6 +139,25 @@ CV_EXPORTS_W void FastHoughTransform( InputArray  src,
                                       int         op = FHT_ADD,
                                       int         makeSkew = HDO_DESKEW );
 
+/**
+* @brief   Calculates 2D Fast Hough transform of a stack of images.
+* @param   src         The source (input) images.
+* @param   dst         The destination images, a transform per source image.
+* @param   dstMatDepth The depth of destination images
+* @param   op          The operation to be applied, see cv::HoughOp
+* @param   angleRange  The part of Hough space to calculate, see cv::AngleRangeOption
+* @param   makeSkew    Specifies to do or not to do image skewing, see cv::HoughDeskewOption
+*
+* The result is the same as calling FastHoughTransform for every image,
+* the images are transformed in parallel.
+*/
+CV_EXPORTS_W void FastHoughTransformBatch( InputArrayOfArrays  src,
+                                           OutputArrayOfArrays dst,
+                                           int                 dstMatDepth,
+                                           int                 angleRange = ARO_315_135,
+                                           int                 op = FHT_ADD,
+                                           int                 makeSkew = HDO_DESKEW );
+
 /**
 * @brief   Calculates coordinates of line segment corresponded by point in Hough space.
 * @param   houghPoint  Point in Hough space.
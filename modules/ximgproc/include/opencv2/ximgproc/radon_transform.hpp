@@ -26,6 +26,7 @@ namespace cv { namespace ximgproc {
 * The output size will be num_of_integral x src_diagonal_length.
 * If crop is selected, the input image will be crop into square then circle,
 * and output size will be num_of_integral x min_edge.
+* The angles are projected in parallel, the rotated image is processed by bands of rows.
 *
 */
 CV_EXPORTS_W void RadonTransform(InputArray src,
@@ -35,6 +36,28 @@ CV_EXPORTS_W void RadonTransform(InputArray src,
                                       double end_angle = 180,
                                       bool crop = false,
                                       bool norm = false);
+
+/**
+* @brief   Calculate Radon Transform of a stack of images.
+* @param   src         The source (input) images.
+* @param   dst         The destination images, a transform per source image.
+* @param   theta       Angle resolution of the transform in degrees.
+* @param   start_angle Start angle of the transform in degrees.
+* @param   end_angle   End angle of the transform in degrees.
+* @param   crop        Crop the source images into a circle.
+* @param   norm        Normalize the output Mats to grayscale and convert type to CV_8U
+*
+* The result is the same as calling RadonTransform for every image, the angles of all the
+* images are projected in parallel. The images may differ in size and type.
+*
+*/
+CV_EXPORTS_W void RadonTransformBatch(InputArrayOfArrays src,
+                                      OutputArrayOfArrays dst,
+                                      double theta = 1,
+                                      double start_angle = 0,
+                                      double end_angle = 180,
+                                      bool crop = false,
+                                      bool norm = false);
 } }
 
 #endif
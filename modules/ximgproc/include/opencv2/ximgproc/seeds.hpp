@@ -95,6 +95,10 @@ public:
     can be seen below.
 
     ![image](pics/superpixels_blocks2.png)
+
+    The updates are done in parallel on tiles of neighboring superpixels, the blocks and pixels at
+    the boundaries between the tiles are updated afterwards. The result does not depend on the
+    number of threads.
      */
     CV_WRAP virtual void iterate(InputArray img, int num_iterations=4) = 0;
 
@@ -235,6 +235,11 @@ namespace cv {
 
                             /** @brief Based on all images, graph segmentations and stragies, computes all possible rects and return them
                                 @param rects The list of rects. The first ones are more relevents than the lasts ones.
+
+                                Every (image, graph segmentation, strategy) combination is processed in parallel and the
+                                result does not depend on the number of threads. The graph segmentations may be called
+                                concurrently. The built-in strategies are copied for every combination, the other ones are
+                                used by one combination at a time.
                             */
                             CV_WRAP virtual void process(CV_OUT std::vector<Rect>& rects) = 0;
                     };
@@ -108,6 +108,19 @@ public:
      */
     CV_WRAP virtual void detectEdges(cv::InputArray src, cv::OutputArray dst) const = 0;
 
+    /** @brief The function detects edges in src tile by tile and draws them to dst.
+
+    Every tile is processed with a margin around it and the tiles are distributed among the threads,
+    so the temporary feature images are only as large as the tiles. It is meant for the images whose
+    feature channels would not fit into memory at once. The result is close to detectEdges, the
+    differences are at the tile seams only.
+    @param src source image (RGB, float, in [0;1]) to detect edges
+    @param dst destination image (grayscale, float, in [0;1]) where edges are drawn
+    @param tileSize approximate width and height of the tiles, in pixels
+    @sa detectEdges
+     */
+    CV_WRAP virtual void detectEdgesTiled(cv::InputArray src, cv::OutputArray dst, int tileSize = 1024) const = 0;
+
     /** @brief The function computes orientation from edge image.
 
     @param src edge image.
@@ -127,12 +140,22 @@ public:
     @param isParallel enables/disables parallel computing.
      */
     CV_WRAP virtual void edgesNms(cv::InputArray edge_image, cv::InputArray orientation_image, cv::OutputArray dst, int r = 2, int s = 0, float m = 1, bool isParallel = true) const = 0;
+
+    /** @brief Stores the model in a binary file.
+
+    Loading the model from a YAML file takes a lot of time. createStructuredEdgeDetection recognizes
+    the binary files and reads them in one go, the trees are used in place without parsing.
+    The binary files depend on the byte order of the platform.
+    @param filename name of the binary model file
+     */
+    CV_WRAP virtual void saveBinaryModel(const String& filename) const = 0;
 };
 
 /*!
 * The only constructor
 *
-* \param model : name of the file where the model is stored
+* \param model : name of the file where the model is stored, either a
+*                YAML file or a binary one written by saveBinaryModel
 * \param howToGetFeatures : optional object inheriting from RFFeatureGetter.
 *                           You need it only if you would like to train your
 *                           own forest, pass NULL otherwise
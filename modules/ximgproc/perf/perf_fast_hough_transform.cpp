@@ -78,4 +78,20 @@ PERF_TEST_P(srcSize_srcType_dstDepth, FastHoughTransform,
 
 #undef ALL_MAT_DEPHTS
 
+PERF_TEST(FastHoughTransform, large)
+{
+    // a quarter of the angles keeps the destination and its ping-pong copy at 240 MB each
+    Mat src(Size(5000, 7000), CV_8UC1);
+    Mat fht;
+
+    declare.in(src, WARMUP_RNG);
+
+    TEST_CYCLE_N(1)
+    {
+        FastHoughTransform(src, fht, CV_32S, ARO_45_90);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -0,0 +1,38 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+typedef tuple<Size, int> GraphSegmentationTestParam;
+typedef TestBaseWithParam<GraphSegmentationTestParam> GraphSegmentationTest;
+
+PERF_TEST_P(GraphSegmentationTest, perf,
+    Combine(
+    Values(szVGA, sz1080p, Size(3840, 2160)),
+    Values(1, 3))
+)
+{
+    GraphSegmentationTestParam params = GetParam();
+    Size sz = get<0>(params);
+    int cn  = get<1>(params);
+
+    Mat src(sz, CV_MAKE_TYPE(CV_8U, cn));
+    Mat dst(sz, CV_32SC1);
+
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation();
+
+    TEST_CYCLE_N(1)
+    {
+        gs->processImage(src, dst);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
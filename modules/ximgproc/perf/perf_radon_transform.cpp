@@ -32,4 +32,19 @@ PERF_TEST_P(RadonTransformPerfTest, perf,
     SANITY_CHECK_NOTHING();
 }
 
+PERF_TEST(RadonTransform, large)
+{
+    Mat src(Size(5000, 7000), CV_8UC1);
+    Mat radon;
+
+    declare.in(src, WARMUP_RNG);
+
+    TEST_CYCLE_N(1)
+    {
+        RadonTransform(src, radon);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 } }
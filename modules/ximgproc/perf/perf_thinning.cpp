@@ -0,0 +1,36 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test {
+namespace {
+
+typedef tuple<Size, int> ThinningParams;
+typedef TestBaseWithParam<ThinningParams> ThinningPerfTest;
+
+PERF_TEST_P(ThinningPerfTest, perf, Combine(Values(sz720p, sz1080p, sz2160p),
+    Values((int)THINNING_ZHANGSUEN, (int)THINNING_GUOHALL)))
+{
+    Size sz = get<0>(GetParam());
+    int thinningType = get<1>(GetParam());
+
+    // thick strokes over a mostly empty page, like a scanned document mask
+    Mat src = Mat::zeros(sz, CV_8UC1), dst;
+    RNG rng(12345);
+    for (int k = 0; k < sz.area() / 4000; k++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2 = p1 + Point(rng.uniform(-60, 60), rng.uniform(-60, 60));
+        line(src, p1, p2, Scalar(255), rng.uniform(3, 12));
+    }
+
+    declare.in(src).out(dst);
+
+    TEST_CYCLE() thinning(src, dst, thinningType);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
+} // namespace
@@ -69,6 +69,17 @@ SPECIALIZE_HOUGHOP(FHT_AVE, addWeighted(src0, 0.5, src1, 0.5, 0.0, dst));
 
 //----------------------fht----------------------------------------------------
 
+template <typename T, int D, HoughOp OP>
+void fhtMerge(Mat     &img0,
+              Mat     &img1,
+              int32_t  y0,
+              int32_t  h,
+              bool     isPositiveShift,
+              int      level,
+              double   aspl,
+              int32_t  sBegin,
+              int32_t  sEnd);
+
 template <typename T, int D, HoughOp OP>
 void fhtCore(Mat     &img0,
              Mat     &img1,
@@ -110,6 +121,21 @@ void fhtCore(Mat     &img0,
     fhtCore<T, D, OP>(img1, img0, y0 + k, h - k,
                       isPositiveShift, level - 1, aspl);
 
+    fhtMerge<T, D, OP>(img0, img1, y0, h, isPositiveShift, level, aspl, 0, h);
+}
+
+template <typename T, int D, HoughOp OP>
+void fhtMerge(Mat     &img0,
+              Mat     &img1,
+              int32_t  y0,
+              int32_t  h,
+              bool     isPositiveShift,
+              int      level,
+              double   aspl,
+              int32_t  sBegin,
+              int32_t  sEnd)
+{
+    const int32_t k = h >> 1;
     int au = 2 * k - 2;
     int ad = 2 * h - 2 * k - 2;
     int b = h - 1;
@@ -117,7 +143,7 @@ void fhtCore(Mat     &img0,
     int w = img0.cols;
     int wm = (h / w + 1) * w;
 
-    for (int32_t s = 0; s < h; s++)
+    for (int32_t s = sBegin; s < sEnd; s++)
     {
         int su = (s * au + b) / d;
         int sd = (s * ad + b) / d;
@@ -203,6 +229,44 @@ void fhtCore(Mat     &img0,
     }
 }
 
+// node of the recursion of fhtCore, img0 and img1 are exchanged if swapped
+struct FhtNode
+{
+    int32_t y0;
+    int32_t h;
+    int     level;
+    bool    swapped;
+};
+
+// the nodes at maxDepth (or the leaves above) are the subtrees, the nodes above are merged by levels
+static void collectFhtNodes(int32_t                         y0,
+                            int32_t                         h,
+                            int                             level,
+                            bool                            swapped,
+                            int                             depth,
+                            int                             maxDepth,
+                            std::vector<FhtNode>           &subtrees,
+                            std::vector<std::vector<FhtNode> > &merges)
+{
+    if (level <= 0)
+        return;
+
+    FhtNode node = { y0, h, level, swapped };
+    if (h <= 1 || depth == maxDepth)
+    {
+        subtrees.push_back(node);
+        return;
+    }
+
+    const int32_t k = h >> 1;
+    collectFhtNodes(y0, k, level - 1, !swapped, depth + 1, maxDepth, subtrees, merges);
+    collectFhtNodes(y0 + k, h - k, level - 1, !swapped, depth + 1, maxDepth, subtrees, merges);
+    merges[depth].push_back(node);
+}
+
+// images with less rows are transformed by a single thread
+static const int FHT_PARALLEL_MIN_ROWS = 64;
+
 template <typename T, int D, HoughOp Op>
 void fhtVoT(Mat    &img0,
             Mat    &img1,
@@ -213,7 +277,55 @@ void fhtVoT(Mat    &img0,
     for (int thres = 1; img0.rows > thres; thres <<= 1)
         level++;
 
-    fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+    const int nthreads = getNumThreads();
+    int maxDepth = 0;
+    while (maxDepth < level && (1 << maxDepth) < 4 * nthreads)
+        maxDepth++;
+
+    if (nthreads <= 1 || maxDepth == 0 || img0.rows < FHT_PARALLEL_MIN_ROWS)
+    {
+        fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+        return;
+    }
+
+    // The subtrees of the recursion are independent, they are computed in parallel.
+    // The nodes above them are merged level by level, in parallel by rows
+    std::vector<FhtNode> subtrees;
+    std::vector<std::vector<FhtNode> > merges(maxDepth);
+    collectFhtNodes(0, img0.rows, level, false, 0, maxDepth, subtrees, merges);
+
+    parallel_for_(Range(0, (int)subtrees.size()), [&](const Range &range)
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            const FhtNode &n = subtrees[i];
+            fhtCore<T, D, Op>(n.swapped ? img1 : img0, n.swapped ? img0 : img1,
+                              n.y0, n.h, isPositiveShift, n.level, aspl);
+        }
+    });
+
+    for (int depth = maxDepth - 1; depth >= 0; depth--)
+    {
+        // the nodes of a level do not share rows
+        const std::vector<FhtNode> &nodes = merges[depth];
+        std::vector<int> offsets(nodes.size() + 1, 0);
+        for (size_t i = 0; i < nodes.size(); i++)
+            offsets[i + 1] = offsets[i] + nodes[i].h;
+
+        parallel_for_(Range(0, offsets.back()), [&](const Range &range)
+        {
+            size_t i = std::upper_bound(offsets.begin(), offsets.end(), range.start) - offsets.begin() - 1;
+            for (int r = range.start; r < range.end; i++)
+            {
+                const FhtNode &n = nodes[i];
+                const int end = std::min(range.end, offsets[i + 1]);
+                fhtMerge<T, D, Op>(n.swapped ? img1 : img0, n.swapped ? img0 : img1,
+                                   n.y0, n.h, isPositiveShift, n.level, aspl,
+                                   r - offsets[i], end - offsets[i]);
+                r = end;
+            }
+        });
+    }
 }
 
 template <typename T, int D>
@@ -293,6 +405,7 @@ static void FHT(Mat       &dst,
     else
         CV_Assert(src.cols == dst.rows && src.rows == dst.cols);
 
+    // the levels are computed alternately in dst and tmp, both of the full size
     Mat tmp;
     src.convertTo(tmp, dst.type());
     if (!isVertical)
@@ -664,6 +777,27 @@ void FastHoughTransform(InputArray  src,
     }
 }
 
+void FastHoughTransformBatch(InputArrayOfArrays  src,
+                             OutputArrayOfArrays dst,
+                             int                 dstMatDepth,
+                             int                 angleRange,
+                             int                 operation,
+                             int                 makeSkew)
+{
+    std::vector<Mat> srcMats;
+    src.getMatVector(srcMats);
+
+    // the images are transformed in parallel, every transform uses a single thread then
+    std::vector<Mat> dstMats(srcMats.size());
+    parallel_for_(Range(0, (int)srcMats.size()), [&](const Range &range)
+    {
+        for (int i = range.start; i < range.end; i++)
+            FastHoughTransform(srcMats[i], dstMats[i], dstMatDepth, angleRange, operation, makeSkew);
+    });
+
+    dst.assign(dstMats);
+}
+
 //-----------------------------------------------------------------------------
 
 //----------------------fht point2line-----------------------------------------
@@ -61,25 +61,11 @@ namespace cv {
                     }
             };
 
-            // A point in the sets of points
-            class PointSetElement {
-                public:
-                    int p;
-                    int size;
-
-                    PointSetElement() { }
-
-                    PointSetElement(int p_) {
-                        p = p_;
-                        size = 1;
-                    }
-            };
-
-            // An object to manage set of points, who can be fusionned
+            // An object to manage set of points, who can be fusionned.
+            // A flat union-find: parents and set sizes are kept in two arrays.
             class PointSet {
                 public:
                     PointSet(int nb_elements_);
-                    ~PointSet();
 
                     int nb_elements;
 
@@ -90,10 +76,11 @@ namespace cv {
                     void joinPoints(int p_a, int p_b);
 
                     // Return the set size of a set (based on the main point)
-                    int size(unsigned int p) { return mapping[p].size; }
+                    int size(unsigned int p) { return sizes[p]; }
 
                 private:
-                    PointSetElement* mapping;
+                    std::vector<int> parents;
+                    std::vector<int> sizes;
 
             };
 
@@ -145,16 +132,19 @@ namespace cv {
                     void filter(const Mat &img, Mat &img_filtered);
 
                     // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
+                    void buildGraph(std::vector<Edge> &edges, const Mat &img_filtered);
+
+                    // Sort the edges by weight
+                    void sortEdges(std::vector<Edge> &edges);
 
                     // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    void segmentGraph(std::vector<Edge> &edges, PointSet &es);
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const std::vector<Edge> &edges, PointSet &es);
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
-                    void finalMapping(PointSet *es, Mat &output);
+                    void finalMapping(PointSet &es, Mat &output);
             };
 
             void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
@@ -168,97 +158,97 @@ namespace cv {
                 GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
             }
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
+            void GraphSegmentationImpl::buildGraph(std::vector<Edge> &edges, const Mat &img_filtered) {
 
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
+                const int rows = img_filtered.rows;
+                const int cols = img_filtered.cols;
+                const int nb_channels = img_filtered.channels();
 
-                nb_edges = 0;
+                // Every pixel is linked to its top, left, bottom and right neighbour, so each
+                // edge is there in both directions. The number of edges of a row is known,
+                // rows are filled in their own slices and the edges come in the raster order
+                // for any number of threads.
+                std::vector<size_t> row_offsets(rows + 1, 0);
+                for (int i = 0; i < rows; i++)
+                    row_offsets[i + 1] = row_offsets[i] + 2 * (cols - 1) + (i > 0 ? cols : 0) + (i + 1 < rows ? cols : 0);
+                edges.resize(row_offsets[rows]);
 
-                int nb_channels = img_filtered.channels();
+                parallel_for_(Range(0, rows), [&](const Range& range) {
+                    for (int i = range.start; i < range.end; i++) {
+                        const float* p = img_filtered.ptr<float>(i);
+                        Edge* e = edges.data() + row_offsets[i];
 
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
+                        for (int j = 0; j < cols; j++) {
 
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
+                            //Take the top, left, bottom and right pixel
+                            for (int delta = -1; delta <= 1; delta += 2) {
+                                for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
 
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
+                                    int i2 = i + delta * delta_i;
+                                    int j2 = j + delta * delta_j;
 
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
+                                    if (i2 >= 0 && i2 < rows && j2 >= 0 && j2 < cols) {
+                                        const float* p2 = img_filtered.ptr<float>(i2);
 
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
+                                        float tmp_total = 0;
+                                        for (int channel = 0; channel < nb_channels; channel++) {
+                                            float tmp_diff = p[j * nb_channels + channel] - p2[j2 * nb_channels + channel];
+                                            tmp_total += tmp_diff * tmp_diff;
+                                        }
 
-                                    float tmp_total = 0;
-
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        float tmp_diff = p[j * nb_channels + channel] - p2[j2 * nb_channels + channel];
-                                        tmp_total += tmp_diff * tmp_diff;
+                                        e->from = i * cols + j;
+                                        e->to = i2 * cols + j2;
+                                        e->weight = std::sqrt(tmp_total);
+                                        e++;
                                     }
-
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
-
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
-
-                                    nb_edges++;
                                 }
                             }
                         }
                     }
-                }
+                });
             }
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
-
-                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+            void GraphSegmentationImpl::sortEdges(std::vector<Edge> &edges) {
 
-                // Sort edges
-                std::sort(edges, edges + nb_edges);
-
-                // Create a set with all point (by default mapped to themselves)
-                *es = new PointSet(img_filtered.cols * img_filtered.rows);
+                // The order of the edges of the same weight decides which sets are joined
+                // first, std::sort keeps the segmentation the same as it always was
+                std::sort(edges.begin(), edges.end());
+            }
 
-                // Thresholds
-                float* thresholds = new float[total_points];
+            void GraphSegmentationImpl::segmentGraph(std::vector<Edge> &edges, PointSet &es) {
 
-                for (int i = 0; i < total_points; i++)
-                    thresholds[i] = k;
+                // Thresholds, before any join there is a set per point
+                std::vector<float> thresholds(es.nb_elements, k);
 
-                for ( int i = 0; i < nb_edges; i++) {
+                for (size_t i = 0; i < edges.size(); i++) {
 
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                    Edge& e = edges[i];
+                    int p_a = es.getBasePoint(e.from);
+                    int p_b = es.getBasePoint(e.to);
 
                     if (p_a != p_b) {
-                        if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
-                            (*es)->joinPoints(p_a, p_b);
-                            p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
+                        if (e.weight <= thresholds[p_a] && e.weight <= thresholds[p_b]) {
+                            es.joinPoints(p_a, p_b);
+                            p_a = es.getBasePoint(p_a);
+                            thresholds[p_a] = e.weight + k / es.size(p_a);
 
-                            edges[i].weight = 0;
+                            e.weight = 0;
                         }
                     }
                 }
-
-                delete [] thresholds;
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
+            void GraphSegmentationImpl::filterSmallAreas(const std::vector<Edge> &edges, PointSet &es) {
 
-                for ( int i = 0; i < nb_edges; i++) {
+                for (size_t i = 0; i < edges.size(); i++) {
 
                     if (edges[i].weight > 0) {
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                        int p_a = es.getBasePoint(edges[i].from);
+                        int p_b = es.getBasePoint(edges[i].to);
 
-                        if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
-                            es->joinPoints(p_a, p_b);
+                        if (p_a != p_b && (es.size(p_a) < min_size || es.size(p_b) < min_size)) {
+                            es.joinPoints(p_a, p_b);
 
                         }
                     }
@@ -266,15 +256,12 @@ namespace cv {
 
             }
 
-            void GraphSegmentationImpl::finalMapping(PointSet *es, Mat &output) {
+            void GraphSegmentationImpl::finalMapping(PointSet &es, Mat &output) {
 
                 int maximum_size = ( int)(output.rows * output.cols);
 
                 int last_id = 0;
-                int * mapped_id = new int[maximum_size];
-
-                for ( int i = 0; i < maximum_size; i++)
-                    mapped_id[i] = -1;
+                std::vector<int> mapped_id(maximum_size, -1);
 
                 int rows = output.rows;
                 int cols = output.cols;
@@ -290,7 +277,7 @@ namespace cv {
 
                     for (int j = 0; j < cols; j++) {
 
-                        int point = es->getBasePoint(i * cols + j);
+                        int point = es.getBasePoint(i * cols + j);
 
                         if (mapped_id[point] == -1) {
                             mapped_id[point] = last_id;
@@ -300,8 +287,6 @@ namespace cv {
                         p[j] = mapped_id[point];
                     }
                 }
-
-                delete [] mapped_id;
             }
 
             void GraphSegmentationImpl::processImage(InputArray src, OutputArray dst) {
@@ -317,25 +302,23 @@ namespace cv {
                 filter(img, img_filtered);
 
                 // Build graph
-                Edge *edges;
-                int nb_edges;
+                std::vector<Edge> edges;
+
+                buildGraph(edges, img_filtered);
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                sortEdges(edges);
 
                 // Segment graph
-                PointSet *es;
+                PointSet es(img.rows * img.cols);
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                segmentGraph(edges, es);
 
                 // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                filterSmallAreas(edges, es);
 
                 // Map to final output
                 finalMapping(es, output);
 
-                delete [] edges;
-                delete es;
-
             }
 
             Ptr<GraphSegmentation> createGraphSegmentation(double sigma, float k, int min_size) {
@@ -349,42 +332,33 @@ namespace cv {
                 return graphseg;
             }
 
-            PointSet::PointSet(int nb_elements_) {
+            PointSet::PointSet(int nb_elements_) : parents(nb_elements_), sizes(nb_elements_, 1) {
                 nb_elements = nb_elements_;
 
-                mapping = new PointSetElement[nb_elements];
-
                 for ( int i = 0; i < nb_elements; i++) {
-                    mapping[i] = PointSetElement(i);
+                    parents[i] = i;
                 }
             }
 
-            PointSet::~PointSet() {
-                delete [] mapping;
-            }
-
             int PointSet::getBasePoint( int p) {
 
-                 int base_p = p;
-
-                while (base_p != mapping[base_p].p) {
-                    base_p = mapping[base_p].p;
+                // Path halving: every visited point is linked to its grandparent
+                while (p != parents[p]) {
+                    parents[p] = parents[parents[p]];
+                    p = parents[p];
                 }
 
-                // Save mapping for faster acces later
-                mapping[p].p = base_p;
-
-                return base_p;
+                return p;
             }
 
             void PointSet::joinPoints(int p_a, int p_b) {
 
                 // Always target smaller set, to avoid redirection in getBasePoint
-                if (mapping[p_a].size < mapping[p_b].size)
-                    swap(p_a, p_b);
+                if (sizes[p_a] < sizes[p_b])
+                    std::swap(p_a, p_b);
 
-                mapping[p_b].p = p_a;
-                mapping[p_a].size += mapping[p_b].size;
+                parents[p_b] = p_a;
+                sizes[p_a] += sizes[p_b];
 
                 nb_elements--;
             }
@@ -5,71 +5,111 @@
 #include "precomp.hpp"
 
 namespace cv {namespace ximgproc {
-    void RadonTransform(InputArray src,
-                             OutputArray dst,
-                             double theta,
-                             double start_angle,
-                             double end_angle,
-                             bool crop,
-                             bool norm)
+    // maximal number of pixels of the rotated source kept by a thread
+    static const int RADON_BAND_PIXELS = 1 << 20;
+
+    // the source prepared for the projections, centered in a square
+    struct RadonSource
     {
-        CV_Assert(src.dims() == 2);
-        CV_Assert(src.channels() == 1);
-        CV_Assert((end_angle - start_angle) * theta > 0);
+        Mat masked;
+        Point center;
+        int row_num;
+        int out_mat_type;
+    };
 
-        Mat _srcMat = src.getMat();
+    static void prepareRadonSource(const Mat& src, bool crop, RadonSource& rs)
+    {
+        CV_Assert(src.dims == 2);
+        CV_Assert(src.channels() == 1);
 
-        int _row_num, _col_num, _out_mat_type;
-        _col_num = cvRound((end_angle - start_angle) / theta);
-        transpose(_srcMat, _srcMat);
-        Mat _masked_src;
-        cv::Point _center;
+        Mat _srcMat;
+        transpose(src, _srcMat);
 
         if (_srcMat.type() == CV_32FC1 || _srcMat.type() == CV_64FC1) {
-            _out_mat_type = CV_64FC1;
+            rs.out_mat_type = CV_64FC1;
         }
         else {
-            _out_mat_type = CV_32SC1;
+            rs.out_mat_type = CV_32SC1;
         }
 
         if (crop) {
             // crop the source into square
-            _row_num = min(_srcMat.rows, _srcMat.cols);
+            rs.row_num = min(_srcMat.rows, _srcMat.cols);
             cv::Rect _crop_ROI(
-                _srcMat.cols / 2 - _row_num / 2,
-                _srcMat.rows / 2 - _row_num / 2,
-                _row_num, _row_num);
+                _srcMat.cols / 2 - rs.row_num / 2,
+                _srcMat.rows / 2 - rs.row_num / 2,
+                rs.row_num, rs.row_num);
             _srcMat = _srcMat(_crop_ROI);
             // crop the source into circle
             Mat _mask(_srcMat.size(), CV_8UC1, Scalar(0));
-            _center = Point(_srcMat.cols / 2, _srcMat.rows / 2);
-            circle(_mask, _center, _srcMat.cols / 2, Scalar(255), FILLED);
-            _srcMat.copyTo(_masked_src, _mask);
+            rs.center = Point(_srcMat.cols / 2, _srcMat.rows / 2);
+            circle(_mask, rs.center, _srcMat.cols / 2, Scalar(255), FILLED);
+            _srcMat.copyTo(rs.masked, _mask);
         }
         else {
             // avoid cropping corner when rotating
-            _row_num = cvCeil(sqrt(_srcMat.rows * _srcMat.rows + _srcMat.cols * _srcMat.cols));
-            _masked_src = Mat(Size(_row_num, _row_num), _srcMat.type(), Scalar(0));
-            _center = Point(_masked_src.cols / 2, _masked_src.rows / 2);
-            _srcMat.copyTo(_masked_src(Rect(
-                (_row_num - _srcMat.cols) / 2,
-                (_row_num - _srcMat.rows) / 2,
+            rs.row_num = cvCeil(sqrt(_srcMat.rows * _srcMat.rows + _srcMat.cols * _srcMat.cols));
+            rs.masked = Mat(Size(rs.row_num, rs.row_num), _srcMat.type(), Scalar(0));
+            rs.center = Point(rs.masked.cols / 2, rs.masked.rows / 2);
+            _srcMat.copyTo(rs.masked(Rect(
+                (rs.row_num - _srcMat.cols) / 2,
+                (rs.row_num - _srcMat.rows) / 2,
                 _srcMat.cols, _srcMat.rows)));
         }
+    }
 
-        double _t;
+    // Computes the columns [cols.start, cols.end) of the transform. The source is rotated
+    // by bands of rows, so the memory used does not depend on the image size.
+    static void radonColumns(const RadonSource& rs,
+                             Mat& radon,
+                             double theta,
+                             double start_angle,
+                             const Range& cols)
+    {
+        const int _band_rows = std::max(1, std::min(rs.row_num, RADON_BAND_PIXELS / rs.row_num));
         Mat _rotated_src;
-        Mat _radon(_row_num, _col_num, _out_mat_type);
 
-        for (int _col = 0; _col < _col_num; _col++) {
+        for (int _col = cols.start; _col < cols.end; _col++) {
             // rotate the source by _t
-            _t = (start_angle + _col * theta);
-            cv::Mat _r_matrix = cv::getRotationMatrix2D(_center, _t, 1);
-            cv::warpAffine(_masked_src, _rotated_src, _r_matrix, _masked_src.size());
-            Mat _col_mat = _radon.col(_col);
-            // make projection
-            cv::reduce(_rotated_src, _col_mat, 1, REDUCE_SUM, _out_mat_type);
+            double _t = (start_angle + _col * theta);
+            cv::Mat _r_matrix = cv::getRotationMatrix2D(rs.center, _t, 1);
+
+            for (int _y = 0; _y < rs.row_num; _y += _band_rows) {
+                const int _h = std::min(_band_rows, rs.row_num - _y);
+                // rotate the band of rows [_y, _y + _h) only
+                cv::Mat _band_matrix = _r_matrix.clone();
+                _band_matrix.at<double>(1, 2) -= _y;
+                cv::warpAffine(rs.masked, _rotated_src, _band_matrix, Size(rs.masked.cols, _h));
+                Mat _col_mat = radon.col(_col).rowRange(_y, _y + _h);
+                // make projection
+                cv::reduce(_rotated_src, _col_mat, 1, REDUCE_SUM, rs.out_mat_type);
+            }
         }
+    }
+
+    void RadonTransform(InputArray src,
+                             OutputArray dst,
+                             double theta,
+                             double start_angle,
+                             double end_angle,
+                             bool crop,
+                             bool norm)
+    {
+        CV_Assert(src.dims() == 2);
+        CV_Assert(src.channels() == 1);
+        CV_Assert((end_angle - start_angle) * theta > 0);
+
+        int _col_num = cvRound((end_angle - start_angle) / theta);
+
+        RadonSource _source;
+        prepareRadonSource(src.getMat(), crop, _source);
+
+        Mat _radon(_source.row_num, _col_num, _source.out_mat_type);
+
+        // the angles are projected in parallel
+        parallel_for_(Range(0, _col_num), [&](const Range& range) {
+            radonColumns(_source, _radon, theta, start_angle, range);
+        });
 
         if (norm) {
             normalize(_radon, _radon, 0, 255, NORM_MINMAX, CV_8UC1);
@@ -78,4 +118,42 @@ namespace cv {namespace ximgproc {
         _radon.copyTo(dst);
         return;
     }
+
+    void RadonTransformBatch(InputArrayOfArrays src,
+                             OutputArrayOfArrays dst,
+                             double theta,
+                             double start_angle,
+                             double end_angle,
+                             bool crop,
+                             bool norm)
+    {
+        CV_Assert((end_angle - start_angle) * theta > 0);
+
+        std::vector<Mat> _srcs;
+        src.getMatVector(_srcs);
+        const int _n = (int)_srcs.size();
+        int _col_num = cvRound((end_angle - start_angle) / theta);
+
+        std::vector<RadonSource> _sources(_n);
+        std::vector<Mat> _radons(_n);
+        for (int i = 0; i < _n; i++) {
+            prepareRadonSource(_srcs[i], crop, _sources[i]);
+            _radons[i].create(_sources[i].row_num, _col_num, _sources[i].out_mat_type);
+        }
+
+        // the angles of all the images are projected in parallel
+        parallel_for_(Range(0, _n * _col_num), [&](const Range& range) {
+            for (int _job = range.start; _job < range.end; _job++) {
+                const int i = _job / _col_num, _col = _job % _col_num;
+                radonColumns(_sources[i], _radons[i], theta, start_angle, Range(_col, _col + 1));
+            }
+        });
+
+        if (norm) {
+            for (int i = 0; i < _n; i++)
+                normalize(_radons[i], _radons[i], 0, 255, NORM_MINMAX, CV_8UC1);
+        }
+
+        dst.assign(_radons);
+    }
 } }
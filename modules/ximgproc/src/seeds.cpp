@@ -52,6 +52,7 @@
 #include <algorithm>
 #include <vector>
 #include <cstdlib>
+#include "opencv2/core/hal/intrin.hpp"
 using namespace std;
 
 
@@ -61,6 +62,9 @@ using namespace std;
 
 #define MINIMUM_NR_SUBLABELS 1
 
+// size of the tiles updated in parallel, in superpixels of the initial grid
+#define TILE_NR_SUPERPIXELS 4
+
 
 // the type of the histogram and the T array
 typedef float HISTN;
@@ -109,6 +113,10 @@ private:
     inline void updateLabels();
     // main loop for pixel updating
     void updatePixels();
+    // update of the pixels (x, y) and (x+1, y), returns true if (x+1, y) has changed
+    bool updatePixelPairH(int x, int y);
+    // update of the pixels (x, y) and (x, y+1), returns true if (x, y+1) has changed
+    bool updatePixelPairV(int x, int y);
 
 
     /* block operations */
@@ -122,6 +130,23 @@ private:
 
     //main loop for block updates
     void updateBlocks(int level, float req_confidence = 0.0f);
+    // update of the blocks (x, y) and (x+1, y), returns true if (x+1, y) has changed
+    bool updateBlockPairH(int level, int x, int y, float req_confidence);
+    // update of the blocks (x, y) and (x, y+1), returns true if (x, y+1) has changed
+    bool updateBlockPairV(int level, int x, int y, float req_confidence);
+
+    /* parallel updates */
+    // first cell of every tile column (or row) of a grid of n cells covering size pixels
+    void tileBounds(int n, int size, int nr_top, int nr_tiles, vector<int>& bounds) const;
+    // calls body(tile, cols, rows, deferred_h, deferred_v) for all the tiles, see updatePixels()
+    template<typename Body>
+    void forEachTile(const vector<int>& xs, const vector<int>& ys,
+            vector<vector<Point> >& deferred_h, vector<vector<Point> >& deferred_v, const Body& body);
+    // tile updating the superpixel label
+    inline int tileOf(int label) const {
+        int w = nr_wh[2 * seeds_top_level];
+        return (label / w / TILE_NR_SUPERPIXELS) * nr_tiles_x + (label % w) / TILE_NR_SUPERPIXELS;
+    }
 
     /* go to next block level */
     int goDownOneLevel();
@@ -156,6 +181,7 @@ private:
 
     // keep one labeling for each level
     vector<int> nr_wh; // [2*level]/[2*level+1] number of labels in x-direction/y-direction
+    int nr_tiles_x, nr_tiles_y; // tiles of TILE_NR_SUPERPIXELS^2 top level labels
 
     /* pre-initialized arrays. they are not modified afterwards */
     int* labels_bottom; //labels of level==0
@@ -304,6 +330,8 @@ void SuperpixelSEEDSImpl::initialize(int num_superpixels, int num_levels)
     nr_partitions_mat = Mat(nr_wh[2 * seeds_top_level + 1],
             nr_wh[2 * seeds_top_level], CV_32SC1);
     nr_partitions = (unsigned int*)nr_partitions_mat.data;
+    nr_tiles_x = (nr_wh[2 * seeds_top_level] + TILE_NR_SUPERPIXELS - 1) / TILE_NR_SUPERPIXELS;
+    nr_tiles_y = (nr_wh[2 * seeds_top_level + 1] + TILE_NR_SUPERPIXELS - 1) / TILE_NR_SUPERPIXELS;
 
     //preinit the labels (these are not changed anymore later)
     int i = 0;
@@ -339,17 +367,20 @@ void SuperpixelSEEDSImpl::initImageBins(const Mat& img, int max_value)
     int img_height = img.size().height;
     int channels = img.channels();
 
-    for (int y = 0; y < img_height; ++y)
+    parallel_for_(Range(0, img_height), [&](const Range& range)
     {
-        for (int x = 0; x < img_width; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-            const _Tp* ptr = img.ptr<_Tp>(y, x);
-            int bin = 0;
-            for (int i = 0; i < channels; ++i)
-                bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
-            image_bins[y * img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+            {
+                const _Tp* ptr = img.ptr<_Tp>(y, x);
+                int bin = 0;
+                for (int i = 0; i < channels; ++i)
+                    bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
+                image_bins[y * img_width + x] = bin;
+            }
         }
-    }
+    });
 }
 
 /* specialization for float: max_value is assumed to be 1.0f */
@@ -360,17 +391,20 @@ void SuperpixelSEEDSImpl::initImageBins<float>(const Mat& img, int)
     int img_height = img.size().height;
     int channels = img.channels();
 
-    for (int y = 0; y < img_height; ++y)
+    parallel_for_(Range(0, img_height), [&](const Range& range)
     {
-        for (int x = 0; x < img_width; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-            const float* ptr = img.ptr<float>(y, x);
-            int bin = 0;
-            for(int i=0; i<channels; ++i)
-                bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
-            image_bins[y*img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+            {
+                const float* ptr = img.ptr<float>(y, x);
+                int bin = 0;
+                for(int i=0; i<channels; ++i)
+                    bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
+                image_bins[y*img_width + x] = bin;
+            }
         }
-    }
+    });
 }
 
 void SuperpixelSEEDSImpl::initImage(InputArray img)
@@ -457,151 +491,271 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
         memset(T[level], 0, sizeof(HISTN) * nr_labels);
     }
 
-    // build histograms on the first level by adding the pixels to the blocks
-    for (int i = 0; i < width * height; ++i)
-        addPixel(0, labels_bottom[i], i);
-
-    // build histograms on the upper levels by adding the histogram from the level below
+    // build histograms on the first level by adding the pixels to the blocks,
+    // the rows of blocks are built in parallel
+    const int nr_rows0 = nr_wh[1];
+    parallel_for_(Range(0, nr_rows0), [&](const Range& range)
+    {
+        // first pixel row of a row of blocks, see computeLabel()
+        int y_begin = (int)(((int64)range.start * height + nr_rows0 - 1) / nr_rows0);
+        int y_end = range.end == nr_rows0 ? height :
+            (int)(((int64)range.end * height + nr_rows0 - 1) / nr_rows0);
+        for (int i = y_begin * width; i < y_end * width; ++i)
+            addPixel(0, labels_bottom[i], i);
+    });
+
+    // build histograms on the upper levels by adding the histogram from the level below.
+    // All the blocks of a row have their parents in the same row of the initial grid,
+    // so the rows of parents are built in parallel
     for (int level = 1; level < until_level; level++)
     {
-        for (int label = 0; label < nrLabels(level - 1); label++)
+        const int sub_w = nr_wh[2 * (level - 1)], sub_h = nr_wh[2 * (level - 1) + 1];
+        const int w = nr_wh[2 * level], h = nr_wh[2 * level + 1];
+        vector<vector<int> > sub_rows(h);
+        for (int y = 0; y < sub_h; y++)
+            sub_rows[std::min(parent[level - 1][y * sub_w] / w, h - 1)].push_back(y);
+
+        parallel_for_(Range(0, h), [&](const Range& range)
         {
-            addBlock(level, parent[level - 1][label], level - 1, label);
-        }
+            for (int row = range.start; row < range.end; row++)
+            {
+                for (size_t k = 0; k < sub_rows[row].size(); k++)
+                {
+                    int y = sub_rows[row][k];
+                    for (int label = y * sub_w; label < (y + 1) * sub_w; label++)
+                        addBlock(level, parent[level - 1][label], level - 1, label);
+                }
+            }
+        });
     }
 }
 
-void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
+void SuperpixelSEEDSImpl::tileBounds(int n, int size, int nr_top, int nr_tiles,
+        vector<int>& bounds) const
+{
+    bounds.assign(nr_tiles + 1, n);
+    bounds[0] = 0;
+    int tile = 0;
+    for (int c = 0; c < n; c++)
+    {
+        // the tile of the top level label covering the first pixel of the cell
+        int pixel = (int)(((int64)c * size + n - 1) / n);
+        int top = std::min((int)((int64)pixel * nr_top / size), nr_top - 1);
+        int cur = std::min(top / TILE_NR_SUPERPIXELS, nr_tiles - 1);
+        while (tile < cur)
+            bounds[++tile] = c;
+    }
+}
+
+template<typename Body>
+void SuperpixelSEEDSImpl::forEachTile(const vector<int>& xs, const vector<int>& ys,
+        vector<vector<Point> >& deferred_h, vector<vector<Point> >& deferred_v, const Body& body)
+{
+    const int ntx = (int)xs.size() - 1;
+    const int nty = (int)ys.size() - 1;
+    deferred_h.assign(ntx * nty, vector<Point>());
+    deferred_v.assign(ntx * nty, vector<Point>());
+
+    // the tiles are processed in 4 passes, one per corner of the 2x2 tile pattern. The tiles
+    // of a pass are separated by at least one tile, so they neither read the labels written
+    // by each other nor update the same superpixels
+    for (int pass = 0; pass < 4; pass++)
+    {
+        const int x0 = pass & 1, y0 = pass >> 1;
+        const int ncx = (ntx - x0 + 1) / 2, ncy = (nty - y0 + 1) / 2;
+        parallel_for_(Range(0, ncx * ncy), [&](const Range& range)
+        {
+            for (int k = range.start; k < range.end; k++)
+            {
+                int tx = x0 + 2 * (k % ncx), ty = y0 + 2 * (k / ncx);
+                int tile = ty * ntx + tx;
+                body(tile, Range(xs[tx], xs[tx + 1]), Range(ys[ty], ys[ty + 1]),
+                        deferred_h[tile], deferred_v[tile]);
+            }
+        });
+    }
+}
+
+bool SuperpixelSEEDSImpl::updateBlockPairH(int level, int x, int y, float req_confidence)
 {
-    int labelA;
-    int labelB;
-    int sublabel;
-    bool done;
     int step = nr_wh[2 * level];
 
-    // horizontal bidirectional block updating
-    for (int y = 1; y < nr_wh[2 * level + 1] - 1; y++)
+    // choose a label at the current level
+    int sublabel = y * step + x;
+    // get the label at the top level (= superpixel label)
+    int labelA = parent[level][y * step + x];
+    // get the neighboring label at the top level (= superpixel label)
+    int labelB = parent[level][y * step + x + 1];
+
+    // get the surrounding labels at the top level, to check for splitting
+    int a11 = parent[level][(y - 1) * step + (x - 1)];
+    int a12 = parent[level][(y - 1) * step + (x)];
+    int a21 = parent[level][(y) * step + (x - 1)];
+    int a22 = parent[level][(y) * step + (x)];
+    int a31 = parent[level][(y + 1) * step + (x - 1)];
+    int a32 = parent[level][(y + 1) * step + (x)];
+
+    if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
+            && checkSplit_hf(a11, a12, a21, a22, a31, a32)) )
+    {
+        // run algorithm as usual
+        float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
+        if( conf > req_confidence )
+        {
+            deleteBlockToplevel(labelA, level, sublabel);
+            addBlockToplevel(labelB, level, sublabel);
+            return false;
+        }
+    }
+
+    if( nr_partitions[labelB] > MINIMUM_NR_SUBLABELS )
     {
-        for (int x = 1; x < nr_wh[2 * level] - 2; x++)
+        // try opposite direction
+        sublabel = y * step + x + 1;
+        int a13 = parent[level][(y - 1) * step + (x + 1)];
+        int a14 = parent[level][(y - 1) * step + (x + 2)];
+        int a23 = parent[level][(y) * step + (x + 1)];
+        int a24 = parent[level][(y) * step + (x + 2)];
+        int a33 = parent[level][(y + 1) * step + (x + 1)];
+        int a34 = parent[level][(y + 1) * step + (x + 2)];
+        if( nr_partitions[labelB] <= 2 // == 2
+                || (nr_partitions[labelB] > 2 && checkSplit_hb(a13, a14, a23, a24, a33, a34)) )
         {
-            // choose a label at the current level
-            sublabel = y * step + x;
-            // get the label at the top level (= superpixel label)
-            labelA = parent[level][y * step + x];
-            // get the neighboring label at the top level (= superpixel label)
-            labelB = parent[level][y * step + x + 1];
-
-            if( labelA == labelB )
-                continue;
-
-            // get the surrounding labels at the top level, to check for splitting
-            int a11 = parent[level][(y - 1) * step + (x - 1)];
-            int a12 = parent[level][(y - 1) * step + (x)];
-            int a21 = parent[level][(y) * step + (x - 1)];
-            int a22 = parent[level][(y) * step + (x)];
-            int a31 = parent[level][(y + 1) * step + (x - 1)];
-            int a32 = parent[level][(y + 1) * step + (x)];
-            done = false;
-
-            if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
-                    && checkSplit_hf(a11, a12, a21, a22, a31, a32)) )
+            // run algorithm as usual
+            float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+            if( conf > req_confidence )
             {
-                // run algorithm as usual
-                float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
-                if( conf > req_confidence )
-                {
-                    deleteBlockToplevel(labelA, level, sublabel);
-                    addBlockToplevel(labelB, level, sublabel);
-                    done = true;
-                }
+                deleteBlockToplevel(labelB, level, sublabel);
+                addBlockToplevel(labelA, level, sublabel);
+                return true;
             }
+        }
+    }
+    return false;
+}
+
+bool SuperpixelSEEDSImpl::updateBlockPairV(int level, int x, int y, float req_confidence)
+{
+    int step = nr_wh[2 * level];
+
+    // choose a label at the current level
+    int sublabel = y * step + x;
+    // get the label at the top level (= superpixel label)
+    int labelA = parent[level][y * step + x];
+    // get the neighboring label at the top level (= superpixel label)
+    int labelB = parent[level][(y + 1) * step + x];
+
+    int a11 = parent[level][(y - 1) * step + (x - 1)];
+    int a12 = parent[level][(y - 1) * step + (x)];
+    int a13 = parent[level][(y - 1) * step + (x + 1)];
+    int a21 = parent[level][(y) * step + (x - 1)];
+    int a22 = parent[level][(y) * step + (x)];
+    int a23 = parent[level][(y) * step + (x + 1)];
+
+    if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
+            && checkSplit_vf(a11, a12, a13, a21, a22, a23)) )
+    {
+        // run algorithm as usual
+        float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
+        if( conf > req_confidence )
+        {
+            deleteBlockToplevel(labelA, level, sublabel);
+            addBlockToplevel(labelB, level, sublabel);
+            return false;
+        }
+    }
 
-            if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
+    if( nr_partitions[labelB] > MINIMUM_NR_SUBLABELS )
+    {
+        // try opposite direction
+        sublabel = (y + 1) * step + x;
+        int a31 = parent[level][(y + 1) * step + (x - 1)];
+        int a32 = parent[level][(y + 1) * step + (x)];
+        int a33 = parent[level][(y + 1) * step + (x + 1)];
+        int a41 = parent[level][(y + 2) * step + (x - 1)];
+        int a42 = parent[level][(y + 2) * step + (x)];
+        int a43 = parent[level][(y + 2) * step + (x + 1)];
+        if( nr_partitions[labelB] <= 2 // == 2
+                || (nr_partitions[labelB] > 2 && checkSplit_vb(a31, a32, a33, a41, a42, a43)) )
+        {
+            // run algorithm as usual
+            float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+            if( conf > req_confidence )
             {
-                // try opposite direction
-                sublabel = y * step + x + 1;
-                int a13 = parent[level][(y - 1) * step + (x + 1)];
-                int a14 = parent[level][(y - 1) * step + (x + 2)];
-                int a23 = parent[level][(y) * step + (x + 1)];
-                int a24 = parent[level][(y) * step + (x + 2)];
-                int a33 = parent[level][(y + 1) * step + (x + 1)];
-                int a34 = parent[level][(y + 1) * step + (x + 2)];
-                if( nr_partitions[labelB] <= 2 // == 2
-                        || (nr_partitions[labelB] > 2 && checkSplit_hb(a13, a14, a23, a24, a33, a34)) )
-                {
-                    // run algorithm as usual
-                    float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
-                    if( conf > req_confidence )
-                    {
-                        deleteBlockToplevel(labelB, level, sublabel);
-                        addBlockToplevel(labelA, level, sublabel);
-                        x++;
-                    }
-                }
+                deleteBlockToplevel(labelB, level, sublabel);
+                addBlockToplevel(labelA, level, sublabel);
+                return true;
             }
         }
     }
+    return false;
+}
 
-    // vertical bidirectional
-    for (int x = 1; x < nr_wh[2 * level] - 1; x++)
+void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
+{
+    const int w = nr_wh[2 * level];
+    const int h = nr_wh[2 * level + 1];
+    const int* labels_level = parent[level];
+
+    vector<int> xs, ys;
+    tileBounds(w, width, nr_wh[2 * seeds_top_level], nr_tiles_x, xs);
+    tileBounds(h, height, nr_wh[2 * seeds_top_level + 1], nr_tiles_y, ys);
+
+    // the block pairs whose superpixels belong to other tiles are updated afterwards
+    vector<vector<Point> > deferred_h, deferred_v;
+    forEachTile(xs, ys, deferred_h, deferred_v, [&](int tile, const Range& cols, const Range& rows,
+            vector<Point>& tile_deferred_h, vector<Point>& tile_deferred_v)
     {
-        for (int y = 1; y < nr_wh[2 * level + 1] - 2; y++)
+        // horizontal bidirectional block updating
+        for (int y = std::max(rows.start, 1); y < std::min(rows.end, h - 1); y++)
         {
-            // choose a label at the current level
-            sublabel = y * step + x;
-            // get the label at the top level (= superpixel label)
-            labelA = parent[level][y * step + x];
-            // get the neighboring label at the top level (= superpixel label)
-            labelB = parent[level][(y + 1) * step + x];
-
-            if( labelA == labelB )
-                continue;
-
-            int a11 = parent[level][(y - 1) * step + (x - 1)];
-            int a12 = parent[level][(y - 1) * step + (x)];
-            int a13 = parent[level][(y - 1) * step + (x + 1)];
-            int a21 = parent[level][(y) * step + (x - 1)];
-            int a22 = parent[level][(y) * step + (x)];
-            int a23 = parent[level][(y) * step + (x + 1)];
-
-            done = false;
-            if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
-                    && checkSplit_vf(a11, a12, a13, a21, a22, a23)) )
+            for (int x = std::max(cols.start, 1); x < std::min(cols.end, w - 2); x++)
             {
-                // run algorithm as usual
-                float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
-                if( conf > req_confidence )
-                {
-                    deleteBlockToplevel(labelA, level, sublabel);
-                    addBlockToplevel(labelB, level, sublabel);
-                    done = true;
-                }
+                int labelA = labels_level[y * w + x];
+                int labelB = labels_level[y * w + x + 1];
+                if( labelA == labelB )
+                    continue;
+                if( tileOf(labelA) != tile || tileOf(labelB) != tile )
+                    tile_deferred_h.push_back(Point(x, y));
+                else if( updateBlockPairH(level, x, y, req_confidence) )
+                    x++;
             }
+        }
 
-            if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
+        // vertical bidirectional
+        for (int x = std::max(cols.start, 1); x < std::min(cols.end, w - 1); x++)
+        {
+            for (int y = std::max(rows.start, 1); y < std::min(rows.end, h - 2); y++)
             {
-                // try opposite direction
-                sublabel = (y + 1) * step + x;
-                int a31 = parent[level][(y + 1) * step + (x - 1)];
-                int a32 = parent[level][(y + 1) * step + (x)];
-                int a33 = parent[level][(y + 1) * step + (x + 1)];
-                int a41 = parent[level][(y + 2) * step + (x - 1)];
-                int a42 = parent[level][(y + 2) * step + (x)];
-                int a43 = parent[level][(y + 2) * step + (x + 1)];
-                if( nr_partitions[labelB] <= 2 // == 2
-                        || (nr_partitions[labelB] > 2 && checkSplit_vb(a31, a32, a33, a41, a42, a43)) )
-                {
-                    // run algorithm as usual
-                    float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
-                    if( conf > req_confidence )
-                    {
-                        deleteBlockToplevel(labelB, level, sublabel);
-                        addBlockToplevel(labelA, level, sublabel);
-                        y++;
-                    }
-                }
+                int labelA = labels_level[y * w + x];
+                int labelB = labels_level[(y + 1) * w + x];
+                if( labelA == labelB )
+                    continue;
+                if( tileOf(labelA) != tile || tileOf(labelB) != tile )
+                    tile_deferred_v.push_back(Point(x, y));
+                else if( updateBlockPairV(level, x, y, req_confidence) )
+                    y++;
             }
         }
+    });
+
+    for (size_t t = 0; t < deferred_h.size(); t++)
+    {
+        for (size_t k = 0; k < deferred_h[t].size(); k++)
+        {
+            Point pt = deferred_h[t][k];
+            if( labels_level[pt.y * w + pt.x] != labels_level[pt.y * w + pt.x + 1] )
+                updateBlockPairH(level, pt.x, pt.y, req_confidence);
+        }
+    }
+    for (size_t t = 0; t < deferred_v.size(); t++)
+    {
+        for (size_t k = 0; k < deferred_v[t].size(); k++)
+        {
+            Point pt = deferred_v[t][k];
+            if( labels_level[pt.y * w + pt.x] != labels_level[(pt.y + 1) * w + pt.x] )
+                updateBlockPairV(level, pt.x, pt.y, req_confidence);
+        }
     }
 }
 
@@ -635,196 +789,269 @@ int SuperpixelSEEDSImpl::goDownOneLevel()
     return new_level;
 }
 
-void SuperpixelSEEDSImpl::updatePixels()
+// index of the first pair of different labels row[x], row[x+1] with x in [x, end), or end
+static inline int nextLabelChange(const int* row, int x, int end)
 {
-    int labelA;
-    int labelB;
+#if CV_SIMD
+    for (; x <= end - v_int32::nlanes; x += v_int32::nlanes)
+    {
+        if( v_check_any(vx_load(row + x) != vx_load(row + x + 1)) )
+            break;
+    }
+#endif
+    while (x < end && row[x] == row[x + 1])
+        x++;
+    return x;
+}
+
+bool SuperpixelSEEDSImpl::updatePixelPairH(int x, int y)
+{
+    int labelA = labels[(y) * width + (x)];
+    int labelB = labels[(y) * width + (x + 1)];
     int priorA = 0;
     int priorB = 0;
 
-    for (int y = 1; y < height - 1; y++)
+    int a22 = labelA;
+    int a23 = labelB;
+    if( forwardbackward )
     {
-        for (int x = 1; x < width - 2; x++)
+        // horizontal bidirectional
+        int a11 = labels[(y - 1) * width + (x - 1)];
+        int a12 = labels[(y - 1) * width + (x)];
+        int a21 = labels[(y) * width + (x - 1)];
+        int a31 = labels[(y + 1) * width + (x - 1)];
+        int a32 = labels[(y + 1) * width + (x)];
+        if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
         {
+            if( seeds_prior )
+            {
+                priorA = threebyfour(x, y, labelA);
+                priorB = threebyfour(x, y, labelB);
+            }
 
-            labelA = labels[(y) * width + (x)];
-            labelB = labels[(y) * width + (x + 1)];
-
-            if( labelA != labelB )
+            if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+            {
+                update(labelB, y * width + x, labelA);
+            }
+            else
             {
-                int a22 = labelA;
-                int a23 = labelB;
-                if( forwardbackward )
+                int a13 = labels[(y - 1) * width + (x + 1)];
+                int a14 = labels[(y - 1) * width + (x + 2)];
+                int a24 = labels[(y) * width + (x + 2)];
+                int a33 = labels[(y + 1) * width + (x + 1)];
+                int a34 = labels[(y + 1) * width + (x + 2)];
+                if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
                 {
-                    // horizontal bidirectional
-                    int a11 = labels[(y - 1) * width + (x - 1)];
-                    int a12 = labels[(y - 1) * width + (x)];
-                    int a21 = labels[(y) * width + (x - 1)];
-                    int a31 = labels[(y + 1) * width + (x - 1)];
-                    int a32 = labels[(y + 1) * width + (x)];
-                    if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
+                    if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
                     {
-                        if( seeds_prior )
-                        {
-                            priorA = threebyfour(x, y, labelA);
-                            priorB = threebyfour(x, y, labelB);
-                        }
-
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                        {
-                            update(labelB, y * width + x, labelA);
-                        }
-                        else
-                        {
-                            int a13 = labels[(y - 1) * width + (x + 1)];
-                            int a14 = labels[(y - 1) * width + (x + 2)];
-                            int a24 = labels[(y) * width + (x + 2)];
-                            int a33 = labels[(y + 1) * width + (x + 1)];
-                            int a34 = labels[(y + 1) * width + (x + 2)];
-                            if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
-                            {
-                                if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
-                                {
-                                    update(labelA, y * width + x + 1, labelB);
-                                    x++;
-                                }
-                            }
-                        }
+                        update(labelA, y * width + x + 1, labelB);
+                        return true;
                     }
                 }
-                else
-                { // forward backward
-                    // horizontal bidirectional
-                    int a13 = labels[(y - 1) * width + (x + 1)];
-                    int a14 = labels[(y - 1) * width + (x + 2)];
-                    int a24 = labels[(y) * width + (x + 2)];
-                    int a33 = labels[(y + 1) * width + (x + 1)];
-                    int a34 = labels[(y + 1) * width + (x + 2)];
-                    if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
+            }
+        }
+    }
+    else
+    { // forward backward
+        // horizontal bidirectional
+        int a13 = labels[(y - 1) * width + (x + 1)];
+        int a14 = labels[(y - 1) * width + (x + 2)];
+        int a24 = labels[(y) * width + (x + 2)];
+        int a33 = labels[(y + 1) * width + (x + 1)];
+        int a34 = labels[(y + 1) * width + (x + 2)];
+        if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
+        {
+            if( seeds_prior )
+            {
+                priorA = threebyfour(x, y, labelA);
+                priorB = threebyfour(x, y, labelB);
+            }
+
+            if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+            {
+                update(labelA, y * width + x + 1, labelB);
+                return true;
+            }
+            else
+            {
+                int a11 = labels[(y - 1) * width + (x - 1)];
+                int a12 = labels[(y - 1) * width + (x)];
+                int a21 = labels[(y) * width + (x - 1)];
+                int a31 = labels[(y + 1) * width + (x - 1)];
+                int a32 = labels[(y + 1) * width + (x)];
+                if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
+                {
+                    if( probability(y * width + x, labelA, labelB, priorA, priorB) )
                     {
-                        if( seeds_prior )
-                        {
-                            priorA = threebyfour(x, y, labelA);
-                            priorB = threebyfour(x, y, labelB);
-                        }
-
-                        if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
-                        {
-                            update(labelA, y * width + x + 1, labelB);
-                            x++;
-                        }
-                        else
-                        {
-                            int a11 = labels[(y - 1) * width + (x - 1)];
-                            int a12 = labels[(y - 1) * width + (x)];
-                            int a21 = labels[(y) * width + (x - 1)];
-                            int a31 = labels[(y + 1) * width + (x - 1)];
-                            int a32 = labels[(y + 1) * width + (x)];
-                            if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
-                            {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                                {
-                                    update(labelB, y * width + x, labelA);
-                                }
-                            }
-                        }
+                        update(labelB, y * width + x, labelA);
                     }
                 }
-            } // labelA != labelB
-        } // for x
-    } // for y
+            }
+        }
+    }
+    return false;
+}
+
+bool SuperpixelSEEDSImpl::updatePixelPairV(int x, int y)
+{
+    int labelA = labels[(y) * width + (x)];
+    int labelB = labels[(y + 1) * width + (x)];
+    int priorA = 0;
+    int priorB = 0;
+
+    int a22 = labelA;
+    int a32 = labelB;
 
-    for (int x = 1; x < width - 1; x++)
+    if( forwardbackward )
     {
-        for (int y = 1; y < height - 2; y++)
+        // vertical bidirectional
+        int a11 = labels[(y - 1) * width + (x - 1)];
+        int a12 = labels[(y - 1) * width + (x)];
+        int a13 = labels[(y - 1) * width + (x + 1)];
+        int a21 = labels[(y) * width + (x - 1)];
+        int a23 = labels[(y) * width + (x + 1)];
+        if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
         {
-
-            labelA = labels[(y) * width + (x)];
-            labelB = labels[(y + 1) * width + (x)];
-            if( labelA != labelB )
+            if( seeds_prior )
             {
-                int a22 = labelA;
-                int a32 = labelB;
+                priorA = fourbythree(x, y, labelA);
+                priorB = fourbythree(x, y, labelB);
+            }
 
-                if( forwardbackward )
+            if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+            {
+                update(labelB, y * width + x, labelA);
+            }
+            else
+            {
+                int a31 = labels[(y + 1) * width + (x - 1)];
+                int a33 = labels[(y + 1) * width + (x + 1)];
+                int a41 = labels[(y + 2) * width + (x - 1)];
+                int a42 = labels[(y + 2) * width + (x)];
+                int a43 = labels[(y + 2) * width + (x + 1)];
+                if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
                 {
-                    // vertical bidirectional
-                    int a11 = labels[(y - 1) * width + (x - 1)];
-                    int a12 = labels[(y - 1) * width + (x)];
-                    int a13 = labels[(y - 1) * width + (x + 1)];
-                    int a21 = labels[(y) * width + (x - 1)];
-                    int a23 = labels[(y) * width + (x + 1)];
-                    if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
+                    if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
                     {
-                        if( seeds_prior )
-                        {
-                            priorA = fourbythree(x, y, labelA);
-                            priorB = fourbythree(x, y, labelB);
-                        }
-
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                        {
-                            update(labelB, y * width + x, labelA);
-                        }
-                        else
-                        {
-                            int a31 = labels[(y + 1) * width + (x - 1)];
-                            int a33 = labels[(y + 1) * width + (x + 1)];
-                            int a41 = labels[(y + 2) * width + (x - 1)];
-                            int a42 = labels[(y + 2) * width + (x)];
-                            int a43 = labels[(y + 2) * width + (x + 1)];
-                            if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
-                            {
-                                if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
-                                {
-                                    update(labelA, (y + 1) * width + x, labelB);
-                                    y++;
-                                }
-                            }
-                        }
+                        update(labelA, (y + 1) * width + x, labelB);
+                        return true;
                     }
                 }
-                else
-                { // forwardbackward
-                    // vertical bidirectional
-                    int a31 = labels[(y + 1) * width + (x - 1)];
-                    int a33 = labels[(y + 1) * width + (x + 1)];
-                    int a41 = labels[(y + 2) * width + (x - 1)];
-                    int a42 = labels[(y + 2) * width + (x)];
-                    int a43 = labels[(y + 2) * width + (x + 1)];
-                    if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
+            }
+        }
+    }
+    else
+    { // forwardbackward
+        // vertical bidirectional
+        int a31 = labels[(y + 1) * width + (x - 1)];
+        int a33 = labels[(y + 1) * width + (x + 1)];
+        int a41 = labels[(y + 2) * width + (x - 1)];
+        int a42 = labels[(y + 2) * width + (x)];
+        int a43 = labels[(y + 2) * width + (x + 1)];
+        if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
+        {
+            if( seeds_prior )
+            {
+                priorA = fourbythree(x, y, labelA);
+                priorB = fourbythree(x, y, labelB);
+            }
+
+            if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+            {
+                update(labelA, (y + 1) * width + x, labelB);
+                return true;
+            }
+            else
+            {
+                int a11 = labels[(y - 1) * width + (x - 1)];
+                int a12 = labels[(y - 1) * width + (x)];
+                int a13 = labels[(y - 1) * width + (x + 1)];
+                int a21 = labels[(y) * width + (x - 1)];
+                int a23 = labels[(y) * width + (x + 1)];
+                if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
+                {
+                    if( probability(y * width + x, labelA, labelB, priorA, priorB) )
                     {
-                        if( seeds_prior )
-                        {
-                            priorA = fourbythree(x, y, labelA);
-                            priorB = fourbythree(x, y, labelB);
-                        }
-
-                        if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
-                        {
-                            update(labelA, (y + 1) * width + x, labelB);
-                            y++;
-                        }
-                        else
-                        {
-                            int a11 = labels[(y - 1) * width + (x - 1)];
-                            int a12 = labels[(y - 1) * width + (x)];
-                            int a13 = labels[(y - 1) * width + (x + 1)];
-                            int a21 = labels[(y) * width + (x - 1)];
-                            int a23 = labels[(y) * width + (x + 1)];
-                            if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
-                            {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                                {
-                                    update(labelB, y * width + x, labelA);
-                                }
-                            }
-                        }
+                        update(labelB, y * width + x, labelA);
                     }
                 }
-            } // labelA != labelB
-        } // for y
-    } // for x
+            }
+        }
+    }
+    return false;
+}
+
+void SuperpixelSEEDSImpl::updatePixels()
+{
+    int labelA;
+    int labelB;
+
+    // The image is split into tiles of TILE_NR_SUPERPIXELS^2 superpixels of the initial grid,
+    // a superpixel is updated by the tile it started in. A tile only moves the pixels between
+    // its own superpixels, the pairs of pixels at the boundaries with the superpixels of other
+    // tiles are moved serially after all the tiles. Only the pixels at the boundaries between
+    // different labels are visited.
+    vector<int> xs, ys;
+    tileBounds(width, width, nr_wh[2 * seeds_top_level], nr_tiles_x, xs);
+    tileBounds(height, height, nr_wh[2 * seeds_top_level + 1], nr_tiles_y, ys);
+
+    vector<vector<Point> > deferred_h, deferred_v;
+    forEachTile(xs, ys, deferred_h, deferred_v, [&](int tile, const Range& cols, const Range& rows,
+            vector<Point>& tile_deferred_h, vector<Point>& tile_deferred_v)
+    {
+        const int x_begin = std::max(cols.start, 1);
+
+        // horizontal bidirectional
+        const int x_end_h = std::min(cols.end, width - 2);
+        for (int y = std::max(rows.start, 1); y < std::min(rows.end, height - 1); y++)
+        {
+            const int* row = labels + y * width;
+            for (int x = nextLabelChange(row, x_begin, x_end_h); x < x_end_h;
+                    x = nextLabelChange(row, x + 1, x_end_h))
+            {
+                if( tileOf(row[x]) != tile || tileOf(row[x + 1]) != tile )
+                    tile_deferred_h.push_back(Point(x, y));
+                else if( updatePixelPairH(x, y) )
+                    x++;
+            }
+        }
+
+        // vertical bidirectional
+        const int y_end_v = std::min(rows.end, height - 2);
+        for (int x = x_begin; x < std::min(cols.end, width - 1); x++)
+        {
+            for (int y = std::max(rows.start, 1); y < y_end_v; y++)
+            {
+                int lA = labels[(y) * width + (x)];
+                int lB = labels[(y + 1) * width + (x)];
+                if( lA == lB )
+                    continue;
+                if( tileOf(lA) != tile || tileOf(lB) != tile )
+                    tile_deferred_v.push_back(Point(x, y));
+                else if( updatePixelPairV(x, y) )
+                    y++;
+            }
+        }
+    });
+
+    for (size_t t = 0; t < deferred_h.size(); t++)
+    {
+        for (size_t k = 0; k < deferred_h[t].size(); k++)
+        {
+            Point pt = deferred_h[t][k];
+            if( labels[pt.y * width + pt.x] != labels[pt.y * width + pt.x + 1] )
+                updatePixelPairH(pt.x, pt.y);
+        }
+    }
+    for (size_t t = 0; t < deferred_v.size(); t++)
+    {
+        for (size_t k = 0; k < deferred_v[t].size(); k++)
+        {
+            Point pt = deferred_v[t][k];
+            if( labels[pt.y * width + pt.x] != labels[(pt.y + 1) * width + pt.x] )
+                updatePixelPairV(pt.x, pt.y);
+        }
+    }
     forwardbackward = !forwardbackward;
 
     // update border pixels
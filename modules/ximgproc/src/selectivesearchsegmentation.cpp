@@ -258,6 +258,9 @@ namespace cv {
                     virtual void addStrategy(Ptr<SelectiveSearchSegmentationStrategy> g, float weight) CV_OVERRIDE;
                     virtual void clearStrategies() CV_OVERRIDE;
 
+                    // Copy with copies of the sub-strategies, empty if one of them can't be copied
+                    Ptr<SelectiveSearchSegmentationStrategy> clone() const;
+
                 private:
                     String name_;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
@@ -688,6 +691,118 @@ namespace cv {
 
             // Core
 
+            /****************************************
+             * Parallel processing helpers
+             ***************************************/
+
+            // A new instance of a built-in strategy, to be used by a single thread. The strategies
+            // keep per-image state only, so a new instance gives the same similarities.
+            // Returns an empty pointer for the strategies implemented outside of this file.
+            static Ptr<SelectiveSearchSegmentationStrategy> cloneStrategy(const Ptr<SelectiveSearchSegmentationStrategy>& s) {
+                SelectiveSearchSegmentationStrategy* p = s.get();
+
+                if (dynamic_cast<SelectiveSearchSegmentationStrategyColorImpl*>(p)) {
+                    return makePtr<SelectiveSearchSegmentationStrategyColorImpl>();
+                }
+                if (dynamic_cast<SelectiveSearchSegmentationStrategySizeImpl*>(p)) {
+                    return makePtr<SelectiveSearchSegmentationStrategySizeImpl>();
+                }
+                if (dynamic_cast<SelectiveSearchSegmentationStrategyFillImpl*>(p)) {
+                    return makePtr<SelectiveSearchSegmentationStrategyFillImpl>();
+                }
+                if (dynamic_cast<SelectiveSearchSegmentationStrategyTextureImpl*>(p)) {
+                    return makePtr<SelectiveSearchSegmentationStrategyTextureImpl>();
+                }
+                if (SelectiveSearchSegmentationStrategyMultipleImpl* m = dynamic_cast<SelectiveSearchSegmentationStrategyMultipleImpl*>(p)) {
+                    return m->clone();
+                }
+
+                return Ptr<SelectiveSearchSegmentationStrategy>();
+            }
+
+            Ptr<SelectiveSearchSegmentationStrategy> SelectiveSearchSegmentationStrategyMultipleImpl::clone() const {
+                Ptr<SelectiveSearchSegmentationStrategyMultipleImpl> m = makePtr<SelectiveSearchSegmentationStrategyMultipleImpl>();
+
+                for (unsigned int i = 0; i < strategies.size(); i++) {
+                    Ptr<SelectiveSearchSegmentationStrategy> c = cloneStrategy(strategies[i]);
+                    if (!c) {
+                        return Ptr<SelectiveSearchSegmentationStrategy>();
+                    }
+                    m->addStrategy(c, weights[i]);
+                }
+
+                return m;
+            }
+
+            // Initial segmentation of an image, shared by the strategies
+            struct ImageSegmentation {
+                ImageSegmentation() : nb_segs(0), ready(false), remaining(0) {}
+
+                Mat img_regions;
+                Mat_<char> is_neighbour;
+                Mat_<int> sizes;
+                int nb_segs;
+                std::vector<Rect> bounding_rects;
+
+                bool ready;
+                int remaining; // Number of strategies still using it, it's released after the last one
+                Mutex mutex;
+            };
+
+            static void computeImageSegmentation(const Mat& img, const Ptr<GraphSegmentation>& gs, ImageSegmentation& seg) {
+
+                // Compute initial segmentation
+                gs->processImage(img, seg.img_regions);
+
+                // Get number of regions
+                double min, max;
+                minMaxLoc(seg.img_regions, &min, &max);
+                int nb_segs = (int)max + 1;
+                seg.nb_segs = nb_segs;
+
+                // Compute bouding rects and neighbours
+                std::vector<Point> tl(nb_segs, Point(INT_MAX, INT_MAX)), br(nb_segs, Point(-1, -1));
+
+                seg.is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
+                seg.sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+
+                Mat_<char>& is_neighbour = seg.is_neighbour;
+                int* sizes = seg.sizes[0];
+                const int* previous_p = NULL;
+
+                for (int i = 0; i < (int)seg.img_regions.rows; i++) {
+                    const int* p = seg.img_regions.ptr<int>(i);
+
+                    for (int j = 0; j < (int)seg.img_regions.cols; j++) {
+
+                        sizes[p[j]]++;
+                        tl[p[j]].x = std::min(tl[p[j]].x, j);
+                        tl[p[j]].y = std::min(tl[p[j]].y, i);
+                        br[p[j]].x = std::max(br[p[j]].x, j);
+                        br[p[j]].y = std::max(br[p[j]].y, i);
+
+                        if (i > 0 && j > 0) {
+
+                            is_neighbour(p[j], p[j - 1]) = 1;
+                            is_neighbour(p[j], previous_p[j]) = 1;
+                            is_neighbour(p[j], previous_p[j - 1]) = 1;
+
+                            is_neighbour(p[j - 1], p[j]) = 1;
+                            is_neighbour(previous_p[j], p[j]) = 1;
+                            is_neighbour(previous_p[j - 1], p[j]) = 1;
+                        }
+                    }
+                    previous_p = p;
+                }
+
+                seg.bounding_rects.resize(nb_segs);
+                for (int r = 0; r < nb_segs; r++) {
+                    if (br[r].x >= 0) {
+                        seg.bounding_rects[r] = Rect(tl[r], br[r] + Point(1, 1));
+                    }
+                }
+            }
+
             class SelectiveSearchSegmentationImpl CV_FINAL : public SelectiveSearchSegmentation {
                 public:
                     SelectiveSearchSegmentationImpl() {
@@ -731,7 +846,7 @@ namespace cv {
                     std::vector<Ptr<GraphSegmentation> > segmentations;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
 
-                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
+                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id, RNG& rng);
             };
 
             void SelectiveSearchSegmentationImpl::setBaseImage(InputArray img) {
@@ -886,78 +1001,72 @@ namespace cv {
 
             void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
 
-                std::vector<Region> all_regions;
-
-                int image_id = 0;
-
-                for(std::vector<Mat>::iterator image = images.begin(); image != images.end(); ++image) {
-                    for(std::vector<Ptr<GraphSegmentation> >::iterator gs = segmentations.begin(); gs != segmentations.end(); ++gs) {
-
-                        Mat img_regions;
-                        Mat_<char> is_neighbour;
-                        Mat_<int> sizes;
+                CV_TRACE_FUNCTION();
 
-                        // Compute initial segmentation
-                        (*gs)->processImage(*image, img_regions);
+                const int nb_segmentations = (int)segmentations.size();
+                const int nb_strategies = (int)strategies.size();
+                const int nb_images = (int)(images.size() * segmentations.size());
 
-                        // Get number of regions
-                        double min, max;
-                        minMaxLoc(img_regions, &min, &max);
-                        int nb_segs = (int)max + 1;
-
-                        // Compute bouding rects and neighbours
-                        std::vector<Rect> bounding_rects;
-                        bounding_rects.resize(nb_segs);
-
-                        std::vector<std::vector<cv::Point> > points;
-
-                        points.resize(nb_segs);
-
-                        is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
-                        sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
-
-                        const int* previous_p = NULL;
-
-                        for (int i = 0; i < (int)img_regions.rows; i++) {
-                            const int* p = img_regions.ptr<int>(i);
-
-                            for (int j = 0; j < (int)img_regions.cols; j++) {
+                // Every (image, segmentation, strategy) is a job, in the order of the serial loops.
+                // The strategies which can't be copied are shared by their jobs, one job at a time.
+                std::vector<bool> copyable(nb_strategies);
+                std::vector<Mutex> strategy_mutex(nb_strategies);
+                for (int i = 0; i < nb_strategies; i++) {
+                    copyable[i] = !cloneStrategy(strategies[i]).empty();
+                }
 
-                                points[p[j]].push_back(cv::Point(j, i));
-                                sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
+                std::vector<ImageSegmentation> segmented(nb_images);
+                for (int i = 0; i < nb_images; i++) {
+                    segmented[i].remaining = nb_strategies;
+                }
 
-                                if (i > 0 && j > 0) {
+                std::vector<std::vector<Region> > job_regions(nb_images * nb_strategies);
 
-                                    is_neighbour.at<char>(p[j], p[j - 1]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
+                parallel_for_(Range(0, (int)job_regions.size()), [&](const Range& range) {
+                    for (int job = range.start; job < range.end; job++) {
+                        const int image_id = job / nb_strategies;
+                        const int strategy_id = job % nb_strategies;
+                        const Mat& image = images[image_id / nb_segmentations];
+                        ImageSegmentation& seg = segmented[image_id];
 
-                                    is_neighbour.at<char>(p[j - 1], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
-                                }
+                        {
+                            AutoLock lock(seg.mutex);
+                            if (!seg.ready) {
+                                computeImageSegmentation(image, segmentations[image_id % nb_segmentations], seg);
+                                seg.ready = true;
                             }
-                            previous_p = p;
                         }
 
-                        for(int seg = 0; seg < nb_segs; seg++) {
-                            bounding_rects[seg] = cv::boundingRect(points[seg]);
-                        }
+                        // Ranks are random, every job has its own sequence so they don't depend on the scheduling
+                        RNG rng((uint64)job + 1);
 
-                        for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
-                            std::vector<Region> regions;
-                            hierarchicalGrouping(*image, *strategy, img_regions, is_neighbour, sizes, nb_segs, bounding_rects, regions, image_id);
+                        if (copyable[strategy_id]) {
+                            Ptr<SelectiveSearchSegmentationStrategy> strategy = cloneStrategy(strategies[strategy_id]);
+                            hierarchicalGrouping(image, strategy, seg.img_regions, seg.is_neighbour, seg.sizes, seg.nb_segs, seg.bounding_rects, job_regions[job], image_id, rng);
+                        } else {
+                            AutoLock lock(strategy_mutex[strategy_id]);
+                            hierarchicalGrouping(image, strategies[strategy_id], seg.img_regions, seg.is_neighbour, seg.sizes, seg.nb_segs, seg.bounding_rects, job_regions[job], image_id, rng);
+                        }
 
-                            for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                                all_regions.push_back(*region);
+                        {
+                            AutoLock lock(seg.mutex);
+                            if (--seg.remaining == 0) {
+                                seg.img_regions.release();
+                                seg.is_neighbour.release();
+                                seg.sizes.release();
+                                std::vector<Rect>().swap(seg.bounding_rects);
                             }
                         }
-
-                        image_id++;
                     }
+                });
+
+                std::vector<Region> all_regions;
+                for (size_t job = 0; job < job_regions.size(); job++) {
+                    all_regions.insert(all_regions.end(), job_regions[job].begin(), job_regions[job].end());
+                    std::vector<Region>().swap(job_regions[job]);
                 }
 
-                std::sort(all_regions.begin(), all_regions.end());
+                std::stable_sort(all_regions.begin(), all_regions.end());
 
                 std::map<Rect, char, rectComparator> processed_rect;
 
@@ -973,7 +1082,7 @@ namespace cv {
 
             }
 
-            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
+            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id, RNG& rng) {
 
                 Mat sizes = sizes_.clone();
 
@@ -1083,7 +1192,7 @@ namespace cv {
                 // Compute regions' rank
                 for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
                     // Note: this is inverted from the paper, but we keep the lover region first so it's works
-                    (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
+                    (*region).rank = rng.uniform(0., 1.) * ((*region).level);
                 }
 
             }
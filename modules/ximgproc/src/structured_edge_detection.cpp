@@ -421,6 +421,33 @@ namespace cv
 namespace ximgproc
 {
 
+// Layout of the binary model files written by saveBinaryModel. Every array starts
+// at a SED_MODEL_ALIGNMENT aligned offset, so that it can be used in place once loaded.
+static const char SED_MODEL_MAGIC[8] = {'C', 'V', 'S', 'E', 'D', 'R', 'F', '\0'};
+static const uint SED_MODEL_VERSION = 1;
+static const uint SED_MODEL_ENDIAN_TAG = 0x01020304;
+static const size_t SED_MODEL_ALIGNMENT = 64;
+// featureIds, thresholds, childs, edgeBoundaries, edgeBins, all of them are 4-byte values
+static const int SED_MODEL_ARRAYS = 5;
+
+struct SEDModelHeader
+{
+    char magic[8];
+    uint version;
+    uint endianTag;
+
+    int stride, shrinkNumber, patchSize, patchInnerSize;
+    int numberOfGradientOrientations, gradientSmoothingRadius;
+    int regFeatureSmoothingRadius, ssFeatureSmoothingRadius;
+    int gradientNormalizationRadius, selfsimilarityGridSize;
+    int numberOfTrees, numberOfTreesToEvaluate;
+    int numberOfTreeNodes, reserved;
+
+    uint64 counts[SED_MODEL_ARRAYS];
+    uint64 offsets[SED_MODEL_ARRAYS];
+    uint64 fileSize;
+};
+
 class StructuredEdgeDetectionImpl : public StructuredEdgeDetection
 {
 public:
@@ -435,6 +462,80 @@ public:
           howToGetFeatures( (!_howToGetFeatures.empty())
                           ? _howToGetFeatures
                           : createRFFeatureGetter().staticCast<const RFFeatureGetter>() )
+    {
+        if ( isBinaryModel(filename) )
+            loadBinaryModel(filename);
+        else
+            loadModel(filename);
+    }
+
+    /*!
+     * The function stores __rf model in a binary file
+     *
+     * \param filename : name of the binary model file
+     */
+    void saveBinaryModel(const String &filename) const CV_OVERRIDE
+    {
+        SEDModelHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SED_MODEL_MAGIC, sizeof(header.magic));
+        header.version = SED_MODEL_VERSION;
+        header.endianTag = SED_MODEL_ENDIAN_TAG;
+
+        header.stride = __rf.options.stride;
+        header.shrinkNumber = __rf.options.shrinkNumber;
+        header.patchSize = __rf.options.patchSize;
+        header.patchInnerSize = __rf.options.patchInnerSize;
+        header.numberOfGradientOrientations = __rf.options.numberOfGradientOrientations;
+        header.gradientSmoothingRadius = __rf.options.gradientSmoothingRadius;
+        header.regFeatureSmoothingRadius = __rf.options.regFeatureSmoothingRadius;
+        header.ssFeatureSmoothingRadius = __rf.options.ssFeatureSmoothingRadius;
+        header.gradientNormalizationRadius = __rf.options.gradientNormalizationRadius;
+        header.selfsimilarityGridSize = __rf.options.selfsimilarityGridSize;
+        header.numberOfTrees = __rf.options.numberOfTrees;
+        header.numberOfTreesToEvaluate = __rf.options.numberOfTreesToEvaluate;
+        header.numberOfTreeNodes = __rf.numberOfTreeNodes;
+
+        const Mat* arrays[SED_MODEL_ARRAYS];
+        getModelArrays(arrays);
+
+        uint64 offset = sizeof(header);
+        for (int i = 0; i < SED_MODEL_ARRAYS; ++i)
+        {
+            offset = alignSize((size_t)offset, (int)SED_MODEL_ALIGNMENT);
+            header.counts[i] = arrays[i]->total();
+            header.offsets[i] = offset;
+            offset += header.counts[i] * sizeof(int);
+        }
+        header.fileSize = offset;
+
+        FILE* f = fopen(filename.c_str(), "wb");
+        if (!f)
+            CV_Error(Error::StsError, "Cannot open " + filename + " for writing");
+
+        fwrite(&header, sizeof(header), 1, f);
+        for (int i = 0; i < SED_MODEL_ARRAYS; ++i)
+        {
+            static const char padding[SED_MODEL_ALIGNMENT] = {0};
+            fwrite(padding, (size_t)(header.offsets[i] - (uint64)ftell(f)), 1, f);
+            if (header.counts[i] > 0)
+                fwrite(arrays[i]->data, (size_t)header.counts[i] * sizeof(int), 1, f);
+        }
+
+        const bool ok = !ferror(f) && (uint64)ftell(f) == header.fileSize;
+        fclose(f);
+
+        if (!ok)
+            CV_Error(Error::StsError, "Failed to write the model to " + filename);
+    }
+
+protected:
+    /*!
+     * This function loads __rf model from a YAML file
+     *
+     * \param filename : name of the file where the model is stored
+     */
+    void loadModel(const cv::String &filename)
     {
         cv::FileStorage modelFile(filename, FileStorage::READ);
         CV_Assert( modelFile.isOpened() );
@@ -475,13 +576,15 @@ public:
         cv::FileNode featureIds = modelFile["featureIds"];
 
         std::vector <int> currentTree;
+        std::vector <int> childsVec, featureIdsVec, edgeBoundariesVec, edgeBinsVec;
+        std::vector <float> thresholdsVec;
 
         for(cv::FileNodeIterator it = childs.begin();
             it != childs.end(); ++it)
         {
             (*it) >> currentTree;
             std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.childs));
+                std::back_inserter(childsVec));
         }
 
         for(cv::FileNodeIterator it = featureIds.begin();
@@ -489,7 +592,7 @@ public:
         {
             (*it) >> currentTree;
             std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.featureIds));
+                std::back_inserter(featureIdsVec));
         }
 
         cv::FileNode thresholds = modelFile["thresholds"];
@@ -500,7 +603,7 @@ public:
         {
             (*it) >> fcurrentTree;
             std::copy(fcurrentTree.begin(), fcurrentTree.end(),
-                std::back_inserter(__rf.thresholds));
+                std::back_inserter(thresholdsVec));
         }
 
         cv::FileNode edgeBoundaries = modelFile["edgeBoundaries"];
@@ -511,7 +614,7 @@ public:
         {
             (*it) >> currentTree;
             std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.edgeBoundaries));
+                std::back_inserter(edgeBoundariesVec));
         }
 
         for(cv::FileNodeIterator it = edgeBins.begin();
@@ -519,12 +622,199 @@ public:
         {
             (*it) >> currentTree;
             std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.edgeBins));
+                std::back_inserter(edgeBinsVec));
+        }
+
+        __rf.numberOfTreeNodes = int( childsVec.size() ) / __rf.options.numberOfTrees;
+
+        __rf.childs = Mat(childsVec, true);
+        __rf.featureIds = Mat(featureIdsVec, true);
+        __rf.thresholds = Mat(thresholdsVec, true);
+        __rf.edgeBoundaries = Mat(edgeBoundariesVec, true);
+        __rf.edgeBins = Mat(edgeBinsVec, true);
+    }
+
+
+    static bool isBinaryModel(const cv::String &filename)
+    {
+        char magic[sizeof(SED_MODEL_MAGIC)];
+        FILE* f = fopen(filename.c_str(), "rb");
+        if (!f)
+            return false;
+        const bool ok = fread(magic, sizeof(magic), 1, f) == 1
+            && memcmp(magic, SED_MODEL_MAGIC, sizeof(magic)) == 0;
+        fclose(f);
+        return ok;
+    }
+
+    /*!
+     * This function reads a binary model file in one go and uses the trees in place
+     *
+     * \param filename : name of the file where the model is stored
+     */
+    void loadBinaryModel(const cv::String &filename)
+    {
+        FILE* f = fopen(filename.c_str(), "rb");
+        if (!f)
+            CV_Error(Error::StsError, "Cannot open the model file " + filename);
+
+        fseek(f, 0, SEEK_END);
+        const long fileSize = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        // the buffer is allocated aligned, so are the arrays within it
+        Mat data;
+        bool ok = fileSize >= (long)sizeof(SEDModelHeader) && fileSize <= (long)INT_MAX;
+        if (ok)
+        {
+            data.create(1, (int)fileSize, CV_8U);
+            ok = fread(data.data, (size_t)fileSize, 1, f) == 1;
+        }
+        fclose(f);
+        if (!ok)
+            CV_Error(Error::StsParseError, "The model file " + filename + " is truncated");
+
+        SEDModelHeader header;
+        memcpy(&header, data.data, sizeof(header));
+
+        if (header.endianTag != SED_MODEL_ENDIAN_TAG)
+            CV_Error(Error::StsParseError, "The model file " + filename + " was written on a platform with different byte order");
+        if (header.version != SED_MODEL_VERSION)
+            CV_Error(Error::StsParseError, cv::format("Unsupported structured edge detection model version %u (expected %u)",
+                header.version, SED_MODEL_VERSION));
+        if (header.fileSize != (uint64)fileSize)
+            CV_Error(Error::StsParseError, "The model file " + filename + " is truncated");
+
+        for (int i = 0; i < SED_MODEL_ARRAYS; ++i)
+        {
+            // compared separately, so that the end of the array cannot overflow
+            if ( header.offsets[i] % SED_MODEL_ALIGNMENT != 0
+              || header.offsets[i] > (uint64)fileSize
+              || header.counts[i] > ((uint64)fileSize - header.offsets[i]) / sizeof(int) )
+                CV_Error(Error::StsParseError, "The model file " + filename + " is corrupted");
+        }
+
+        if (!validateBinaryModelHeader(header))
+            CV_Error(Error::StsParseError, "The model file " + filename + " is corrupted");
+
+        __rf.options.stride = header.stride;
+        __rf.options.shrinkNumber = header.shrinkNumber;
+        __rf.options.patchSize = header.patchSize;
+        __rf.options.patchInnerSize = header.patchInnerSize;
+        __rf.options.numberOfGradientOrientations = header.numberOfGradientOrientations;
+        __rf.options.gradientSmoothingRadius = header.gradientSmoothingRadius;
+        __rf.options.regFeatureSmoothingRadius = header.regFeatureSmoothingRadius;
+        __rf.options.ssFeatureSmoothingRadius = header.ssFeatureSmoothingRadius;
+        __rf.options.gradientNormalizationRadius = header.gradientNormalizationRadius;
+        __rf.options.selfsimilarityGridSize = header.selfsimilarityGridSize;
+        __rf.options.numberOfTrees = header.numberOfTrees;
+        __rf.options.numberOfTreesToEvaluate = header.numberOfTreesToEvaluate;
+        __rf.options.numberOfOutputChannels =
+            2*(__rf.options.numberOfGradientOrientations + 1) + 3;
+        __rf.numberOfTreeNodes = header.numberOfTreeNodes;
+
+        // the trees are used in place, the buffer is released together with the model
+        Mat* arrays[SED_MODEL_ARRAYS] = { &__rf.featureIds, &__rf.thresholds, &__rf.childs,
+                                          &__rf.edgeBoundaries, &__rf.edgeBins };
+        for (int i = 0; i < SED_MODEL_ARRAYS; ++i)
+        {
+            int type = i == 1 ? CV_32F : CV_32S;
+            if (header.counts[i] > 0)
+                *arrays[i] = Mat((int)header.counts[i], 1, type, (void*)(data.data + header.offsets[i]));
+            else
+                arrays[i]->release();
+        }
+        __rf.modelData = data;
+
+        if (!validateTrees())
+        {
+            for (int i = 0; i < SED_MODEL_ARRAYS; ++i)
+                arrays[i]->release();
+            __rf.modelData.release();
+            CV_Error(Error::StsParseError, "The model file " + filename + " is corrupted");
+        }
+    }
+
+    /*!
+     * The function checks the options and the array sizes of a binary model
+     */
+    static bool validateBinaryModelHeader(const SEDModelHeader &header)
+    {
+        if ( header.stride <= 0 || header.shrinkNumber <= 0
+          || header.patchSize < header.shrinkNumber || header.patchSize > 4096
+          || header.patchInnerSize <= 0 || header.patchInnerSize > header.patchSize
+          || header.numberOfGradientOrientations <= 0 || header.numberOfGradientOrientations > 64
+          || header.selfsimilarityGridSize <= 0 || header.selfsimilarityGridSize > header.patchSize
+          || header.numberOfTrees <= 0 || header.numberOfTreeNodes <= 0
+          || header.numberOfTreesToEvaluate <= 0 || header.numberOfTreesToEvaluate > header.numberOfTrees )
+            return false;
+
+        const uint64 nNodes = (uint64)header.numberOfTrees * header.numberOfTreeNodes;
+        if (nNodes > (uint64)INT_MAX)
+            return false;
+
+        // one feature id, threshold and child per node, at least one edge boundary pair per node
+        return header.counts[0] == nNodes && header.counts[1] == nNodes && header.counts[2] == nNodes
+            && header.counts[3] > nNodes && (header.counts[3] - 1) % nNodes == 0;
+    }
+
+    /*!
+     * The function checks that predictEdges only reaches valid nodes, features and edge bins
+     */
+    bool validateTrees() const
+    {
+        const int nTreesNodes = __rf.numberOfTreeNodes;
+        const int nNodes = __rf.options.numberOfTrees * nTreesNodes;
+        const int nchannels = __rf.options.numberOfOutputChannels;
+        const int gridSize = __rf.options.selfsimilarityGridSize;
+        const int64 nFeatures = CV_SQR((int64)__rf.options.patchSize/__rf.options.shrinkNumber)*nchannels
+            + CV_SQR((int64)gridSize)*(CV_SQR((int64)gridSize) - 1)/2 * nchannels;
+
+        const int *childs = __rf.childs.ptr<int>();
+        const int *featureIds = __rf.featureIds.ptr<int>();
+        for (int k = 0; k < nNodes; ++k)
+        {
+            if (childs[k] == 0)
+                continue;
+
+            // the children follow their parent within the tree, so that every descent ends in a leaf
+            const int node = k % nTreesNodes;
+            if ( childs[k] - 1 <= node || childs[k] >= nTreesNodes
+              || featureIds[k] < 0 || featureIds[k] >= nFeatures )
+                return false;
+        }
+
+        const int nBins = (int)__rf.edgeBins.total();
+        const int nBoundaries = (int)__rf.edgeBoundaries.total();
+        const int *edgeBoundaries = __rf.edgeBoundaries.ptr<int>();
+        if (edgeBoundaries[0] < 0 || edgeBoundaries[nBoundaries - 1] > nBins)
+            return false;
+        for (int k = 1; k < nBoundaries; ++k)
+        {
+            if (edgeBoundaries[k] < edgeBoundaries[k - 1])
+                return false;
+        }
+
+        const int *edgeBins = __rf.edgeBins.ptr<int>();
+        const int ipSize2 = CV_SQR(__rf.options.patchInnerSize);
+        for (int k = 0; k < nBins; ++k)
+        {
+            if (edgeBins[k] < 0 || edgeBins[k] >= ipSize2)
+                return false;
         }
+        return true;
+    }
 
-        __rf.numberOfTreeNodes = int( __rf.childs.size() ) / __rf.options.numberOfTrees;
+    void getModelArrays(const Mat* arrays[]) const
+    {
+        arrays[0] = &__rf.featureIds;
+        arrays[1] = &__rf.thresholds;
+        arrays[2] = &__rf.childs;
+        arrays[3] = &__rf.edgeBoundaries;
+        arrays[4] = &__rf.edgeBins;
     }
 
+public:
     /*!
      * The function detects edges in src and draw them to dst
      *
@@ -557,6 +847,59 @@ public:
         predictEdges( features, dst );
     }
 
+    /*!
+     * The function detects edges in src tile by tile and draw them to dst
+     *
+     * \param _src : source image (RGB, float, in [0;1]) to detect edges
+     * \param _dst : destination image (grayscale, float, in [0;1])
+     *              where edges are drawn
+     * \param tileSize : approximate size of the tiles
+     */
+    void detectEdgesTiled(cv::InputArray _src, cv::OutputArray _dst, int tileSize) const CV_OVERRIDE
+    {
+        CV_Assert( _src.type() == CV_32FC3 );
+        CV_Assert( tileSize > 0 );
+
+        Mat src = _src.getMat();
+        _dst.createSameSize( _src, cv::DataType<float>::type );
+        Mat dst = _dst.getMat();
+
+        // Tiles start at multiples of the shrink and of the patch grid period
+        // (the trees are chosen by the patch position modulo 2*nTreesEval),
+        // so the patches inside a tile are those of the whole image
+        const int period = __rf.options.stride * 2 * __rf.options.numberOfTreesToEvaluate;
+        int align = period;
+        while (align % __rf.options.shrinkNumber != 0)
+            align += period;
+
+        // the margin covers the patch, the smoothing and the gradient normalization
+        const int margin = alignSize(2 * __rf.options.patchSize, align);
+        tileSize = alignSize(tileSize, align);
+
+        const int tilesX = divUp(src.cols, tileSize);
+        const int tilesY = divUp(src.rows, tileSize);
+        if (tilesX * tilesY == 1)
+        {
+            detectEdges(src, dst);
+            return;
+        }
+
+        const Rect imageRect(0, 0, src.cols, src.rows);
+        parallel_for_(cv::Range(0, tilesX * tilesY), [&](const cv::Range& range)
+        {
+            for (int t = range.start; t < range.end; ++t)
+            {
+                Rect tile = Rect((t % tilesX) * tileSize, (t / tilesX) * tileSize, tileSize, tileSize) & imageRect;
+                Rect region = Rect(tile.x - margin, tile.y - margin,
+                                   tile.width + 2*margin, tile.height + 2*margin) & imageRect;
+
+                Mat edges;
+                detectEdges(src(region), edges);
+                edges(Rect(tile.tl() - region.tl(), tile.size())).copyTo(dst(tile));
+            }
+        });
+    }
+
     /*!
      * The function computes orientation from edge image.
      *
@@ -680,6 +1023,13 @@ protected:
         int ipSize = __rf.options.patchInnerSize;
         int gridSize = __rf.options.selfsimilarityGridSize;
 
+        const int *childs = __rf.childs.ptr<int>();
+        const int *featureIds = __rf.featureIds.ptr<int>();
+        const float *thresholds = __rf.thresholds.ptr<float>();
+        const int *edgeBoundaries = __rf.edgeBoundaries.ptr<int>();
+        const int *edgeBins = __rf.edgeBins.ptr<int>();
+        const int nBnds = (int(__rf.edgeBoundaries.total()) - 1) / (nTreesNodes * nTrees);
+
         const int height = cvCeil( double(features.rows*shrink - pSize) / stride );
         const int width  = cvCeil( double(features.cols*shrink - pSize) / stride );
         // image size in patches with overlapping
@@ -758,9 +1108,9 @@ protected:
                     // select root node of the tree to evaluate
 
                     int offset = (j*stride/shrink)*nchannels;
-                    while ( __rf.childs[currentNode] != 0 )
+                    while ( childs[currentNode] != 0 )
                     {
-                        int currentId = __rf.featureIds[currentNode];
+                        int currentId = featureIds[currentNode];
                         float currentFeature;
 
                         if (currentId >= nFeatures)
@@ -777,10 +1127,10 @@ protected:
                             currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
 
                         // compare feature to threshold and move left or right accordingly
-                        if (currentFeature < __rf.thresholds[currentNode])
-                            currentNode = baseNode + __rf.childs[currentNode] - 1;
+                        if (currentFeature < thresholds[currentNode])
+                            currentNode = baseNode + childs[currentNode] - 1;
                         else
-                            currentNode = baseNode + __rf.childs[currentNode];
+                            currentNode = baseNode + childs[currentNode];
                     }
 
                     indexPtr[j*nTreesEval + k] = currentNode;
@@ -811,18 +1161,15 @@ protected:
                 {// for j,k in [0;width)x[0;nTreesEval)
 
                     int currentNode = pIndex[j*nTreesEval + k];
-                    size_t sizeBoundaries = __rf.edgeBoundaries.size();
-                    int convertedBoundaries = static_cast<int>(sizeBoundaries);
-                    int nBnds = (convertedBoundaries - 1) / (nTreesNodes * nTrees);
-                    int start = __rf.edgeBoundaries[currentNode * nBnds];
-                    int finish = __rf.edgeBoundaries[currentNode * nBnds + 1];
+                    int start = edgeBoundaries[currentNode * nBnds];
+                    int finish = edgeBoundaries[currentNode * nBnds + 1];
 
                     if (start == finish)
                         continue;
 
                     int offset = j*stride*outNum;
                     for (int p = start; p < finish; ++p)
-                        pDst[offset + offsetE[__rf.edgeBins[p]]] += step;
+                        pDst[offset + offsetE[edgeBins[p]]] += step;
                 }
             }
         }
@@ -883,12 +1230,14 @@ protected:
 
         int numberOfTreeNodes;
 
-        std::vector <int> featureIds;     /*!< feature coordinate thresholded at k-th node */
-        std::vector <float> thresholds;   /*!< threshold applied to featureIds[k] at k-th node */
-        std::vector <int> childs;         /*!< k --> child[k] - 1, child[k] */
+        Mat featureIds;     /*!< feature coordinate thresholded at k-th node (CV_32S) */
+        Mat thresholds;     /*!< threshold applied to featureIds[k] at k-th node (CV_32F) */
+        Mat childs;         /*!< k --> child[k] - 1, child[k] (CV_32S) */
+
+        Mat edgeBoundaries; /*!< ... (CV_32S) */
+        Mat edgeBins;       /*!< ... (CV_32S) */
 
-        std::vector <int> edgeBoundaries; /*!< ... */
-        std::vector <int> edgeBins;       /*!< ... */
+        Mat modelData;      /*!< contents of the binary model file the arrays point to, if any */
     } __rf;
 };
 
@@ -1,90 +1,200 @@
 #include "precomp.hpp"
 
+#include "opencv2/core/hal/intrin.hpp"
+
 using namespace std;
 
 namespace cv {
 namespace ximgproc {
 
-// Applies a thinning iteration to a binary image
-static void thinningIteration(Mat img, int iter, int thinningType){
-    Mat marker = Mat::zeros(img.size(), CV_8UC1);
+// Builds the decision table of a thinning sub-iteration. The table is indexed by the
+// neighbourhood code of a foreground pixel, bit k of the code is the neighbour p(k+2):
+//  p9 p2 p3
+//  p8    p4
+//  p7 p6 p5
+static void buildThinningTable(int thinningType, int iter, uchar* table)
+{
+    for (int code = 0; code < 256; code++)
+    {
+        int p2 = code & 1, p3 = (code >> 1) & 1, p4 = (code >> 2) & 1, p5 = (code >> 3) & 1;
+        int p6 = (code >> 4) & 1, p7 = (code >> 5) & 1, p8 = (code >> 6) & 1, p9 = (code >> 7) & 1;
+        bool remove = false;
 
-    if(thinningType == THINNING_ZHANGSUEN){
-        for (int i = 1; i < img.rows-1; i++)
-        {
-            for (int j = 1; j < img.cols-1; j++)
-            {
-                uchar p2 = img.at<uchar>(i-1, j);
-                uchar p3 = img.at<uchar>(i-1, j+1);
-                uchar p4 = img.at<uchar>(i, j+1);
-                uchar p5 = img.at<uchar>(i+1, j+1);
-                uchar p6 = img.at<uchar>(i+1, j);
-                uchar p7 = img.at<uchar>(i+1, j-1);
-                uchar p8 = img.at<uchar>(i, j-1);
-                uchar p9 = img.at<uchar>(i-1, j-1);
-
-                int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
-                         (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
-                         (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
-                         (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
-                int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
-                int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
-                int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
-
-                if (A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0)
-                    marker.at<uchar>(i,j) = 1;
-            }
+        if(thinningType == THINNING_ZHANGSUEN){
+            int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
+                     (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
+                     (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
+                     (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
+            int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+            int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
+            int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
+
+            remove = A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0;
         }
+        if(thinningType == THINNING_GUOHALL){
+            int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
+                     ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
+            int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
+            int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
+            int N  = N1 < N2 ? N1 : N2;
+            int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
+
+            remove = (C == 1) && ((N >= 2) && ((N <= 3)) & (m == 0));
+        }
+
+        table[code] = remove ? 1 : 0;
     }
-    if(thinningType == THINNING_GUOHALL){
-        for (int i = 1; i < img.rows-1; i++)
+}
+
+static inline void extendSpan(Range& span, const Range& r)
+{
+    if (r.empty())
+        return;
+    if (span.empty())
+        span = r;
+    else
+        span = Range(std::min(span.start, r.start), std::max(span.end, r.end));
+}
+
+// Marks the pixels of the columns [start, end) of a row removed by a sub-iteration,
+// the image is binary 0/255. Returns the span of the marked pixels.
+static Range markRow(const uchar* prev, const uchar* cur, const uchar* next, uchar* marker,
+                     const uchar* table, int start, int end, uchar* codes)
+{
+    int first = end, last = start - 1;
+    int j = start;
+#if CV_SIMD
+    const int VECSZ = v_uint8::nlanes;
+    for (; j <= end - VECSZ; j += VECSZ)
+    {
+        if (!v_check_any(vx_load(cur + j)))
+            continue;
+
+        v_uint8 code = (vx_load(prev + j) & vx_setall_u8(1))
+                     | (vx_load(prev + j + 1) & vx_setall_u8(2))
+                     | (vx_load(cur + j + 1) & vx_setall_u8(4))
+                     | (vx_load(next + j + 1) & vx_setall_u8(8))
+                     | (vx_load(next + j) & vx_setall_u8(16))
+                     | (vx_load(next + j - 1) & vx_setall_u8(32))
+                     | (vx_load(cur + j - 1) & vx_setall_u8(64))
+                     | (vx_load(prev + j - 1) & vx_setall_u8(128));
+        v_store(codes, code);
+
+        for (int k = 0; k < VECSZ; k++)
         {
-            for (int j = 1; j < img.cols-1; j++)
+            if (cur[j + k] && table[codes[k]])
             {
-                uchar p2 = img.at<uchar>(i-1, j);
-                uchar p3 = img.at<uchar>(i-1, j+1);
-                uchar p4 = img.at<uchar>(i, j+1);
-                uchar p5 = img.at<uchar>(i+1, j+1);
-                uchar p6 = img.at<uchar>(i+1, j);
-                uchar p7 = img.at<uchar>(i+1, j-1);
-                uchar p8 = img.at<uchar>(i, j-1);
-                uchar p9 = img.at<uchar>(i-1, j-1);
-
-                int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
-                         ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
-                int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
-                int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
-                int N  = N1 < N2 ? N1 : N2;
-                int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
-
-                if ((C == 1) && ((N >= 2) && ((N <= 3)) & (m == 0)))
-                    marker.at<uchar>(i,j) = 1;
+                marker[j + k] = 255;
+                first = std::min(first, j + k);
+                last = j + k;
             }
         }
     }
+#else
+    CV_UNUSED(codes);
+#endif
+    for (; j < end; j++)
+    {
+        if (!cur[j])
+            continue;
 
-    img &= ~marker;
+        int code = (prev[j] & 1) | (prev[j + 1] & 2) | (cur[j + 1] & 4) | (next[j + 1] & 8) |
+                   (next[j] & 16) | (next[j - 1] & 32) | (cur[j - 1] & 64) | (prev[j - 1] & 128);
+        if (table[code])
+        {
+            marker[j] = 255;
+            first = std::min(first, j);
+            last = j;
+        }
+    }
+    return first <= last ? Range(first, last + 1) : Range(0, 0);
 }
 
 // Apply the thinning procedure to a given image
 void thinning(InputArray input, OutputArray output, int thinningType){
-    Mat processed = input.getMat().clone();
-    CV_CheckTypeEQ(processed.type(), CV_8UC1, "");
-    // Enforce the range of the input image to be in between 0 - 255
-    processed /= 255;
-
-    Mat prev = Mat::zeros(processed.size(), CV_8UC1);
-    Mat diff;
-
-    do {
-        thinningIteration(processed, 0, thinningType);
-        thinningIteration(processed, 1, thinningType);
-        absdiff(processed, prev, diff);
-        processed.copyTo(prev);
+    CV_CheckTypeEQ(input.type(), CV_8UC1, "");
+
+    // Enforce the range of the input image to be either 0 or 255, the pixels above 127 are set
+    Mat processed;
+    compare(input, 127, processed, CMP_GT);
+
+    const int rows = processed.rows, cols = processed.cols;
+    if (rows < 3 || cols < 3)
+    {
+        output.assign(processed);
+        return;
     }
-    while (countNonZero(diff) > 0);
 
-    processed *= 255;
+    uchar tables[2][256];
+    buildThinningTable(thinningType, 0, tables[0]);
+    buildThinningTable(thinningType, 1, tables[1]);
+
+    Mat marker = Mat::zeros(processed.size(), CV_8UC1);
+
+    // A pixel kept by a sub-iteration is kept by the next sub-iteration of the same kind unless
+    // its neighbourhood has changed since, so only the pixels next to the ones removed by
+    // the last two sub-iterations are evaluated. The spans of the removed pixels are kept per row.
+    std::vector<Range> changed[2];
+    changed[0].assign(rows, Range(0, cols));
+    changed[1].assign(rows, Range(0, cols));
+    // the first and the last rows are never changed
+    changed[0].front() = changed[0].back() = changed[1].front() = changed[1].back() = Range(0, 0);
+    std::vector<Range> candidates(rows, Range(0, 0)), removed(rows, Range(0, 0));
+
+    for (int iter = 0; ; iter ^= 1)
+    {
+        bool anyCandidate = false;
+        for (int i = 1; i < rows - 1; i++)
+        {
+            Range span(0, 0);
+            for (int r = i - 1; r <= i + 1; r++)
+            {
+                extendSpan(span, changed[0][r]);
+                extendSpan(span, changed[1][r]);
+            }
+            if (!span.empty())
+            {
+                span = Range(std::max(span.start - 1, 1), std::min(span.end + 1, cols - 1));
+                anyCandidate = true;
+            }
+            candidates[i] = span;
+        }
+        // nothing has changed during the last two sub-iterations
+        if (!anyCandidate)
+            break;
+
+        const uchar* table = tables[iter];
+        parallel_for_(Range(1, rows - 1), [&](const Range& range)
+        {
+            AutoBuffer<uchar> codes(cols);
+            for (int i = range.start; i < range.end; i++)
+            {
+                const Range& span = candidates[i];
+                removed[i] = span.empty() ? Range(0, 0) :
+                    markRow(processed.ptr(i - 1), processed.ptr(i), processed.ptr(i + 1), marker.ptr(i),
+                            table, span.start, span.end, codes.data());
+            }
+        });
+
+        // the marks are applied once all the rows are evaluated
+        parallel_for_(Range(1, rows - 1), [&](const Range& range)
+        {
+            for (int i = range.start; i < range.end; i++)
+            {
+                const Range& span = removed[i];
+                if (span.empty())
+                    continue;
+
+                uchar* p = processed.ptr(i);
+                uchar* m = marker.ptr(i);
+                for (int j = span.start; j < span.end; j++)
+                    p[j] = (uchar)(p[j] & ~m[j]);
+                memset(m + span.start, 0, span.size());
+            }
+        });
+
+        changed[iter].swap(removed);
+    }
 
     output.assign(processed);
 }
@@ -459,4 +459,47 @@ INSTANTIATE_TEST_CASE_P(FullSet, FastHoughTransformTest,
 #undef FHT_ALL_DEPTHS
 #undef FHT_ALL_CHANNELS
 
+TEST(FastHoughTransformTest, parallel_levels)
+{
+    // the number of rows is not a power of two, so the subtrees are unbalanced
+    Mat src(Size(211, 301), CV_8UC1);
+    randu(src, 0, 256);
+
+    const int ranges[] = { ARO_315_135, ARO_0_45, ARO_45_135, ARO_CTR_VER };
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+    {
+        int prev_threads = getNumThreads();
+        setNumThreads(1);
+        Mat serial;
+        FastHoughTransform(src, serial, CV_32S, ranges[r]);
+        setNumThreads(prev_threads);
+
+        Mat parallel;
+        FastHoughTransform(src, parallel, CV_32S, ranges[r]);
+        EXPECT_EQ(0, cvtest::norm(serial, parallel, NORM_INF)) << "angle range " << ranges[r];
+    }
+}
+
+TEST(FastHoughTransformTest, batch)
+{
+    std::vector<Mat> srcs;
+    srcs.push_back(Mat(Size(100, 80), CV_8UC1));
+    srcs.push_back(Mat(Size(33, 70), CV_8UC3));
+    srcs.push_back(Mat(Size(128, 128), CV_32FC1));
+    for (size_t i = 0; i < srcs.size(); i++)
+        randu(srcs[i], 0, 100);
+
+    std::vector<Mat> fhts;
+    FastHoughTransformBatch(srcs, fhts, CV_64F);
+    ASSERT_EQ(srcs.size(), fhts.size());
+    for (size_t i = 0; i < srcs.size(); i++)
+    {
+        Mat fht;
+        FastHoughTransform(srcs[i], fht, CV_64F);
+        ASSERT_EQ(fht.type(), fhts[i].type());
+        ASSERT_EQ(fht.size(), fhts[i].size());
+        EXPECT_EQ(0, cvtest::norm(fht, fhts[i], NORM_INF)) << "image " << i;
+    }
+}
+
 }} // namespace
@@ -0,0 +1,167 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+TEST(ximgproc_GraphSegmentation, flat_regions)
+{
+    // 4 flat quadrants of very different colors, the blurred borders are below min_size
+    Mat img(120, 160, CV_8UC3);
+    img(Rect(0, 0, 80, 60)).setTo(Scalar(0, 0, 0));
+    img(Rect(80, 0, 80, 60)).setTo(Scalar(255, 0, 0));
+    img(Rect(0, 60, 80, 60)).setTo(Scalar(0, 255, 0));
+    img(Rect(80, 60, 80, 60)).setTo(Scalar(0, 0, 255));
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.5, 300, 1000);
+    Mat labels;
+    gs->processImage(img, labels);
+
+    ASSERT_EQ(CV_32SC1, labels.type());
+    double minVal, maxVal;
+    minMaxLoc(labels, &minVal, &maxVal);
+    EXPECT_EQ(0, minVal);
+    EXPECT_EQ(3, maxVal);
+    // labels are given in the raster order of the first pixel of each region
+    EXPECT_EQ(0, labels.at<int>(10, 10));
+    EXPECT_EQ(1, labels.at<int>(10, 150));
+    EXPECT_EQ(2, labels.at<int>(110, 10));
+    EXPECT_EQ(3, labels.at<int>(110, 150));
+}
+
+struct RefEdge
+{
+    int from, to;
+    float weight;
+    bool operator<(const RefEdge& e) const { return weight < e.weight; }
+};
+
+static int refBasePoint(std::vector<int>& parents, int p)
+{
+    int base_p = p;
+    while (base_p != parents[base_p])
+        base_p = parents[base_p];
+    parents[p] = base_p;
+    return base_p;
+}
+
+static void refJoinPoints(std::vector<int>& parents, std::vector<int>& sizes, int p_a, int p_b)
+{
+    if (sizes[p_a] < sizes[p_b])
+        std::swap(p_a, p_b);
+    parents[p_b] = p_a;
+    sizes[p_a] += sizes[p_b];
+}
+
+// The original single threaded implementation, kept to check that the labels do not change
+static void referenceGraphSegmentation(const Mat& img, double sigma, float k, int min_size, Mat& labels)
+{
+    Mat img_converted, img_filtered;
+    img.convertTo(img_converted, CV_32F);
+    GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
+
+    const int rows = img.rows, cols = img.cols, cn = img.channels();
+    std::vector<RefEdge> edges;
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            for (int delta = -1; delta <= 1; delta += 2)
+            {
+                for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--)
+                {
+                    int i2 = i + delta * delta_i, j2 = j + delta * delta_j;
+                    if (i2 < 0 || i2 >= rows || j2 < 0 || j2 >= cols)
+                        continue;
+                    const float* p = img_filtered.ptr<float>(i);
+                    const float* p2 = img_filtered.ptr<float>(i2);
+                    float tmp_total = 0;
+                    for (int c = 0; c < cn; c++)
+                    {
+                        float tmp_diff = p[j * cn + c] - p2[j2 * cn + c];
+                        tmp_total += tmp_diff * tmp_diff;
+                    }
+                    RefEdge e = { i * cols + j, i2 * cols + j2, std::sqrt(tmp_total) };
+                    edges.push_back(e);
+                }
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    const int total = rows * cols;
+    std::vector<int> parents(total), sizes(total, 1);
+    for (int i = 0; i < total; i++)
+        parents[i] = i;
+    std::vector<float> thresholds(total, k);
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        int p_a = refBasePoint(parents, edges[i].from);
+        int p_b = refBasePoint(parents, edges[i].to);
+        if (p_a != p_b && edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b])
+        {
+            refJoinPoints(parents, sizes, p_a, p_b);
+            p_a = refBasePoint(parents, p_a);
+            thresholds[p_a] = edges[i].weight + k / sizes[p_a];
+            edges[i].weight = 0;
+        }
+    }
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        if (edges[i].weight <= 0)
+            continue;
+        int p_a = refBasePoint(parents, edges[i].from);
+        int p_b = refBasePoint(parents, edges[i].to);
+        if (p_a != p_b && (sizes[p_a] < min_size || sizes[p_b] < min_size))
+            refJoinPoints(parents, sizes, p_a, p_b);
+    }
+
+    labels.create(rows, cols, CV_32SC1);
+    std::vector<int> mapped_id(total, -1);
+    int last_id = 0;
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            int point = refBasePoint(parents, i * cols + j);
+            if (mapped_id[point] == -1)
+                mapped_id[point] = last_id++;
+            labels.at<int>(i, j) = mapped_id[point];
+        }
+    }
+}
+
+TEST(ximgproc_GraphSegmentation, same_as_reference)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation();
+    Mat labels, reference;
+    gs->processImage(img, labels);
+    referenceGraphSegmentation(img, gs->getSigma(), gs->getK(), gs->getMinSize(), reference);
+
+    EXPECT_EQ(0, cvtest::norm(labels, reference, NORM_INF));
+}
+
+TEST(ximgproc_GraphSegmentation, parallel_deterministic)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation();
+
+    int prev_threads = getNumThreads();
+    Mat serial, parallel;
+    setNumThreads(1);
+    gs->processImage(img, serial);
+    setNumThreads(prev_threads);
+    gs->processImage(img, parallel);
+
+    EXPECT_EQ(0, cvtest::norm(serial, parallel, NORM_INF));
+}
+
+}} // namespace
@@ -78,4 +78,42 @@ TEST(RadonTransformTest, accuracy_float)
     EXPECT_GT(111, sum(radon.col(0))[0]);
 }
 
+TEST(RadonTransformTest, large_image_bands)
+{
+    // the rotated image is processed by several bands of rows
+    Mat src(Size(1200, 1100), CV_8UC1);
+    randu(src, 0, 256);
+    cv::Mat radon;
+    ximgproc::RadonTransform(src, radon, 30, 0, 180, false, false);
+
+    ASSERT_EQ(CV_32SC1, radon.type());
+    // no interpolation at 0 degrees
+    EXPECT_EQ(sum(src)[0], sum(radon.col(0))[0]);
+}
+
+TEST(RadonTransformTest, batch)
+{
+    std::vector<Mat> srcs;
+    srcs.push_back(Mat(Size(64, 48), CV_8UC1));
+    srcs.push_back(Mat(Size(40, 40), CV_32FC1));
+    srcs.push_back(Mat(Size(33, 57), CV_64FC1));
+    for (size_t i = 0; i < srcs.size(); i++)
+        randu(srcs[i], 0, 100);
+
+    for (int crop = 0; crop < 2; crop++)
+    {
+        std::vector<Mat> radons;
+        ximgproc::RadonTransformBatch(srcs, radons, 5, 0, 180, crop != 0, false);
+        ASSERT_EQ(srcs.size(), radons.size());
+        for (size_t i = 0; i < srcs.size(); i++)
+        {
+            Mat radon;
+            ximgproc::RadonTransform(srcs[i], radon, 5, 0, 180, crop != 0, false);
+            ASSERT_EQ(radon.type(), radons[i].type());
+            ASSERT_EQ(radon.size(), radons[i].size());
+            EXPECT_EQ(0, cvtest::norm(radon, radons[i], NORM_INF)) << "image " << i << ", crop " << crop;
+        }
+    }
+}
+
 } }
@@ -0,0 +1,43 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static Mat runSEEDS(const Mat& img, int nthreads, int prior, bool double_step)
+{
+    int prev_threads = getNumThreads();
+    setNumThreads(nthreads);
+
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(),
+                                                       200, 4, prior, 5, double_step);
+    seeds->iterate(img, 4);
+    Mat labels;
+    seeds->getLabels(labels);
+
+    setNumThreads(prev_threads);
+
+    double minLabel, maxLabel;
+    minMaxLoc(labels, &minLabel, &maxLabel);
+    EXPECT_GE(minLabel, 0);
+    EXPECT_LT(maxLabel, seeds->getNumberOfSuperpixels());
+    return labels.clone();
+}
+
+TEST(ximgproc_SuperpixelSEEDS, parallel_deterministic)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+    cvtColor(img, img, COLOR_BGR2HSV);
+
+    for (int prior = 0; prior <= 2; prior += 2)
+    {
+        Mat serial = runSEEDS(img, 1, prior, prior != 0);
+        Mat parallel = runSEEDS(img, getNumThreads(), prior, prior != 0);
+        EXPECT_EQ(0, cvtest::norm(serial, parallel, NORM_INF)) << "prior = " << prior;
+    }
+}
+
+}} // namespace
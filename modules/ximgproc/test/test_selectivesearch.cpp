@@ -0,0 +1,62 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+// strategy unknown to the implementation, it can't be copied for the parallel jobs
+class WrappedStrategy CV_FINAL : public SelectiveSearchSegmentationStrategy
+{
+public:
+    WrappedStrategy() : s(createSelectiveSearchSegmentationStrategySize()) {}
+
+    void setImage(InputArray img, InputArray regions, InputArray sizes, int image_id) CV_OVERRIDE
+    {
+        s->setImage(img, regions, sizes, image_id);
+    }
+    float get(int r1, int r2) CV_OVERRIDE { return s->get(r1, r2); }
+    void merge(int r1, int r2) CV_OVERRIDE { s->merge(r1, r2); }
+
+private:
+    Ptr<SelectiveSearchSegmentationStrategy> s;
+};
+
+static std::vector<Rect> runSelectiveSearch(const Mat& img, int nthreads)
+{
+    int prev_threads = getNumThreads();
+    setNumThreads(nthreads);
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    ss->switchToSelectiveSearchFast();
+    ss->addStrategy(makePtr<WrappedStrategy>());
+    std::vector<Rect> rects;
+    ss->process(rects);
+
+    setNumThreads(prev_threads);
+    return rects;
+}
+
+TEST(ximgproc_SelectiveSearchSegmentation, parallel_deterministic)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+    resize(img, img, Size(128, 128), 0, 0, INTER_AREA);
+
+    std::vector<Rect> serial = runSelectiveSearch(img, 1);
+    std::vector<Rect> parallel = runSelectiveSearch(img, getNumThreads());
+    std::vector<Rect> parallel2 = runSelectiveSearch(img, getNumThreads());
+
+    ASSERT_FALSE(serial.empty());
+    EXPECT_EQ(serial, parallel);
+    EXPECT_EQ(parallel, parallel2);
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        EXPECT_TRUE((serial[i] & Rect(0, 0, img.cols, img.rows)) == serial[i]) << serial[i];
+    }
+}
+
+}} // namespace
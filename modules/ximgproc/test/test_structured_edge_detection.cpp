@@ -39,4 +39,61 @@ TEST(ximgproc_StructuredEdgeDetection, regression)
     }
 }
 
+TEST(ximgproc_StructuredEdgeDetection, binary_model_and_tiles)
+{
+    cv::String dir = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/";
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pDollar =
+        cv::ximgproc::createStructuredEdgeDetection(dir + "model.yml.gz");
+
+    cv::Mat src = cv::imread(dir + "sources/01.png", 1);
+    ASSERT_FALSE(src.empty());
+    src.convertTo(src, CV_32F, 1/255.0);
+
+    cv::Mat edges;
+    pDollar->detectEdges(src, edges);
+
+    cv::String binaryName = cv::tempfile(".bin");
+    pDollar->saveBinaryModel(binaryName);
+    {
+        cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pBinary =
+            cv::ximgproc::createStructuredEdgeDetection(binaryName);
+        cv::Mat binaryEdges;
+        pBinary->detectEdges(src, binaryEdges);
+        EXPECT_EQ(0, cvtest::norm(edges, binaryEdges, NORM_INF));
+    }
+    remove(binaryName.c_str());
+
+    // the tiles see the same patches as the whole image, only the borders of the tiles may differ
+    cv::Mat tiledEdges;
+    pDollar->detectEdgesTiled(src, tiledEdges, 64);
+    ASSERT_EQ(edges.size(), tiledEdges.size());
+    EXPECT_LE(cvtest::norm(edges, tiledEdges, NORM_L1) / edges.total(), 0.01);
+}
+
+TEST(ximgproc_StructuredEdgeDetection, corrupted_binary_model)
+{
+    cv::String dir = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/";
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pDollar =
+        cv::ximgproc::createStructuredEdgeDetection(dir + "model.yml.gz");
+
+    cv::String binaryName = cv::tempfile(".bin");
+    pDollar->saveBinaryModel(binaryName);
+
+    FILE* f = fopen(binaryName.c_str(), "r+b");
+    ASSERT_TRUE(f != NULL);
+
+    // the header stores the counts and then the offsets of the five arrays after 72 bytes,
+    // the child of the root of the first tree is made to point outside of the tree
+    uint64 childsOffset = 0;
+    ASSERT_EQ(0, fseek(f, 72 + 5 * sizeof(uint64) + 2 * sizeof(uint64), SEEK_SET));
+    ASSERT_EQ(1u, fread(&childsOffset, sizeof(childsOffset), 1, f));
+    const int badChild = INT_MAX;
+    ASSERT_EQ(0, fseek(f, (long)childsOffset, SEEK_SET));
+    ASSERT_EQ(1u, fwrite(&badChild, sizeof(badChild), 1, f));
+    fclose(f);
+
+    EXPECT_THROW(cv::ximgproc::createStructuredEdgeDetection(binaryName), cv::Exception);
+    remove(binaryName.c_str());
+}
+
 }} // namespace
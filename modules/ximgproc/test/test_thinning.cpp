@@ -48,5 +48,81 @@ TEST(ximgproc_Thinning, simple_GUOHALL)
 #endif
 }
 
+// the straightforward implementation, every pixel is evaluated on each sub-iteration
+static void thinningReference(const Mat& src, Mat& dst, int thinningType)
+{
+    Mat img = src / 255;
+    Mat prev;
+    do
+    {
+        img.copyTo(prev);
+        for (int iter = 0; iter < 2; iter++)
+        {
+            Mat marker = Mat::zeros(img.size(), CV_8UC1);
+            for (int i = 1; i < img.rows - 1; i++)
+            {
+                for (int j = 1; j < img.cols - 1; j++)
+                {
+                    int p2 = img.at<uchar>(i-1, j), p3 = img.at<uchar>(i-1, j+1);
+                    int p4 = img.at<uchar>(i, j+1), p5 = img.at<uchar>(i+1, j+1);
+                    int p6 = img.at<uchar>(i+1, j), p7 = img.at<uchar>(i+1, j-1);
+                    int p8 = img.at<uchar>(i, j-1), p9 = img.at<uchar>(i-1, j-1);
+                    bool remove;
+                    if (thinningType == THINNING_ZHANGSUEN)
+                    {
+                        int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
+                                 (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
+                                 (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
+                                 (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
+                        int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+                        int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
+                        int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
+                        remove = A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0;
+                    }
+                    else
+                    {
+                        int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
+                                 ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
+                        int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
+                        int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
+                        int N  = std::min(N1, N2);
+                        int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
+                        remove = C == 1 && N >= 2 && N <= 3 && m == 0;
+                    }
+                    if (remove)
+                        marker.at<uchar>(i, j) = 1;
+                }
+            }
+            img &= ~marker;
+        }
+    }
+    while (cvtest::norm(img, prev, NORM_INF) > 0);
+    dst = img * 255;
+}
+
+typedef testing::TestWithParam<int> ximgproc_Thinning_Reference;
+
+TEST_P(ximgproc_Thinning_Reference, accuracy)
+{
+    int thinningType = GetParam();
+
+    // blobs of various thickness touching the borders, the odd width exercises the vector tails
+    Mat src = Mat::zeros(Size(203, 157), CV_8UC1);
+    RNG& rng = theRNG();
+    for (int k = 0; k < 15; k++)
+    {
+        Point center(rng.uniform(-10, src.cols + 10), rng.uniform(-10, src.rows + 10));
+        Size axes(rng.uniform(3, 40), rng.uniform(3, 40));
+        ellipse(src, center, axes, rng.uniform(0, 180), 0, 360, Scalar(rng.uniform(128, 256)), -1);
+    }
+    rectangle(src, Rect(0, 0, 60, 20), Scalar(255), -1);
+
+    Mat dst, ref;
+    thinning(src, dst, thinningType);
+    thinningReference(src, ref, thinningType);
+    EXPECT_EQ(0, cvtest::norm(dst, ref, NORM_INF));
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, ximgproc_Thinning_Reference, testing::Values(THINNING_ZHANGSUEN, THINNING_GUOHALL));
 
 }} // namespace